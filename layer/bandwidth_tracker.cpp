@@ -0,0 +1,267 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "bandwidth_tracker.hpp"
+#include "device.hpp"
+#include "format.hpp"
+#include "framebuffer.hpp"
+#include "image.hpp"
+#include "message_codes.hpp"
+#include "render_pass.hpp"
+#include <algorithm>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace MPD
+{
+BandwidthTracker::BandwidthTracker(Device &device)
+    : device(device)
+{
+}
+
+void BandwidthTracker::addRenderPass(VkRenderPass renderPass, const BandwidthEstimate &estimate)
+{
+	auto &totals = renderPasses[renderPass];
+	totals.instances++;
+	totals.bandwidth += estimate;
+}
+
+void BandwidthTracker::addTransfer(const BandwidthEstimate &estimate)
+{
+	transfers += estimate;
+}
+
+void BandwidthTracker::addDeadStore(VkImage image, VkDeviceSize bytes, DeadStoreReasonFlags reason)
+{
+	auto &totals = deadStores[image];
+	totals.bytes += bytes;
+	totals.reasons |= reason;
+}
+
+void BandwidthTracker::endFrame()
+{
+	frameCount++;
+
+	uint64_t interval = device.getConfig().bandwidthReportFrameInterval;
+	if (interval != 0 && frameCount >= interval)
+		report(frameCount);
+}
+
+void BandwidthTracker::flush()
+{
+	// Work submitted after the last present still counts as a frame of its own.
+	if (!renderPasses.empty() || !deadStores.empty() || transfers.getTotalBytes() != 0)
+		report(max<uint64_t>(frameCount, 1));
+}
+
+static double toMiB(double bytes)
+{
+	return bytes / (1024.0 * 1024.0);
+}
+
+void BandwidthTracker::report(uint64_t frames)
+{
+	vector<pair<VkRenderPass, const RenderPassTotals *>> ranked;
+	ranked.reserve(renderPasses.size());
+
+	BandwidthEstimate total = transfers;
+	for (auto &renderPass : renderPasses)
+	{
+		ranked.push_back(make_pair(renderPass.first, &renderPass.second));
+		total += renderPass.second.bandwidth;
+	}
+
+	size_t count = min<size_t>(ranked.size(), device.getConfig().bandwidthReportTopRenderPasses);
+	partial_sort(begin(ranked), begin(ranked) + count, end(ranked),
+	             [](const pair<VkRenderPass, const RenderPassTotals *> &a,
+	                const pair<VkRenderPass, const RenderPassTotals *> &b) {
+		             return a.second->bandwidth.getTotalBytes() > b.second->bandwidth.getTotalBytes();
+	             });
+
+	double perFrame = 1.0 / double(frames);
+	char line[256];
+
+	snprintf(line, sizeof(line),
+	         "Estimated external memory bandwidth over frames %llu to %llu: %.2f MiB read and %.2f MiB written per "
+	         "frame, of which %.2f MiB read and %.2f MiB written by transfer commands.",
+	         static_cast<unsigned long long>(firstFrame), static_cast<unsigned long long>(firstFrame + frames - 1),
+	         toMiB(total.readBytes * perFrame), toMiB(total.writeBytes * perFrame),
+	         toMiB(transfers.readBytes * perFrame), toMiB(transfers.writeBytes * perFrame));
+	string message = line;
+
+	if (count)
+		message += " Render passes ranked by traffic per frame:";
+
+	for (size_t i = 0; i < count; i++)
+	{
+		auto &totals = *ranked[i].second;
+		double share = total.getTotalBytes() ? 100.0 * double(totals.bandwidth.getTotalBytes()) /
+		                                           double(total.getTotalBytes()) :
+		                                       0.0;
+		snprintf(line, sizeof(line),
+		         "\n  #%u VkRenderPass 0x%llx: %.2f instances, %.2f MiB read, %.2f MiB written (%.1f%% of total).",
+		         unsigned(i + 1), static_cast<unsigned long long>((uint64_t)ranked[i].first),
+		         totals.instances * perFrame, toMiB(totals.bandwidth.readBytes * perFrame),
+		         toMiB(totals.bandwidth.writeBytes * perFrame), share);
+		message += line;
+	}
+
+	device.log(VK_DEBUG_REPORT_INFORMATION_BIT_EXT, MESSAGE_CODE_BANDWIDTH_REPORT, "%s", message.c_str());
+	reportDeadStores(frames);
+
+	renderPasses.clear();
+	transfers = BandwidthEstimate();
+	firstFrame += frames;
+	frameCount = 0;
+}
+
+void BandwidthTracker::reportDeadStores(uint64_t frames)
+{
+	if (deadStores.empty())
+		return;
+
+	vector<pair<VkImage, const DeadStoreTotals *>> ranked;
+	ranked.reserve(deadStores.size());
+
+	VkDeviceSize total = 0;
+	for (auto &image : deadStores)
+	{
+		ranked.push_back(make_pair(image.first, &image.second));
+		total += image.second.bytes;
+	}
+
+	size_t count = min<size_t>(ranked.size(), device.getConfig().deadStoreReportTopImages);
+	partial_sort(begin(ranked), begin(ranked) + count, end(ranked),
+	             [](const pair<VkImage, const DeadStoreTotals *> &a, const pair<VkImage, const DeadStoreTotals *> &b) {
+		             return a.second->bytes > b.second->bytes;
+	             });
+
+	double perFrame = 1.0 / double(frames);
+	char line[256];
+
+	snprintf(line, sizeof(line),
+	         "%.2f MiB per frame are written to %u image(s) with STORE_OP_STORE, but never read afterwards. "
+	         "Use STORE_OP_DONT_CARE for these attachments to save the bandwidth.",
+	         toMiB(total * perFrame), unsigned(ranked.size()));
+	string message = line;
+
+	static const struct
+	{
+		DeadStoreReasonFlags bit;
+		const char *description;
+	} reasons[] = {
+		{ DEAD_STORE_DISCARDED_BIT, "discarded by DONT_CARE" },
+		{ DEAD_STORE_CLEARED_BIT, "cleared" },
+		{ DEAD_STORE_OVERWRITTEN_BIT, "overwritten by a transfer" },
+		{ DEAD_STORE_STORED_AGAIN_BIT, "stored again" },
+		{ DEAD_STORE_DESTROYED_BIT, "destroyed" },
+	};
+
+	for (size_t i = 0; i < count; i++)
+	{
+		auto &totals = *ranked[i].second;
+		string why;
+		for (auto &reason : reasons)
+		{
+			if (totals.reasons & reason.bit)
+			{
+				if (!why.empty())
+					why += ", ";
+				why += reason.description;
+			}
+		}
+
+		snprintf(line, sizeof(line), "\n  VkImage 0x%llx: %.2f MiB per frame (%s before being read).",
+		         static_cast<unsigned long long>((uint64_t)ranked[i].first), toMiB(totals.bytes * perFrame),
+		         why.c_str());
+		message += line;
+	}
+
+	device.log(VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT, MESSAGE_CODE_DEAD_ATTACHMENT_STORE, "%s", message.c_str());
+	deadStores.clear();
+}
+
+BandwidthEstimate BandwidthTracker::estimateRenderPass(const RenderPass &renderPass, const Framebuffer &framebuffer,
+                                                       const VkRect2D &renderArea)
+{
+	auto &createInfo = renderPass.getCreateInfo();
+	VkDeviceSize pixels = VkDeviceSize(renderArea.extent.width) * renderArea.extent.height *
+	                      max(framebuffer.getCreateInfo().layers, 1u);
+
+	BandwidthEstimate estimate;
+	for (uint32_t att = 0; att < createInfo.attachmentCount; att++)
+	{
+		auto &state = renderPass.getAttachmentState(att);
+		if (!state.usage)
+			continue;
+
+		auto &attachment = createInfo.pAttachments[att];
+		VkDeviceSize samplePixels = pixels * static_cast<uint32_t>(attachment.samples);
+		uint32_t stencilBits = formatStencilBitsPerPixel(attachment.format);
+		uint32_t bits = formatBitsPerPixel(attachment.format) - stencilBits;
+		VkDeviceSize bytes = samplePixels * bits / 8;
+		VkDeviceSize stencilBytes = samplePixels * stencilBits / 8;
+
+		// Input attachments which never live on tile are sampled from memory like any other texture.
+		if (!renderPass.renderPassUsesAttachmentOnTile(att))
+		{
+			estimate.readBytes += bytes + stencilBytes;
+			continue;
+		}
+
+		if (attachment.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD)
+			estimate.readBytes += bytes;
+		if (attachment.stencilLoadOp == VK_ATTACHMENT_LOAD_OP_LOAD)
+			estimate.readBytes += stencilBytes;
+		if (attachment.storeOp == VK_ATTACHMENT_STORE_OP_STORE)
+			estimate.writeBytes += bytes;
+		if (attachment.stencilStoreOp == VK_ATTACHMENT_STORE_OP_STORE)
+			estimate.writeBytes += stencilBytes;
+	}
+
+	return estimate;
+}
+
+VkDeviceSize BandwidthTracker::imageRegionBytes(const Image &image, const VkExtent3D &extent, uint32_t layerCount)
+{
+	auto &createInfo = image.getCreateInfo();
+	VkDeviceSize pixels = VkDeviceSize(extent.width) * extent.height * extent.depth * layerCount;
+	return pixels * static_cast<uint32_t>(createInfo.samples) * formatBitsPerPixel(createInfo.format) / 8;
+}
+
+VkDeviceSize BandwidthTracker::imageRangeBytes(const Image &image, const VkImageSubresourceRange &range)
+{
+	auto &createInfo = image.getCreateInfo();
+	uint32_t layers = min(range.layerCount, createInfo.arrayLayers - range.baseArrayLayer);
+	uint32_t levels = min(range.levelCount, createInfo.mipLevels - range.baseMipLevel);
+
+	VkDeviceSize bytes = 0;
+	for (uint32_t level = range.baseMipLevel; level < range.baseMipLevel + levels; level++)
+	{
+		VkExtent3D extent = { max(createInfo.extent.width >> level, 1u), max(createInfo.extent.height >> level, 1u),
+			                  max(createInfo.extent.depth >> level, 1u) };
+		bytes += imageRegionBytes(image, extent, layers);
+	}
+	return bytes;
+}
+}
@@ -0,0 +1,124 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#include "perfdoc.hpp"
+#include <unordered_map>
+
+namespace MPD
+{
+class Device;
+class Image;
+class RenderPass;
+class Framebuffer;
+
+/// Estimated traffic between the GPU and external memory.
+struct BandwidthEstimate
+{
+	VkDeviceSize readBytes = 0;
+	VkDeviceSize writeBytes = 0;
+
+	BandwidthEstimate() = default;
+	BandwidthEstimate(VkDeviceSize readBytes, VkDeviceSize writeBytes)
+	    : readBytes(readBytes)
+	    , writeBytes(writeBytes)
+	{
+	}
+
+	BandwidthEstimate &operator+=(const BandwidthEstimate &other)
+	{
+		readBytes += other.readBytes;
+		writeBytes += other.writeBytes;
+		return *this;
+	}
+
+	VkDeviceSize getTotalBytes() const
+	{
+		return readBytes + writeBytes;
+	}
+};
+
+/// Why data stored to an image was never read.
+enum DeadStoreReasonBits
+{
+	// The next render pass used LOAD_OP_DONT_CARE.
+	DEAD_STORE_DISCARDED_BIT = 1 << 0,
+	DEAD_STORE_CLEARED_BIT = 1 << 1,
+	// A copy, blit or resolve replaced the whole subresource.
+	DEAD_STORE_OVERWRITTEN_BIT = 1 << 2,
+	DEAD_STORE_STORED_AGAIN_BIT = 1 << 3,
+	DEAD_STORE_DESTROYED_BIT = 1 << 4
+};
+using DeadStoreReasonFlags = uint32_t;
+
+/// Accumulates the estimated external memory bandwidth of submitted work,
+/// and reports it per frame with render passes ranked by how much traffic they cause.
+/// Estimates are made when recording, and accounted for every time the command buffer is submitted.
+class BandwidthTracker
+{
+public:
+	explicit BandwidthTracker(Device &device);
+
+	void addRenderPass(VkRenderPass renderPass, const BandwidthEstimate &estimate);
+	void addTransfer(const BandwidthEstimate &estimate);
+
+	/// Render pass stores to an image which were never read before being replaced, discarded or destroyed.
+	void addDeadStore(VkImage image, VkDeviceSize bytes, DeadStoreReasonFlags reason);
+
+	/// Called on present, reports every bandwidthReportFrameInterval frames if enabled.
+	void endFrame();
+
+	/// Reports everything accumulated since the last report, called when the device is destroyed.
+	void flush();
+
+	/// Tile loads and stores, including multisampled data and resolves, for one instance of a render pass.
+	/// Attachments which are only read as input attachments are counted as texture reads.
+	static BandwidthEstimate estimateRenderPass(const RenderPass &renderPass, const Framebuffer &framebuffer,
+	                                            const VkRect2D &renderArea);
+
+	/// Bytes covered by a subresource range, or by a region of a single mip level.
+	static VkDeviceSize imageRangeBytes(const Image &image, const VkImageSubresourceRange &range);
+	static VkDeviceSize imageRegionBytes(const Image &image, const VkExtent3D &extent, uint32_t layerCount);
+
+private:
+	Device &device;
+
+	struct RenderPassTotals
+	{
+		uint64_t instances = 0;
+		BandwidthEstimate bandwidth;
+	};
+
+	struct DeadStoreTotals
+	{
+		VkDeviceSize bytes = 0;
+		DeadStoreReasonFlags reasons = 0;
+	};
+
+	std::unordered_map<VkRenderPass, RenderPassTotals> renderPasses;
+	std::unordered_map<VkImage, DeadStoreTotals> deadStores;
+	BandwidthEstimate transfers;
+	uint64_t firstFrame = 0;
+	uint64_t frameCount = 0;
+
+	void report(uint64_t frames);
+	void reportDeadStores(uint64_t frames);
+};
+}
@@ -49,6 +49,10 @@ static void dispatchLog(Logger &logger, VkDebugReportFlagsEXT flags, VkDebugRepo
 
 void BaseObject::log(VkDebugReportFlagsEXT flags, int32_t messageCode, const char *fmt, ...)
 {
+	// In record-only mode all diagnostics come from the offline analyzer.
+	if (baseDevice->isRecordOnly())
+		return;
+
 	va_list args;
 	va_start(args, fmt);
 	dispatchLog(getInstance()->getLogger(), flags, type, objHandle, messageCode, fmt, args);
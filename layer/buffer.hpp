@@ -43,6 +43,16 @@ public:
 	VkResult init(VkBuffer buffer_, const VkBufferCreateInfo &createInfo);
 	VkResult bindMemory(DeviceMemory *memory, VkDeviceSize offset);
 
+	VkBuffer getBuffer() const
+	{
+		return buffer;
+	}
+
+	const VkBufferCreateInfo &getCreateInfo() const
+	{
+		return createInfo;
+	}
+
 	const VkMemoryRequirements &getMemoryRequirements() const
 	{
 		return memoryRequirements;
@@ -0,0 +1,851 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "capture.hpp"
+#include <stddef.h>
+#include <string.h>
+
+using namespace std;
+
+namespace MPD
+{
+// A chunk is handed to the writer thread once it grows beyond this size.
+static const size_t CAPTURE_CHUNK_SIZE = 4 * 1024 * 1024;
+// Number of chunks in the ring. If the writer thread falls behind, recording blocks until a chunk is free.
+static const unsigned CAPTURE_CHUNK_COUNT = 4;
+
+CaptureWriter::~CaptureWriter()
+{
+	if (!file)
+		return;
+
+	if (!buffer->empty())
+		submitChunk();
+
+	{
+		lock_guard<mutex> holder{ lock };
+		stopping = true;
+		cond.notify_all();
+	}
+
+	writerThread.join();
+	fclose(file);
+}
+
+bool CaptureWriter::open(const string &path)
+{
+	file = fopen(path.c_str(), "wb");
+	if (!file)
+		return false;
+
+	// Leave some headroom so the chunk does not reallocate for the record which crosses the limit.
+	chunks.resize(CAPTURE_CHUNK_COUNT);
+	for (auto &chunk : chunks)
+		chunk.reserve(CAPTURE_CHUNK_SIZE + 64 * 1024);
+	buffer = &chunks[writeIndex];
+
+	writerThread = thread(&CaptureWriter::writerLoop, this);
+
+	CaptureFileHeader header = { CAPTURE_MAGIC, CAPTURE_VERSION };
+	write(header);
+	return true;
+}
+
+void CaptureWriter::writerLoop()
+{
+	unique_lock<mutex> holder{ lock };
+	for (;;)
+	{
+		cond.wait(holder, [this]() { return pendingCount != 0 || stopping; });
+		if (pendingCount == 0)
+			break;
+
+		// The chunk is owned by this thread until pendingCount is decremented.
+		auto &chunk = chunks[readIndex];
+		holder.unlock();
+		fwrite(chunk.data(), 1, chunk.size(), file);
+		chunk.clear();
+		holder.lock();
+
+		readIndex = (readIndex + 1) % CAPTURE_CHUNK_COUNT;
+		pendingCount--;
+		cond.notify_all();
+	}
+}
+
+void CaptureWriter::submitChunk()
+{
+	unique_lock<mutex> holder{ lock };
+	pendingCount++;
+	cond.notify_all();
+
+	// The next chunk must have been written out before it can be reused.
+	cond.wait(holder, [this]() { return pendingCount < CAPTURE_CHUNK_COUNT; });
+	writeIndex = (writeIndex + 1) % CAPTURE_CHUNK_COUNT;
+	buffer = &chunks[writeIndex];
+}
+
+void CaptureWriter::begin(CaptureOp op)
+{
+	recordOffset = buffer->size();
+	CaptureRecordHeader header = { uint32_t(op), 0 };
+	write(header);
+}
+
+void CaptureWriter::end()
+{
+	uint32_t size = uint32_t(buffer->size() - recordOffset - sizeof(CaptureRecordHeader));
+	memcpy(buffer->data() + recordOffset + offsetof(CaptureRecordHeader, size), &size, sizeof(size));
+
+	if (buffer->size() >= CAPTURE_CHUNK_SIZE)
+		submitChunk();
+}
+
+void CaptureWriter::writeRaw(const void *data, size_t size)
+{
+	auto *bytes = static_cast<const uint8_t *>(data);
+	buffer->insert(buffer->end(), bytes, bytes + size);
+}
+
+void CaptureWriter::writeBlob(const void *data, size_t size)
+{
+	write(uint32_t(size));
+	if (size)
+		writeRaw(data, size);
+}
+
+void CaptureWriter::writeString(const char *str)
+{
+	writeBlob(str, str ? strlen(str) + 1 : 0);
+}
+
+void CaptureWriter::getDeviceQueue(uint32_t familyIndex, uint32_t index, VkQueue queue)
+{
+	begin(CAPTURE_OP_GET_DEVICE_QUEUE);
+	write(familyIndex);
+	write(index);
+	writeHandle(queue);
+	end();
+}
+
+void CaptureWriter::allocateMemory(VkDeviceMemory memory, const VkMemoryAllocateInfo &allocInfo,
+                                   VkMemoryPropertyFlags propertyFlags)
+{
+	// Memory type indices are not portable between devices, so store the properties we need instead.
+	begin(CAPTURE_OP_ALLOCATE_MEMORY);
+	writeHandle(memory);
+	write(allocInfo.allocationSize);
+	write(propertyFlags);
+	end();
+}
+
+void CaptureWriter::createBuffer(VkBuffer buffer, const VkBufferCreateInfo &createInfo)
+{
+	VkBufferCreateInfo info = createInfo;
+	info.pNext = nullptr;
+	info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	info.queueFamilyIndexCount = 0;
+	info.pQueueFamilyIndices = nullptr;
+
+	begin(CAPTURE_OP_CREATE_BUFFER);
+	writeHandle(buffer);
+	write(info);
+	end();
+}
+
+void CaptureWriter::bindBufferMemory(VkBuffer buffer, VkDeviceMemory memory, VkDeviceSize offset)
+{
+	begin(CAPTURE_OP_BIND_BUFFER_MEMORY);
+	writeHandle(buffer);
+	writeHandle(memory);
+	write(offset);
+	end();
+}
+
+void CaptureWriter::createImage(VkImage image, const VkImageCreateInfo &createInfo)
+{
+	VkImageCreateInfo info = createInfo;
+	info.pNext = nullptr;
+	info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	info.queueFamilyIndexCount = 0;
+	info.pQueueFamilyIndices = nullptr;
+
+	begin(CAPTURE_OP_CREATE_IMAGE);
+	writeHandle(image);
+	write(info);
+	end();
+}
+
+void CaptureWriter::createSwapchainImage(VkImage image, const VkImageCreateInfo &createInfo)
+{
+	VkImageCreateInfo info = createInfo;
+	info.pNext = nullptr;
+	info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	info.queueFamilyIndexCount = 0;
+	info.pQueueFamilyIndices = nullptr;
+
+	begin(CAPTURE_OP_CREATE_SWAPCHAIN_IMAGE);
+	writeHandle(image);
+	write(info);
+	end();
+}
+
+void CaptureWriter::bindImageMemory(VkImage image, VkDeviceMemory memory, VkDeviceSize offset)
+{
+	begin(CAPTURE_OP_BIND_IMAGE_MEMORY);
+	writeHandle(image);
+	writeHandle(memory);
+	write(offset);
+	end();
+}
+
+void CaptureWriter::createImageView(VkImageView view, const VkImageViewCreateInfo &createInfo)
+{
+	begin(CAPTURE_OP_CREATE_IMAGE_VIEW);
+	writeHandle(view);
+	writeStruct(createInfo);
+	end();
+}
+
+void CaptureWriter::createSampler(VkSampler sampler, const VkSamplerCreateInfo &createInfo)
+{
+	begin(CAPTURE_OP_CREATE_SAMPLER);
+	writeHandle(sampler);
+	writeStruct(createInfo);
+	end();
+}
+
+void CaptureWriter::createShaderModule(VkShaderModule module, const VkShaderModuleCreateInfo &createInfo)
+{
+	begin(CAPTURE_OP_CREATE_SHADER_MODULE);
+	writeHandle(module);
+	write(createInfo.flags);
+	writeBlob(createInfo.pCode, createInfo.codeSize);
+	end();
+}
+
+void CaptureWriter::createRenderPass(VkRenderPass renderPass, const VkRenderPassCreateInfo &createInfo)
+{
+	begin(CAPTURE_OP_CREATE_RENDER_PASS);
+	writeHandle(renderPass);
+	write(createInfo.flags);
+	writeArray(createInfo.pAttachments, createInfo.attachmentCount);
+
+	write(createInfo.subpassCount);
+	for (uint32_t i = 0; i < createInfo.subpassCount; i++)
+	{
+		const auto &subpass = createInfo.pSubpasses[i];
+		write(subpass.flags);
+		write(subpass.pipelineBindPoint);
+		writeArray(subpass.pInputAttachments, subpass.inputAttachmentCount);
+		writeArray(subpass.pColorAttachments, subpass.colorAttachmentCount);
+		writeArray(subpass.pResolveAttachments, subpass.pResolveAttachments ? subpass.colorAttachmentCount : 0);
+		writeArray(subpass.pDepthStencilAttachment, subpass.pDepthStencilAttachment ? 1 : 0);
+		writeArray(subpass.pPreserveAttachments, subpass.preserveAttachmentCount);
+	}
+
+	writeArray(createInfo.pDependencies, createInfo.dependencyCount);
+	end();
+}
+
+void CaptureWriter::createFramebuffer(VkFramebuffer framebuffer, const VkFramebufferCreateInfo &createInfo)
+{
+	begin(CAPTURE_OP_CREATE_FRAMEBUFFER);
+	writeHandle(framebuffer);
+	write(createInfo.flags);
+	writeHandle(createInfo.renderPass);
+	writeHandleArray(createInfo.pAttachments, createInfo.attachmentCount);
+	write(createInfo.width);
+	write(createInfo.height);
+	write(createInfo.layers);
+	end();
+}
+
+void CaptureWriter::createDescriptorSetLayout(VkDescriptorSetLayout layout,
+                                              const VkDescriptorSetLayoutCreateInfo &createInfo)
+{
+	begin(CAPTURE_OP_CREATE_DESCRIPTOR_SET_LAYOUT);
+	writeHandle(layout);
+	write(createInfo.flags);
+
+	write(createInfo.bindingCount);
+	for (uint32_t i = 0; i < createInfo.bindingCount; i++)
+	{
+		const auto &binding = createInfo.pBindings[i];
+		write(binding.binding);
+		write(binding.descriptorType);
+		write(binding.descriptorCount);
+		write(binding.stageFlags);
+		writeHandleArray(binding.pImmutableSamplers, binding.pImmutableSamplers ? binding.descriptorCount : 0);
+	}
+	end();
+}
+
+void CaptureWriter::createPipelineLayout(VkPipelineLayout layout, const VkPipelineLayoutCreateInfo &createInfo)
+{
+	begin(CAPTURE_OP_CREATE_PIPELINE_LAYOUT);
+	writeHandle(layout);
+	write(createInfo.flags);
+	writeHandleArray(createInfo.pSetLayouts, createInfo.setLayoutCount);
+	writeArray(createInfo.pPushConstantRanges, createInfo.pushConstantRangeCount);
+	end();
+}
+
+void CaptureWriter::writeShaderStage(const VkPipelineShaderStageCreateInfo &stage)
+{
+	write(stage.flags);
+	write(stage.stage);
+	writeHandle(stage.module);
+	writeString(stage.pName);
+
+	const auto *spec = stage.pSpecializationInfo;
+	writeArray(spec ? spec->pMapEntries : nullptr, spec ? spec->mapEntryCount : 0);
+	writeBlob(spec ? spec->pData : nullptr, spec ? spec->dataSize : 0);
+}
+
+void CaptureWriter::createGraphicsPipeline(VkPipeline pipeline, const VkGraphicsPipelineCreateInfo &createInfo)
+{
+	begin(CAPTURE_OP_CREATE_GRAPHICS_PIPELINE);
+	writeHandle(pipeline);
+	write(createInfo.flags);
+
+	write(createInfo.stageCount);
+	for (uint32_t i = 0; i < createInfo.stageCount; i++)
+		writeShaderStage(createInfo.pStages[i]);
+
+	// Optional state blocks are prefixed with a presence flag.
+	// Pointers inside the state blocks are written separately as arrays.
+	const auto *vertexInput = createInfo.pVertexInputState;
+	write(uint32_t(vertexInput != nullptr));
+	if (vertexInput)
+	{
+		writeArray(vertexInput->pVertexBindingDescriptions, vertexInput->vertexBindingDescriptionCount);
+		writeArray(vertexInput->pVertexAttributeDescriptions, vertexInput->vertexAttributeDescriptionCount);
+	}
+
+	write(uint32_t(createInfo.pInputAssemblyState != nullptr));
+	if (createInfo.pInputAssemblyState)
+		writeStruct(*createInfo.pInputAssemblyState);
+
+	write(uint32_t(createInfo.pTessellationState != nullptr));
+	if (createInfo.pTessellationState)
+		writeStruct(*createInfo.pTessellationState);
+
+	const auto *viewport = createInfo.pViewportState;
+	write(uint32_t(viewport != nullptr));
+	if (viewport)
+	{
+		write(viewport->viewportCount);
+		write(viewport->scissorCount);
+		writeArray(viewport->pViewports, viewport->pViewports ? viewport->viewportCount : 0);
+		writeArray(viewport->pScissors, viewport->pScissors ? viewport->scissorCount : 0);
+	}
+
+	write(uint32_t(createInfo.pRasterizationState != nullptr));
+	if (createInfo.pRasterizationState)
+		writeStruct(*createInfo.pRasterizationState);
+
+	const auto *multisample = createInfo.pMultisampleState;
+	write(uint32_t(multisample != nullptr));
+	if (multisample)
+	{
+		VkPipelineMultisampleStateCreateInfo info = *multisample;
+		info.pNext = nullptr;
+		info.pSampleMask = nullptr;
+		write(info);
+
+		uint32_t maskWords = (uint32_t(multisample->rasterizationSamples) + 31) / 32;
+		writeArray(multisample->pSampleMask, multisample->pSampleMask ? maskWords : 0);
+	}
+
+	write(uint32_t(createInfo.pDepthStencilState != nullptr));
+	if (createInfo.pDepthStencilState)
+		writeStruct(*createInfo.pDepthStencilState);
+
+	const auto *colorBlend = createInfo.pColorBlendState;
+	write(uint32_t(colorBlend != nullptr));
+	if (colorBlend)
+	{
+		VkPipelineColorBlendStateCreateInfo info = *colorBlend;
+		info.pNext = nullptr;
+		info.pAttachments = nullptr;
+		write(info);
+		writeArray(colorBlend->pAttachments, colorBlend->attachmentCount);
+	}
+
+	const auto *dynamic = createInfo.pDynamicState;
+	writeArray(dynamic ? dynamic->pDynamicStates : nullptr, dynamic ? dynamic->dynamicStateCount : 0);
+
+	writeHandle(createInfo.layout);
+	writeHandle(createInfo.renderPass);
+	write(createInfo.subpass);
+	end();
+}
+
+void CaptureWriter::createComputePipeline(VkPipeline pipeline, const VkComputePipelineCreateInfo &createInfo)
+{
+	begin(CAPTURE_OP_CREATE_COMPUTE_PIPELINE);
+	writeHandle(pipeline);
+	write(createInfo.flags);
+	writeShaderStage(createInfo.stage);
+	writeHandle(createInfo.layout);
+	end();
+}
+
+void CaptureWriter::createDescriptorPool(VkDescriptorPool pool, const VkDescriptorPoolCreateInfo &createInfo)
+{
+	begin(CAPTURE_OP_CREATE_DESCRIPTOR_POOL);
+	writeHandle(pool);
+	write(createInfo.flags);
+	write(createInfo.maxSets);
+	writeArray(createInfo.pPoolSizes, createInfo.poolSizeCount);
+	end();
+}
+
+void CaptureWriter::allocateDescriptorSets(const VkDescriptorSetAllocateInfo &allocInfo, const VkDescriptorSet *pSets)
+{
+	begin(CAPTURE_OP_ALLOCATE_DESCRIPTOR_SETS);
+	writeHandle(allocInfo.descriptorPool);
+	writeHandleArray(allocInfo.pSetLayouts, allocInfo.descriptorSetCount);
+	writeHandleArray(pSets, allocInfo.descriptorSetCount);
+	end();
+}
+
+void CaptureWriter::freeDescriptorSets(VkDescriptorPool pool, uint32_t count, const VkDescriptorSet *pSets)
+{
+	begin(CAPTURE_OP_FREE_DESCRIPTOR_SETS);
+	writeHandle(pool);
+	writeHandleArray(pSets, count);
+	end();
+}
+
+void CaptureWriter::updateDescriptorSets(uint32_t writeCount, const VkWriteDescriptorSet *pWrites, uint32_t copyCount,
+                                         const VkCopyDescriptorSet *pCopies)
+{
+	begin(CAPTURE_OP_UPDATE_DESCRIPTOR_SETS);
+
+	write(writeCount);
+	for (uint32_t i = 0; i < writeCount; i++)
+	{
+		const auto &w = pWrites[i];
+		writeHandle(w.dstSet);
+		write(w.dstBinding);
+		write(w.dstArrayElement);
+		write(w.descriptorType);
+
+		switch (w.descriptorType)
+		{
+		case VK_DESCRIPTOR_TYPE_SAMPLER:
+		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+		case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+		case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+		case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+			writeArray(w.pImageInfo, w.descriptorCount);
+			break;
+
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+			writeArray(w.pBufferInfo, w.descriptorCount);
+			break;
+
+		default:
+			// Texel buffer views are not tracked by the capture, only the count is kept.
+			write(w.descriptorCount);
+			break;
+		}
+	}
+
+	write(copyCount);
+	for (uint32_t i = 0; i < copyCount; i++)
+		writeStruct(pCopies[i]);
+
+	end();
+}
+
+void CaptureWriter::createCommandPool(VkCommandPool pool, const VkCommandPoolCreateInfo &createInfo)
+{
+	begin(CAPTURE_OP_CREATE_COMMAND_POOL);
+	writeHandle(pool);
+	write(createInfo.flags);
+	write(createInfo.queueFamilyIndex);
+	end();
+}
+
+void CaptureWriter::allocateCommandBuffers(const VkCommandBufferAllocateInfo &allocInfo,
+                                           const VkCommandBuffer *pCommandBuffers)
+{
+	begin(CAPTURE_OP_ALLOCATE_COMMAND_BUFFERS);
+	writeHandle(allocInfo.commandPool);
+	write(allocInfo.level);
+	writeHandleArray(pCommandBuffers, allocInfo.commandBufferCount);
+	end();
+}
+
+void CaptureWriter::freeCommandBuffers(VkCommandPool pool, uint32_t count, const VkCommandBuffer *pCommandBuffers)
+{
+	begin(CAPTURE_OP_FREE_COMMAND_BUFFERS);
+	writeHandle(pool);
+	writeHandleArray(pCommandBuffers, count);
+	end();
+}
+
+void CaptureWriter::beginCommandBuffer(VkCommandBuffer commandBuffer, const VkCommandBufferBeginInfo &beginInfo)
+{
+	const auto *inheritance = beginInfo.pInheritanceInfo;
+
+	begin(CAPTURE_OP_BEGIN_COMMAND_BUFFER);
+	writeHandle(commandBuffer);
+	write(beginInfo.flags);
+	write(uint32_t(inheritance != nullptr));
+	if (inheritance)
+		writeStruct(*inheritance);
+	end();
+}
+
+void CaptureWriter::cmdBeginRenderPass(VkCommandBuffer commandBuffer, const VkRenderPassBeginInfo &beginInfo,
+                                       VkSubpassContents contents)
+{
+	begin(CAPTURE_OP_CMD_BEGIN_RENDER_PASS);
+	writeHandle(commandBuffer);
+	writeHandle(beginInfo.renderPass);
+	writeHandle(beginInfo.framebuffer);
+	write(beginInfo.renderArea);
+	writeArray(beginInfo.pClearValues, beginInfo.clearValueCount);
+	write(contents);
+	end();
+}
+
+void CaptureWriter::cmdNextSubpass(VkCommandBuffer commandBuffer, VkSubpassContents contents)
+{
+	begin(CAPTURE_OP_CMD_NEXT_SUBPASS);
+	writeHandle(commandBuffer);
+	write(contents);
+	end();
+}
+
+void CaptureWriter::cmdExecuteCommands(VkCommandBuffer commandBuffer, uint32_t count,
+                                       const VkCommandBuffer *pCommandBuffers)
+{
+	begin(CAPTURE_OP_CMD_EXECUTE_COMMANDS);
+	writeHandle(commandBuffer);
+	writeHandleArray(pCommandBuffers, count);
+	end();
+}
+
+void CaptureWriter::cmdBindPipeline(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipeline pipeline)
+{
+	begin(CAPTURE_OP_CMD_BIND_PIPELINE);
+	writeHandle(commandBuffer);
+	write(bindPoint);
+	writeHandle(pipeline);
+	end();
+}
+
+void CaptureWriter::cmdBindDescriptorSets(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint,
+                                          VkPipelineLayout layout, uint32_t firstSet, uint32_t setCount,
+                                          const VkDescriptorSet *pSets, uint32_t dynamicOffsetCount,
+                                          const uint32_t *pDynamicOffsets)
+{
+	begin(CAPTURE_OP_CMD_BIND_DESCRIPTOR_SETS);
+	writeHandle(commandBuffer);
+	write(bindPoint);
+	writeHandle(layout);
+	write(firstSet);
+	writeHandleArray(pSets, setCount);
+	writeArray(pDynamicOffsets, dynamicOffsetCount);
+	end();
+}
+
+void CaptureWriter::cmdBindIndexBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset,
+                                       VkIndexType indexType)
+{
+	begin(CAPTURE_OP_CMD_BIND_INDEX_BUFFER);
+	writeHandle(commandBuffer);
+	writeHandle(buffer);
+	write(offset);
+	write(indexType);
+	end();
+}
+
+void CaptureWriter::cmdBindVertexBuffers(VkCommandBuffer commandBuffer, uint32_t firstBinding, uint32_t bindingCount,
+                                         const VkBuffer *pBuffers, const VkDeviceSize *pOffsets)
+{
+	begin(CAPTURE_OP_CMD_BIND_VERTEX_BUFFERS);
+	writeHandle(commandBuffer);
+	write(firstBinding);
+	writeHandleArray(pBuffers, bindingCount);
+	writeArray(pOffsets, bindingCount);
+	end();
+}
+
+void CaptureWriter::cmdSetViewport(VkCommandBuffer commandBuffer, uint32_t firstViewport, uint32_t count,
+                                   const VkViewport *pViewports)
+{
+	begin(CAPTURE_OP_CMD_SET_VIEWPORT);
+	writeHandle(commandBuffer);
+	write(firstViewport);
+	writeArray(pViewports, count);
+	end();
+}
+
+void CaptureWriter::cmdSetScissor(VkCommandBuffer commandBuffer, uint32_t firstScissor, uint32_t count,
+                                  const VkRect2D *pScissors)
+{
+	begin(CAPTURE_OP_CMD_SET_SCISSOR);
+	writeHandle(commandBuffer);
+	write(firstScissor);
+	writeArray(pScissors, count);
+	end();
+}
+
+void CaptureWriter::cmdPushConstants(VkCommandBuffer commandBuffer, VkPipelineLayout layout,
+                                     VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size,
+                                     const void *pValues)
+{
+	begin(CAPTURE_OP_CMD_PUSH_CONSTANTS);
+	writeHandle(commandBuffer);
+	writeHandle(layout);
+	write(stageFlags);
+	write(offset);
+	writeBlob(pValues, size);
+	end();
+}
+
+void CaptureWriter::indexData(VkBuffer buffer, VkDeviceSize offset, const void *data, size_t size)
+{
+	begin(CAPTURE_OP_INDEX_DATA);
+	writeHandle(buffer);
+	write(offset);
+	writeBlob(data, size);
+	end();
+}
+
+void CaptureWriter::cmdDraw(VkCommandBuffer commandBuffer, uint32_t vertexCount, uint32_t instanceCount,
+                            uint32_t firstVertex, uint32_t firstInstance)
+{
+	begin(CAPTURE_OP_CMD_DRAW);
+	writeHandle(commandBuffer);
+	write(vertexCount);
+	write(instanceCount);
+	write(firstVertex);
+	write(firstInstance);
+	end();
+}
+
+void CaptureWriter::cmdDrawIndexed(VkCommandBuffer commandBuffer, uint32_t indexCount, uint32_t instanceCount,
+                                   uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance)
+{
+	begin(CAPTURE_OP_CMD_DRAW_INDEXED);
+	writeHandle(commandBuffer);
+	write(indexCount);
+	write(instanceCount);
+	write(firstIndex);
+	write(vertexOffset);
+	write(firstInstance);
+	end();
+}
+
+void CaptureWriter::cmdDrawIndirect(CaptureOp op, VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset,
+                                    uint32_t drawCount, uint32_t stride)
+{
+	MPD_ASSERT(op == CAPTURE_OP_CMD_DRAW_INDIRECT || op == CAPTURE_OP_CMD_DRAW_INDEXED_INDIRECT);
+	begin(op);
+	writeHandle(commandBuffer);
+	writeHandle(buffer);
+	write(offset);
+	write(drawCount);
+	write(stride);
+	end();
+}
+
+void CaptureWriter::cmdDispatch(VkCommandBuffer commandBuffer, uint32_t x, uint32_t y, uint32_t z)
+{
+	begin(CAPTURE_OP_CMD_DISPATCH);
+	writeHandle(commandBuffer);
+	write(x);
+	write(y);
+	write(z);
+	end();
+}
+
+void CaptureWriter::cmdDispatchIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset)
+{
+	begin(CAPTURE_OP_CMD_DISPATCH_INDIRECT);
+	writeHandle(commandBuffer);
+	writeHandle(buffer);
+	write(offset);
+	end();
+}
+
+void CaptureWriter::cmdPipelineBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask,
+                                       VkPipelineStageFlags dstStageMask, VkDependencyFlags dependencyFlags,
+                                       uint32_t memoryBarrierCount, const VkMemoryBarrier *pMemoryBarriers,
+                                       uint32_t bufferMemoryBarrierCount,
+                                       const VkBufferMemoryBarrier *pBufferMemoryBarriers,
+                                       uint32_t imageMemoryBarrierCount,
+                                       const VkImageMemoryBarrier *pImageMemoryBarriers)
+{
+	begin(CAPTURE_OP_CMD_PIPELINE_BARRIER);
+	writeHandle(commandBuffer);
+	write(srcStageMask);
+	write(dstStageMask);
+	write(dependencyFlags);
+
+	write(memoryBarrierCount);
+	for (uint32_t i = 0; i < memoryBarrierCount; i++)
+		writeStruct(pMemoryBarriers[i]);
+	write(bufferMemoryBarrierCount);
+	for (uint32_t i = 0; i < bufferMemoryBarrierCount; i++)
+		writeStruct(pBufferMemoryBarriers[i]);
+	write(imageMemoryBarrierCount);
+	for (uint32_t i = 0; i < imageMemoryBarrierCount; i++)
+		writeStruct(pImageMemoryBarriers[i]);
+	end();
+}
+
+void CaptureWriter::cmdClearColorImage(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout layout,
+                                       const VkClearColorValue &color, uint32_t rangeCount,
+                                       const VkImageSubresourceRange *pRanges)
+{
+	begin(CAPTURE_OP_CMD_CLEAR_COLOR_IMAGE);
+	writeHandle(commandBuffer);
+	writeHandle(image);
+	write(layout);
+	write(color);
+	writeArray(pRanges, rangeCount);
+	end();
+}
+
+void CaptureWriter::cmdClearDepthStencilImage(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout layout,
+                                              const VkClearDepthStencilValue &value, uint32_t rangeCount,
+                                              const VkImageSubresourceRange *pRanges)
+{
+	begin(CAPTURE_OP_CMD_CLEAR_DEPTH_STENCIL_IMAGE);
+	writeHandle(commandBuffer);
+	writeHandle(image);
+	write(layout);
+	write(value);
+	writeArray(pRanges, rangeCount);
+	end();
+}
+
+void CaptureWriter::cmdClearAttachments(VkCommandBuffer commandBuffer, uint32_t attachmentCount,
+                                        const VkClearAttachment *pAttachments, uint32_t rectCount,
+                                        const VkClearRect *pRects)
+{
+	begin(CAPTURE_OP_CMD_CLEAR_ATTACHMENTS);
+	writeHandle(commandBuffer);
+	writeArray(pAttachments, attachmentCount);
+	writeArray(pRects, rectCount);
+	end();
+}
+
+void CaptureWriter::cmdCopyBuffer(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkBuffer dstBuffer,
+                                  uint32_t regionCount, const VkBufferCopy *pRegions)
+{
+	begin(CAPTURE_OP_CMD_COPY_BUFFER);
+	writeHandle(commandBuffer);
+	writeHandle(srcBuffer);
+	writeHandle(dstBuffer);
+	writeArray(pRegions, regionCount);
+	end();
+}
+
+void CaptureWriter::cmdCopyImage(CaptureOp op, VkCommandBuffer commandBuffer, VkImage srcImage,
+                                 VkImageLayout srcLayout, VkImage dstImage, VkImageLayout dstLayout,
+                                 uint32_t regionCount, const void *pRegions, size_t regionSize)
+{
+	// vkCmdCopyImage and vkCmdResolveImage only differ in the region type.
+	MPD_ASSERT(op == CAPTURE_OP_CMD_COPY_IMAGE || op == CAPTURE_OP_CMD_RESOLVE_IMAGE);
+	begin(op);
+	writeHandle(commandBuffer);
+	writeHandle(srcImage);
+	write(srcLayout);
+	writeHandle(dstImage);
+	write(dstLayout);
+	write(regionCount);
+	writeRaw(pRegions, regionCount * regionSize);
+	end();
+}
+
+void CaptureWriter::cmdBlitImage(VkCommandBuffer commandBuffer, VkImage srcImage, VkImageLayout srcLayout,
+                                 VkImage dstImage, VkImageLayout dstLayout, uint32_t regionCount,
+                                 const VkImageBlit *pRegions, VkFilter filter)
+{
+	begin(CAPTURE_OP_CMD_BLIT_IMAGE);
+	writeHandle(commandBuffer);
+	writeHandle(srcImage);
+	write(srcLayout);
+	writeHandle(dstImage);
+	write(dstLayout);
+	writeArray(pRegions, regionCount);
+	write(filter);
+	end();
+}
+
+void CaptureWriter::cmdCopyBufferImage(CaptureOp op, VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image,
+                                       VkImageLayout layout, uint32_t regionCount, const VkBufferImageCopy *pRegions)
+{
+	MPD_ASSERT(op == CAPTURE_OP_CMD_COPY_BUFFER_TO_IMAGE || op == CAPTURE_OP_CMD_COPY_IMAGE_TO_BUFFER);
+	begin(op);
+	writeHandle(commandBuffer);
+	writeHandle(buffer);
+	writeHandle(image);
+	write(layout);
+	writeArray(pRegions, regionCount);
+	end();
+}
+
+void CaptureWriter::cmdFillBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset,
+                                  VkDeviceSize size, uint32_t data)
+{
+	begin(CAPTURE_OP_CMD_FILL_BUFFER);
+	writeHandle(commandBuffer);
+	writeHandle(buffer);
+	write(offset);
+	write(size);
+	write(data);
+	end();
+}
+
+void CaptureWriter::cmdUpdateBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset,
+                                    VkDeviceSize size, const void *pData)
+{
+	begin(CAPTURE_OP_CMD_UPDATE_BUFFER);
+	writeHandle(commandBuffer);
+	writeHandle(buffer);
+	write(offset);
+	writeBlob(pData, size_t(size));
+	end();
+}
+
+void CaptureWriter::queueSubmit(VkQueue queue, uint32_t submitCount, const VkSubmitInfo *pSubmits)
+{
+	// Semaphores and fences are not captured, replay serializes all submissions.
+	begin(CAPTURE_OP_QUEUE_SUBMIT);
+	writeHandle(queue);
+	write(submitCount);
+	for (uint32_t i = 0; i < submitCount; i++)
+		writeHandleArray(pSubmits[i].pCommandBuffers, pSubmits[i].commandBufferCount);
+	end();
+}
+}
@@ -0,0 +1,210 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "capture_format.hpp"
+#include "perfdoc.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace MPD
+{
+
+/// Serializes the intercepted API stream of a device into a capture file which can be replayed later.
+///
+/// All entry points are called with the global layer lock held, so records are written in the same order
+/// as the layer observed the calls.
+/// Records are appended to a ring of fixed size chunks, which a background thread writes to disk,
+/// so recording a command is little more than a memcpy on the calling thread.
+class CaptureWriter
+{
+public:
+	CaptureWriter() = default;
+	~CaptureWriter();
+
+	CaptureWriter(const CaptureWriter &) = delete;
+	void operator=(const CaptureWriter &) = delete;
+
+	bool open(const std::string &path);
+
+	void getDeviceQueue(uint32_t familyIndex, uint32_t index, VkQueue queue);
+
+	void allocateMemory(VkDeviceMemory memory, const VkMemoryAllocateInfo &allocInfo,
+	                    VkMemoryPropertyFlags propertyFlags);
+	void createBuffer(VkBuffer buffer, const VkBufferCreateInfo &createInfo);
+	void bindBufferMemory(VkBuffer buffer, VkDeviceMemory memory, VkDeviceSize offset);
+	void createImage(VkImage image, const VkImageCreateInfo &createInfo);
+	void createSwapchainImage(VkImage image, const VkImageCreateInfo &createInfo);
+	void bindImageMemory(VkImage image, VkDeviceMemory memory, VkDeviceSize offset);
+	void createImageView(VkImageView view, const VkImageViewCreateInfo &createInfo);
+	void createSampler(VkSampler sampler, const VkSamplerCreateInfo &createInfo);
+	void createShaderModule(VkShaderModule module, const VkShaderModuleCreateInfo &createInfo);
+	void createRenderPass(VkRenderPass renderPass, const VkRenderPassCreateInfo &createInfo);
+	void createFramebuffer(VkFramebuffer framebuffer, const VkFramebufferCreateInfo &createInfo);
+	void createDescriptorSetLayout(VkDescriptorSetLayout layout, const VkDescriptorSetLayoutCreateInfo &createInfo);
+	void createPipelineLayout(VkPipelineLayout layout, const VkPipelineLayoutCreateInfo &createInfo);
+	void createGraphicsPipeline(VkPipeline pipeline, const VkGraphicsPipelineCreateInfo &createInfo);
+	void createComputePipeline(VkPipeline pipeline, const VkComputePipelineCreateInfo &createInfo);
+	void createDescriptorPool(VkDescriptorPool pool, const VkDescriptorPoolCreateInfo &createInfo);
+	void allocateDescriptorSets(const VkDescriptorSetAllocateInfo &allocInfo, const VkDescriptorSet *pSets);
+	void freeDescriptorSets(VkDescriptorPool pool, uint32_t count, const VkDescriptorSet *pSets);
+	void updateDescriptorSets(uint32_t writeCount, const VkWriteDescriptorSet *pWrites, uint32_t copyCount,
+	                          const VkCopyDescriptorSet *pCopies);
+	void createCommandPool(VkCommandPool pool, const VkCommandPoolCreateInfo &createInfo);
+	void allocateCommandBuffers(const VkCommandBufferAllocateInfo &allocInfo, const VkCommandBuffer *pCommandBuffers);
+	void freeCommandBuffers(VkCommandPool pool, uint32_t count, const VkCommandBuffer *pCommandBuffers);
+
+	/// Records any call which only needs a single handle to replay, i.e. destruction, resets and vkEndCommandBuffer.
+	template <typename T>
+	void destroyObject(CaptureOp op, T handle)
+	{
+		begin(op);
+		writeHandle(handle);
+		end();
+	}
+
+	void beginCommandBuffer(VkCommandBuffer commandBuffer, const VkCommandBufferBeginInfo &beginInfo);
+	void cmdBeginRenderPass(VkCommandBuffer commandBuffer, const VkRenderPassBeginInfo &beginInfo,
+	                        VkSubpassContents contents);
+	void cmdNextSubpass(VkCommandBuffer commandBuffer, VkSubpassContents contents);
+	void cmdExecuteCommands(VkCommandBuffer commandBuffer, uint32_t count, const VkCommandBuffer *pCommandBuffers);
+	void cmdBindPipeline(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipeline pipeline);
+	void cmdBindDescriptorSets(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout layout,
+	                           uint32_t firstSet, uint32_t setCount, const VkDescriptorSet *pSets,
+	                           uint32_t dynamicOffsetCount, const uint32_t *pDynamicOffsets);
+	void cmdBindIndexBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset,
+	                        VkIndexType indexType);
+	void cmdBindVertexBuffers(VkCommandBuffer commandBuffer, uint32_t firstBinding, uint32_t bindingCount,
+	                          const VkBuffer *pBuffers, const VkDeviceSize *pOffsets);
+	void cmdSetViewport(VkCommandBuffer commandBuffer, uint32_t firstViewport, uint32_t count,
+	                    const VkViewport *pViewports);
+	void cmdSetScissor(VkCommandBuffer commandBuffer, uint32_t firstScissor, uint32_t count, const VkRect2D *pScissors);
+	void cmdPushConstants(VkCommandBuffer commandBuffer, VkPipelineLayout layout, VkShaderStageFlags stageFlags,
+	                      uint32_t offset, uint32_t size, const void *pValues);
+
+	/// Snapshot of index buffer contents read through persistently mapped memory.
+	/// Replay writes this data back before the draw which consumes it.
+	void indexData(VkBuffer buffer, VkDeviceSize offset, const void *data, size_t size);
+
+	void cmdDraw(VkCommandBuffer commandBuffer, uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex,
+	             uint32_t firstInstance);
+	void cmdDrawIndexed(VkCommandBuffer commandBuffer, uint32_t indexCount, uint32_t instanceCount,
+	                    uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance);
+	void cmdDrawIndirect(CaptureOp op, VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset,
+	                     uint32_t drawCount, uint32_t stride);
+	void cmdDispatch(VkCommandBuffer commandBuffer, uint32_t x, uint32_t y, uint32_t z);
+	void cmdDispatchIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset);
+	void cmdPipelineBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask,
+	                        VkPipelineStageFlags dstStageMask, VkDependencyFlags dependencyFlags,
+	                        uint32_t memoryBarrierCount, const VkMemoryBarrier *pMemoryBarriers,
+	                        uint32_t bufferMemoryBarrierCount, const VkBufferMemoryBarrier *pBufferMemoryBarriers,
+	                        uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier *pImageMemoryBarriers);
+	void cmdClearColorImage(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout layout,
+	                        const VkClearColorValue &color, uint32_t rangeCount,
+	                        const VkImageSubresourceRange *pRanges);
+	void cmdClearDepthStencilImage(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout layout,
+	                               const VkClearDepthStencilValue &value, uint32_t rangeCount,
+	                               const VkImageSubresourceRange *pRanges);
+	void cmdClearAttachments(VkCommandBuffer commandBuffer, uint32_t attachmentCount,
+	                         const VkClearAttachment *pAttachments, uint32_t rectCount, const VkClearRect *pRects);
+	void cmdCopyBuffer(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkBuffer dstBuffer, uint32_t regionCount,
+	                   const VkBufferCopy *pRegions);
+	void cmdCopyImage(CaptureOp op, VkCommandBuffer commandBuffer, VkImage srcImage, VkImageLayout srcLayout,
+	                  VkImage dstImage, VkImageLayout dstLayout, uint32_t regionCount, const void *pRegions,
+	                  size_t regionSize);
+	void cmdBlitImage(VkCommandBuffer commandBuffer, VkImage srcImage, VkImageLayout srcLayout, VkImage dstImage,
+	                  VkImageLayout dstLayout, uint32_t regionCount, const VkImageBlit *pRegions, VkFilter filter);
+	void cmdCopyBufferImage(CaptureOp op, VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image,
+	                        VkImageLayout layout, uint32_t regionCount, const VkBufferImageCopy *pRegions);
+	void cmdFillBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size,
+	                   uint32_t data);
+	void cmdUpdateBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size,
+	                     const void *pData);
+
+	void queueSubmit(VkQueue queue, uint32_t submitCount, const VkSubmitInfo *pSubmits);
+
+private:
+	FILE *file = nullptr;
+	size_t recordOffset = 0;
+
+	std::vector<std::vector<uint8_t>> chunks;
+	std::vector<uint8_t> *buffer = nullptr;
+	unsigned writeIndex = 0;
+	unsigned readIndex = 0;
+	unsigned pendingCount = 0;
+	bool stopping = false;
+
+	std::mutex lock;
+	std::condition_variable cond;
+	std::thread writerThread;
+
+	void begin(CaptureOp op);
+	void end();
+	void submitChunk();
+	void writerLoop();
+
+	void writeRaw(const void *data, size_t size);
+	void writeBlob(const void *data, size_t size);
+	void writeString(const char *str);
+	void writeShaderStage(const VkPipelineShaderStageCreateInfo &stage);
+
+	template <typename T>
+	void write(const T &value)
+	{
+		writeRaw(&value, sizeof(T));
+	}
+
+	template <typename T>
+	void writeHandle(T handle)
+	{
+		write<uint64_t>((uint64_t)handle);
+	}
+
+	template <typename T>
+	void writeArray(const T *values, uint32_t count)
+	{
+		write(count);
+		if (count)
+			writeRaw(values, count * sizeof(T));
+	}
+
+	template <typename T>
+	void writeHandleArray(const T *handles, uint32_t count)
+	{
+		write(count);
+		for (uint32_t i = 0; i < count; i++)
+			writeHandle(handles ? handles[i] : T(VK_NULL_HANDLE));
+	}
+
+	/// Writes a struct with its pNext pointer cleared.
+	template <typename T>
+	void writeStruct(const T &value)
+	{
+		T copy = value;
+		copy.pNext = nullptr;
+		write(copy);
+	}
+};
+}
@@ -0,0 +1,131 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#include <stdint.h>
+
+namespace MPD
+{
+/// Binary layout of API capture files written by the layer (see captureFilename in the config file).
+///
+/// A capture starts with a CaptureFileHeader, followed by a tightly packed sequence of records.
+/// Each record is a CaptureRecordHeader followed by `size` bytes of payload.
+/// Payloads are streams of little helpers written by CaptureWriter:
+///  - scalars and plain structs are written as raw bytes, pointers in structs are always zeroed,
+///  - arrays are a uint32_t count followed by the raw elements,
+///  - Vulkan handles are always stored as uint64_t,
+///  - blobs (SPIR-V, index data, push constants) are a uint32_t byte count followed by the bytes.
+/// The format is native endian and is only intended to be replayed on the same kind of platform it was captured on.
+static const uint32_t CAPTURE_MAGIC = 0x4350504d; // "MPPC"
+static const uint32_t CAPTURE_VERSION = 1;
+
+struct CaptureFileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+};
+
+struct CaptureRecordHeader
+{
+	uint32_t op;
+	uint32_t size;
+};
+
+enum CaptureOp
+{
+	CAPTURE_OP_GET_DEVICE_QUEUE = 1,
+
+	CAPTURE_OP_ALLOCATE_MEMORY,
+	CAPTURE_OP_FREE_MEMORY,
+	CAPTURE_OP_CREATE_BUFFER,
+	CAPTURE_OP_DESTROY_BUFFER,
+	CAPTURE_OP_BIND_BUFFER_MEMORY,
+	CAPTURE_OP_CREATE_IMAGE,
+	CAPTURE_OP_CREATE_SWAPCHAIN_IMAGE,
+	CAPTURE_OP_DESTROY_IMAGE,
+	CAPTURE_OP_BIND_IMAGE_MEMORY,
+	CAPTURE_OP_CREATE_IMAGE_VIEW,
+	CAPTURE_OP_DESTROY_IMAGE_VIEW,
+	CAPTURE_OP_CREATE_SAMPLER,
+	CAPTURE_OP_DESTROY_SAMPLER,
+	CAPTURE_OP_CREATE_SHADER_MODULE,
+	CAPTURE_OP_DESTROY_SHADER_MODULE,
+	CAPTURE_OP_CREATE_RENDER_PASS,
+	CAPTURE_OP_DESTROY_RENDER_PASS,
+	CAPTURE_OP_CREATE_FRAMEBUFFER,
+	CAPTURE_OP_DESTROY_FRAMEBUFFER,
+	CAPTURE_OP_CREATE_DESCRIPTOR_SET_LAYOUT,
+	CAPTURE_OP_DESTROY_DESCRIPTOR_SET_LAYOUT,
+	CAPTURE_OP_CREATE_PIPELINE_LAYOUT,
+	CAPTURE_OP_DESTROY_PIPELINE_LAYOUT,
+	CAPTURE_OP_CREATE_GRAPHICS_PIPELINE,
+	CAPTURE_OP_CREATE_COMPUTE_PIPELINE,
+	CAPTURE_OP_DESTROY_PIPELINE,
+	CAPTURE_OP_CREATE_DESCRIPTOR_POOL,
+	CAPTURE_OP_DESTROY_DESCRIPTOR_POOL,
+	CAPTURE_OP_RESET_DESCRIPTOR_POOL,
+	CAPTURE_OP_ALLOCATE_DESCRIPTOR_SETS,
+	CAPTURE_OP_FREE_DESCRIPTOR_SETS,
+	CAPTURE_OP_UPDATE_DESCRIPTOR_SETS,
+	CAPTURE_OP_CREATE_COMMAND_POOL,
+	CAPTURE_OP_DESTROY_COMMAND_POOL,
+	CAPTURE_OP_ALLOCATE_COMMAND_BUFFERS,
+	CAPTURE_OP_FREE_COMMAND_BUFFERS,
+	CAPTURE_OP_RESET_COMMAND_POOL,
+	CAPTURE_OP_RESET_COMMAND_BUFFER,
+
+	CAPTURE_OP_BEGIN_COMMAND_BUFFER,
+	CAPTURE_OP_END_COMMAND_BUFFER,
+	CAPTURE_OP_CMD_BEGIN_RENDER_PASS,
+	CAPTURE_OP_CMD_NEXT_SUBPASS,
+	CAPTURE_OP_CMD_END_RENDER_PASS,
+	CAPTURE_OP_CMD_EXECUTE_COMMANDS,
+	CAPTURE_OP_CMD_BIND_PIPELINE,
+	CAPTURE_OP_CMD_BIND_DESCRIPTOR_SETS,
+	CAPTURE_OP_CMD_BIND_INDEX_BUFFER,
+	CAPTURE_OP_CMD_BIND_VERTEX_BUFFERS,
+	CAPTURE_OP_CMD_SET_VIEWPORT,
+	CAPTURE_OP_CMD_SET_SCISSOR,
+	CAPTURE_OP_CMD_PUSH_CONSTANTS,
+	CAPTURE_OP_INDEX_DATA,
+	CAPTURE_OP_CMD_DRAW,
+	CAPTURE_OP_CMD_DRAW_INDEXED,
+	CAPTURE_OP_CMD_DRAW_INDIRECT,
+	CAPTURE_OP_CMD_DRAW_INDEXED_INDIRECT,
+	CAPTURE_OP_CMD_DISPATCH,
+	CAPTURE_OP_CMD_DISPATCH_INDIRECT,
+	CAPTURE_OP_CMD_PIPELINE_BARRIER,
+	CAPTURE_OP_CMD_CLEAR_COLOR_IMAGE,
+	CAPTURE_OP_CMD_CLEAR_DEPTH_STENCIL_IMAGE,
+	CAPTURE_OP_CMD_CLEAR_ATTACHMENTS,
+	CAPTURE_OP_CMD_COPY_BUFFER,
+	CAPTURE_OP_CMD_COPY_IMAGE,
+	CAPTURE_OP_CMD_COPY_BUFFER_TO_IMAGE,
+	CAPTURE_OP_CMD_COPY_IMAGE_TO_BUFFER,
+	CAPTURE_OP_CMD_BLIT_IMAGE,
+	CAPTURE_OP_CMD_RESOLVE_IMAGE,
+	CAPTURE_OP_CMD_FILL_BUFFER,
+	CAPTURE_OP_CMD_UPDATE_BUFFER,
+
+	CAPTURE_OP_QUEUE_SUBMIT,
+
+	CAPTURE_OP_COUNT
+};
+}
@@ -20,6 +20,7 @@
 
 #include "commandbuffer.hpp"
 #include "buffer.hpp"
+#include "capture.hpp"
 #include "device.hpp"
 #include "device_memory.hpp"
 #include "message_codes.hpp"
@@ -43,11 +44,27 @@ namespace MPD
 {
 CommandBuffer::CommandBuffer(Device *device, uint64_t objHandle_)
     : BaseObject(device, objHandle_, VULKAN_OBJECT_TYPE)
+    , depthPrePassHeuristic(this, device)
+    , tileReadbackHeuristic(this, device)
+    , clearAttachmentsHeuristic(this, device)
 {
 	// register heuristics
-	heuristics.emplace_back(new DepthPrePassHeuristic(this, device));
-	heuristics.emplace_back(new TileReadbackHeuristic(this, device));
-	heuristics.emplace_back(new ClearAttachmentsHeuristic(this, device));
+	registerHeuristic(&depthPrePassHeuristic);
+	registerHeuristic(&tileReadbackHeuristic);
+	registerHeuristic(&clearAttachmentsHeuristic);
+
+	// The binding arrays are sized once, reset() only clears them.
+	uint32_t maxSets = device->getProperties().limits.maxBoundDescriptorSets;
+	graphicsDescriptorSets.resize(maxSets);
+	computeDescriptorSets.resize(maxSets);
+}
+
+void CommandBuffer::registerHeuristic(Heuristic *heuristic)
+{
+	HeuristicEventMask events = heuristic->getEvents();
+	for (unsigned event = 0; event < HEURISTIC_EVENT_COUNT; event++)
+		if (events & heuristicEventBit(HeuristicEvent(event)))
+			eventHeuristics[event].add(heuristic);
 }
 
 VkResult CommandBuffer::init(VkCommandBuffer commandBuffer_, CommandPool *commandPool_)
@@ -64,18 +81,24 @@ void CommandBuffer::reset()
 	indexOffset = 0;
 	executedCommandBuffers.clear();
 	deferredFunctions.clear();
+	renderPassInstances.clear();
+	transferBandwidth = BandwidthEstimate();
 	smallIndexedDrawcallCount = 0;
+	binds = {};
+	redundantBinds = {};
+	boundPipelines[0] = VK_NULL_HANDLE;
+	boundPipelines[1] = VK_NULL_HANDLE;
+	graphicsPipeline = nullptr;
+	pipelineDraws.clear();
+	drawStateKeys.clear();
 	currentRenderPass = nullptr;
 	currentSubpassIndex = 0;
 
-	for (auto &it : heuristics)
+	for (auto *it : eventHeuristics[HEURISTIC_EVENT_RESET])
 		it->reset();
 
-	graphicsDescriptorSets.clear();
-	computeDescriptorSets.clear();
-	uint32_t maxSets = baseDevice->getProperties().limits.maxBoundDescriptorSets;
-	graphicsDescriptorSets.resize(maxSets);
-	computeDescriptorSets.resize(maxSets);
+	fill(begin(graphicsDescriptorSets), end(graphicsDescriptorSets), DescriptorSetInfo());
+	fill(begin(computeDescriptorSets), end(computeDescriptorSets), DescriptorSetInfo());
 	graphicsLayout = nullptr;
 	computeLayout = nullptr;
 }
@@ -118,22 +141,53 @@ void CommandBuffer::enqueueGraphicsDescriptorSetUsage()
 	}
 }
 
-void CommandBuffer::bindDescriptorSets(VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout, uint32_t firstSet,
-                                       uint32_t descriptorSetCount, const VkDescriptorSet *pDescriptorSets, uint32_t,
-                                       const uint32_t *)
+void CommandBuffer::bindDescriptorSets(VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout layout,
+                                       uint32_t firstSet, uint32_t descriptorSetCount,
+                                       const VkDescriptorSet *pDescriptorSets, uint32_t dynamicOffsetCount,
+                                       const uint32_t *pDynamicOffsets)
 {
 	auto &sets = pipelineBindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS ? graphicsDescriptorSets : computeDescriptorSets;
+	bool redundant = true;
+	uint32_t dynamicOffset = 0;
 
 	for (uint32_t i = 0; i < descriptorSetCount; i++)
 	{
 		MPD_ASSERT(i + firstSet < sets.size());
-		sets[i + firstSet].set = baseDevice->get<DescriptorSet>(pDescriptorSets[i]);
-		sets[i + firstSet].dirty = true;
+		auto *set = baseDevice->get<DescriptorSet>(pDescriptorSets[i]);
+
+		// FNV-1a over the dynamic offsets this set consumes, they are part of what is bound.
+		uint64_t hash = 0xcbf29ce484222325ull;
+		if (set)
+		{
+			auto &counts = set->getBindingTable().descriptorCounts;
+			uint32_t dynamicCount = counts[VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC] +
+			                        counts[VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC];
+			for (uint32_t j = 0; j < dynamicCount && dynamicOffset < dynamicOffsetCount; j++)
+				hash = (hash ^ pDynamicOffsets[dynamicOffset++]) * 0x100000001b3ull;
+		}
+
+		// Binding through an incompatible layout disturbs the sets, so only the same layout can make a bind redundant.
+		auto &info = sets[i + firstSet];
+		if (info.set != set || info.layout != layout || info.dynamicOffsetHash != hash)
+			redundant = false;
+
+		info.set = set;
+		info.layout = layout;
+		info.dynamicOffsetHash = hash;
+		info.dirty = true;
 	}
+
+	binds.descriptorSets++;
+	if (redundant && descriptorSetCount)
+		redundantBinds.descriptorSets++;
 }
 
 void CommandBuffer::bindIndexBuffer(Buffer *buffer, VkDeviceSize offset, VkIndexType indexType)
 {
+	binds.indexBuffers++;
+	if (buffer == indexBuffer && offset == indexOffset && indexType == this->indexType)
+		redundantBinds.indexBuffers++;
+
 	this->indexBuffer = buffer;
 	this->indexOffset = offset;
 	this->indexType = indexType;
@@ -146,11 +200,46 @@ void CommandBuffer::enqueueDeferredFunction(std::function<void(Queue &)> Functio
 
 void CommandBuffer::callDeferredFunctions(Queue &queue)
 {
-	for (auto func : deferredFunctions)
+	for (auto &func : deferredFunctions)
 	{
 		func(queue);
 	}
 	deferredFunctions.clear();
+
+	auto &tracker = baseDevice->getBandwidthTracker();
+	for (auto &instance : renderPassInstances)
+	{
+		tracker.addRenderPass(instance.handle, instance.bandwidth);
+		reportDrawOrder(instance);
+	}
+	tracker.addTransfer(transferBandwidth);
+
+	reportRedundantBinds();
+
+	for (auto &entry : pipelineDraws)
+		entry.pipeline->addSubmittedDraws(entry.draws);
+	pipelineDraws.clear();
+}
+
+void CommandBuffer::reportRedundantBinds()
+{
+	uint32_t redundant = redundantBinds.pipelines + redundantBinds.descriptorSets + redundantBinds.indexBuffers;
+	uint64_t frameRedundant = baseDevice->addRedundantBinds(redundant);
+
+	if (redundant && redundant >= baseDevice->getConfig().redundantBindThreshold)
+	{
+		log(VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT, MESSAGE_CODE_REDUNDANT_STATE_BIND,
+		    "%u vkCmdBind* calls bind exactly what is already bound: %u of %u pipeline binds, %u of %u descriptor "
+		    "set binds and %u of %u index buffer binds. Each of them still costs driver CPU time. "
+		    "%llu redundant binds were submitted so far this frame.",
+		    redundant, redundantBinds.pipelines, binds.pipelines, redundantBinds.descriptorSets,
+		    binds.descriptorSets, redundantBinds.indexBuffers, binds.indexBuffers,
+		    static_cast<unsigned long long>(frameRedundant));
+	}
+
+	// Only the first submission reports, like the deferred functions which only run once.
+	binds = {};
+	redundantBinds = {};
 }
 
 void CommandBuffer::executeCommandBuffer(CommandBuffer *commandBuffer)
@@ -160,12 +249,21 @@ void CommandBuffer::executeCommandBuffer(CommandBuffer *commandBuffer)
 
 void CommandBuffer::bindPipeline(VkPipelineBindPoint pipelineBindPoint, VkPipeline pipeline)
 {
-	for (auto &it : heuristics)
+	auto &bound = boundPipelines[pipelineBindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS ? 0 : 1];
+	binds.pipelines++;
+	if (bound == pipeline)
+		redundantBinds.pipelines++;
+	bound = pipeline;
+
+	for (auto *it : eventHeuristics[HEURISTIC_EVENT_BIND_PIPELINE])
 		it->cmdBindPipeline(commandBuffer, pipelineBindPoint, pipeline);
 	this->pipeline = baseDevice->get<Pipeline>(pipeline);
 
 	if (pipelineBindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS)
+	{
+		graphicsPipeline = this->pipeline;
 		graphicsLayout = this->pipeline->getPipelineLayout();
+	}
 	else
 		computeLayout = this->pipeline->getPipelineLayout();
 }
@@ -173,7 +271,7 @@ void CommandBuffer::bindPipeline(VkPipelineBindPoint pipelineBindPoint, VkPipeli
 void CommandBuffer::clearAttachments(uint32_t attachmentCount, const VkClearAttachment *pAttachments,
                                      uint32_t rectCount, const VkClearRect *pRect)
 {
-	for (auto &it : heuristics)
+	for (auto *it : eventHeuristics[HEURISTIC_EVENT_CLEAR_ATTACHMENTS])
 		it->cmdClearAttachments(commandBuffer, attachmentCount, pAttachments, rectCount, pRect);
 }
 
@@ -182,130 +280,110 @@ void CommandBuffer::nextSubpass(VkSubpassContents contents)
 	MPD_ASSERT(currentRenderPass);
 	currentSubpassIndex++;
 	MPD_ASSERT(currentSubpassIndex < currentRenderPass->getCreateInfo().subpassCount);
-	for (auto &it : heuristics)
+	for (auto *it : eventHeuristics[HEURISTIC_EVENT_SET_SUBPASS])
 		it->cmdSetSubpass(commandBuffer, currentSubpassIndex, contents);
 }
 
 void CommandBuffer::setCurrentRenderPass(RenderPass *renderPass)
 {
 	currentRenderPass = renderPass;
-	for (auto &it : heuristics)
+	for (auto *it : eventHeuristics[HEURISTIC_EVENT_SET_RENDER_PASS])
 		it->cmdSetRenderPass(commandBuffer, renderPass);
 }
 
 void CommandBuffer::setCurrentSubpassIndex(uint32_t index)
 {
 	currentSubpassIndex = index;
-	for (auto &it : heuristics)
+	for (auto *it : eventHeuristics[HEURISTIC_EVENT_SET_SUBPASS])
 		it->cmdSetSubpass(commandBuffer, currentSubpassIndex, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 }
 
-void CommandBuffer::enqueueRenderPassLoadOps(VkRenderPass renderPass, VkFramebuffer framebuffer)
+void CommandBuffer::enqueueRenderPassLoadOps(const RenderPass *renderPass, const Framebuffer *framebuffer)
 {
-	auto *rp = baseDevice->get<RenderPass>(renderPass);
-	auto *fb = baseDevice->get<Framebuffer>(framebuffer);
-	MPD_ASSERT(rp);
-	MPD_ASSERT(fb);
-
-	auto &fbInfo = fb->getCreateInfo();
-	auto &rpInfo = rp->getCreateInfo();
-
-	// Check if any attachments have LOAD or CLEAR operation on them.
-	// Don't care is treated as undefined.
+	auto &rpInfo = renderPass->getCreateInfo();
+	MPD_ASSERT(rpInfo.attachmentCount <= framebuffer->getAttachmentCount());
 
 	for (uint32_t att = 0; att < rpInfo.attachmentCount; att++)
 	{
-		auto &attachment = rpInfo.pAttachments[att];
+		auto &state = renderPass->getAttachmentState(att);
 
 		// If the attachment is unused, don't register anything.
-		if (!rp->renderPassUsesAttachmentAsImageOnly(att) && !rp->renderPassUsesAttachmentOnTile(att))
+		if (!state.usage)
 			continue;
 
-		Image::Usage usage = Image::Usage::Undefined;
-
-		if (!formatIsStencilOnly(attachment.format) && attachment.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD)
-		{
-			usage = Image::Usage::RenderPassReadToTile;
-		}
-
-		if ((formatIsDepthStencil(attachment.format) || formatIsStencilOnly(attachment.format)) &&
-		    attachment.stencilLoadOp == VK_ATTACHMENT_LOAD_OP_LOAD)
-		{
-			usage = Image::Usage::RenderPassReadToTile;
-		}
-
-		if (!formatIsStencilOnly(attachment.format) && attachment.loadOp == VK_ATTACHMENT_LOAD_OP_CLEAR)
-		{
-			usage = Image::Usage::RenderPassCleared;
-		}
-
-		if ((formatIsDepthStencil(attachment.format) || formatIsStencilOnly(attachment.format)) &&
-		    attachment.stencilLoadOp == VK_ATTACHMENT_LOAD_OP_CLEAR)
-		{
-			usage = Image::Usage::RenderPassCleared;
-		}
-
-		if (rp->renderPassUsesAttachmentAsImageOnly(att))
-		{
-			// If the attachment is only used as an input attachment, it is basically a fancy way of reading as a texture.
-			// LOAD_OP_LOAD doesn't actually read-back to tile.
-			usage = Image::Usage::ResourceRead;
-		}
-
-		ImageView *view = baseDevice->get<ImageView>(fbInfo.pAttachments[att]);
-		enqueueDeferredFunction([view, usage](Queue &) { view->signalUsage(usage); });
+		Image::Usage usage = state.loadUsage;
+		auto *attachment = &framebuffer->getAttachment(att);
+		MPD_ASSERT(attachment->image);
+		enqueueDeferredFunction([attachment, usage](Queue &) {
+			if (attachment->image)
+				attachment->image->signalUsage(attachment->subresourceRange, usage);
+		});
 	}
 }
-void CommandBuffer::enqueueRenderPassStoreOps(VkRenderPass renderPass, VkFramebuffer framebuffer)
-{
-	auto *rp = baseDevice->get<RenderPass>(renderPass);
-	auto *fb = baseDevice->get<Framebuffer>(framebuffer);
-	MPD_ASSERT(rp);
-	MPD_ASSERT(fb);
 
-	auto &fbInfo = fb->getCreateInfo();
-	auto &rpInfo = rp->getCreateInfo();
+void CommandBuffer::enqueueRenderPassStoreOps(const RenderPass *renderPass, const Framebuffer *framebuffer)
+{
+	auto &rpInfo = renderPass->getCreateInfo();
+	MPD_ASSERT(rpInfo.attachmentCount <= framebuffer->getAttachmentCount());
 
 	for (uint32_t att = 0; att < rpInfo.attachmentCount; att++)
 	{
-		auto &attachment = rpInfo.pAttachments[att];
-
 		// If the attachment is unused on tile, don't register anything.
-		if (!rp->renderPassUsesAttachmentOnTile(att))
+		if (!renderPass->renderPassUsesAttachmentOnTile(att))
 			continue;
 
-		Image::Usage usage = Image::Usage::RenderPassDiscarded;
-
-		if (!formatIsStencilOnly(attachment.format) && attachment.storeOp == VK_ATTACHMENT_STORE_OP_STORE)
-		{
-			usage = Image::Usage::RenderPassStored;
-		}
-
-		if ((formatIsDepthStencil(attachment.format) || formatIsStencilOnly(attachment.format)) &&
-		    attachment.stencilStoreOp == VK_ATTACHMENT_STORE_OP_STORE)
-		{
-			usage = Image::Usage::RenderPassStored;
-		}
-
-		ImageView *view = baseDevice->get<ImageView>(fbInfo.pAttachments[att]);
-		MPD_ASSERT(view);
-		enqueueDeferredFunction([view, usage](Queue &) { view->signalUsage(usage); });
+		Image::Usage usage = renderPass->getAttachmentState(att).storeUsage;
+		auto *attachment = &framebuffer->getAttachment(att);
+		MPD_ASSERT(attachment->image);
+		enqueueDeferredFunction([attachment, usage](Queue &) {
+			if (attachment->image)
+				attachment->image->signalUsage(attachment->subresourceRange, usage);
+		});
 	}
 }
 
 void CommandBuffer::beginRenderPass(const VkRenderPassBeginInfo *pRenderPassBegin, VkSubpassContents contents)
 {
-	for (auto &it : heuristics)
-	{
-		it->cmdBeginRenderPass(commandBuffer, pRenderPassBegin, contents);
+	auto *framebuffer = baseDevice->get<Framebuffer>(pRenderPassBegin->framebuffer);
+	MPD_ASSERT(framebuffer);
+
+	// The framebuffer holds on to the render pass it was created with, which is almost always the one used here.
+	// Any other compatible render pass has to be looked up.
+	RenderPass *renderPass = framebuffer->getRenderPass();
+	if (!renderPass || framebuffer->getCreateInfo().renderPass != pRenderPassBegin->renderPass)
+		renderPass = baseDevice->get<RenderPass>(pRenderPassBegin->renderPass);
+	MPD_ASSERT(renderPass);
+
+	for (auto *it : eventHeuristics[HEURISTIC_EVENT_BEGIN_RENDER_PASS])
+		it->cmdBeginRenderPass(commandBuffer, pRenderPassBegin, renderPass, contents);
+	for (auto *it : eventHeuristics[HEURISTIC_EVENT_SET_SUBPASS])
 		it->cmdSetSubpass(commandBuffer, 0, contents);
-	}
 
-	enqueueRenderPassLoadOps(pRenderPassBegin->renderPass, pRenderPassBegin->framebuffer);
+	enqueueRenderPassLoadOps(renderPass, framebuffer);
 	// Don't need to wait for CmdEndRenderPass.
-	enqueueRenderPassStoreOps(pRenderPassBegin->renderPass, pRenderPassBegin->framebuffer);
+	enqueueRenderPassStoreOps(renderPass, framebuffer);
+
+	renderPassInstances.push_back({ pRenderPassBegin->renderPass, renderPass, framebuffer, pRenderPassBegin->renderArea,
+	                                BandwidthTracker::estimateRenderPass(*renderPass, *framebuffer,
+	                                                                     pRenderPassBegin->renderArea),
+	                                DrawOrderStats() });
+	drawStateKeys.clear();
+
+	// Capture an index rather than the instance, so the function stays small enough to not allocate.
+	uint32_t instanceIndex = uint32_t(renderPassInstances.size() - 1);
+	enqueueDeferredFunction([this, instanceIndex](Queue &) {
+		auto &instance = renderPassInstances[instanceIndex];
+		baseDevice->getMemoryAliasingAdvisor().tick();
+		baseDevice->advanceUsageEpoch();
+		baseDevice->getRenderPassMergeAdvisor().beginRenderPass(instance.handle, instance.renderPass,
+		                                                        instance.framebuffer, instance.renderArea);
+	});
+
+	// Descriptor sets are signalled again within each render pass, so sampling is attributed to the right instance.
+	for (auto &set : graphicsDescriptorSets)
+		set.dirty = true;
 
-	currentRenderPass = baseDevice->get<RenderPass>(pRenderPassBegin->renderPass);
+	currentRenderPass = renderPass;
 	currentSubpassIndex = 0;
 	auto &createInfo = currentRenderPass->getCreateInfo();
 
@@ -341,7 +419,7 @@ void CommandBuffer::beginRenderPass(const VkRenderPassBeginInfo *pRenderPassBegi
 
 void CommandBuffer::endRenderPass()
 {
-	for (auto &it : heuristics)
+	for (auto *it : eventHeuristics[HEURISTIC_EVENT_END_RENDER_PASS])
 		it->cmdEndRenderPass(commandBuffer);
 	auto &createInfo = currentRenderPass->getCreateInfo();
 
@@ -369,15 +447,130 @@ void CommandBuffer::endRenderPass()
 	enqueueDeferredFunction([=](Queue &queue) {
 		auto &tracker = queue.getQueueTracker();
 		tracker.pipelineBarrier(src, dst);
+		baseDevice->getRenderPassMergeAdvisor().endRenderPass();
+		baseDevice->getMemoryAliasingAdvisor().tick();
+		baseDevice->advanceUsageEpoch();
 	});
 
+	if (!renderPassInstances.empty())
+		renderPassInstances.back().drawOrder = analyzeDrawOrder();
+
 	currentRenderPass = nullptr;
 	currentSubpassIndex = 0;
 }
 
+void CommandBuffer::recordDrawState(uint32_t drawCount)
+{
+	if (drawCount == 0)
+		return;
+
+	if (graphicsPipeline)
+	{
+		if (!pipelineDraws.empty() && pipelineDraws.back().pipeline == graphicsPipeline)
+			pipelineDraws.back().draws += drawCount;
+		else
+			pipelineDraws.push_back({ graphicsPipeline, drawCount });
+	}
+
+	// Draws in secondary command buffers are not part of a render pass instance recorded here.
+	if (secondary || !currentRenderPass || !graphicsPipeline)
+		return;
+
+	// FNV-1a over the bound descriptor sets and their dynamic offsets.
+	uint64_t hash = 0xcbf29ce484222325ull;
+	size_t numSets = graphicsLayout ? graphicsLayout->getDescriptorSetLayouts().size() : 0;
+	for (size_t i = 0; i < numSets; i++)
+	{
+		hash = (hash ^ uint64_t(reinterpret_cast<uintptr_t>(graphicsDescriptorSets[i].set))) * 0x100000001b3ull;
+		hash = (hash ^ graphicsDescriptorSets[i].dynamicOffsetHash) * 0x100000001b3ull;
+	}
+
+	drawStateKeys.push_back(
+	    { boundPipelines[0], hash, currentSubpassIndex, drawCount, graphicsPipeline->isOrderIndependent() });
+}
+
+CommandBuffer::DrawOrderStats CommandBuffer::analyzeDrawOrder()
+{
+	DrawOrderStats stats = {};
+
+	// Draws sharing a key, like those of an indirect draw, never switch state between each other.
+	for (size_t i = 0; i < drawStateKeys.size(); i++)
+	{
+		auto &key = drawStateKeys[i];
+		stats.draws += key.drawCount;
+		if (i == 0 || key.pipeline != drawStateKeys[i - 1].pipeline)
+			stats.pipelineSwitches++;
+		if (i == 0 || key.descriptorSets != drawStateKeys[i - 1].descriptorSets)
+			stats.descriptorSetSwitches++;
+	}
+
+	// Subpasses are never reordered. Within one, draws which depend on the order keep their place and act as barriers,
+	// only the runs of order independent draws between them are grouped by pipeline, then by descriptor sets.
+	auto subpassBegin = drawStateKeys.begin();
+	while (subpassBegin != drawStateKeys.end())
+	{
+		auto subpassEnd = find_if(subpassBegin, drawStateKeys.end(), [subpassBegin](const DrawStateKey &key) {
+			return key.subpass != subpassBegin->subpass;
+		});
+
+		const DrawStateKey *last = nullptr;
+		auto itr = subpassBegin;
+		while (itr != subpassEnd)
+		{
+			auto runEnd = itr + 1;
+			if (itr->orderIndependent)
+			{
+				runEnd = find_if(itr, subpassEnd, [](const DrawStateKey &key) { return !key.orderIndependent; });
+
+				// The order of the keys is not needed anymore, so they are sorted in place to avoid allocating.
+				sort(itr, runEnd, [](const DrawStateKey &a, const DrawStateKey &b) {
+					if (a.pipeline != b.pipeline)
+						return a.pipeline < b.pipeline;
+					return a.descriptorSets < b.descriptorSets;
+				});
+			}
+
+			for (; itr != runEnd; ++itr)
+			{
+				if (!last || itr->pipeline != last->pipeline)
+					stats.minPipelineSwitches++;
+				if (!last || itr->descriptorSets != last->descriptorSets)
+					stats.minDescriptorSetSwitches++;
+				last = &*itr;
+			}
+		}
+
+		subpassBegin = subpassEnd;
+	}
+
+	// Grouping by pipeline first can cost descriptor set switches which the recorded order did not have.
+	stats.minPipelineSwitches = min(stats.minPipelineSwitches, stats.pipelineSwitches);
+	stats.minDescriptorSetSwitches = min(stats.minDescriptorSetSwitches, stats.descriptorSetSwitches);
+	drawStateKeys.clear();
+	return stats;
+}
+
+void CommandBuffer::reportDrawOrder(const RenderPassInstance &instance)
+{
+	auto &stats = instance.drawOrder;
+	uint32_t savings = (stats.pipelineSwitches - stats.minPipelineSwitches) +
+	                   (stats.descriptorSetSwitches - stats.minDescriptorSetSwitches);
+	if (savings < baseDevice->getConfig().drawOrderSwitchSavingsThreshold ||
+	    !instance.renderPass->updateDrawOrderSavings(savings))
+		return;
+
+	log(VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT, MESSAGE_CODE_DRAW_ORDER_STATE_CHANGES,
+	    "The %u draws in an instance of VkRenderPass 0x%llx switch pipelines %u times and descriptor sets %u times. "
+	    "Sorting the draws between those which are blended, stencil tested, or do not test and write depth and "
+	    "write color, by pipeline and descriptor sets would only need %u pipeline and %u descriptor set switches.",
+	    stats.draws, static_cast<unsigned long long>((uint64_t)instance.handle),
+	    stats.pipelineSwitches, stats.descriptorSetSwitches, stats.minPipelineSwitches,
+	    stats.minDescriptorSetSwitches);
+}
+
 void CommandBuffer::draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
 {
-	for (auto &it : heuristics)
+	for (auto *it : eventHeuristics[HEURISTIC_EVENT_DRAW])
 		it->cmdDraw(commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
 }
 
@@ -414,7 +607,7 @@ void CommandBuffer::drawIndexed(uint32_t indexCount, uint32_t instanceCount, uin
 {
 	MPD_ASSERT(indexBuffer != nullptr);
 
-	for (auto &it : heuristics)
+	for (auto *it : eventHeuristics[HEURISTIC_EVENT_DRAW_INDEXED])
 		it->cmdDrawIndexed(commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
 
 	// Check small drawcalls
@@ -453,6 +646,24 @@ void CommandBuffer::drawIndexed(uint32_t indexCount, uint32_t instanceCount, uin
 	}
 }
 
+void CommandBuffer::captureIndexData(CaptureWriter &capture, uint32_t indexCount, uint32_t firstIndex) const
+{
+	const auto &cfg = baseDevice->getConfig();
+	if (!indexBuffer || !cfg.indexBufferScanningEnable || indexCount < cfg.indexBufferScanMinIndexCount)
+		return;
+
+	const DeviceMemory *deviceMemory = indexBuffer->getDeviceMemory();
+	if (!deviceMemory || !deviceMemory->getMappedMemory())
+		return;
+
+	// The index data is snapshotted when the draw is recorded, not when it is submitted.
+	uint32_t stride = (indexType == VK_INDEX_TYPE_UINT16) ? sizeof(uint16_t) : sizeof(uint32_t);
+	VkDeviceSize offset = indexOffset + VkDeviceSize(stride) * firstIndex;
+	const uint8_t *data =
+	    static_cast<const uint8_t *>(deviceMemory->getMappedMemory()) + indexBuffer->getMemoryOffset() + offset;
+	capture.indexData(indexBuffer->getBuffer(), offset, data, size_t(indexCount) * stride);
+}
+
 void CommandBuffer::scanIndices(Buffer *buffer, VkDeviceSize indexOffset, VkIndexType indexType, uint32_t indexCount,
                                 uint32_t firstIndex, bool primitiveRestart)
 {
@@ -19,6 +19,7 @@
  */
 
 #pragma once
+#include "bandwidth_tracker.hpp"
 #include "base_object.hpp"
 #include "dispatch_helper.hpp"
 #include "heuristic.hpp"
@@ -36,8 +37,10 @@ class CommandPool;
 class Buffer;
 class Queue;
 class RenderPass;
+class Framebuffer;
 class DescriptorSet;
 class PipelineLayout;
+class CaptureWriter;
 
 class CommandBuffer : public BaseObject
 {
@@ -84,6 +87,12 @@ public:
 	                     const VkBufferMemoryBarrier *pBufferMemoryBarriers, uint32_t imageMemoryBarrierCount,
 	                     const VkImageMemoryBarrier *pImageMemoryBarriers);
 
+	/// Accounts for transfer work outside render passes in the bandwidth estimate once submitted.
+	void addTransferBandwidth(const BandwidthEstimate &bandwidth)
+	{
+		transferBandwidth += bandwidth;
+	}
+
 	void clearAttachments(uint32_t attachmentCount, const VkClearAttachment *pAttachments, uint32_t rectCount,
 	                      const VkClearRect *pRect);
 
@@ -103,6 +112,13 @@ public:
 	void enqueueGraphicsDescriptorSetUsage();
 	void enqueueComputeDescriptorSetUsage();
 
+	/// Records the pipeline and descriptor sets used by drawCount draws for the draw order analysis of the render pass,
+	/// and counts the draws towards their pipeline. Indirect draws pass their drawCount.
+	void recordDrawState(uint32_t drawCount = 1);
+
+	/// Writes the index data which scanIndices() would consume for this draw to the capture.
+	void captureIndexData(CaptureWriter &capture, uint32_t indexCount, uint32_t firstIndex) const;
+
 private:
 	void scanIndices(Buffer *buffer, VkDeviceSize indexOffset, VkIndexType indexType, uint32_t indexCount,
 	                 uint32_t firstIndex, bool primitiveRestart);
@@ -120,7 +136,44 @@ private:
 
 	uint32_t smallIndexedDrawcallCount = 0;
 
-	std::vector<std::unique_ptr<Heuristic>> heuristics;
+	// vkCmdBind* calls, and how many of them bound exactly what was already bound.
+	// Reported once the command buffer is submitted.
+	struct BindCounts
+	{
+		uint32_t pipelines;
+		uint32_t descriptorSets;
+		uint32_t indexBuffers;
+	};
+	BindCounts binds;
+	BindCounts redundantBinds;
+	VkPipeline boundPipelines[2];
+	Pipeline *graphicsPipeline;
+	void reportRedundantBinds();
+
+	// Draws per graphics pipeline, consecutive draws with the same pipeline share an entry.
+	// Handed to the pipelines on submit.
+	struct PipelineDraws
+	{
+		Pipeline *pipeline;
+		uint32_t draws;
+	};
+	std::vector<PipelineDraws> pipelineDraws;
+
+	// Heuristic state lives inline, so allocating a command buffer is a single allocation.
+	DepthPrePassHeuristic depthPrePassHeuristic;
+	TileReadbackHeuristic tileReadbackHeuristic;
+	ClearAttachmentsHeuristic clearAttachmentsHeuristic;
+
+	// Per-event dispatch lists, only heuristics which subscribed to an event are called for it.
+	HeuristicDispatchList eventHeuristics[HEURISTIC_EVENT_COUNT];
+	template <typename T>
+	void registerHeuristic(T *heuristic)
+	{
+		static_assert((heuristicOverriddenEvents<T>() & ~T::EVENTS) == 0,
+		              "The heuristic overrides a callback whose event is missing from its EVENTS mask.");
+		registerHeuristic(static_cast<Heuristic *>(heuristic));
+	}
+	void registerHeuristic(Heuristic *heuristic);
 	const RenderPass *currentRenderPass;
 	uint32_t currentSubpassIndex = 0;
 	bool secondary = false;
@@ -134,12 +187,52 @@ private:
 	std::vector<CacheEntry> cacheEntries;
 	static bool testCache(uint32_t value, uint32_t iteration, CacheEntry *cacheEntries, uint32_t cacheSize);
 
-	void enqueueRenderPassLoadOps(VkRenderPass renderPass, VkFramebuffer framebuffer);
-	void enqueueRenderPassStoreOps(VkRenderPass renderPass, VkFramebuffer framebuffer);
+	void enqueueRenderPassLoadOps(const RenderPass *renderPass, const Framebuffer *framebuffer);
+	void enqueueRenderPassStoreOps(const RenderPass *renderPass, const Framebuffer *framebuffer);
+
+	// State switches between the draws of a render pass instance, as recorded and with the draws sorted.
+	struct DrawOrderStats
+	{
+		uint32_t draws;
+		uint32_t pipelineSwitches;
+		uint32_t descriptorSetSwitches;
+		uint32_t minPipelineSwitches;
+		uint32_t minDescriptorSetSwitches;
+	};
+
+	// Render pass instances and the estimated bandwidth of the recorded work,
+	// handed to the device's BandwidthTracker and RenderPassMergeAdvisor on submit.
+	// Kept until the command buffer is reset, so every submit of it is accounted.
+	struct RenderPassInstance
+	{
+		VkRenderPass handle;
+		RenderPass *renderPass;
+		const Framebuffer *framebuffer;
+		VkRect2D renderArea;
+		BandwidthEstimate bandwidth;
+		DrawOrderStats drawOrder;
+	};
+	std::vector<RenderPassInstance> renderPassInstances;
+	BandwidthEstimate transferBandwidth;
+
+	// Pipeline and descriptor sets used by each draw of the current render pass instance.
+	struct DrawStateKey
+	{
+		VkPipeline pipeline;
+		uint64_t descriptorSets;
+		uint32_t subpass;
+		uint32_t drawCount;
+		bool orderIndependent;
+	};
+	std::vector<DrawStateKey> drawStateKeys;
+	DrawOrderStats analyzeDrawOrder();
+	void reportDrawOrder(const RenderPassInstance &instance);
 
 	struct DescriptorSetInfo
 	{
 		DescriptorSet *set = nullptr;
+		VkPipelineLayout layout = VK_NULL_HANDLE;
+		uint64_t dynamicOffsetHash = 0;
 		bool dirty = true;
 	};
 	std::vector<DescriptorSetInfo> graphicsDescriptorSets;
@@ -176,6 +176,79 @@ public:
 	                             "#  logcat (Android only)\n"
 	                             "#  debug_output (OutputDebugString, Windows only).");
 
+	MPD_DEFINE_CFG_OPTION_STRING(captureFilename, "",
+	                             "If set, the API calls seen by the layer are written to this file,\n"
+	                             "# so they can be replayed offline with perfdoc-replay.\n"
+	                             "# Capturing has a significant CPU overhead and should only be enabled when needed.");
+
+	MPD_DEFINE_CFG_OPTIONB(captureRecordOnly, false,
+	                       "If enabled together with captureFilename, the layer only records the API stream and "
+	                       "does not analyze anything at runtime.\n"
+	                       "# Run perfdoc-analyze on the capture afterwards to get the diagnostics.");
+
+	MPD_DEFINE_CFG_OPTIONU(bandwidthReportFrameInterval, 0,
+	                       "Report the estimated external memory bandwidth every this many presented frames.\n"
+	                       "# If 0, a single report covering the whole run is made when the device is destroyed.");
+
+	MPD_DEFINE_CFG_OPTIONU(bandwidthReportTopRenderPasses, 8,
+	                       "How many render passes to list in the bandwidth report, ranked by estimated traffic");
+
+	MPD_DEFINE_CFG_OPTIONU(transientMemoryReportFrameInterval, 0,
+	                       "Report the physical memory which transient, lazily allocated attachments would save every "
+	                       "this many presented frames.\n"
+	                       "# If 0, it is only reported when the device is destroyed.");
+
+	MPD_DEFINE_CFG_OPTIONU(deadStoreReportTopImages, 8,
+	                       "How many images to list when reporting stores which are never read, ranked by wasted "
+	                       "bandwidth");
+
+	MPD_DEFINE_CFG_OPTION_STRING(tileBufferArchitecture, "bifrost",
+	                             "Mali architecture whose tile buffer budget is used to check the color storage of "
+	                             "subpasses.\n"
+	                             "# Supported values are midgard, bifrost and valhall.");
+
+	MPD_DEFINE_CFG_OPTIONU(tileBufferBudgetBitsPerPixel, 0,
+	                       "If non-zero, overrides the color bits per pixel which fit in the tile buffer at full "
+	                       "tile size.\n"
+	                       "# Color attachments x samples beyond this budget make the GPU shrink its tiles.");
+
+	MPD_DEFINE_CFG_OPTIONF(descriptorPoolOverProvisionRatio, 2.0,
+	                       "Report descriptor pools which declare more than this many times the sets or descriptors "
+	                       "ever allocated from them at once");
+
+	MPD_DEFINE_CFG_OPTIONU(descriptorPoolWasteThreshold, 16 * 1024,
+	                       "Only report over-provisioned descriptor pools if they waste at least this many bytes of "
+	                       "descriptor memory");
+
+	MPD_DEFINE_CFG_OPTIONU(redundantBindThreshold, 8,
+	                       "Report command buffers with at least this many vkCmdBind* calls which rebind exactly the "
+	                       "state already bound");
+
+	MPD_DEFINE_CFG_OPTIONU(drawOrderSwitchSavingsThreshold, 32,
+	                       "Report render passes in which sorting the draws would save at least this many pipeline "
+	                       "and descriptor set switches");
+
+	MPD_DEFINE_CFG_OPTIONU(pipelineLayoutMergeableSetBindings, 0,
+	                       "Report pipeline layouts whose pipelines use at most this many descriptor bindings spread "
+	                       "over several descriptor sets. Off by default, sets are often split by update frequency");
+
+	MPD_DEFINE_CFG_OPTIONU(hiddenSurfaceRemovalDrawThreshold, 100,
+	                       "Report pipelines which defeat early depth/stencil testing or Forward Pixel Kill once this "
+	                       "many draws using them were submitted");
+
+	MPD_DEFINE_CFG_OPTIONU(shaderCostReportFrameInterval, 0,
+	                       "Report the shaders with the highest estimated cost per frame every this many presented "
+	                       "frames.\n"
+	                       "# If 0, a single report covering the whole run is made when the device is destroyed.");
+
+	MPD_DEFINE_CFG_OPTIONU(shaderCostReportTopShaders, 8,
+	                       "How many shaders of each stage to list in the shader cost report, "
+	                       "ranked by static cost times draws");
+
+	MPD_DEFINE_CFG_OPTIONU(fullPrecisionFragmentOpThreshold, 16,
+	                       "Report fragment shaders which do all of their floating-point math in 32-bit precision "
+	                       "if they have at least this many floating-point operations");
+
 	bool tryToLoadFromFile(const std::string &fname);
 
 	void dumpToFile(const std::string &fname) const;
@@ -20,12 +20,65 @@
 
 #include "descriptor_pool.hpp"
 #include "descriptor_set.hpp"
+#include "descriptor_set_layout.hpp"
 #include "device.hpp"
 #include "message_codes.hpp"
+#include <algorithm>
+#include <stdio.h>
+#include <string>
+
+using namespace std;
 
 namespace MPD
 {
 
+static const char *descriptorTypeName(VkDescriptorType type)
+{
+	switch (type)
+	{
+	case VK_DESCRIPTOR_TYPE_SAMPLER:
+		return "SAMPLER";
+	case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+		return "COMBINED_IMAGE_SAMPLER";
+	case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+		return "SAMPLED_IMAGE";
+	case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+		return "STORAGE_IMAGE";
+	case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+		return "UNIFORM_TEXEL_BUFFER";
+	case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+		return "STORAGE_TEXEL_BUFFER";
+	case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+		return "UNIFORM_BUFFER";
+	case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+		return "STORAGE_BUFFER";
+	case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+		return "UNIFORM_BUFFER_DYNAMIC";
+	case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+		return "STORAGE_BUFFER_DYNAMIC";
+	case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+		return "INPUT_ATTACHMENT";
+	default:
+		return "UNKNOWN";
+	}
+}
+
+// Rough cost of the bookkeeping a driver reserves for every set a pool is created for, on top of its descriptors.
+static const uint32_t estimatedSetBytes = 64;
+
+VkResult DescriptorPool::init(const VkDescriptorPoolCreateInfo &createInfo)
+{
+	sets.declared = createInfo.maxSets;
+	for (uint32_t i = 0; i < createInfo.poolSizeCount; i++)
+	{
+		auto &poolSize = createInfo.pPoolSizes[i];
+		if (poolSize.type < VK_DESCRIPTOR_TYPE_RANGE_SIZE)
+			descriptors[poolSize.type].declared += poolSize.descriptorCount;
+	}
+
+	return VK_SUCCESS;
+}
+
 DescriptorPool::~DescriptorPool()
 {
 	baseDevice->freeDescriptorSets(this);
@@ -35,6 +88,17 @@ void DescriptorPool::descriptorSetCreated(DescriptorSet *dset)
 {
 	MPD_ASSERT(dset);
 
+	sets.current++;
+	sets.peak = max(sets.peak, sets.current);
+
+	auto &counts = dset->getBindingTable().descriptorCounts;
+	for (uint32_t type = 0; type < VK_DESCRIPTOR_TYPE_RANGE_SIZE; type++)
+	{
+		auto &capacity = descriptors[type];
+		capacity.current += counts[type];
+		capacity.peak = max(capacity.peak, capacity.current);
+	}
+
 	auto it = layoutInfos.find(dset->getLayoutUuid());
 	if (it != layoutInfos.end())
 	{
@@ -64,10 +128,79 @@ void DescriptorPool::descriptorSetDeleted(DescriptorSet *dset)
 	auto it = layoutInfos.find(dset->getLayoutUuid());
 	MPD_ASSERT(it != layoutInfos.end());
 	++it->second.descriptorSetsFreedCount;
+
+	MPD_ASSERT(sets.current > 0);
+	sets.current--;
+
+	auto &counts = dset->getBindingTable().descriptorCounts;
+	for (uint32_t type = 0; type < VK_DESCRIPTOR_TYPE_RANGE_SIZE; type++)
+	{
+		MPD_ASSERT(descriptors[type].current >= counts[type]);
+		descriptors[type].current -= counts[type];
+	}
 }
 
 void DescriptorPool::reset()
 {
+	reportSizing();
 	baseDevice->freeDescriptorSets(this);
 }
+
+void DescriptorPool::reportSizing()
+{
+	// Pools which never had a set allocated from them are most likely still to be used.
+	if (sets.peak == 0)
+		return;
+
+	const auto &cfg = baseDevice->getConfig();
+	auto isOverProvisioned = [&](const Capacity &capacity) {
+		return capacity.declared > capacity.peak &&
+		       double(capacity.declared) > cfg.descriptorPoolOverProvisionRatio * double(capacity.peak);
+	};
+
+	uint64_t wastedBytes = 0;
+	if (isOverProvisioned(sets))
+		wastedBytes += uint64_t(sets.declared - sets.peak) * estimatedSetBytes;
+
+	for (uint32_t type = 0; type < VK_DESCRIPTOR_TYPE_RANGE_SIZE; type++)
+	{
+		auto &capacity = descriptors[type];
+		if (isOverProvisioned(capacity))
+			wastedBytes += uint64_t(capacity.declared - capacity.peak) *
+			               DescriptorSetLayout::estimatedDescriptorBytes(static_cast<VkDescriptorType>(type));
+	}
+
+	// Only report again once the peaks have changed the picture.
+	if (wastedBytes < cfg.descriptorPoolWasteThreshold || wastedBytes == lastReportedWastedBytes)
+		return;
+	lastReportedWastedBytes = wastedBytes;
+
+	char line[256];
+	snprintf(line, sizeof(line),
+	         "Descriptor pool is over-provisioned, about %.1f KiB of descriptor memory was never used. "
+	         "Declared capacity compared to the most allocated at once:",
+	         double(wastedBytes) / 1024.0);
+	string message = line;
+
+	if (isOverProvisioned(sets))
+	{
+		snprintf(line, sizeof(line), "\n  sets: %u declared, at most %u allocated at once.", sets.declared,
+		         sets.peak);
+		message += line;
+	}
+
+	for (uint32_t type = 0; type < VK_DESCRIPTOR_TYPE_RANGE_SIZE; type++)
+	{
+		auto &capacity = descriptors[type];
+		if (!isOverProvisioned(capacity))
+			continue;
+
+		snprintf(line, sizeof(line), "\n  %s: %u declared, at most %u allocated at once.",
+		         descriptorTypeName(static_cast<VkDescriptorType>(type)), capacity.declared, capacity.peak);
+		message += line;
+	}
+
+	log(VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT, MESSAGE_CODE_DESCRIPTOR_POOL_OVER_PROVISIONED, "%s",
+	    message.c_str());
+}
 }
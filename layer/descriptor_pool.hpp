@@ -41,10 +41,7 @@ public:
 
 	~DescriptorPool();
 
-	VkResult init(const VkDescriptorPoolCreateInfo &)
-	{
-		return VK_SUCCESS;
-	}
+	VkResult init(const VkDescriptorPoolCreateInfo &createInfo);
 
 	void descriptorSetCreated(DescriptorSet *dset);
 
@@ -52,7 +49,22 @@ public:
 
 	void reset();
 
+	/// Compares the declared capacity with the most sets and descriptors ever allocated at once,
+	/// and reports pools which could be made a lot smaller. Called on reset and before the pool is destroyed.
+	void reportSizing();
+
 private:
+	struct Capacity
+	{
+		uint32_t declared;
+		uint32_t current;
+		uint32_t peak;
+	};
+
+	Capacity sets = {};
+	Capacity descriptors[VK_DESCRIPTOR_TYPE_RANGE_SIZE] = {};
+	uint64_t lastReportedWastedBytes = 0;
+
 	struct DescriptorSetLayoutInfo
 	{
 		uint32_t descriptorSetsFreedCount;
@@ -21,95 +21,113 @@
 #include "descriptor_set.hpp"
 #include "descriptor_pool.hpp"
 #include "descriptor_set_layout.hpp"
+#include "descriptor_update_template.hpp"
 #include "device.hpp"
 #include "image_view.hpp"
+#include <string.h>
 
 namespace MPD
 {
 
-VkResult DescriptorSet::init(const DescriptorSetLayout *layout_, DescriptorPool *pool_)
+VkResult DescriptorSet::init(const DescriptorSetLayout *layout, DescriptorPool *pool_)
 {
-	MPD_ASSERT(layout_);
+	MPD_ASSERT(layout);
 	MPD_ASSERT(pool_);
 
 	pool = pool_;
-	layout = layout_;
 	layoutUuid = layout->getUuid();
-
-	for (auto &binding : layout->getBindings())
-	{
-		bindings[binding.first].views.resize(binding.second.arraySize);
-		bindings[binding.first].descriptorType = binding.second.descriptorType;
-	}
+	bindingTable = layout->getBindingTable();
+	views.resize(bindingTable->getImageViewCount());
 
 	pool->descriptorSetCreated(this);
 	return VK_SUCCESS;
 }
 
+ImageView **DescriptorSet::getSlots(uint32_t binding, uint32_t arrayElement, uint32_t count)
+{
+	auto *bindingInfo = bindingTable->getBinding(binding);
+	MPD_ASSERT(bindingInfo);
+	if (bindingInfo->offset == DescriptorSetLayout::UNTRACKED)
+		return nullptr;
+
+	// Updates past the end of a binding continue into the next bindings, which directly follow it.
+	uint32_t first = bindingInfo->offset + arrayElement;
+	MPD_ASSERT(first + count <= views.size());
+	return views.data() + first;
+}
+
 void DescriptorSet::copyDescriptors(Device *device, const VkCopyDescriptorSet &copy)
 {
 	auto *dst = device->get<DescriptorSet>(copy.dstSet);
 	auto *src = device->get<DescriptorSet>(copy.srcSet);
 
-	auto &dstData = dst->bindings[copy.dstBinding];
-	auto &srcData = src->bindings[copy.srcBinding];
+	auto *dstSlots = dst->getSlots(copy.dstBinding, copy.dstArrayElement, copy.descriptorCount);
+	auto *srcSlots = src->getSlots(copy.srcBinding, copy.srcArrayElement, copy.descriptorCount);
+	MPD_ASSERT(!dstSlots == !srcSlots);
+	dst->signaledEpoch = 0;
 
-	for (uint32_t i = 0; i < copy.descriptorCount; i++)
-	{
-		MPD_ASSERT(copy.dstArrayElement + i < dstData.views.size());
-		MPD_ASSERT(copy.srcArrayElement + i < srcData.views.size());
-		MPD_ASSERT(dstData.descriptorType == srcData.descriptorType);
-		dstData.views[copy.dstArrayElement + i] = srcData.views[copy.srcArrayElement + i];
-	}
+	if (dstSlots && srcSlots)
+		memmove(dstSlots, srcSlots, copy.descriptorCount * sizeof(*dstSlots));
 }
 
 void DescriptorSet::writeDescriptors(Device *device, const VkWriteDescriptorSet &write)
 {
 	auto *dst = device->get<DescriptorSet>(write.dstSet);
-	uint32_t binding = write.dstBinding;
-	uint32_t arrayIndex = write.dstArrayElement;
-	uint32_t count = write.descriptorCount;
+	MPD_ASSERT(dst->bindingTable->getBinding(write.dstBinding)->descriptorType == write.descriptorType);
+
+	// Only image descriptors have slots.
+	auto *slots = dst->getSlots(write.dstBinding, write.dstArrayElement, write.descriptorCount);
+	if (!slots)
+		return;
 
-	auto &bindingData = dst->bindings[binding];
-	for (uint32_t i = 0; i < count; i++)
+	dst->signaledEpoch = 0;
+
+	for (uint32_t i = 0; i < write.descriptorCount; i++)
+		slots[i] = device->get<ImageView>(write.pImageInfo[i].imageView);
+}
+
+void DescriptorSet::updateWithTemplate(Device *device, VkDescriptorSet set,
+                                       const DescriptorUpdateTemplate &updateTemplate, const void *pData)
+{
+	auto *dst = device->get<DescriptorSet>(set);
+	MPD_ASSERT(dst);
+
+	auto *data = static_cast<const uint8_t *>(pData);
+	for (auto &copy : updateTemplate.getImageViewCopies())
 	{
-		MPD_ASSERT(arrayIndex + i < bindingData.views.size());
-		MPD_ASSERT(bindingData.descriptorType == write.descriptorType);
-
-		switch (write.descriptorType)
-		{
-		case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
-		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-		case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-			bindingData.views[arrayIndex + i] = device->get<ImageView>(write.pImageInfo[i].imageView);
-			break;
-
-		default:
-			bindingData.views[arrayIndex + i] = nullptr;
-			break;
-		}
+		MPD_ASSERT(copy.slot + copy.count <= dst->views.size());
+		ImageView **slots = dst->views.data() + copy.slot;
+		const uint8_t *src = data + copy.offset;
+		for (uint32_t i = 0; i < copy.count; i++, src += copy.stride)
+			slots[i] = device->get<ImageView>(reinterpret_cast<const VkDescriptorImageInfo *>(src)->imageView);
 	}
+
+	dst->signaledEpoch = 0;
 }
 
 void DescriptorSet::signalUsage()
 {
-	for (auto &binding : layout->getSampledImageBindings())
+	// Sets are typically bound many times per submit, signaling again would not change anything.
+	if (signaledEpoch == baseDevice->getUsageEpoch())
+		return;
+
+	auto &mergeAdvisor = baseDevice->getRenderPassMergeAdvisor();
+	uint32_t sampledImageCount = bindingTable->sampledImageCount;
+	uint32_t viewCount = uint32_t(views.size());
+
+	for (uint32_t i = 0; i < sampledImageCount; i++)
 	{
-		for (auto &view : bindings[binding].views)
-		{
-			if (view)
-				view->signalUsage(Image::Usage::ResourceRead);
-		}
+		if (views[i] && views[i]->signalUsage(Image::Usage::ResourceRead))
+			mergeAdvisor.sampleImage(views[i]->getImage());
 	}
 
-	for (auto &binding : layout->getStorageImageBindings())
+	for (uint32_t i = sampledImageCount; i < viewCount; i++)
 	{
-		for (auto &view : bindings[binding].views)
-		{
-			if (view)
-				view->signalUsage(Image::Usage::ResourceWrite);
-		}
+		if (views[i])
+			views[i]->signalUsage(Image::Usage::ResourceWrite);
 	}
+
+	signaledEpoch = baseDevice->getUsageEpoch();
 }
 
 DescriptorSet::~DescriptorSet()
@@ -20,15 +20,16 @@
 
 #pragma once
 #include "base_object.hpp"
+#include "descriptor_set_layout.hpp"
 #include <atomic>
-#include <unordered_map>
+#include <memory>
 #include <vector>
 
 namespace MPD
 {
 
-class DescriptorSetLayout;
 class DescriptorPool;
+class DescriptorUpdateTemplate;
 class ImageView;
 
 class DescriptorSet : public BaseObject
@@ -44,8 +45,8 @@ public:
 
 	~DescriptorSet();
 
-	/// @note The DescriptorSet will not hold any reference to the layout. The spec allows layouts to be deleted before
-	/// sets.
+	/// @note The DescriptorSet will not hold any reference to the layout, only to its binding table. The spec allows
+	/// layouts to be deleted before sets.
 	VkResult init(const DescriptorSetLayout *layout, DescriptorPool *pool);
 
 	uint64_t getLayoutUuid() const
@@ -58,22 +59,29 @@ public:
 		return pool;
 	}
 
+	const DescriptorSetLayout::BindingTable &getBindingTable() const
+	{
+		return *bindingTable;
+	}
+
 	void signalUsage();
 
 	static void writeDescriptors(Device *device, const VkWriteDescriptorSet &write);
 	static void copyDescriptors(Device *device, const VkCopyDescriptorSet &copy);
+	static void updateWithTemplate(Device *device, VkDescriptorSet set, const DescriptorUpdateTemplate &updateTemplate,
+	                               const void *pData);
 
 private:
 	uint64_t layoutUuid = 0;
 	DescriptorPool *pool = nullptr;
-	const DescriptorSetLayout *layout = nullptr;
+	std::shared_ptr<const DescriptorSetLayout::BindingTable> bindingTable;
 
-	struct BindingData
-	{
-		std::vector<ImageView *> views;
-		VkDescriptorType descriptorType;
-	};
+	// Reset whenever the set is updated, so new contents are always signaled.
+	uint64_t signaledEpoch = 0;
+
+	// One slot per image descriptor, laid out as described by the binding table.
+	std::vector<ImageView *> views;
 
-	std::unordered_map<uint32_t, BindingData> bindings;
+	ImageView **getSlots(uint32_t binding, uint32_t arrayElement, uint32_t count);
 };
 }
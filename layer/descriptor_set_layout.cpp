@@ -19,34 +19,51 @@
  */
 
 #include "descriptor_set_layout.hpp"
+#include <algorithm>
 
 namespace MPD
 {
+static bool isSampledImage(VkDescriptorType type)
+{
+	return type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER || type == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+}
+
 VkResult DescriptorSetLayout::init(const VkDescriptorSetLayoutCreateInfo *pCreateInfo)
 {
-	uint32_t bindings = pCreateInfo->bindingCount;
-	for (uint32_t i = 0; i < bindings; i++)
+	auto table = std::make_shared<BindingTable>();
+
+	uint32_t bindingCount = 0;
+	for (uint32_t i = 0; i < pCreateInfo->bindingCount; i++)
+		bindingCount = std::max(bindingCount, pCreateInfo->pBindings[i].binding + 1);
+
+	table->bindings.resize(bindingCount, { VK_DESCRIPTOR_TYPE_MAX_ENUM, 0, UNTRACKED });
+	for (uint32_t i = 0; i < pCreateInfo->bindingCount; i++)
 	{
 		auto &binding = pCreateInfo->pBindings[i];
+		table->bindings[binding.binding] = { binding.descriptorType, binding.descriptorCount, UNTRACKED };
+		if (binding.descriptorType < VK_DESCRIPTOR_TYPE_RANGE_SIZE)
+			table->descriptorCounts[binding.descriptorType] += binding.descriptorCount;
+	}
 
-		switch (binding.descriptorType)
+	for (auto &binding : table->bindings)
+	{
+		if (isSampledImage(binding.descriptorType))
 		{
-		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-		case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
-			sampledImageBindings.insert(binding.binding);
-			break;
-
-		case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-			storageImageBindings.insert(binding.binding);
-			break;
-
-		default:
-			break;
+			binding.offset = table->sampledImageCount;
+			table->sampledImageCount += binding.arraySize;
 		}
+	}
 
-		this->bindings[binding.binding] = { binding.descriptorType, binding.descriptorCount };
+	for (auto &binding : table->bindings)
+	{
+		if (binding.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)
+		{
+			binding.offset = table->sampledImageCount + table->storageImageCount;
+			table->storageImageCount += binding.arraySize;
+		}
 	}
 
+	bindingTable = std::move(table);
 	return VK_SUCCESS;
 }
-}
\ No newline at end of file
+}
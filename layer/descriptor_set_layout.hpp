@@ -20,8 +20,8 @@
 
 #pragma once
 #include "base_object.hpp"
-#include <unordered_map>
-#include <unordered_set>
+#include <memory>
+#include <vector>
 
 namespace MPD
 {
@@ -39,30 +39,67 @@ public:
 
 	VkResult init(const VkDescriptorSetLayoutCreateInfo *pCreateInfo);
 
-	const std::unordered_set<uint32_t> &getSampledImageBindings() const
-	{
-		return sampledImageBindings;
-	}
-
-	const std::unordered_set<uint32_t> &getStorageImageBindings() const
-	{
-		return storageImageBindings;
-	}
+	/// Binding offset for descriptors which descriptor sets do not keep track of.
+	static const uint32_t UNTRACKED = ~0u;
 
 	struct Binding
 	{
 		VkDescriptorType descriptorType;
 		uint32_t arraySize;
+		// Index of the first image view slot of this binding in a descriptor set, or UNTRACKED.
+		uint32_t offset;
+	};
+
+	/// Computed once per layout.
+	/// Descriptor sets store their image views in a single array: sampled images first, then storage images.
+	/// Within each group bindings are laid out in binding order, so a write which overflows a binding continues
+	/// into the next one as the spec requires.
+	struct BindingTable
+	{
+		// Indexed by binding number, unused binding numbers have no descriptors.
+		std::vector<Binding> bindings;
+		uint32_t sampledImageCount = 0;
+		uint32_t storageImageCount = 0;
+
+		// Descriptors of each type a set with this layout takes from its pool.
+		uint32_t descriptorCounts[VK_DESCRIPTOR_TYPE_RANGE_SIZE] = {};
+
+		const Binding *getBinding(uint32_t binding) const
+		{
+			return binding < bindings.size() ? &bindings[binding] : nullptr;
+		}
+
+		uint32_t getImageViewCount() const
+		{
+			return sampledImageCount + storageImageCount;
+		}
 	};
 
-	const std::unordered_map<uint32_t, Binding> &getBindings() const
+	/// Rough size of a descriptor in memory on Mali: texture and sampler descriptors are 32 bytes each,
+	/// buffers are described by a 16 byte pointer and size.
+	static uint32_t estimatedDescriptorBytes(VkDescriptorType type)
+	{
+		switch (type)
+		{
+		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+			return 64;
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+			return 16;
+		default:
+			return 32;
+		}
+	}
+
+	/// Shared with the descriptor sets, the spec allows the layout to be destroyed before them.
+	const std::shared_ptr<const BindingTable> &getBindingTable() const
 	{
-		return bindings;
+		return bindingTable;
 	}
 
 private:
-	std::unordered_set<uint32_t> sampledImageBindings;
-	std::unordered_set<uint32_t> storageImageBindings;
-	std::unordered_map<uint32_t, Binding> bindings;
+	std::shared_ptr<const BindingTable> bindingTable;
 };
 }
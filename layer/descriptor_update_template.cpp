@@ -0,0 +1,133 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "descriptor_update_template.hpp"
+#include "device.hpp"
+
+namespace MPD
+{
+static bool isTrackedImage(VkDescriptorType type)
+{
+	return type == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE || type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER ||
+	       type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+}
+
+VkResult DescriptorUpdateTemplate::init(const VkDescriptorUpdateTemplateCreateInfo *pCreateInfo)
+{
+	entries.assign(pCreateInfo->pDescriptorUpdateEntries,
+	               pCreateInfo->pDescriptorUpdateEntries + pCreateInfo->descriptorUpdateEntryCount);
+	for (auto &entry : entries)
+		descriptorCount += entry.descriptorCount;
+
+	// Push descriptors are not tracked by the layer.
+	if (pCreateInfo->templateType != VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET)
+		return VK_SUCCESS;
+
+	auto *layout = baseDevice->get<DescriptorSetLayout>(pCreateInfo->descriptorSetLayout);
+	MPD_ASSERT(layout);
+	auto &table = *layout->getBindingTable();
+
+	for (auto &entry : entries)
+	{
+		if (!isTrackedImage(entry.descriptorType) || entry.descriptorCount == 0)
+			continue;
+
+		auto *binding = table.getBinding(entry.dstBinding);
+		MPD_ASSERT(binding && binding->offset != DescriptorSetLayout::UNTRACKED);
+		uint32_t slot = binding->offset + entry.dstArrayElement;
+
+		// Entries which continue where the previous one stopped become a single copy.
+		if (!imageViewCopies.empty())
+		{
+			auto &last = imageViewCopies.back();
+			if (last.stride == entry.stride && last.slot + last.count == slot &&
+			    last.offset + last.count * last.stride == entry.offset)
+			{
+				last.count += entry.descriptorCount;
+				continue;
+			}
+		}
+
+		imageViewCopies.push_back({ slot, entry.descriptorCount, entry.offset, entry.stride });
+	}
+
+	return VK_SUCCESS;
+}
+
+void DescriptorUpdateTemplate::expandWrites(VkDescriptorSet set, const void *pData,
+                                            std::vector<VkWriteDescriptorSet> &writes,
+                                            std::vector<VkDescriptorImageInfo> &imageInfos,
+                                            std::vector<VkDescriptorBufferInfo> &bufferInfos,
+                                            std::vector<VkBufferView> &texelBufferViews) const
+{
+	// Reserve up front so the writes can point into the arrays as they are filled in.
+	writes.clear();
+	imageInfos.clear();
+	bufferInfos.clear();
+	texelBufferViews.clear();
+	imageInfos.reserve(descriptorCount);
+	bufferInfos.reserve(descriptorCount);
+	texelBufferViews.reserve(descriptorCount);
+
+	auto *data = static_cast<const uint8_t *>(pData);
+	for (auto &entry : entries)
+	{
+		VkWriteDescriptorSet write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+		write.dstSet = set;
+		write.dstBinding = entry.dstBinding;
+		write.dstArrayElement = entry.dstArrayElement;
+		write.descriptorCount = entry.descriptorCount;
+		write.descriptorType = entry.descriptorType;
+
+		switch (entry.descriptorType)
+		{
+		case VK_DESCRIPTOR_TYPE_SAMPLER:
+		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+		case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+		case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+		case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+			write.pImageInfo = imageInfos.data() + imageInfos.size();
+			for (uint32_t i = 0; i < entry.descriptorCount; i++)
+				imageInfos.push_back(
+				    *reinterpret_cast<const VkDescriptorImageInfo *>(data + entry.offset + i * entry.stride));
+			break;
+
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+			write.pBufferInfo = bufferInfos.data() + bufferInfos.size();
+			for (uint32_t i = 0; i < entry.descriptorCount; i++)
+				bufferInfos.push_back(
+				    *reinterpret_cast<const VkDescriptorBufferInfo *>(data + entry.offset + i * entry.stride));
+			break;
+
+		default:
+			write.pTexelBufferView = texelBufferViews.data() + texelBufferViews.size();
+			for (uint32_t i = 0; i < entry.descriptorCount; i++)
+				texelBufferViews.push_back(
+				    *reinterpret_cast<const VkBufferView *>(data + entry.offset + i * entry.stride));
+			break;
+		}
+
+		writes.push_back(write);
+	}
+}
+}
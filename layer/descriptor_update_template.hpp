@@ -0,0 +1,117 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#include "base_object.hpp"
+#include "descriptor_set_layout.hpp"
+#include <memory>
+#include <vector>
+
+// The bundled headers predate descriptor update templates. The core names are used throughout, the KHR entry points
+// share the same signatures and structures.
+#ifndef VK_VERSION_1_1
+VK_DEFINE_NON_DISPATCHABLE_HANDLE(VkDescriptorUpdateTemplate)
+typedef VkFlags VkDescriptorUpdateTemplateCreateFlags;
+
+typedef enum VkDescriptorUpdateTemplateType {
+	VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET = 0,
+	VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR = 1,
+	VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_MAX_ENUM = 0x7FFFFFFF
+} VkDescriptorUpdateTemplateType;
+
+typedef struct VkDescriptorUpdateTemplateEntry
+{
+	uint32_t dstBinding;
+	uint32_t dstArrayElement;
+	uint32_t descriptorCount;
+	VkDescriptorType descriptorType;
+	size_t offset;
+	size_t stride;
+} VkDescriptorUpdateTemplateEntry;
+
+typedef struct VkDescriptorUpdateTemplateCreateInfo
+{
+	VkStructureType sType;
+	const void *pNext;
+	VkDescriptorUpdateTemplateCreateFlags flags;
+	uint32_t descriptorUpdateEntryCount;
+	const VkDescriptorUpdateTemplateEntry *pDescriptorUpdateEntries;
+	VkDescriptorUpdateTemplateType templateType;
+	VkDescriptorSetLayout descriptorSetLayout;
+	VkPipelineBindPoint pipelineBindPoint;
+	VkPipelineLayout pipelineLayout;
+	uint32_t set;
+} VkDescriptorUpdateTemplateCreateInfo;
+
+typedef VkResult(VKAPI_PTR *PFN_vkCreateDescriptorUpdateTemplate)(
+    VkDevice device, const VkDescriptorUpdateTemplateCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator,
+    VkDescriptorUpdateTemplate *pDescriptorUpdateTemplate);
+typedef void(VKAPI_PTR *PFN_vkDestroyDescriptorUpdateTemplate)(VkDevice device,
+                                                               VkDescriptorUpdateTemplate descriptorUpdateTemplate,
+                                                               const VkAllocationCallbacks *pAllocator);
+typedef void(VKAPI_PTR *PFN_vkUpdateDescriptorSetWithTemplate)(VkDevice device, VkDescriptorSet descriptorSet,
+                                                               VkDescriptorUpdateTemplate descriptorUpdateTemplate,
+                                                               const void *pData);
+#endif
+
+namespace MPD
+{
+
+class DescriptorUpdateTemplate : public BaseObject
+{
+public:
+	using VulkanType = VkDescriptorUpdateTemplate;
+	// VK_DEBUG_REPORT_OBJECT_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_EXT, which the bundled headers do not have either.
+	static const VkDebugReportObjectTypeEXT VULKAN_OBJECT_TYPE = static_cast<VkDebugReportObjectTypeEXT>(1000085000);
+
+	DescriptorUpdateTemplate(Device *device, uint64_t objHandle_)
+	    : BaseObject(device, objHandle_, VULKAN_OBJECT_TYPE)
+	{
+	}
+
+	VkResult init(const VkDescriptorUpdateTemplateCreateInfo *pCreateInfo);
+
+	/// A run of image views to copy from the template data into consecutive slots of a descriptor set.
+	/// Compiled once from the template entries, using the binding table of the set layout.
+	struct ImageViewCopy
+	{
+		uint32_t slot;
+		uint32_t count;
+		size_t offset;
+		size_t stride;
+	};
+
+	const std::vector<ImageViewCopy> &getImageViewCopies() const
+	{
+		return imageViewCopies;
+	}
+
+	/// Expands an update into the equivalent descriptor writes, so captures do not need to know about templates.
+	/// The writes point into the given arrays, which must stay alive as long as the writes.
+	void expandWrites(VkDescriptorSet set, const void *pData, std::vector<VkWriteDescriptorSet> &writes,
+	                  std::vector<VkDescriptorImageInfo> &imageInfos, std::vector<VkDescriptorBufferInfo> &bufferInfos,
+	                  std::vector<VkBufferView> &texelBufferViews) const;
+
+private:
+	std::vector<ImageViewCopy> imageViewCopies;
+	std::vector<VkDescriptorUpdateTemplateEntry> entries;
+	uint32_t descriptorCount = 0;
+};
+}
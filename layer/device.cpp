@@ -20,6 +20,7 @@
 
 #include "device.hpp"
 #include "buffer.hpp"
+#include "capture.hpp"
 #include "commandbuffer.hpp"
 #include "commandpool.hpp"
 #include "descriptor_pool.hpp"
@@ -43,6 +44,10 @@ namespace MPD
 {
 Device::Device(Instance *inst, uint64_t objHandle_)
     : BaseInstanceObject(inst, objHandle_, VULKAN_OBJECT_TYPE)
+    , bandwidthTracker(*this)
+    , transientMemoryTracker(*this)
+    , memoryAliasingAdvisor(*this)
+    , shaderCostTracker(*this)
 {
 }
 
@@ -50,6 +55,42 @@ Device::~Device()
 {
 }
 
+// Color bits per pixel which fit in the tile buffer at the full 16x16 tile size.
+static const struct
+{
+	const char *architecture;
+	uint32_t bitsPerPixel;
+} tileBufferBudgets[] = {
+	{ "midgard", 128 },
+	{ "bifrost", 128 },
+	{ "valhall", 256 },
+};
+
+void Device::initTileBufferBudget()
+{
+	auto &cfg = getConfig();
+	if (cfg.tileBufferBudgetBitsPerPixel)
+	{
+		tileBufferBudget = cfg.tileBufferBudgetBitsPerPixel;
+		return;
+	}
+
+	for (auto &budget : tileBufferBudgets)
+	{
+		if (cfg.tileBufferArchitecture == budget.architecture)
+		{
+			tileBufferBudget = budget.bitsPerPixel;
+			return;
+		}
+	}
+
+	log(VK_DEBUG_REPORT_WARNING_BIT_EXT, 0,
+	    "Unknown tileBufferArchitecture \"%s\" in the config, assuming bifrost. "
+	    "Supported values are midgard, bifrost and valhall.",
+	    cfg.tileBufferArchitecture.c_str());
+	tileBufferBudget = 128;
+}
+
 void Device::setQueue(uint32_t family, uint32_t index, VkQueue queue)
 {
 	if (family >= queueFamilies.size())
@@ -80,6 +121,33 @@ VkResult Device::init(VkPhysicalDevice gpu_, VkDevice device_, const VkLayerInst
 	getInstanceTable()->GetPhysicalDeviceMemoryProperties(gpu, &memoryProperties);
 	getInstanceTable()->GetPhysicalDeviceProperties(gpu, &properties);
 
+	auto getProcAddr = [this](const char *name, const char *khrName) {
+		auto proc = pTable->GetDeviceProcAddr(device, name);
+		return proc ? proc : pTable->GetDeviceProcAddr(device, khrName);
+	};
+	descriptorUpdateTemplateTable.CreateDescriptorUpdateTemplate =
+	    reinterpret_cast<PFN_vkCreateDescriptorUpdateTemplate>(
+	        getProcAddr("vkCreateDescriptorUpdateTemplate", "vkCreateDescriptorUpdateTemplateKHR"));
+	descriptorUpdateTemplateTable.DestroyDescriptorUpdateTemplate =
+	    reinterpret_cast<PFN_vkDestroyDescriptorUpdateTemplate>(
+	        getProcAddr("vkDestroyDescriptorUpdateTemplate", "vkDestroyDescriptorUpdateTemplateKHR"));
+	descriptorUpdateTemplateTable.UpdateDescriptorSetWithTemplate =
+	    reinterpret_cast<PFN_vkUpdateDescriptorSetWithTemplate>(
+	        getProcAddr("vkUpdateDescriptorSetWithTemplate", "vkUpdateDescriptorSetWithTemplateKHR"));
+
+	initTileBufferBudget();
+
+	const auto &captureFilename = getConfig().captureFilename;
+	if (!captureFilename.empty())
+	{
+		capture.reset(new CaptureWriter);
+		if (!capture->open(captureFilename))
+		{
+			MPD_LOG("Failed to open capture file: %s.\n", captureFilename.c_str());
+			capture.reset();
+		}
+	}
+
 	return VK_SUCCESS;
 }
 
@@ -108,6 +176,13 @@ void Device::freeDescriptorSets(DescriptorPool *pool)
 	}
 }
 
+void Device::reportPipelineLayoutUsage()
+{
+	auto &map = static_cast<std::unordered_map<VkPipelineLayout, std::unique_ptr<PipelineLayout>> &>(maps);
+	for (auto &layout : map)
+		layout.second->reportUsage();
+}
+
 void Device::freeCommandBuffers(CommandPool *pool)
 {
 	MPD_ASSERT(pool);
@@ -19,8 +19,14 @@
  */
 
 #pragma once
+#include "bandwidth_tracker.hpp"
 #include "base_object.hpp"
 #include "config.hpp"
+#include "descriptor_update_template.hpp"
+#include "memory_aliasing_advisor.hpp"
+#include "render_pass_merge_advisor.hpp"
+#include "shader_cost_tracker.hpp"
+#include "transient_memory_tracker.hpp"
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -46,6 +52,8 @@ class SwapchainKHR;
 class Queue;
 class Event;
 class PipelineLayout;
+class DescriptorUpdateTemplate;
+class CaptureWriter;
 
 #define MPD_OBJECT_MAP(ourType) std::unordered_map<Vk##ourType, std::unique_ptr<ourType>>
 
@@ -66,7 +74,8 @@ class ObjectMaps : public MPD_OBJECT_MAP(CommandBuffer),
                    public MPD_OBJECT_MAP(Queue),
                    public MPD_OBJECT_MAP(SwapchainKHR),
                    public MPD_OBJECT_MAP(Event),
-                   public MPD_OBJECT_MAP(PipelineLayout)
+                   public MPD_OBJECT_MAP(PipelineLayout),
+                   public MPD_OBJECT_MAP(DescriptorUpdateTemplate)
 {
 };
 
@@ -100,6 +109,20 @@ public:
 		return pInstanceTable;
 	}
 
+	/// Descriptor update templates are missing from the dispatch table, so they are looked up separately.
+	/// Either the core or the KHR entry points, they are interchangeable. Null if the device supports neither.
+	struct DescriptorUpdateTemplateTable
+	{
+		PFN_vkCreateDescriptorUpdateTemplate CreateDescriptorUpdateTemplate;
+		PFN_vkDestroyDescriptorUpdateTemplate DestroyDescriptorUpdateTemplate;
+		PFN_vkUpdateDescriptorSetWithTemplate UpdateDescriptorSetWithTemplate;
+	};
+
+	const DescriptorUpdateTemplateTable &getDescriptorUpdateTemplateTable() const
+	{
+		return descriptorUpdateTemplateTable;
+	}
+
 	const VkPhysicalDeviceMemoryProperties &getMemoryProperties() const
 	{
 		return memoryProperties;
@@ -159,18 +182,101 @@ public:
 	void freeDescriptorSets(DescriptorPool *pool);
 	void freeCommandBuffers(CommandPool *pool);
 
+	/// Reports the usage of pipeline layouts the application did not destroy, called when the device is destroyed.
+	void reportPipelineLayoutUsage();
+
 	const Config &getConfig() const;
 
+	/// Returns the API capture writer, or nullptr if capturing is disabled.
+	CaptureWriter *getCapture() const
+	{
+		return capture.get();
+	}
+
+	/// Returns true if commands should only be captured, leaving all analysis to perfdoc-analyze.
+	bool isRecordOnly() const
+	{
+		return capture && getConfig().captureRecordOnly;
+	}
+
+	BandwidthTracker &getBandwidthTracker()
+	{
+		return bandwidthTracker;
+	}
+
+	MemoryAliasingAdvisor &getMemoryAliasingAdvisor()
+	{
+		return memoryAliasingAdvisor;
+	}
+
+	TransientMemoryTracker &getTransientMemoryTracker()
+	{
+		return transientMemoryTracker;
+	}
+
+	RenderPassMergeAdvisor &getRenderPassMergeAdvisor()
+	{
+		return renderPassMergeAdvisor;
+	}
+
+	ShaderCostTracker &getShaderCostTracker()
+	{
+		return shaderCostTracker;
+	}
+
+	/// Color bits per pixel which fit in the tile buffer at full tile size, for the configured architecture.
+	uint32_t getTileBufferBudget() const
+	{
+		return tileBufferBudget;
+	}
+
+	/// Descriptor sets and image views signal their usage at most once per epoch.
+	/// The epoch advances on every submit, at render pass boundaries and whenever an image changes state,
+	/// as signaling again could then give a different result.
+	uint64_t getUsageEpoch() const
+	{
+		return usageEpoch;
+	}
+
+	void advanceUsageEpoch()
+	{
+		usageEpoch++;
+	}
+
+	/// Counts redundant vkCmdBind* calls submitted in the current frame, returns the total so far.
+	uint64_t addRedundantBinds(uint32_t count)
+	{
+		redundantBindsThisFrame += count;
+		return redundantBindsThisFrame;
+	}
+
+	void endFrame()
+	{
+		redundantBindsThisFrame = 0;
+	}
+
 private:
 	VkPhysicalDevice gpu = VK_NULL_HANDLE;
 	VkDevice device = VK_NULL_HANDLE;
 	const VkLayerInstanceDispatchTable *pInstanceTable = nullptr;
 	VkLayerDispatchTable *pTable = nullptr;
+	DescriptorUpdateTemplateTable descriptorUpdateTemplateTable = {};
 
 	ObjectMaps maps;
 	VkPhysicalDeviceMemoryProperties memoryProperties;
 	VkPhysicalDeviceProperties properties;
 
 	std::vector<std::vector<VkQueue>> queueFamilies;
+	std::unique_ptr<CaptureWriter> capture;
+	BandwidthTracker bandwidthTracker;
+	TransientMemoryTracker transientMemoryTracker;
+	MemoryAliasingAdvisor memoryAliasingAdvisor;
+	RenderPassMergeAdvisor renderPassMergeAdvisor;
+	ShaderCostTracker shaderCostTracker;
+	uint64_t usageEpoch = 1;
+	uint64_t redundantBindsThisFrame = 0;
+	uint32_t tileBufferBudget = 0;
+
+	void initTileBufferBudget();
 };
 }
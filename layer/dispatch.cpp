@@ -32,11 +32,13 @@
 #include "message_codes.hpp"
 
 #include "buffer.hpp"
+#include "capture.hpp"
 #include "commandbuffer.hpp"
 #include "commandpool.hpp"
 #include "descriptor_pool.hpp"
 #include "descriptor_set.hpp"
 #include "descriptor_set_layout.hpp"
+#include "descriptor_update_template.hpp"
 #include "device_memory.hpp"
 #include "event.hpp"
 #include "framebuffer.hpp"
@@ -114,6 +116,8 @@ static VKAPI_ATTR VkResult VKAPI_CALL CreateDevice(VkPhysicalDevice gpu, const V
 			VkQueue queue;
 			device->getTable()->GetDeviceQueue(*pDevice, family, j, &queue);
 			device->setQueue(family, j, queue);
+			if (device->getCapture())
+				device->getCapture()->getDeviceQueue(family, j, queue);
 
 			auto *pQueue = device->alloc<Queue>(queue);
 			MPD_ASSERT(pQueue);
@@ -200,6 +204,9 @@ static VKAPI_ATTR VkResult VKAPI_CALL CreateCommandPool(VkDevice device, const V
 		}
 		else
 		{
+			if (layer->getCapture())
+				layer->getCapture()->createCommandPool(*pCommandPool, *pCreateInfo);
+
 			if (pCreateInfo->flags & VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT)
 			{
 				commandPool->log(
@@ -221,6 +228,9 @@ static VKAPI_ATTR void VKAPI_CALL DestroyCommandPool(VkDevice device, VkCommandP
 	auto *layer = getLayerData(key, deviceData);
 	layer->getTable()->DestroyCommandPool(device, commandPool, pAllocator);
 
+	if (layer->getCapture())
+		layer->getCapture()->destroyObject(CAPTURE_OP_DESTROY_COMMAND_POOL, commandPool);
+
 	// destroyCommandPool will also destroy any commandbuffers allocated to this pool
 	layer->destroy<CommandPool>(commandPool);
 }
@@ -254,6 +264,9 @@ static VKAPI_ATTR VkResult VKAPI_CALL AllocateCommandBuffers(VkDevice device,
 				layer->destroy<CommandBuffer>(pCommandBuffers[i]);
 			}
 		}
+
+		if (layer->getCapture())
+			layer->getCapture()->allocateCommandBuffers(*pAllocateInfo, pCommandBuffers);
 	}
 
 	return result;
@@ -269,6 +282,9 @@ static VKAPI_ATTR void VKAPI_CALL FreeCommandBuffers(VkDevice device, VkCommandP
 	auto *layer = getLayerData(key, deviceData);
 	layer->getTable()->FreeCommandBuffers(device, commandPool, commandBufferCount, pCommandBuffers);
 
+	if (layer->getCapture())
+		layer->getCapture()->freeCommandBuffers(commandPool, commandBufferCount, pCommandBuffers);
+
 	for (uint32_t i = 0; i < commandBufferCount; i++)
 	{
 		// destroy internal commandbuffer and remove from pool
@@ -299,9 +315,27 @@ static VKAPI_ATTR VkResult VKAPI_CALL BeginCommandBuffer(VkCommandBuffer command
 		pCommandBuffer->log(VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT, MESSAGE_CODE_COMMAND_BUFFER_SIMULTANEOUS_USE,
 		                    "VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT is set.");
 	}
+
+	if (layer->getCapture())
+		layer->getCapture()->beginCommandBuffer(commandBuffer, *pBeginInfo);
+
 	return layer->getTable()->BeginCommandBuffer(commandBuffer, pBeginInfo);
 }
 
+static VKAPI_ATTR VkResult VKAPI_CALL EndCommandBuffer(VkCommandBuffer commandBuffer)
+{
+	// Only intercepted when capturing.
+	lock_guard<mutex> holder{ globalLock };
+
+	void *key = getDispatchKey(commandBuffer);
+	auto *layer = getLayerData(key, deviceData);
+
+	if (layer->getCapture())
+		layer->getCapture()->destroyObject(CAPTURE_OP_END_COMMAND_BUFFER, commandBuffer);
+
+	return layer->getTable()->EndCommandBuffer(commandBuffer);
+}
+
 static VKAPI_ATTR VkResult VKAPI_CALL CreateEvent(VkDevice device, const VkEventCreateInfo *pCreateInfo,
                                                   const VkAllocationCallbacks *pAllocator, VkEvent *pEvent)
 {
@@ -436,6 +470,8 @@ static VKAPI_ATTR VkResult VKAPI_CALL CreateBuffer(VkDevice device, const VkBuff
 			layer->destroy<Buffer>(*pBuffer);
 			layer->getTable()->DestroyBuffer(device, *pBuffer, pCallbacks);
 		}
+		else if (layer->getCapture())
+			layer->getCapture()->createBuffer(*pBuffer, *pCreateInfo);
 	}
 	return res;
 }
@@ -453,6 +489,8 @@ static VKAPI_ATTR VkResult VKAPI_CALL BindBufferMemory(VkDevice device, VkBuffer
 	auto res = pBuffer->bindMemory(pMemory, offset);
 	if (res == VK_SUCCESS)
 		res = layer->getTable()->BindBufferMemory(device, buffer, memory, offset);
+	if (res == VK_SUCCESS && layer->getCapture())
+		layer->getCapture()->bindBufferMemory(buffer, memory, offset);
 	return res;
 }
 
@@ -469,6 +507,8 @@ static VKAPI_ATTR VkResult VKAPI_CALL BindImageMemory(VkDevice device, VkImage i
 	auto res = pImage->bindMemory(pMemory, offset);
 	if (res == VK_SUCCESS)
 		res = layer->getTable()->BindImageMemory(device, image, memory, offset);
+	if (res == VK_SUCCESS && layer->getCapture())
+		layer->getCapture()->bindImageMemory(image, memory, offset);
 	return res;
 }
 
@@ -479,6 +519,9 @@ static VKAPI_ATTR void VKAPI_CALL DestroyBuffer(VkDevice device, VkBuffer buffer
 	void *key = getDispatchKey(device);
 	auto *layer = getLayerData(key, deviceData);
 
+	if (layer->getCapture())
+		layer->getCapture()->destroyObject(CAPTURE_OP_DESTROY_BUFFER, buffer);
+
 	layer->destroy<Buffer>(buffer);
 	layer->getTable()->DestroyBuffer(device, buffer, pCallbacks);
 }
@@ -520,7 +563,11 @@ static VKAPI_ATTR VkResult VKAPI_CALL CreateSwapchainKHR(VkDevice device, const
 			MPD_ASSERT(oldSwapchain != nullptr);
 			for (auto &swapchainImage : swapchainImages)
 				if (oldSwapchain->potentiallySteal(swapchainImage))
+				{
 					layer->destroy<Image>(swapchainImage);
+					if (layer->getCapture())
+						layer->getCapture()->destroyObject(CAPTURE_OP_DESTROY_IMAGE, swapchainImage);
+				}
 		}
 
 		VkImageCreateInfo imageCreateInfo = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
@@ -566,6 +613,11 @@ static VKAPI_ATTR VkResult VKAPI_CALL CreateSwapchainKHR(VkDevice device, const
 			layer->getTable()->DestroySwapchainKHR(device, *pSwapchain, pAllocator);
 			return res;
 		}
+
+		// There is no surface when replaying, so swapchain images are captured as plain images.
+		if (layer->getCapture())
+			for (auto &swapchainImage : swapchainImages)
+				layer->getCapture()->createSwapchainImage(swapchainImage, imageCreateInfo);
 	}
 	return res;
 }
@@ -586,13 +638,32 @@ static VKAPI_ATTR void VKAPI_CALL DestroySwapchainKHR(VkDevice device, VkSwapcha
 		{
 			// Swapchain images may have been reused in oldSwapchain.
 			if (image != VK_NULL_HANDLE)
+			{
 				layer->destroy<Image>(image);
+				if (layer->getCapture())
+					layer->getCapture()->destroyObject(CAPTURE_OP_DESTROY_IMAGE, image);
+			}
 		}
 		layer->destroy<SwapchainKHR>(swapchain);
 	}
 	layer->getTable()->DestroySwapchainKHR(device, swapchain, pAllocator);
 }
 
+static VKAPI_ATTR VkResult VKAPI_CALL QueuePresentKHR(VkQueue queue, const VkPresentInfoKHR *pPresentInfo)
+{
+	lock_guard<mutex> holder{ globalLock };
+	void *key = getDispatchKey(queue);
+	auto *layer = getLayerData(key, deviceData);
+
+	// Presentation delimits frames for the periodic reports.
+	layer->getBandwidthTracker().endFrame();
+	layer->getTransientMemoryTracker().endFrame();
+	layer->getMemoryAliasingAdvisor().endFrame();
+	layer->getShaderCostTracker().endFrame();
+	layer->endFrame();
+	return layer->getTable()->QueuePresentKHR(queue, pPresentInfo);
+}
+
 static VKAPI_ATTR VkResult VKAPI_CALL GetSwapchainImagesKHR(VkDevice device, VkSwapchainKHR swapchain,
                                                             uint32_t *pSwapchainImageCount, VkImage *pSwapchainImages)
 {
@@ -643,6 +714,8 @@ static VKAPI_ATTR VkResult VKAPI_CALL CreateImage(VkDevice device, const VkImage
 			layer->destroy<Image>(*pImage);
 			layer->getTable()->DestroyImage(device, *pImage, pCallbacks);
 		}
+		else if (layer->getCapture())
+			layer->getCapture()->createImage(*pImage, *pCreateInfo);
 	}
 	return res;
 }
@@ -679,6 +752,11 @@ static VKAPI_ATTR VkResult VKAPI_CALL AllocateMemory(VkDevice device, const VkMe
 			layer->destroy<DeviceMemory>(*pMemory);
 			layer->getTable()->FreeMemory(device, *pMemory, pCallbacks);
 		}
+		else if (layer->getCapture())
+		{
+			const auto &memoryType = layer->getMemoryProperties().memoryTypes[pAllocateInfo->memoryTypeIndex];
+			layer->getCapture()->allocateMemory(*pMemory, *pAllocateInfo, memoryType.propertyFlags);
+		}
 	}
 	return res;
 }
@@ -737,6 +815,8 @@ static VKAPI_ATTR VkResult VKAPI_CALL CreateRenderPass(VkDevice device, const Vk
 			layer->destroy<RenderPass>(*pRenderPass);
 			layer->getTable()->DestroyRenderPass(device, *pRenderPass, pAllocator);
 		}
+		else if (layer->getCapture())
+			layer->getCapture()->createRenderPass(*pRenderPass, *pCreateInfo);
 	}
 	return res;
 }
@@ -777,6 +857,10 @@ static VKAPI_ATTR VkResult VKAPI_CALL CreateGraphicsPipelines(VkDevice device, V
 				break;
 			}
 		}
+
+		if (res == VK_SUCCESS && layer->getCapture())
+			for (uint32_t i = 0; i < createInfoCount; i++)
+				layer->getCapture()->createGraphicsPipeline(pPipelines[i], pCreateInfos[i]);
 	}
 	return res;
 }
@@ -817,6 +901,10 @@ static VKAPI_ATTR VkResult VKAPI_CALL CreateComputePipelines(VkDevice device, Vk
 				break;
 			}
 		}
+
+		if (res == VK_SUCCESS && layer->getCapture())
+			for (uint32_t i = 0; i < createInfoCount; i++)
+				layer->getCapture()->createComputePipeline(pPipelines[i], pCreateInfos[i]);
 	}
 	return res;
 }
@@ -827,6 +915,9 @@ static VKAPI_ATTR void VKAPI_CALL DestroyPipeline(VkDevice device, VkPipeline pi
 	lock_guard<mutex> holder{ globalLock };
 	void *key = getDispatchKey(device);
 	auto *layer = getLayerData(key, deviceData);
+	if (layer->getCapture())
+		layer->getCapture()->destroyObject(CAPTURE_OP_DESTROY_PIPELINE, pipeline);
+
 	layer->destroy<Pipeline>(pipeline);
 	layer->getTable()->DestroyPipeline(device, pipeline, pAllocator);
 }
@@ -838,6 +929,9 @@ static VKAPI_ATTR void VKAPI_CALL DestroyRenderPass(VkDevice device, VkRenderPas
 	void *key = getDispatchKey(device);
 	auto *layer = getLayerData(key, deviceData);
 
+	if (layer->getCapture())
+		layer->getCapture()->destroyObject(CAPTURE_OP_DESTROY_RENDER_PASS, renderPass);
+
 	layer->destroy<RenderPass>(renderPass);
 	layer->getTable()->DestroyRenderPass(device, renderPass, pAllocator);
 }
@@ -861,6 +955,8 @@ static VKAPI_ATTR VkResult VKAPI_CALL CreateFramebuffer(VkDevice device, const V
 			layer->destroy<Framebuffer>(*pFramebuffer);
 			layer->getTable()->DestroyFramebuffer(device, *pFramebuffer, pAllocator);
 		}
+		else if (layer->getCapture())
+			layer->getCapture()->createFramebuffer(*pFramebuffer, *pCreateInfo);
 	}
 	return res;
 }
@@ -872,6 +968,9 @@ static VKAPI_ATTR void VKAPI_CALL DestroyFramebuffer(VkDevice device, VkFramebuf
 	void *key = getDispatchKey(device);
 	auto *layer = getLayerData(key, deviceData);
 
+	if (layer->getCapture())
+		layer->getCapture()->destroyObject(CAPTURE_OP_DESTROY_FRAMEBUFFER, framebuffer);
+
 	layer->destroy<Framebuffer>(framebuffer);
 	layer->getTable()->DestroyFramebuffer(device, framebuffer, pAllocator);
 }
@@ -894,6 +993,8 @@ static VKAPI_ATTR VkResult VKAPI_CALL CreateImageView(VkDevice device, const VkI
 			layer->destroy<ImageView>(*pImageView);
 			layer->getTable()->DestroyImageView(device, *pImageView, pAllocator);
 		}
+		else if (layer->getCapture())
+			layer->getCapture()->createImageView(*pImageView, *pCreateInfo);
 	}
 	return res;
 }
@@ -905,6 +1006,9 @@ static VKAPI_ATTR void VKAPI_CALL DestroyImageView(VkDevice device, VkImageView
 	void *key = getDispatchKey(device);
 	auto *layer = getLayerData(key, deviceData);
 
+	if (layer->getCapture())
+		layer->getCapture()->destroyObject(CAPTURE_OP_DESTROY_IMAGE_VIEW, imageView);
+
 	layer->destroy<ImageView>(imageView);
 	layer->getTable()->DestroyImageView(device, imageView, pAllocator);
 }
@@ -916,6 +1020,9 @@ static VKAPI_ATTR void VKAPI_CALL FreeMemory(VkDevice device, VkDeviceMemory mem
 	void *key = getDispatchKey(device);
 	auto *layer = getLayerData(key, deviceData);
 
+	if (layer->getCapture())
+		layer->getCapture()->destroyObject(CAPTURE_OP_FREE_MEMORY, memory);
+
 	layer->destroy<DeviceMemory>(memory);
 	layer->getTable()->FreeMemory(device, memory, pCallbacks);
 }
@@ -926,6 +1033,12 @@ static VKAPI_ATTR void VKAPI_CALL DestroyImage(VkDevice device, VkImage image, c
 	void *key = getDispatchKey(device);
 	auto *layer = getLayerData(key, deviceData);
 
+	if (layer->getCapture())
+		layer->getCapture()->destroyObject(CAPTURE_OP_DESTROY_IMAGE, image);
+
+	auto *pImage = layer->get<Image>(image);
+	if (pImage)
+		pImage->signalDestroy();
 	layer->destroy<Image>(image);
 	layer->getTable()->DestroyImage(device, image, pCallbacks);
 }
@@ -945,17 +1058,25 @@ static VKAPI_ATTR void VKAPI_CALL CmdResolveImage(VkCommandBuffer commandBuffer,
 	auto *src = layer->get<Image>(srcImage);
 	auto *dst = layer->get<Image>(dstImage);
 
+	BandwidthEstimate bandwidth;
 	for (uint32_t i = 0; i < regionCount; i++)
 	{
 		// Capture-by-value is vital.
 		auto srcRegion = pRegions[i].srcSubresource;
 		auto dstRegion = pRegions[i].dstSubresource;
+		auto dstUsage = dst->coversMipLevel(dstRegion, pRegions[i].dstOffset, pRegions[i].extent) ?
+		                    Image::Usage::ResourceOverwrite :
+		                    Image::Usage::ResourceWrite;
 
 		cmd->enqueueDeferredFunction([=](Queue &) {
 			src->signalUsage(srcRegion, Image::Usage::ResourceRead);
-			dst->signalUsage(dstRegion, Image::Usage::ResourceWrite);
+			dst->signalUsage(dstRegion, dstUsage);
 		});
+
+		bandwidth.readBytes += BandwidthTracker::imageRegionBytes(*src, pRegions[i].extent, srcRegion.layerCount);
+		bandwidth.writeBytes += BandwidthTracker::imageRegionBytes(*dst, pRegions[i].extent, dstRegion.layerCount);
 	}
+	cmd->addTransferBandwidth(bandwidth);
 
 	// Using this function is always a really bad idea, flat out warn on any use of this function.
 	cmd->log(VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT, MESSAGE_CODE_RESOLVE_IMAGE,
@@ -966,6 +1087,9 @@ static VKAPI_ATTR void VKAPI_CALL CmdResolveImage(VkCommandBuffer commandBuffer,
 
 	layer->getTable()->CmdResolveImage(commandBuffer, srcImage, srcImageLayout, dstImage, dstImageLayout, regionCount,
 	                                   pRegions);
+	if (layer->getCapture())
+		layer->getCapture()->cmdCopyImage(CAPTURE_OP_CMD_RESOLVE_IMAGE, commandBuffer, srcImage, srcImageLayout,
+		                                  dstImage, dstImageLayout, regionCount, pRegions, sizeof(*pRegions));
 }
 
 static VKAPI_ATTR VkResult VKAPI_CALL CreatePipelineLayout(VkDevice device,
@@ -989,6 +1113,8 @@ static VKAPI_ATTR VkResult VKAPI_CALL CreatePipelineLayout(VkDevice device,
 		{
 			layer->destroy<PipelineLayout>(*pLayout);
 		}
+		else if (layer->getCapture())
+			layer->getCapture()->createPipelineLayout(*pLayout, *pCreateInfo);
 	}
 
 	return result;
@@ -1001,6 +1127,13 @@ static VKAPI_ATTR void VKAPI_CALL DestroyPipelineLayout(VkDevice device, VkPipel
 	void *key = getDispatchKey(device);
 	auto *layer = getLayerData(key, deviceData);
 
+	if (layer->getCapture())
+		layer->getCapture()->destroyObject(CAPTURE_OP_DESTROY_PIPELINE_LAYOUT, layout);
+
+	auto *pipelineLayout = layer->get<PipelineLayout>(layout);
+	if (pipelineLayout)
+		pipelineLayout->reportUsage();
+
 	layer->destroy<PipelineLayout>(layout);
 	layer->getTable()->DestroyPipelineLayout(device, layout, pAllocator);
 }
@@ -1026,6 +1159,8 @@ static VKAPI_ATTR VkResult VKAPI_CALL CreateDescriptorSetLayout(VkDevice device,
 		{
 			layer->destroy<DescriptorSetLayout>(*pSetLayout);
 		}
+		else if (layer->getCapture())
+			layer->getCapture()->createDescriptorSetLayout(*pSetLayout, *pCreateInfo);
 	}
 
 	return result;
@@ -1038,6 +1173,9 @@ static VKAPI_ATTR void VKAPI_CALL DestroyDescriptorSetLayout(VkDevice device, Vk
 	void *key = getDispatchKey(device);
 	auto *layer = getLayerData(key, deviceData);
 
+	if (layer->getCapture())
+		layer->getCapture()->destroyObject(CAPTURE_OP_DESTROY_DESCRIPTOR_SET_LAYOUT, layout);
+
 	layer->destroy<DescriptorSetLayout>(layout);
 	layer->getTable()->DestroyDescriptorSetLayout(device, layout, pCallbacks);
 }
@@ -1062,6 +1200,8 @@ static VKAPI_ATTR VkResult VKAPI_CALL CreateDescriptorPool(VkDevice device,
 		{
 			layer->destroy<DescriptorPool>(*pDescriptorPool);
 		}
+		else if (layer->getCapture())
+			layer->getCapture()->createDescriptorPool(*pDescriptorPool, *pCreateInfo);
 	}
 
 	return result;
@@ -1074,6 +1214,13 @@ static VKAPI_ATTR void VKAPI_CALL DestroyDescriptorPool(VkDevice device, VkDescr
 	void *key = getDispatchKey(device);
 	auto *layer = getLayerData(key, deviceData);
 
+	if (layer->getCapture())
+		layer->getCapture()->destroyObject(CAPTURE_OP_DESTROY_DESCRIPTOR_POOL, descriptorPool);
+
+	auto *pool = layer->get<DescriptorPool>(descriptorPool);
+	if (pool)
+		pool->reportSizing();
+
 	layer->destroy<DescriptorPool>(descriptorPool);
 	layer->getTable()->DestroyDescriptorPool(device, descriptorPool, pAllocator);
 }
@@ -1087,6 +1234,9 @@ static VKAPI_ATTR VkResult VKAPI_CALL ResetDescriptorPool(VkDevice device, VkDes
 	auto *pool = layer->get<DescriptorPool>(descriptorPool);
 	pool->reset();
 
+	if (layer->getCapture())
+		layer->getCapture()->destroyObject(CAPTURE_OP_RESET_DESCRIPTOR_POOL, descriptorPool);
+
 	return layer->getTable()->ResetDescriptorPool(device, descriptorPool, flags);
 }
 
@@ -1119,6 +1269,8 @@ static VKAPI_ATTR VkResult VKAPI_CALL AllocateDescriptorSets(VkDevice device,
 				layer->destroy<DescriptorSet>(pDescriptorSets[j]);
 			}
 		}
+		else if (layer->getCapture())
+			layer->getCapture()->allocateDescriptorSets(*pAllocateInfo, pDescriptorSets);
 	}
 
 	return result;
@@ -1137,6 +1289,9 @@ static VKAPI_ATTR VkResult VKAPI_CALL FreeDescriptorSets(VkDevice device, VkDesc
 		layer->destroy<DescriptorSet>(pDescriptorSets[i]);
 	}
 
+	if (layer->getCapture())
+		layer->getCapture()->freeDescriptorSets(descriptorPool, descriptorSetCount, pDescriptorSets);
+
 	return layer->getTable()->FreeDescriptorSets(device, descriptorPool, descriptorSetCount, pDescriptorSets);
 }
 
@@ -1225,6 +1380,10 @@ static VKAPI_ATTR void VKAPI_CALL DestroyDevice(VkDevice device, const VkAllocat
 
 	void *key = getDispatchKey(device);
 	auto *layer = getLayerData(key, deviceData);
+	layer->getBandwidthTracker().flush();
+	layer->getTransientMemoryTracker().flush();
+	layer->getShaderCostTracker().flush();
+	layer->reportPipelineLayoutUsage();
 	layer->getTable()->DestroyDevice(device, pAllocator);
 	destroyLayerData(key, deviceData);
 }
@@ -1248,6 +1407,8 @@ static VKAPI_ATTR void VKAPI_CALL CmdExecuteCommands(VkCommandBuffer commandBuff
 	}
 
 	layer->getTable()->CmdExecuteCommands(commandBuffer, commandBufferCount, pCommandBuffers);
+	if (layer->getCapture())
+		layer->getCapture()->cmdExecuteCommands(commandBuffer, commandBufferCount, pCommandBuffers);
 }
 
 static VKAPI_ATTR void VKAPI_CALL CmdBindIndexBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer,
@@ -1266,6 +1427,8 @@ static VKAPI_ATTR void VKAPI_CALL CmdBindIndexBuffer(VkCommandBuffer commandBuff
 
 	layer->getTable()->CmdBindIndexBuffer(commandBuffer, buffer, offset, indexType);
 	cmdBuffer->bindIndexBuffer(index_buffer, offset, indexType);
+	if (layer->getCapture())
+		layer->getCapture()->cmdBindIndexBuffer(commandBuffer, buffer, offset, indexType);
 }
 
 static VKAPI_ATTR void VKAPI_CALL CmdBindPipeline(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint,
@@ -1281,6 +1444,8 @@ static VKAPI_ATTR void VKAPI_CALL CmdBindPipeline(VkCommandBuffer commandBuffer,
 
 	layer->getTable()->CmdBindPipeline(commandBuffer, pipelineBindPoint, pipeline);
 	cmdBuffer->bindPipeline(pipelineBindPoint, pipeline);
+	if (layer->getCapture())
+		layer->getCapture()->cmdBindPipeline(commandBuffer, pipelineBindPoint, pipeline);
 }
 
 static VKAPI_ATTR void VKAPI_CALL CmdBeginRenderPass(VkCommandBuffer commandBuffer,
@@ -1297,6 +1462,8 @@ static VKAPI_ATTR void VKAPI_CALL CmdBeginRenderPass(VkCommandBuffer commandBuff
 
 	layer->getTable()->CmdBeginRenderPass(commandBuffer, pRenderPassBegin, contents);
 	cmdBuffer->beginRenderPass(pRenderPassBegin, contents);
+	if (layer->getCapture())
+		layer->getCapture()->cmdBeginRenderPass(commandBuffer, *pRenderPassBegin, contents);
 }
 
 static VKAPI_ATTR void VKAPI_CALL CmdNextSubpass(VkCommandBuffer commandBuffer, VkSubpassContents contents)
@@ -1311,6 +1478,8 @@ static VKAPI_ATTR void VKAPI_CALL CmdNextSubpass(VkCommandBuffer commandBuffer,
 
 	layer->getTable()->CmdNextSubpass(commandBuffer, contents);
 	cmdBuffer->nextSubpass(contents);
+	if (layer->getCapture())
+		layer->getCapture()->cmdNextSubpass(commandBuffer, contents);
 }
 
 static VKAPI_ATTR void VKAPI_CALL CmdEndRenderPass(VkCommandBuffer commandBuffer)
@@ -1325,6 +1494,8 @@ static VKAPI_ATTR void VKAPI_CALL CmdEndRenderPass(VkCommandBuffer commandBuffer
 
 	layer->getTable()->CmdEndRenderPass(commandBuffer);
 	cmdBuffer->endRenderPass();
+	if (layer->getCapture())
+		layer->getCapture()->destroyObject(CAPTURE_OP_CMD_END_RENDER_PASS, commandBuffer);
 }
 
 static VKAPI_ATTR void VKAPI_CALL CmdCopyBuffer(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkBuffer dstBuffer,
@@ -1340,7 +1511,14 @@ static VKAPI_ATTR void VKAPI_CALL CmdCopyBuffer(VkCommandBuffer commandBuffer, V
 	cmdBuffer->enqueueDeferredFunction(
 	    [=](Queue &queue) { queue.getQueueTracker().pushWork(QueueTracker::STAGE_TRANSFER); });
 
+	VkDeviceSize size = 0;
+	for (uint32_t i = 0; i < regionCount; i++)
+		size += pRegions[i].size;
+	cmdBuffer->addTransferBandwidth(BandwidthEstimate(size, size));
+
 	layer->getTable()->CmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, regionCount, pRegions);
+	if (layer->getCapture())
+		layer->getCapture()->cmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, regionCount, pRegions);
 }
 
 static VKAPI_ATTR void VKAPI_CALL CmdCopyImage(VkCommandBuffer commandBuffer, VkImage srcImage,
@@ -1358,23 +1536,34 @@ static VKAPI_ATTR void VKAPI_CALL CmdCopyImage(VkCommandBuffer commandBuffer, Vk
 	auto *src = layer->get<Image>(srcImage);
 	auto *dst = layer->get<Image>(dstImage);
 
+	BandwidthEstimate bandwidth;
 	for (uint32_t i = 0; i < regionCount; i++)
 	{
 		// Capture-by-value is vital.
 		auto srcRegion = pRegions[i].srcSubresource;
 		auto dstRegion = pRegions[i].dstSubresource;
+		auto dstUsage = dst->coversMipLevel(dstRegion, pRegions[i].dstOffset, pRegions[i].extent) ?
+		                    Image::Usage::ResourceOverwrite :
+		                    Image::Usage::ResourceWrite;
 
 		cmdBuffer->enqueueDeferredFunction([=](Queue &) {
 			src->signalUsage(srcRegion, Image::Usage::ResourceRead);
-			dst->signalUsage(dstRegion, Image::Usage::ResourceWrite);
+			dst->signalUsage(dstRegion, dstUsage);
 		});
+
+		bandwidth.readBytes += BandwidthTracker::imageRegionBytes(*src, pRegions[i].extent, srcRegion.layerCount);
+		bandwidth.writeBytes += BandwidthTracker::imageRegionBytes(*dst, pRegions[i].extent, dstRegion.layerCount);
 	}
+	cmdBuffer->addTransferBandwidth(bandwidth);
 
 	cmdBuffer->enqueueDeferredFunction(
 	    [=](Queue &queue) { queue.getQueueTracker().pushWork(QueueTracker::STAGE_TRANSFER); });
 
 	layer->getTable()->CmdCopyImage(commandBuffer, srcImage, srcImageLayout, dstImage, dstImageLayout, regionCount,
 	                                pRegions);
+	if (layer->getCapture())
+		layer->getCapture()->cmdCopyImage(CAPTURE_OP_CMD_COPY_IMAGE, commandBuffer, srcImage, srcImageLayout, dstImage,
+		                                  dstImageLayout, regionCount, pRegions, sizeof(*pRegions));
 }
 
 static VKAPI_ATTR void VKAPI_CALL CmdCopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer srcBuffer,
@@ -1390,18 +1579,27 @@ static VKAPI_ATTR void VKAPI_CALL CmdCopyBufferToImage(VkCommandBuffer commandBu
 
 	auto *dst = layer->get<Image>(dstImage);
 
+	VkDeviceSize size = 0;
 	for (uint32_t i = 0; i < regionCount; i++)
 	{
 		// Capture-by-value is vital.
 		auto dstRegion = pRegions[i].imageSubresource;
+		auto dstUsage = dst->coversMipLevel(dstRegion, pRegions[i].imageOffset, pRegions[i].imageExtent) ?
+		                    Image::Usage::ResourceOverwrite :
+		                    Image::Usage::ResourceWrite;
 
-		cmdBuffer->enqueueDeferredFunction([=](Queue &) { dst->signalUsage(dstRegion, Image::Usage::ResourceWrite); });
+		cmdBuffer->enqueueDeferredFunction([=](Queue &) { dst->signalUsage(dstRegion, dstUsage); });
+		size += BandwidthTracker::imageRegionBytes(*dst, pRegions[i].imageExtent, dstRegion.layerCount);
 	}
+	cmdBuffer->addTransferBandwidth(BandwidthEstimate(size, size));
 
 	cmdBuffer->enqueueDeferredFunction(
 	    [=](Queue &queue) { queue.getQueueTracker().pushWork(QueueTracker::STAGE_TRANSFER); });
 
 	layer->getTable()->CmdCopyBufferToImage(commandBuffer, srcBuffer, dstImage, dstImageLayout, regionCount, pRegions);
+	if (layer->getCapture())
+		layer->getCapture()->cmdCopyBufferImage(CAPTURE_OP_CMD_COPY_BUFFER_TO_IMAGE, commandBuffer, srcBuffer, dstImage,
+		                                        dstImageLayout, regionCount, pRegions);
 }
 
 static VKAPI_ATTR void VKAPI_CALL CmdCopyImageToBuffer(VkCommandBuffer commandBuffer, VkImage srcImage,
@@ -1417,18 +1615,35 @@ static VKAPI_ATTR void VKAPI_CALL CmdCopyImageToBuffer(VkCommandBuffer commandBu
 
 	auto *src = layer->get<Image>(srcImage);
 
+	VkDeviceSize size = 0;
 	for (uint32_t i = 0; i < regionCount; i++)
 	{
 		// Capture-by-value is vital.
 		auto dstRegion = pRegions[i].imageSubresource;
 
 		cmdBuffer->enqueueDeferredFunction([=](Queue &) { src->signalUsage(dstRegion, Image::Usage::ResourceRead); });
+		size += BandwidthTracker::imageRegionBytes(*src, pRegions[i].imageExtent, dstRegion.layerCount);
 	}
+	cmdBuffer->addTransferBandwidth(BandwidthEstimate(size, size));
 
 	cmdBuffer->enqueueDeferredFunction(
 	    [=](Queue &queue) { queue.getQueueTracker().pushWork(QueueTracker::STAGE_TRANSFER); });
 
 	layer->getTable()->CmdCopyImageToBuffer(commandBuffer, srcImage, srcImageLayout, dstBuffer, regionCount, pRegions);
+	if (layer->getCapture())
+		layer->getCapture()->cmdCopyBufferImage(CAPTURE_OP_CMD_COPY_IMAGE_TO_BUFFER, commandBuffer, dstBuffer, srcImage,
+		                                        srcImageLayout, regionCount, pRegions);
+}
+
+static VkOffset3D blitOffset(const VkOffset3D (&offsets)[2])
+{
+	return { min(offsets[0].x, offsets[1].x), min(offsets[0].y, offsets[1].y), min(offsets[0].z, offsets[1].z) };
+}
+
+static VkExtent3D blitExtent(const VkOffset3D (&offsets)[2])
+{
+	return { uint32_t(abs(offsets[1].x - offsets[0].x)), uint32_t(abs(offsets[1].y - offsets[0].y)),
+		     uint32_t(abs(offsets[1].z - offsets[0].z)) };
 }
 
 static VKAPI_ATTR void VKAPI_CALL CmdBlitImage(VkCommandBuffer commandBuffer, VkImage srcImage,
@@ -1446,23 +1661,37 @@ static VKAPI_ATTR void VKAPI_CALL CmdBlitImage(VkCommandBuffer commandBuffer, Vk
 	auto *src = layer->get<Image>(srcImage);
 	auto *dst = layer->get<Image>(dstImage);
 
+	BandwidthEstimate bandwidth;
 	for (uint32_t i = 0; i < regionCount; i++)
 	{
 		// Capture-by-value is vital.
 		auto srcRegion = pRegions[i].srcSubresource;
 		auto dstRegion = pRegions[i].dstSubresource;
+		auto dstUsage = dst->coversMipLevel(dstRegion, blitOffset(pRegions[i].dstOffsets),
+		                                    blitExtent(pRegions[i].dstOffsets)) ?
+		                    Image::Usage::ResourceOverwrite :
+		                    Image::Usage::ResourceWrite;
 
 		cmdBuffer->enqueueDeferredFunction([=](Queue &) {
 			src->signalUsage(srcRegion, Image::Usage::ResourceRead);
-			dst->signalUsage(dstRegion, Image::Usage::ResourceWrite);
+			dst->signalUsage(dstRegion, dstUsage);
 		});
+
+		bandwidth.readBytes +=
+		    BandwidthTracker::imageRegionBytes(*src, blitExtent(pRegions[i].srcOffsets), srcRegion.layerCount);
+		bandwidth.writeBytes +=
+		    BandwidthTracker::imageRegionBytes(*dst, blitExtent(pRegions[i].dstOffsets), dstRegion.layerCount);
 	}
+	cmdBuffer->addTransferBandwidth(bandwidth);
 
 	cmdBuffer->enqueueDeferredFunction(
 	    [=](Queue &queue) { queue.getQueueTracker().pushWork(QueueTracker::STAGE_TRANSFER); });
 
 	layer->getTable()->CmdBlitImage(commandBuffer, srcImage, srcImageLayout, dstImage, dstImageLayout, regionCount,
 	                                pRegions, filter);
+	if (layer->getCapture())
+		layer->getCapture()->cmdBlitImage(commandBuffer, srcImage, srcImageLayout, dstImage, dstImageLayout,
+		                                  regionCount, pRegions, filter);
 }
 
 static VKAPI_ATTR void VKAPI_CALL CmdFillBuffer(VkCommandBuffer commandBuffer, VkBuffer dstBuffer,
@@ -1478,7 +1707,19 @@ static VKAPI_ATTR void VKAPI_CALL CmdFillBuffer(VkCommandBuffer commandBuffer, V
 	cmdBuffer->enqueueDeferredFunction(
 	    [=](Queue &queue) { queue.getQueueTracker().pushWork(QueueTracker::STAGE_TRANSFER); });
 
+	// VK_WHOLE_SIZE fills up to the last multiple of 4 bytes, the call itself is forwarded untouched.
+	VkDeviceSize filledSize = size;
+	if (size == VK_WHOLE_SIZE)
+	{
+		auto *buffer = layer->get<Buffer>(dstBuffer);
+		MPD_ASSERT(buffer);
+		filledSize = (buffer->getCreateInfo().size - dstOffset) & ~VkDeviceSize(3);
+	}
+	cmdBuffer->addTransferBandwidth(BandwidthEstimate(0, filledSize));
+
 	layer->getTable()->CmdFillBuffer(commandBuffer, dstBuffer, dstOffset, size, data);
+	if (layer->getCapture())
+		layer->getCapture()->cmdFillBuffer(commandBuffer, dstBuffer, dstOffset, size, data);
 }
 
 static VKAPI_ATTR void VKAPI_CALL CmdUpdateBuffer(VkCommandBuffer commandBuffer, VkBuffer dstBuffer,
@@ -1493,8 +1734,11 @@ static VKAPI_ATTR void VKAPI_CALL CmdUpdateBuffer(VkCommandBuffer commandBuffer,
 
 	cmdBuffer->enqueueDeferredFunction(
 	    [=](Queue &queue) { queue.getQueueTracker().pushWork(QueueTracker::STAGE_TRANSFER); });
+	cmdBuffer->addTransferBandwidth(BandwidthEstimate(0, size));
 
 	layer->getTable()->CmdUpdateBuffer(commandBuffer, dstBuffer, dstOffset, size, data);
+	if (layer->getCapture())
+		layer->getCapture()->cmdUpdateBuffer(commandBuffer, dstBuffer, dstOffset, size, data);
 }
 
 static VKAPI_ATTR void VKAPI_CALL CmdCopyQueryPoolResults(VkCommandBuffer commandBuffer, VkQueryPool queryPool,
@@ -1530,10 +1774,77 @@ static VKAPI_ATTR void VKAPI_CALL UpdateDescriptorSets(VkDevice device, uint32_t
 	for (uint32_t i = 0; i < descriptorCopyCount; i++)
 		DescriptorSet::copyDescriptors(layer, pDescriptorCopies[i]);
 
+	if (layer->getCapture())
+		layer->getCapture()->updateDescriptorSets(descriptorWriteCount, pDescriptorWrites, descriptorCopyCount,
+		                                          pDescriptorCopies);
+
 	layer->getTable()->UpdateDescriptorSets(device, descriptorWriteCount, pDescriptorWrites, descriptorCopyCount,
 	                                        pDescriptorCopies);
 }
 
+static VKAPI_ATTR VkResult VKAPI_CALL CreateDescriptorUpdateTemplate(
+    VkDevice device, const VkDescriptorUpdateTemplateCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator,
+    VkDescriptorUpdateTemplate *pDescriptorUpdateTemplate)
+{
+	lock_guard<mutex> holder{ globalLock };
+	void *key = getDispatchKey(device);
+	auto *layer = getLayerData(key, deviceData);
+
+	VkResult result = layer->getDescriptorUpdateTemplateTable().CreateDescriptorUpdateTemplate(
+	    device, pCreateInfo, pAllocator, pDescriptorUpdateTemplate);
+	if (result == VK_SUCCESS)
+	{
+		auto *updateTemplate = layer->alloc<DescriptorUpdateTemplate>(*pDescriptorUpdateTemplate);
+		MPD_ASSERT(updateTemplate != NULL);
+
+		result = updateTemplate->init(pCreateInfo);
+		if (result != VK_SUCCESS)
+			layer->destroy<DescriptorUpdateTemplate>(*pDescriptorUpdateTemplate);
+	}
+
+	return result;
+}
+
+static VKAPI_ATTR void VKAPI_CALL DestroyDescriptorUpdateTemplate(VkDevice device,
+                                                                  VkDescriptorUpdateTemplate descriptorUpdateTemplate,
+                                                                  const VkAllocationCallbacks *pAllocator)
+{
+	lock_guard<mutex> holder{ globalLock };
+	void *key = getDispatchKey(device);
+	auto *layer = getLayerData(key, deviceData);
+
+	layer->destroy<DescriptorUpdateTemplate>(descriptorUpdateTemplate);
+	layer->getDescriptorUpdateTemplateTable().DestroyDescriptorUpdateTemplate(device, descriptorUpdateTemplate,
+	                                                                          pAllocator);
+}
+
+static VKAPI_ATTR void VKAPI_CALL UpdateDescriptorSetWithTemplate(VkDevice device, VkDescriptorSet descriptorSet,
+                                                                  VkDescriptorUpdateTemplate descriptorUpdateTemplate,
+                                                                  const void *pData)
+{
+	lock_guard<mutex> holder{ globalLock };
+	void *key = getDispatchKey(device);
+	auto *layer = getLayerData(key, deviceData);
+
+	auto *updateTemplate = layer->get<DescriptorUpdateTemplate>(descriptorUpdateTemplate);
+	MPD_ASSERT(updateTemplate);
+	DescriptorSet::updateWithTemplate(layer, descriptorSet, *updateTemplate, pData);
+
+	// Captures see the update as plain descriptor writes, so replays do not depend on template support.
+	if (layer->getCapture())
+	{
+		vector<VkWriteDescriptorSet> writes;
+		vector<VkDescriptorImageInfo> imageInfos;
+		vector<VkDescriptorBufferInfo> bufferInfos;
+		vector<VkBufferView> texelBufferViews;
+		updateTemplate->expandWrites(descriptorSet, pData, writes, imageInfos, bufferInfos, texelBufferViews);
+		layer->getCapture()->updateDescriptorSets(uint32_t(writes.size()), writes.data(), 0, nullptr);
+	}
+
+	layer->getDescriptorUpdateTemplateTable().UpdateDescriptorSetWithTemplate(device, descriptorSet,
+	                                                                          descriptorUpdateTemplate, pData);
+}
+
 static VKAPI_ATTR void VKAPI_CALL CmdBindDescriptorSets(VkCommandBuffer commandBuffer,
                                                         VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout layout,
                                                         uint32_t firstSet, uint32_t descriptorSetCount,
@@ -1552,6 +1863,10 @@ static VKAPI_ATTR void VKAPI_CALL CmdBindDescriptorSets(VkCommandBuffer commandB
 
 	layer->getTable()->CmdBindDescriptorSets(commandBuffer, pipelineBindPoint, layout, firstSet, descriptorSetCount,
 	                                         pDescriptorSets, dynamicOffsetCount, pDynamicOffsets);
+	if (layer->getCapture())
+		layer->getCapture()->cmdBindDescriptorSets(commandBuffer, pipelineBindPoint, layout, firstSet,
+		                                           descriptorSetCount, pDescriptorSets, dynamicOffsetCount,
+		                                           pDynamicOffsets);
 }
 
 static VKAPI_ATTR void VKAPI_CALL CmdDispatch(VkCommandBuffer commandBuffer, uint32_t x, uint32_t y, uint32_t z)
@@ -1567,6 +1882,8 @@ static VKAPI_ATTR void VKAPI_CALL CmdDispatch(VkCommandBuffer commandBuffer, uin
 	    [=](Queue &queue) { queue.getQueueTracker().pushWork(QueueTracker::STAGE_COMPUTE); });
 	layer->getTable()->CmdDispatch(commandBuffer, x, y, z);
 	cmdBuffer->enqueueComputeDescriptorSetUsage();
+	if (layer->getCapture())
+		layer->getCapture()->cmdDispatch(commandBuffer, x, y, z);
 }
 
 static VKAPI_ATTR void VKAPI_CALL CmdDispatchIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer,
@@ -1583,6 +1900,8 @@ static VKAPI_ATTR void VKAPI_CALL CmdDispatchIndirect(VkCommandBuffer commandBuf
 	    [=](Queue &queue) { queue.getQueueTracker().pushWork(QueueTracker::STAGE_COMPUTE); });
 	layer->getTable()->CmdDispatchIndirect(commandBuffer, buffer, offset);
 	cmdBuffer->enqueueComputeDescriptorSetUsage();
+	if (layer->getCapture())
+		layer->getCapture()->cmdDispatchIndirect(commandBuffer, buffer, offset);
 }
 
 static VKAPI_ATTR void VKAPI_CALL CmdClearColorImage(VkCommandBuffer commandBuffer, VkImage image,
@@ -1603,12 +1922,15 @@ static VKAPI_ATTR void VKAPI_CALL CmdClearColorImage(VkCommandBuffer commandBuff
 		// Copy-by-value is important.
 		auto dstRange = pRanges[i];
 		cmdBuffer->enqueueDeferredFunction([=](Queue &) { dst->signalUsage(dstRange, Image::Usage::Cleared); });
+		cmdBuffer->addTransferBandwidth(BandwidthEstimate(0, BandwidthTracker::imageRangeBytes(*dst, dstRange)));
 	}
 
 	cmdBuffer->enqueueDeferredFunction(
 	    [=](Queue &queue) { queue.getQueueTracker().pushWork(QueueTracker::STAGE_TRANSFER); });
 
 	layer->getTable()->CmdClearColorImage(commandBuffer, image, imageLayout, pColor, rangeCount, pRanges);
+	if (layer->getCapture())
+		layer->getCapture()->cmdClearColorImage(commandBuffer, image, imageLayout, *pColor, rangeCount, pRanges);
 }
 
 static VKAPI_ATTR void VKAPI_CALL CmdClearDepthStencilImage(VkCommandBuffer commandBuffer, VkImage image,
@@ -1630,12 +1952,16 @@ static VKAPI_ATTR void VKAPI_CALL CmdClearDepthStencilImage(VkCommandBuffer comm
 		// Copy-by-value is important.
 		auto dstRange = pRanges[i];
 		cmdBuffer->enqueueDeferredFunction([=](Queue &) { dst->signalUsage(dstRange, Image::Usage::Cleared); });
+		cmdBuffer->addTransferBandwidth(BandwidthEstimate(0, BandwidthTracker::imageRangeBytes(*dst, dstRange)));
 	}
 
 	cmdBuffer->enqueueDeferredFunction(
 	    [=](Queue &queue) { queue.getQueueTracker().pushWork(QueueTracker::STAGE_TRANSFER); });
 
 	layer->getTable()->CmdClearDepthStencilImage(commandBuffer, image, imageLayout, pDepthStencil, rangeCount, pRanges);
+	if (layer->getCapture())
+		layer->getCapture()->cmdClearDepthStencilImage(commandBuffer, image, imageLayout, *pDepthStencil, rangeCount,
+		                                               pRanges);
 }
 
 static VKAPI_ATTR void VKAPI_CALL CmdClearAttachments(VkCommandBuffer commandBuffer, uint32_t attachmentCount,
@@ -1651,6 +1977,8 @@ static VKAPI_ATTR void VKAPI_CALL CmdClearAttachments(VkCommandBuffer commandBuf
 
 	cmdBuffer->clearAttachments(attachmentCount, pAttachments, rectCount, pRects);
 	layer->getTable()->CmdClearAttachments(commandBuffer, attachmentCount, pAttachments, rectCount, pRects);
+	if (layer->getCapture())
+		layer->getCapture()->cmdClearAttachments(commandBuffer, attachmentCount, pAttachments, rectCount, pRects);
 }
 
 static VKAPI_ATTR void VKAPI_CALL CmdPipelineBarrier(
@@ -1673,6 +2001,96 @@ static VKAPI_ATTR void VKAPI_CALL CmdPipelineBarrier(
 	layer->getTable()->CmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, dependencyFlags,
 	                                      memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount,
 	                                      pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
+	if (layer->getCapture())
+		layer->getCapture()->cmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, dependencyFlags,
+		                                        memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount,
+		                                        pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL ResetCommandPool(VkDevice device, VkCommandPool commandPool,
+                                                       VkCommandPoolResetFlags flags)
+{
+	// Only intercepted when capturing.
+	lock_guard<mutex> holder{ globalLock };
+	void *key = getDispatchKey(device);
+	auto *layer = getLayerData(key, deviceData);
+
+	if (layer->getCapture())
+		layer->getCapture()->destroyObject(CAPTURE_OP_RESET_COMMAND_POOL, commandPool);
+
+	return layer->getTable()->ResetCommandPool(device, commandPool, flags);
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL ResetCommandBuffer(VkCommandBuffer commandBuffer,
+                                                         VkCommandBufferResetFlags flags)
+{
+	// Only intercepted when capturing.
+	lock_guard<mutex> holder{ globalLock };
+	void *key = getDispatchKey(commandBuffer);
+	auto *layer = getLayerData(key, deviceData);
+
+	if (layer->getCapture())
+		layer->getCapture()->destroyObject(CAPTURE_OP_RESET_COMMAND_BUFFER, commandBuffer);
+
+	return layer->getTable()->ResetCommandBuffer(commandBuffer, flags);
+}
+
+static VKAPI_ATTR void VKAPI_CALL CmdBindVertexBuffers(VkCommandBuffer commandBuffer, uint32_t firstBinding,
+                                                       uint32_t bindingCount, const VkBuffer *pBuffers,
+                                                       const VkDeviceSize *pOffsets)
+{
+	// Only intercepted when capturing.
+	lock_guard<mutex> holder{ globalLock };
+	void *key = getDispatchKey(commandBuffer);
+	auto *layer = getLayerData(key, deviceData);
+
+	if (layer->getCapture())
+		layer->getCapture()->cmdBindVertexBuffers(commandBuffer, firstBinding, bindingCount, pBuffers, pOffsets);
+
+	layer->getTable()->CmdBindVertexBuffers(commandBuffer, firstBinding, bindingCount, pBuffers, pOffsets);
+}
+
+static VKAPI_ATTR void VKAPI_CALL CmdSetViewport(VkCommandBuffer commandBuffer, uint32_t firstViewport,
+                                                 uint32_t viewportCount, const VkViewport *pViewports)
+{
+	// Only intercepted when capturing.
+	lock_guard<mutex> holder{ globalLock };
+	void *key = getDispatchKey(commandBuffer);
+	auto *layer = getLayerData(key, deviceData);
+
+	if (layer->getCapture())
+		layer->getCapture()->cmdSetViewport(commandBuffer, firstViewport, viewportCount, pViewports);
+
+	layer->getTable()->CmdSetViewport(commandBuffer, firstViewport, viewportCount, pViewports);
+}
+
+static VKAPI_ATTR void VKAPI_CALL CmdSetScissor(VkCommandBuffer commandBuffer, uint32_t firstScissor,
+                                                uint32_t scissorCount, const VkRect2D *pScissors)
+{
+	// Only intercepted when capturing.
+	lock_guard<mutex> holder{ globalLock };
+	void *key = getDispatchKey(commandBuffer);
+	auto *layer = getLayerData(key, deviceData);
+
+	if (layer->getCapture())
+		layer->getCapture()->cmdSetScissor(commandBuffer, firstScissor, scissorCount, pScissors);
+
+	layer->getTable()->CmdSetScissor(commandBuffer, firstScissor, scissorCount, pScissors);
+}
+
+static VKAPI_ATTR void VKAPI_CALL CmdPushConstants(VkCommandBuffer commandBuffer, VkPipelineLayout layout,
+                                                   VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size,
+                                                   const void *pValues)
+{
+	// Only intercepted when capturing.
+	lock_guard<mutex> holder{ globalLock };
+	void *key = getDispatchKey(commandBuffer);
+	auto *layer = getLayerData(key, deviceData);
+
+	if (layer->getCapture())
+		layer->getCapture()->cmdPushConstants(commandBuffer, layout, stageFlags, offset, size, pValues);
+
+	layer->getTable()->CmdPushConstants(commandBuffer, layout, stageFlags, offset, size, pValues);
 }
 
 static VKAPI_ATTR void VKAPI_CALL CmdDraw(VkCommandBuffer commandBuffer, uint32_t vertexCount, uint32_t instanceCount,
@@ -1689,6 +2107,9 @@ static VKAPI_ATTR void VKAPI_CALL CmdDraw(VkCommandBuffer commandBuffer, uint32_
 	layer->getTable()->CmdDraw(commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
 	cmdBuffer->draw(vertexCount, instanceCount, firstVertex, firstInstance);
 	cmdBuffer->enqueueGraphicsDescriptorSetUsage();
+	cmdBuffer->recordDrawState();
+	if (layer->getCapture())
+		layer->getCapture()->cmdDraw(commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
 }
 
 static VKAPI_ATTR void VKAPI_CALL CmdDrawIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset,
@@ -1704,6 +2125,10 @@ static VKAPI_ATTR void VKAPI_CALL CmdDrawIndirect(VkCommandBuffer commandBuffer,
 
 	layer->getTable()->CmdDrawIndirect(commandBuffer, buffer, offset, drawCount, stride);
 	cmdBuffer->enqueueGraphicsDescriptorSetUsage();
+	cmdBuffer->recordDrawState(drawCount);
+	if (layer->getCapture())
+		layer->getCapture()->cmdDrawIndirect(CAPTURE_OP_CMD_DRAW_INDIRECT, commandBuffer, buffer, offset, drawCount,
+		                                     stride);
 }
 
 static VKAPI_ATTR void VKAPI_CALL CmdDrawIndexed(VkCommandBuffer commandBuffer, uint32_t indexCount,
@@ -1722,6 +2147,13 @@ static VKAPI_ATTR void VKAPI_CALL CmdDrawIndexed(VkCommandBuffer commandBuffer,
 	                                  firstInstance);
 	cmdBuffer->drawIndexed(indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
 	cmdBuffer->enqueueGraphicsDescriptorSetUsage();
+	cmdBuffer->recordDrawState();
+	if (layer->getCapture())
+	{
+		cmdBuffer->captureIndexData(*layer->getCapture(), indexCount, firstIndex);
+		layer->getCapture()->cmdDrawIndexed(commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset,
+		                                    firstInstance);
+	}
 }
 
 static VKAPI_ATTR void VKAPI_CALL CmdDrawIndexedIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer,
@@ -1737,6 +2169,10 @@ static VKAPI_ATTR void VKAPI_CALL CmdDrawIndexedIndirect(VkCommandBuffer command
 
 	layer->getTable()->CmdDrawIndexedIndirect(commandBuffer, buffer, offset, drawCount, stride);
 	cmdBuffer->enqueueGraphicsDescriptorSetUsage();
+	cmdBuffer->recordDrawState(drawCount);
+	if (layer->getCapture())
+		layer->getCapture()->cmdDrawIndirect(CAPTURE_OP_CMD_DRAW_INDEXED_INDIRECT, commandBuffer, buffer, offset,
+		                                     drawCount, stride);
 }
 
 static VKAPI_ATTR VkResult VKAPI_CALL CreateSampler(VkDevice device, const VkSamplerCreateInfo *pCreateInfo,
@@ -1757,6 +2193,8 @@ static VKAPI_ATTR VkResult VKAPI_CALL CreateSampler(VkDevice device, const VkSam
 			layer->destroy<Sampler>(*pSampler);
 			layer->getTable()->DestroySampler(device, *pSampler, pCallbacks);
 		}
+		else if (layer->getCapture())
+			layer->getCapture()->createSampler(*pSampler, *pCreateInfo);
 	}
 	return res;
 }
@@ -1768,6 +2206,9 @@ static VKAPI_ATTR void VKAPI_CALL DestroySampler(VkDevice device, VkSampler samp
 	void *key = getDispatchKey(device);
 	auto *layer = getLayerData(key, deviceData);
 
+	if (layer->getCapture())
+		layer->getCapture()->destroyObject(CAPTURE_OP_DESTROY_SAMPLER, sampler);
+
 	layer->destroy<Sampler>(sampler);
 	layer->getTable()->DestroySampler(device, sampler, pCallbacks);
 }
@@ -1791,6 +2232,8 @@ static VKAPI_ATTR VkResult VKAPI_CALL CreateShaderModule(VkDevice device, const
 			layer->destroy<ShaderModule>(*pShaderModule);
 			layer->getTable()->DestroyShaderModule(device, *pShaderModule, pCallbacks);
 		}
+		else if (layer->getCapture())
+			layer->getCapture()->createShaderModule(*pShaderModule, *pCreateInfo);
 	}
 	return res;
 }
@@ -1802,6 +2245,9 @@ static VKAPI_ATTR void VKAPI_CALL DestroyShaderModule(VkDevice device, VkShaderM
 	void *key = getDispatchKey(device);
 	auto *layer = getLayerData(key, deviceData);
 
+	if (layer->getCapture())
+		layer->getCapture()->destroyObject(CAPTURE_OP_DESTROY_SHADER_MODULE, shaderModule);
+
 	layer->destroy<ShaderModule>(shaderModule);
 	layer->getTable()->DestroyShaderModule(device, shaderModule, pCallbacks);
 }
@@ -1815,6 +2261,10 @@ static VKAPI_ATTR VkResult VKAPI_CALL QueueSubmit(VkQueue queue, uint32_t submit
 	auto *pQueue = layer->get<Queue>(queue);
 	MPD_ASSERT(pQueue);
 
+	if (layer->getCapture())
+		layer->getCapture()->queueSubmit(queue, submitCount, pSubmits);
+
+	layer->advanceUsageEpoch();
 	for (uint32_t submit = 0; submit < submitCount; submit++)
 	{
 		MPD_ASSERT(pSubmits != nullptr);
@@ -1827,10 +2277,310 @@ static VKAPI_ATTR VkResult VKAPI_CALL QueueSubmit(VkQueue queue, uint32_t submit
 			commandBuffer->callDeferredFunctions(*pQueue);
 		}
 	}
+	layer->getRenderPassMergeAdvisor().endSubmit();
+
+	return layer->getTable()->QueueSubmit(queue, submitCount, pSubmits, fence);
+}
 
+// Record-only entry points, used instead of the analyzing versions when captureRecordOnly is enabled.
+// They only serialize the command and forward it, analysis happens offline in perfdoc-analyze.
+static VKAPI_ATTR VkResult VKAPI_CALL RecordBeginCommandBuffer(VkCommandBuffer commandBuffer,
+                                                               const VkCommandBufferBeginInfo *pBeginInfo)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+	layer->getCapture()->beginCommandBuffer(commandBuffer, *pBeginInfo);
+	return layer->getTable()->BeginCommandBuffer(commandBuffer, pBeginInfo);
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL RecordQueueSubmit(VkQueue queue, uint32_t submitCount,
+                                                        const VkSubmitInfo *pSubmits, VkFence fence)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(queue), deviceData);
+	layer->getCapture()->queueSubmit(queue, submitCount, pSubmits);
 	return layer->getTable()->QueueSubmit(queue, submitCount, pSubmits, fence);
 }
 
+static VKAPI_ATTR void VKAPI_CALL RecordCmdExecuteCommands(VkCommandBuffer commandBuffer, uint32_t commandBufferCount,
+                                                           const VkCommandBuffer *pCommandBuffers)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+	layer->getCapture()->cmdExecuteCommands(commandBuffer, commandBufferCount, pCommandBuffers);
+	layer->getTable()->CmdExecuteCommands(commandBuffer, commandBufferCount, pCommandBuffers);
+}
+
+static VKAPI_ATTR void VKAPI_CALL RecordCmdBindIndexBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer,
+                                                           VkDeviceSize offset, VkIndexType indexType)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+
+	// The binding is still tracked so index data can be captured for indexed draws.
+	auto *cmdBuffer = layer->get<CommandBuffer>(commandBuffer);
+	MPD_ASSERT(cmdBuffer);
+	cmdBuffer->bindIndexBuffer(layer->get<Buffer>(buffer), offset, indexType);
+
+	layer->getCapture()->cmdBindIndexBuffer(commandBuffer, buffer, offset, indexType);
+	layer->getTable()->CmdBindIndexBuffer(commandBuffer, buffer, offset, indexType);
+}
+
+static VKAPI_ATTR void VKAPI_CALL RecordCmdDraw(VkCommandBuffer commandBuffer, uint32_t vertexCount,
+                                                uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+	layer->getCapture()->cmdDraw(commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
+	layer->getTable()->CmdDraw(commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
+}
+
+static VKAPI_ATTR void VKAPI_CALL RecordCmdDrawIndexed(VkCommandBuffer commandBuffer, uint32_t indexCount,
+                                                       uint32_t instanceCount, uint32_t firstIndex,
+                                                       int32_t vertexOffset, uint32_t firstInstance)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+
+	auto *cmdBuffer = layer->get<CommandBuffer>(commandBuffer);
+	MPD_ASSERT(cmdBuffer);
+	cmdBuffer->captureIndexData(*layer->getCapture(), indexCount, firstIndex);
+
+	layer->getCapture()->cmdDrawIndexed(commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset,
+	                                    firstInstance);
+	layer->getTable()->CmdDrawIndexed(commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset,
+	                                  firstInstance);
+}
+
+static VKAPI_ATTR void VKAPI_CALL RecordCmdDrawIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer,
+                                                        VkDeviceSize offset, uint32_t drawCount, uint32_t stride)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+	layer->getCapture()->cmdDrawIndirect(CAPTURE_OP_CMD_DRAW_INDIRECT, commandBuffer, buffer, offset, drawCount,
+	                                     stride);
+	layer->getTable()->CmdDrawIndirect(commandBuffer, buffer, offset, drawCount, stride);
+}
+
+static VKAPI_ATTR void VKAPI_CALL RecordCmdDrawIndexedIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer,
+                                                               VkDeviceSize offset, uint32_t drawCount,
+                                                               uint32_t stride)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+	layer->getCapture()->cmdDrawIndirect(CAPTURE_OP_CMD_DRAW_INDEXED_INDIRECT, commandBuffer, buffer, offset,
+	                                     drawCount, stride);
+	layer->getTable()->CmdDrawIndexedIndirect(commandBuffer, buffer, offset, drawCount, stride);
+}
+
+static VKAPI_ATTR void VKAPI_CALL RecordCmdBindPipeline(VkCommandBuffer commandBuffer,
+                                                        VkPipelineBindPoint pipelineBindPoint, VkPipeline pipeline)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+	layer->getCapture()->cmdBindPipeline(commandBuffer, pipelineBindPoint, pipeline);
+	layer->getTable()->CmdBindPipeline(commandBuffer, pipelineBindPoint, pipeline);
+}
+
+static VKAPI_ATTR void VKAPI_CALL RecordCmdBeginRenderPass(VkCommandBuffer commandBuffer,
+                                                           const VkRenderPassBeginInfo *pRenderPassBegin,
+                                                           VkSubpassContents contents)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+	layer->getCapture()->cmdBeginRenderPass(commandBuffer, *pRenderPassBegin, contents);
+	layer->getTable()->CmdBeginRenderPass(commandBuffer, pRenderPassBegin, contents);
+}
+
+static VKAPI_ATTR void VKAPI_CALL RecordCmdNextSubpass(VkCommandBuffer commandBuffer, VkSubpassContents contents)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+	layer->getCapture()->cmdNextSubpass(commandBuffer, contents);
+	layer->getTable()->CmdNextSubpass(commandBuffer, contents);
+}
+
+static VKAPI_ATTR void VKAPI_CALL RecordCmdEndRenderPass(VkCommandBuffer commandBuffer)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+	layer->getCapture()->destroyObject(CAPTURE_OP_CMD_END_RENDER_PASS, commandBuffer);
+	layer->getTable()->CmdEndRenderPass(commandBuffer);
+}
+
+static VKAPI_ATTR void VKAPI_CALL RecordCmdPipelineBarrier(
+    VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask,
+    VkDependencyFlags dependencyFlags, uint32_t memoryBarrierCount, const VkMemoryBarrier *pMemoryBarriers,
+    uint32_t bufferMemoryBarrierCount, const VkBufferMemoryBarrier *pBufferMemoryBarriers,
+    uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier *pImageMemoryBarriers)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+	layer->getCapture()->cmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, dependencyFlags,
+	                                        memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount,
+	                                        pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
+	layer->getTable()->CmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, dependencyFlags,
+	                                      memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount,
+	                                      pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
+}
+
+static VKAPI_ATTR void VKAPI_CALL RecordCmdClearColorImage(VkCommandBuffer commandBuffer, VkImage image,
+                                                           VkImageLayout imageLayout, const VkClearColorValue *pColor,
+                                                           uint32_t rangeCount,
+                                                           const VkImageSubresourceRange *pRanges)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+	layer->getCapture()->cmdClearColorImage(commandBuffer, image, imageLayout, *pColor, rangeCount, pRanges);
+	layer->getTable()->CmdClearColorImage(commandBuffer, image, imageLayout, pColor, rangeCount, pRanges);
+}
+
+static VKAPI_ATTR void VKAPI_CALL RecordCmdClearDepthStencilImage(VkCommandBuffer commandBuffer, VkImage image,
+                                                                  VkImageLayout imageLayout,
+                                                                  const VkClearDepthStencilValue *pDepthStencil,
+                                                                  uint32_t rangeCount,
+                                                                  const VkImageSubresourceRange *pRanges)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+	layer->getCapture()->cmdClearDepthStencilImage(commandBuffer, image, imageLayout, *pDepthStencil, rangeCount,
+	                                               pRanges);
+	layer->getTable()->CmdClearDepthStencilImage(commandBuffer, image, imageLayout, pDepthStencil, rangeCount,
+	                                             pRanges);
+}
+
+static VKAPI_ATTR void VKAPI_CALL RecordCmdClearAttachments(VkCommandBuffer commandBuffer, uint32_t attachmentCount,
+                                                            const VkClearAttachment *pAttachments, uint32_t rectCount,
+                                                            const VkClearRect *pRects)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+	layer->getCapture()->cmdClearAttachments(commandBuffer, attachmentCount, pAttachments, rectCount, pRects);
+	layer->getTable()->CmdClearAttachments(commandBuffer, attachmentCount, pAttachments, rectCount, pRects);
+}
+
+static VKAPI_ATTR void VKAPI_CALL RecordCmdCopyBuffer(VkCommandBuffer commandBuffer, VkBuffer srcBuffer,
+                                                      VkBuffer dstBuffer, uint32_t regionCount,
+                                                      const VkBufferCopy *pRegions)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+	layer->getCapture()->cmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, regionCount, pRegions);
+	layer->getTable()->CmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, regionCount, pRegions);
+}
+
+static VKAPI_ATTR void VKAPI_CALL RecordCmdCopyImage(VkCommandBuffer commandBuffer, VkImage srcImage,
+                                                     VkImageLayout srcImageLayout, VkImage dstImage,
+                                                     VkImageLayout dstImageLayout, uint32_t regionCount,
+                                                     const VkImageCopy *pRegions)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+	layer->getCapture()->cmdCopyImage(CAPTURE_OP_CMD_COPY_IMAGE, commandBuffer, srcImage, srcImageLayout, dstImage,
+	                                  dstImageLayout, regionCount, pRegions, sizeof(*pRegions));
+	layer->getTable()->CmdCopyImage(commandBuffer, srcImage, srcImageLayout, dstImage, dstImageLayout, regionCount,
+	                                pRegions);
+}
+
+static VKAPI_ATTR void VKAPI_CALL RecordCmdResolveImage(VkCommandBuffer commandBuffer, VkImage srcImage,
+                                                        VkImageLayout srcImageLayout, VkImage dstImage,
+                                                        VkImageLayout dstImageLayout, uint32_t regionCount,
+                                                        const VkImageResolve *pRegions)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+	layer->getCapture()->cmdCopyImage(CAPTURE_OP_CMD_RESOLVE_IMAGE, commandBuffer, srcImage, srcImageLayout,
+	                                  dstImage, dstImageLayout, regionCount, pRegions, sizeof(*pRegions));
+	layer->getTable()->CmdResolveImage(commandBuffer, srcImage, srcImageLayout, dstImage, dstImageLayout, regionCount,
+	                                   pRegions);
+}
+
+static VKAPI_ATTR void VKAPI_CALL RecordCmdCopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer srcBuffer,
+                                                             VkImage dstImage, VkImageLayout dstImageLayout,
+                                                             uint32_t regionCount, const VkBufferImageCopy *pRegions)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+	layer->getCapture()->cmdCopyBufferImage(CAPTURE_OP_CMD_COPY_BUFFER_TO_IMAGE, commandBuffer, srcBuffer, dstImage,
+	                                        dstImageLayout, regionCount, pRegions);
+	layer->getTable()->CmdCopyBufferToImage(commandBuffer, srcBuffer, dstImage, dstImageLayout, regionCount, pRegions);
+}
+
+static VKAPI_ATTR void VKAPI_CALL RecordCmdCopyImageToBuffer(VkCommandBuffer commandBuffer, VkImage srcImage,
+                                                             VkImageLayout srcImageLayout, VkBuffer dstBuffer,
+                                                             uint32_t regionCount, const VkBufferImageCopy *pRegions)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+	layer->getCapture()->cmdCopyBufferImage(CAPTURE_OP_CMD_COPY_IMAGE_TO_BUFFER, commandBuffer, dstBuffer, srcImage,
+	                                        srcImageLayout, regionCount, pRegions);
+	layer->getTable()->CmdCopyImageToBuffer(commandBuffer, srcImage, srcImageLayout, dstBuffer, regionCount, pRegions);
+}
+
+static VKAPI_ATTR void VKAPI_CALL RecordCmdBlitImage(VkCommandBuffer commandBuffer, VkImage srcImage,
+                                                     VkImageLayout srcImageLayout, VkImage dstImage,
+                                                     VkImageLayout dstImageLayout, uint32_t regionCount,
+                                                     const VkImageBlit *pRegions, VkFilter filter)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+	layer->getCapture()->cmdBlitImage(commandBuffer, srcImage, srcImageLayout, dstImage, dstImageLayout, regionCount,
+	                                  pRegions, filter);
+	layer->getTable()->CmdBlitImage(commandBuffer, srcImage, srcImageLayout, dstImage, dstImageLayout, regionCount,
+	                                pRegions, filter);
+}
+
+static VKAPI_ATTR void VKAPI_CALL RecordCmdFillBuffer(VkCommandBuffer commandBuffer, VkBuffer dstBuffer,
+                                                      VkDeviceSize dstOffset, VkDeviceSize size, uint32_t data)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+	layer->getCapture()->cmdFillBuffer(commandBuffer, dstBuffer, dstOffset, size, data);
+	layer->getTable()->CmdFillBuffer(commandBuffer, dstBuffer, dstOffset, size, data);
+}
+
+static VKAPI_ATTR void VKAPI_CALL RecordCmdUpdateBuffer(VkCommandBuffer commandBuffer, VkBuffer dstBuffer,
+                                                        VkDeviceSize dstOffset, VkDeviceSize size, const void *data)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+	layer->getCapture()->cmdUpdateBuffer(commandBuffer, dstBuffer, dstOffset, size, data);
+	layer->getTable()->CmdUpdateBuffer(commandBuffer, dstBuffer, dstOffset, size, data);
+}
+
+static VKAPI_ATTR void VKAPI_CALL RecordCmdBindDescriptorSets(VkCommandBuffer commandBuffer,
+                                                              VkPipelineBindPoint pipelineBindPoint,
+                                                              VkPipelineLayout layout, uint32_t firstSet,
+                                                              uint32_t descriptorSetCount,
+                                                              const VkDescriptorSet *pDescriptorSets,
+                                                              uint32_t dynamicOffsetCount,
+                                                              const uint32_t *pDynamicOffsets)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+	layer->getCapture()->cmdBindDescriptorSets(commandBuffer, pipelineBindPoint, layout, firstSet, descriptorSetCount,
+	                                           pDescriptorSets, dynamicOffsetCount, pDynamicOffsets);
+	layer->getTable()->CmdBindDescriptorSets(commandBuffer, pipelineBindPoint, layout, firstSet, descriptorSetCount,
+	                                         pDescriptorSets, dynamicOffsetCount, pDynamicOffsets);
+}
+
+static VKAPI_ATTR void VKAPI_CALL RecordCmdDispatch(VkCommandBuffer commandBuffer, uint32_t x, uint32_t y, uint32_t z)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+	layer->getCapture()->cmdDispatch(commandBuffer, x, y, z);
+	layer->getTable()->CmdDispatch(commandBuffer, x, y, z);
+}
+
+static VKAPI_ATTR void VKAPI_CALL RecordCmdDispatchIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer,
+                                                            VkDeviceSize offset)
+{
+	lock_guard<mutex> holder{ globalLock };
+	auto *layer = getLayerData(getDispatchKey(commandBuffer), deviceData);
+	layer->getCapture()->cmdDispatchIndirect(commandBuffer, buffer, offset);
+	layer->getTable()->CmdDispatchIndirect(commandBuffer, buffer, offset);
+}
+
 static PFN_vkVoidFunction interceptCoreDeviceCommand(const char *pName)
 {
 	static const struct
@@ -1939,6 +2689,7 @@ static PFN_vkVoidFunction interceptCoreDeviceCommand(const char *pName)
 		{ "vkCreateSwapchainKHR", reinterpret_cast<PFN_vkVoidFunction>(CreateSwapchainKHR) },
 		{ "vkDestroySwapchainKHR", reinterpret_cast<PFN_vkVoidFunction>(DestroySwapchainKHR) },
 		{ "vkGetSwapchainImagesKHR", reinterpret_cast<PFN_vkVoidFunction>(GetSwapchainImagesKHR) },
+		{ "vkQueuePresentKHR", reinterpret_cast<PFN_vkVoidFunction>(QueuePresentKHR) },
 	};
 
 	for (auto &cmd : coreDeviceCommands)
@@ -1946,6 +2697,111 @@ static PFN_vkVoidFunction interceptCoreDeviceCommand(const char *pName)
 			return cmd.proc;
 	return nullptr;
 }
+
+// Commands which are only intercepted if the next layer provides them, so applications can still detect support.
+// The KHR and core descriptor update template entry points are interchangeable.
+static PFN_vkVoidFunction interceptOptionalDeviceCommand(const char *pName)
+{
+	static const struct
+	{
+		const char *name;
+		PFN_vkVoidFunction proc;
+	} optionalDeviceCommands[] = {
+		{ "vkCreateDescriptorUpdateTemplate", reinterpret_cast<PFN_vkVoidFunction>(CreateDescriptorUpdateTemplate) },
+		{ "vkDestroyDescriptorUpdateTemplate", reinterpret_cast<PFN_vkVoidFunction>(DestroyDescriptorUpdateTemplate) },
+		{ "vkUpdateDescriptorSetWithTemplate", reinterpret_cast<PFN_vkVoidFunction>(UpdateDescriptorSetWithTemplate) },
+		{ "vkCreateDescriptorUpdateTemplateKHR", reinterpret_cast<PFN_vkVoidFunction>(CreateDescriptorUpdateTemplate) },
+		{ "vkDestroyDescriptorUpdateTemplateKHR",
+		  reinterpret_cast<PFN_vkVoidFunction>(DestroyDescriptorUpdateTemplate) },
+		{ "vkUpdateDescriptorSetWithTemplateKHR",
+		  reinterpret_cast<PFN_vkVoidFunction>(UpdateDescriptorSetWithTemplate) },
+	};
+
+	for (auto &cmd : optionalDeviceCommands)
+		if (strcmp(cmd.name, pName) == 0)
+			return cmd.proc;
+	return nullptr;
+}
+
+// Commands which the layer does not need to look at, but which have to be seen to make a capture replayable.
+// These are only intercepted when capturing, so they do not add locking overhead otherwise.
+static PFN_vkVoidFunction interceptCaptureDeviceCommand(const char *pName)
+{
+	static const struct
+	{
+		const char *name;
+		PFN_vkVoidFunction proc;
+	} captureDeviceCommands[] = {
+		{ "vkEndCommandBuffer", reinterpret_cast<PFN_vkVoidFunction>(EndCommandBuffer) },
+		{ "vkResetCommandPool", reinterpret_cast<PFN_vkVoidFunction>(ResetCommandPool) },
+		{ "vkResetCommandBuffer", reinterpret_cast<PFN_vkVoidFunction>(ResetCommandBuffer) },
+		{ "vkCmdBindVertexBuffers", reinterpret_cast<PFN_vkVoidFunction>(CmdBindVertexBuffers) },
+		{ "vkCmdSetViewport", reinterpret_cast<PFN_vkVoidFunction>(CmdSetViewport) },
+		{ "vkCmdSetScissor", reinterpret_cast<PFN_vkVoidFunction>(CmdSetScissor) },
+		{ "vkCmdPushConstants", reinterpret_cast<PFN_vkVoidFunction>(CmdPushConstants) },
+	};
+
+	for (auto &cmd : captureDeviceCommands)
+		if (strcmp(cmd.name, pName) == 0)
+			return cmd.proc;
+	return nullptr;
+}
+
+// In record-only mode, command recording and submission go through lightweight entry points which skip all analysis.
+// Returns true in passThrough for commands which are neither analyzed nor captured in this mode,
+// so they can go straight to the next layer.
+static PFN_vkVoidFunction interceptRecordOnlyDeviceCommand(const char *pName, bool &passThrough)
+{
+	static const struct
+	{
+		const char *name;
+		PFN_vkVoidFunction proc;
+	} recordOnlyDeviceCommands[] = {
+		{ "vkBeginCommandBuffer", reinterpret_cast<PFN_vkVoidFunction>(RecordBeginCommandBuffer) },
+		{ "vkQueueSubmit", reinterpret_cast<PFN_vkVoidFunction>(RecordQueueSubmit) },
+		{ "vkCmdExecuteCommands", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdExecuteCommands) },
+		{ "vkCmdBindIndexBuffer", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdBindIndexBuffer) },
+		{ "vkCmdDraw", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdDraw) },
+		{ "vkCmdDrawIndirect", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdDrawIndirect) },
+		{ "vkCmdDrawIndexed", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdDrawIndexed) },
+		{ "vkCmdDrawIndexedIndirect", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdDrawIndexedIndirect) },
+		{ "vkCmdBindPipeline", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdBindPipeline) },
+		{ "vkCmdBeginRenderPass", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdBeginRenderPass) },
+		{ "vkCmdNextSubpass", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdNextSubpass) },
+		{ "vkCmdEndRenderPass", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdEndRenderPass) },
+		{ "vkCmdPipelineBarrier", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdPipelineBarrier) },
+		{ "vkCmdClearColorImage", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdClearColorImage) },
+		{ "vkCmdClearDepthStencilImage", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdClearDepthStencilImage) },
+		{ "vkCmdClearAttachments", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdClearAttachments) },
+		{ "vkCmdCopyBuffer", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdCopyBuffer) },
+		{ "vkCmdCopyImage", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdCopyImage) },
+		{ "vkCmdCopyBufferToImage", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdCopyBufferToImage) },
+		{ "vkCmdCopyImageToBuffer", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdCopyImageToBuffer) },
+		{ "vkCmdBlitImage", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdBlitImage) },
+		{ "vkCmdFillBuffer", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdFillBuffer) },
+		{ "vkCmdUpdateBuffer", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdUpdateBuffer) },
+		{ "vkCmdResolveImage", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdResolveImage) },
+		{ "vkCmdDispatch", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdDispatch) },
+		{ "vkCmdDispatchIndirect", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdDispatchIndirect) },
+		{ "vkCmdBindDescriptorSets", reinterpret_cast<PFN_vkVoidFunction>(RecordCmdBindDescriptorSets) },
+		{ "vkCmdCopyQueryPoolResults", nullptr },
+		{ "vkCmdSetEvent", nullptr },
+		{ "vkCmdResetEvent", nullptr },
+		{ "vkCmdWaitEvents", nullptr },
+		{ "vkQueuePresentKHR", nullptr },
+	};
+
+	passThrough = false;
+	for (auto &cmd : recordOnlyDeviceCommands)
+	{
+		if (strcmp(cmd.name, pName) == 0)
+		{
+			passThrough = cmd.proc == nullptr;
+			return cmd.proc;
+		}
+	}
+	return nullptr;
+}
 }
 
 using namespace MPD;
@@ -1953,12 +2809,33 @@ VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetDeviceProcAddr(VkDevice device, co
 {
 	lock_guard<mutex> holder{ globalLock };
 
+	auto *layer = getLayerData(getDispatchKey(device), deviceData);
+	MPD_ASSERT(layer);
+
+	if (layer->isRecordOnly())
+	{
+		bool passThrough;
+		auto proc = interceptRecordOnlyDeviceCommand(pName, passThrough);
+		if (proc)
+			return proc;
+		if (passThrough)
+			return layer->getTable()->GetDeviceProcAddr(device, pName);
+	}
+
 	auto proc = interceptCoreDeviceCommand(pName);
 	if (proc)
 		return proc;
 
-	auto *layer = getLayerData(getDispatchKey(device), deviceData);
-	MPD_ASSERT(layer);
+	proc = interceptOptionalDeviceCommand(pName);
+	if (proc)
+		return layer->getTable()->GetDeviceProcAddr(device, pName) ? proc : nullptr;
+
+	if (layer->getCapture())
+	{
+		proc = interceptCaptureDeviceCommand(pName);
+		if (proc)
+			return proc;
+	}
 
 	return layer->getTable()->GetDeviceProcAddr(device, pName);
 }
@@ -1982,6 +2859,13 @@ VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetInstanceProcAddr(VkInstance instan
 	auto *layer = getLayerData(getDispatchKey(instance), instanceData);
 	MPD_ASSERT(layer);
 
+	if (!layer->getConfig().captureFilename.empty())
+	{
+		proc = interceptCaptureDeviceCommand(pName);
+		if (proc)
+			return proc;
+	}
+
 	return layer->getProcAddr(pName);
 }
 
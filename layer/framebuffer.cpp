@@ -40,14 +40,58 @@ VkResult Framebuffer::init(VkFramebuffer framebuffer_, const VkFramebufferCreate
 		createInfo.pAttachments = imageViews.empty() ? nullptr : imageViews.data();
 	}
 
+	// Resolve everything up front so beginning a render pass does not have to look up any handles.
+	renderPass = baseDevice->get<RenderPass>(createInfo.renderPass);
+	MPD_ASSERT(renderPass);
+	renderPass->addFramebuffer(this);
+
+	attachments.resize(createInfo.attachmentCount);
+	for (uint32_t i = 0; i < createInfo.attachmentCount; i++)
+	{
+		auto &attachment = attachments[i];
+		if (createInfo.pAttachments[i] == VK_NULL_HANDLE)
+			continue;
+
+		attachment.view = baseDevice->get<ImageView>(createInfo.pAttachments[i]);
+		MPD_ASSERT(attachment.view);
+		attachment.image = attachment.view->getImage();
+		attachment.subresourceRange = attachment.view->getCreateInfo().subresourceRange;
+		attachment.view->addFramebuffer(this);
+	}
+
 	checkPotentiallyTransient();
 
 	return VK_SUCCESS;
 }
 
+Framebuffer::~Framebuffer()
+{
+	if (renderPass)
+		renderPass->removeFramebuffer(this);
+
+	for (auto &attachment : attachments)
+	{
+		// A view can appear more than once, removing is a no-op after the first time.
+		if (attachment.view)
+			attachment.view->removeFramebuffer(this);
+	}
+}
+
+void Framebuffer::invalidateImageView(const ImageView *view)
+{
+	for (auto &attachment : attachments)
+		if (attachment.view == view)
+			attachment = Attachment();
+}
+
+void Framebuffer::invalidateRenderPass(const RenderPass *renderPass_)
+{
+	if (renderPass == renderPass_)
+		renderPass = nullptr;
+}
+
 void Framebuffer::checkPotentiallyTransient()
 {
-	auto *renderPass = baseDevice->get<RenderPass>(createInfo.renderPass);
 	for (uint32_t i = 0; i < createInfo.attachmentCount; i++)
 	{
 		if (createInfo.pAttachments[i] == VK_NULL_HANDLE)
@@ -55,10 +99,7 @@ void Framebuffer::checkPotentiallyTransient()
 		if (i >= renderPass->getCreateInfo().attachmentCount)
 			continue;
 
-		auto *view = baseDevice->get<ImageView>(createInfo.pAttachments[i]);
-		MPD_ASSERT(view);
-		MPD_ASSERT(view->getCreateInfo().image);
-		auto *baseImage = baseDevice->get<Image>(view->getCreateInfo().image);
+		auto *baseImage = attachments[i].image;
 		MPD_ASSERT(baseImage);
 		bool imageIsTransient = (baseImage->getCreateInfo().usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) != 0;
 
@@ -25,6 +25,8 @@
 
 namespace MPD
 {
+class RenderPass;
+
 class Framebuffer : public BaseObject
 {
 public:
@@ -36,6 +38,8 @@ public:
 	{
 	}
 
+	~Framebuffer();
+
 	VkResult init(VkFramebuffer framebuffer, const VkFramebufferCreateInfo &createInfo);
 
 	const VkFramebufferCreateInfo &getCreateInfo() const
@@ -43,10 +47,40 @@ public:
 		return createInfo;
 	}
 
+	/// An attachment of the framebuffer, resolved when the framebuffer is created.
+	/// All pointers are cleared if the image view is destroyed before the framebuffer.
+	struct Attachment
+	{
+		ImageView *view = nullptr;
+		Image *image = nullptr;
+		VkImageSubresourceRange subresourceRange = {};
+	};
+
+	uint32_t getAttachmentCount() const
+	{
+		return uint32_t(attachments.size());
+	}
+
+	const Attachment &getAttachment(uint32_t index) const
+	{
+		return attachments[index];
+	}
+
+	/// The render pass the framebuffer was created against, or nullptr if it has been destroyed since.
+	RenderPass *getRenderPass() const
+	{
+		return renderPass;
+	}
+
+	void invalidateImageView(const ImageView *view);
+	void invalidateRenderPass(const RenderPass *renderPass);
+
 private:
 	VkFramebuffer framebuffer = VK_NULL_HANDLE;
 	VkFramebufferCreateInfo createInfo;
 	std::vector<VkImageView> imageViews;
+	std::vector<Attachment> attachments;
+	RenderPass *renderPass = nullptr;
 
 	void checkPotentiallyTransient();
 };
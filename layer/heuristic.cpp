@@ -32,7 +32,7 @@ namespace MPD
 {
 
 DepthPrePassHeuristic::DepthPrePassHeuristic(CommandBuffer *commandBuffer, Device *device)
-    : Heuristic(device)
+    : Heuristic(device, EVENTS)
 {
 	this->commandBuffer = commandBuffer;
 	reset();
@@ -45,13 +45,12 @@ void DepthPrePassHeuristic::reset()
 	numDrawCallsDepthEqual = 0;
 }
 
-void DepthPrePassHeuristic::cmdBeginRenderPass(VkCommandBuffer, const VkRenderPassBeginInfo *pRenderPassBegin,
-                                               VkSubpassContents)
+void DepthPrePassHeuristic::cmdBeginRenderPass(VkCommandBuffer, const VkRenderPassBeginInfo *,
+                                               RenderPass *renderPass, VkSubpassContents)
 {
 	MPD_ASSERT((state & INSIDE_RENDERPASS) == 0u);
 	reset();
 
-	RenderPass *renderPass = device->get<RenderPass>(pRenderPassBegin->renderPass);
 	MPD_ASSERT(renderPass != nullptr);
 
 	const VkRenderPassCreateInfo &createInfo = renderPass->getCreateInfo();
@@ -170,16 +169,15 @@ void DepthPrePassHeuristic::cmdDrawIndexed(VkCommandBuffer, uint32_t indexCount,
 }
 
 TileReadbackHeuristic::TileReadbackHeuristic(CommandBuffer *commandBuffer, Device *device)
-    : Heuristic(device)
+    : Heuristic(device, EVENTS)
     , commandBuffer(commandBuffer)
 {
 }
 
 void TileReadbackHeuristic::cmdBeginRenderPass(VkCommandBuffer commandBuffer,
                                                const VkRenderPassBeginInfo *pRenderPassBegin,
-                                               VkSubpassContents contents)
+                                               RenderPass *renderPass, VkSubpassContents contents)
 {
-	auto *renderPass = device->get<RenderPass>(pRenderPassBegin->renderPass);
 	MPD_ASSERT(renderPass);
 
 	auto &info = renderPass->getCreateInfo();
@@ -224,7 +222,7 @@ void TileReadbackHeuristic::cmdBeginRenderPass(VkCommandBuffer commandBuffer,
 }
 
 ClearAttachmentsHeuristic::ClearAttachmentsHeuristic(CommandBuffer *commandBuffer, Device *device)
-    : Heuristic(device)
+    : Heuristic(device, EVENTS)
     , commandBuffer(commandBuffer)
 {
 }
@@ -246,10 +244,9 @@ void ClearAttachmentsHeuristic::cmdDrawIndexed(VkCommandBuffer, uint32_t, uint32
 	hasSeenDrawCall = true;
 }
 
-void ClearAttachmentsHeuristic::cmdBeginRenderPass(VkCommandBuffer, const VkRenderPassBeginInfo *pBeginInfo,
-                                                   VkSubpassContents)
+void ClearAttachmentsHeuristic::cmdBeginRenderPass(VkCommandBuffer, const VkRenderPassBeginInfo *,
+                                                   RenderPass *renderPass, VkSubpassContents)
 {
-	auto *renderPass = device->get<RenderPass>(pBeginInfo->renderPass);
 	MPD_ASSERT(renderPass);
 	renderPassInfo = &renderPass->getCreateInfo();
 	currentSubpass = 0;
@@ -21,6 +21,8 @@
 #pragma once
 
 #include "base_object.hpp"
+#include "perfdoc.hpp"
+#include <type_traits>
 
 namespace MPD
 {
@@ -29,11 +31,37 @@ class Device;
 class CommandBuffer;
 class RenderPass;
 
+/// Command buffer events a heuristic can subscribe to.
+/// CommandBuffer only dispatches an event to the heuristics which subscribed to it,
+/// so the per-command cost only grows with the heuristics which actually care about that command.
+enum HeuristicEvent
+{
+	HEURISTIC_EVENT_BEGIN_RENDER_PASS,
+	HEURISTIC_EVENT_SET_RENDER_PASS,
+	HEURISTIC_EVENT_CLEAR_ATTACHMENTS,
+	HEURISTIC_EVENT_SET_SUBPASS,
+	HEURISTIC_EVENT_END_RENDER_PASS,
+	HEURISTIC_EVENT_BIND_PIPELINE,
+	HEURISTIC_EVENT_DRAW,
+	HEURISTIC_EVENT_DRAW_INDEXED,
+	HEURISTIC_EVENT_RESET,
+	HEURISTIC_EVENT_COUNT
+};
+
+using HeuristicEventMask = uint32_t;
+
+static inline constexpr HeuristicEventMask heuristicEventBit(HeuristicEvent event)
+{
+	return 1u << event;
+}
+
 class Heuristic
 {
 public:
-	Heuristic(Device *device)
+	/// events is the mask of events this heuristic overrides, see heuristicEventBit().
+	Heuristic(Device *device, HeuristicEventMask events)
 	    : device(device)
+	    , events(events)
 	{
 	}
 
@@ -41,7 +69,13 @@ public:
 	{
 	}
 
-	virtual void cmdBeginRenderPass(VkCommandBuffer, const VkRenderPassBeginInfo *, VkSubpassContents)
+	HeuristicEventMask getEvents() const
+	{
+		return events;
+	}
+
+	virtual void cmdBeginRenderPass(VkCommandBuffer, const VkRenderPassBeginInfo *, RenderPass *,
+	                                VkSubpassContents)
 	{
 	}
 
@@ -84,15 +118,71 @@ public:
 
 protected:
 	Device *device;
+
+private:
+	HeuristicEventMask events;
+};
+
+// &T::method only has the type of a Heuristic member if T does not override it.
+#define MPD_HEURISTIC_OVERRIDE_BIT(T, method, event) \
+	(std::is_same<decltype(&T::method), decltype(&Heuristic::method)>::value ? 0u : heuristicEventBit(event))
+
+/// Events whose callbacks T overrides. Every one of them must be in T::EVENTS,
+/// as CommandBuffer never calls a callback for an event the heuristic did not subscribe to.
+template <typename T>
+constexpr HeuristicEventMask heuristicOverriddenEvents()
+{
+	return MPD_HEURISTIC_OVERRIDE_BIT(T, cmdBeginRenderPass, HEURISTIC_EVENT_BEGIN_RENDER_PASS) |
+	       MPD_HEURISTIC_OVERRIDE_BIT(T, cmdSetRenderPass, HEURISTIC_EVENT_SET_RENDER_PASS) |
+	       MPD_HEURISTIC_OVERRIDE_BIT(T, cmdClearAttachments, HEURISTIC_EVENT_CLEAR_ATTACHMENTS) |
+	       MPD_HEURISTIC_OVERRIDE_BIT(T, cmdSetSubpass, HEURISTIC_EVENT_SET_SUBPASS) |
+	       MPD_HEURISTIC_OVERRIDE_BIT(T, cmdEndRenderPass, HEURISTIC_EVENT_END_RENDER_PASS) |
+	       MPD_HEURISTIC_OVERRIDE_BIT(T, cmdBindPipeline, HEURISTIC_EVENT_BIND_PIPELINE) |
+	       MPD_HEURISTIC_OVERRIDE_BIT(T, cmdDraw, HEURISTIC_EVENT_DRAW) |
+	       MPD_HEURISTIC_OVERRIDE_BIT(T, cmdDrawIndexed, HEURISTIC_EVENT_DRAW_INDEXED) |
+	       MPD_HEURISTIC_OVERRIDE_BIT(T, reset, HEURISTIC_EVENT_RESET);
+}
+
+/// Fixed-capacity list of the heuristics subscribed to one event.
+/// Stored inline in CommandBuffer so registering heuristics never touches the heap.
+class HeuristicDispatchList
+{
+public:
+	static const unsigned MAX_HEURISTICS = 8;
+
+	void add(Heuristic *heuristic)
+	{
+		MPD_ASSERT(count < MAX_HEURISTICS);
+		heuristics[count++] = heuristic;
+	}
+
+	Heuristic *const *begin() const
+	{
+		return heuristics;
+	}
+
+	Heuristic *const *end() const
+	{
+		return heuristics + count;
+	}
+
+private:
+	Heuristic *heuristics[MAX_HEURISTICS];
+	unsigned count = 0;
 };
 
 class DepthPrePassHeuristic : public Heuristic
 {
 public:
+	static const HeuristicEventMask EVENTS =
+	    heuristicEventBit(HEURISTIC_EVENT_BEGIN_RENDER_PASS) | heuristicEventBit(HEURISTIC_EVENT_END_RENDER_PASS) |
+	    heuristicEventBit(HEURISTIC_EVENT_BIND_PIPELINE) | heuristicEventBit(HEURISTIC_EVENT_DRAW) |
+	    heuristicEventBit(HEURISTIC_EVENT_DRAW_INDEXED) | heuristicEventBit(HEURISTIC_EVENT_RESET);
+
 	DepthPrePassHeuristic(CommandBuffer *commandBuffer, Device *device);
 
 	void cmdBeginRenderPass(VkCommandBuffer commandBuffer, const VkRenderPassBeginInfo *pRenderPassBegin,
-	                        VkSubpassContents contents) override;
+	                        RenderPass *renderPass, VkSubpassContents contents) override;
 
 	void cmdEndRenderPass(VkCommandBuffer commandBuffer) override;
 
@@ -105,9 +195,9 @@ public:
 	void cmdDrawIndexed(VkCommandBuffer commandBuffer, uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex,
 	                    int32_t vertexOffset, uint32_t firstInstance) override;
 
-private:
 	void reset() override;
 
+private:
 	static const uint32_t DEPTH_ATTACHMENT = 0x1;
 	static const uint32_t COLOR_ATTACHMENT = 0x2;
 	static const uint32_t DEPTH_ONLY = 0x4;
@@ -124,10 +214,12 @@ private:
 class TileReadbackHeuristic : public Heuristic
 {
 public:
+	static const HeuristicEventMask EVENTS = heuristicEventBit(HEURISTIC_EVENT_BEGIN_RENDER_PASS);
+
 	TileReadbackHeuristic(CommandBuffer *commandBuffer, Device *device);
 
 	void cmdBeginRenderPass(VkCommandBuffer commandBuffer, const VkRenderPassBeginInfo *pRenderPassBegin,
-	                        VkSubpassContents contents) override;
+	                        RenderPass *renderPass, VkSubpassContents contents) override;
 
 private:
 	CommandBuffer *commandBuffer;
@@ -136,8 +228,15 @@ private:
 class ClearAttachmentsHeuristic : public Heuristic
 {
 public:
+	static const HeuristicEventMask EVENTS =
+	    heuristicEventBit(HEURISTIC_EVENT_BEGIN_RENDER_PASS) | heuristicEventBit(HEURISTIC_EVENT_SET_RENDER_PASS) |
+	    heuristicEventBit(HEURISTIC_EVENT_CLEAR_ATTACHMENTS) | heuristicEventBit(HEURISTIC_EVENT_SET_SUBPASS) |
+	    heuristicEventBit(HEURISTIC_EVENT_DRAW) | heuristicEventBit(HEURISTIC_EVENT_DRAW_INDEXED) |
+	    heuristicEventBit(HEURISTIC_EVENT_RESET);
+
 	ClearAttachmentsHeuristic(CommandBuffer *commandBuffer, Device *device);
-	void cmdBeginRenderPass(VkCommandBuffer, const VkRenderPassBeginInfo *, VkSubpassContents) override;
+	void cmdBeginRenderPass(VkCommandBuffer, const VkRenderPassBeginInfo *, RenderPass *renderPass,
+	                        VkSubpassContents) override;
 	void cmdClearAttachments(VkCommandBuffer, uint32_t, const VkClearAttachment *, uint32_t,
 	                         const VkClearRect *) override;
 	void cmdSetSubpass(VkCommandBuffer, uint32_t index, VkSubpassContents) override;
@@ -21,20 +21,34 @@
 #include "image.hpp"
 #include "device.hpp"
 #include "device_memory.hpp"
+#include "format.hpp"
 #include "message_codes.hpp"
 #include <algorithm>
+#include <stdio.h>
 
 namespace MPD
 {
+static DeadStoreReasonFlags deadStoreReason(Image::Usage usage)
+{
+	switch (usage)
+	{
+	case Image::Usage::RenderPassCleared:
+	case Image::Usage::Cleared:
+		return DEAD_STORE_CLEARED_BIT;
+	case Image::Usage::ResourceOverwrite:
+		return DEAD_STORE_OVERWRITTEN_BIT;
+	case Image::Usage::RenderPassStored:
+		return DEAD_STORE_STORED_AGAIN_BIT;
+	default:
+		return DEAD_STORE_DISCARDED_BIT;
+	}
+}
+
 VkResult Image::init(VkImage image_, const VkImageCreateInfo &createInfo_)
 {
 	image = image_;
 	createInfo = createInfo_;
 
-	arrayLayers.resize(createInfo.arrayLayers);
-	for (auto &layer : arrayLayers)
-		layer.mipLevels.resize(createInfo.mipLevels);
-
 	// Static casting here and compare is fine, the enum == its numeric value.
 	if (static_cast<uint32_t>(createInfo.samples) > baseDevice->getConfig().maxEfficientSamples)
 	{
@@ -64,66 +78,358 @@ Image::Usage Image::getLastUsage(uint32_t arrayLayer, uint32_t mipLevel) const
 {
 	MPD_ASSERT(arrayLayer < createInfo.arrayLayers);
 	MPD_ASSERT(mipLevel < createInfo.mipLevels);
-	auto &resource = arrayLayers[arrayLayer].mipLevels[mipLevel];
-	return resource.lastUsage;
+	if (usageRuns.empty())
+		return uniformUsage;
+	return usageRuns[findUsageRun(mipLevel * createInfo.arrayLayers + arrayLayer)].usage;
 }
 
 void Image::signalUsage(const VkImageSubresourceRange &range, Usage usage)
 {
-	uint32_t maxLayers = createInfo.arrayLayers - range.baseArrayLayer;
-	uint32_t arrayLayers = std::min(range.layerCount, maxLayers);
-	uint32_t maxLevels = createInfo.mipLevels - range.baseMipLevel;
-	uint32_t mipLevels = std::min(createInfo.mipLevels, maxLevels);
+	uint32_t layers = createInfo.arrayLayers;
+	uint32_t arrayLayers = std::min(range.layerCount, layers - range.baseArrayLayer);
+	uint32_t mipLevels = std::min(range.levelCount, createInfo.mipLevels - range.baseMipLevel);
+	if (arrayLayers == 0 || mipLevels == 0)
+		return;
+
+	if (!leavesTile)
+		updateTransientCandidate(usage);
+
+	// Lazily allocated images have no physical memory worth sharing.
+	if (memory && !lazilyAllocated)
+	{
+		bool discardsContents = usage == Usage::Undefined || usage == Usage::RenderPassCleared ||
+		                        usage == Usage::Cleared || usage == Usage::ResourceOverwrite;
+		baseDevice->getMemoryAliasingAdvisor().useImage(this, aliasingInterval, discardsContents);
+	}
+
+	bool wholeImage = arrayLayers == layers && mipLevels == createInfo.mipLevels;
+
+	// If the range covers every array layer, consecutive mip levels are contiguous as well.
+	uint32_t spanLength = arrayLayers == layers ? layers * mipLevels : arrayLayers;
+	uint32_t spanCount = arrayLayers == layers ? 1 : mipLevels;
+	uint32_t first = range.baseMipLevel * layers + range.baseArrayLayer;
+
+	if (usageRuns.empty())
+	{
+		// Every subresource in the range shares the same last usage, so each span is a single run.
+		bool inefficient = isInefficientTransition(uniformUsage, usage);
+		bool deadStore = isDeadStore(uniformUsage, usage);
+		if (inefficient || deadStore)
+		{
+			for (uint32_t span = 0; span < spanCount; span++)
+			{
+				uint32_t begin = first + span * layers;
+				if (inefficient)
+					logInefficientTransition(begin, begin + spanLength, uniformUsage, usage);
+				if (deadStore)
+					recordDeadStore(begin, begin + spanLength, deadStoreReason(usage));
+			}
+		}
+
+		// Descriptor sets which were already signaled this epoch might see a different result now,
+		// but only if the usage of some subresource actually changes.
+		if (usage == uniformUsage)
+			return;
+
+		baseDevice->advanceUsageEpoch();
+		if (wholeImage)
+		{
+			uniformUsage = usage;
+			return;
+		}
+
+		usageRuns.push_back({ 0, layers * createInfo.mipLevels, uniformUsage });
+	}
+	else
+	{
+		bool changed = false;
+		for (uint32_t span = 0; span < spanCount; span++)
+		{
+			uint32_t begin = first + span * layers;
+			if (checkUsageRuns(begin, begin + spanLength, usage))
+				changed = true;
+		}
 
-	for (uint32_t arrayLayer = 0; arrayLayer < arrayLayers; arrayLayer++)
-		for (uint32_t mipLevel = 0; mipLevel < mipLevels; mipLevel++)
-			signalUsage(arrayLayer + range.baseArrayLayer, mipLevel + range.baseMipLevel, usage);
+		if (!changed)
+			return;
+		baseDevice->advanceUsageEpoch();
+	}
+
+	if (wholeImage)
+	{
+		// Keep the storage around, images tend to go back and forth between uniform and partial updates.
+		usageRuns.clear();
+		uniformUsage = usage;
+		return;
+	}
+
+	for (uint32_t span = 0; span < spanCount; span++)
+	{
+		uint32_t begin = first + span * layers;
+		setUsageRun(begin, begin + spanLength, usage);
+	}
+
+	if (usageRuns.size() == 1)
+	{
+		uniformUsage = usageRuns.front().usage;
+		usageRuns.clear();
+	}
 }
 
 void Image::signalUsage(const VkImageSubresourceLayers &range, Usage usage)
 {
-	uint32_t maxLayers = createInfo.arrayLayers - range.baseArrayLayer;
-	uint32_t arrayLayers = std::min(range.layerCount, maxLayers);
-
-	for (uint32_t arrayLayer = 0; arrayLayer < arrayLayers; arrayLayer++)
-		signalUsage(arrayLayer + range.baseArrayLayer, range.mipLevel, usage);
+	VkImageSubresourceRange subresourceRange = { range.aspectMask, range.mipLevel, 1, range.baseArrayLayer,
+		                                         range.layerCount };
+	signalUsage(subresourceRange, usage);
 }
 
 void Image::signalUsage(uint32_t arrayLayer, uint32_t mipLevel, Usage usage)
 {
-	auto oldUsage = getLastUsage(arrayLayer, mipLevel);
+	MPD_ASSERT(arrayLayer < createInfo.arrayLayers);
+	MPD_ASSERT(mipLevel < createInfo.mipLevels);
+	VkImageSubresourceRange subresourceRange = { 0, mipLevel, 1, arrayLayer, 1 };
+	signalUsage(subresourceRange, usage);
+}
+
+uint32_t Image::findUsageRun(uint32_t index) const
+{
+	auto itr = std::upper_bound(begin(usageRuns), end(usageRuns), index,
+	                            [](uint32_t value, const UsageRun &run) { return value < run.end; });
+	MPD_ASSERT(itr != end(usageRuns));
+	return uint32_t(itr - begin(usageRuns));
+}
+
+void Image::setUsageRun(uint32_t begin, uint32_t end, Usage usage)
+{
+	uint32_t first = findUsageRun(begin);
+	uint32_t last = findUsageRun(end - 1);
+
+	// Split the runs at either end which are only partially covered, and merge with neighbours of the same usage.
+	UsageRun runs[3];
+	uint32_t runCount = 0;
+	UsageRun run = { begin, end, usage };
+
+	const auto &head = usageRuns[first];
+	if (head.begin < begin && head.usage != usage)
+		runs[runCount++] = { head.begin, begin, head.usage };
+	else if (head.begin < begin)
+		run.begin = head.begin;
+	else if (first > 0 && usageRuns[first - 1].usage == usage)
+		run.begin = usageRuns[--first].begin;
+
+	runs[runCount++] = run;
+	uint32_t middle = runCount - 1;
+
+	const auto &tail = usageRuns[last];
+	if (tail.end > end && tail.usage != usage)
+		runs[runCount++] = { end, tail.end, tail.usage };
+	else if (tail.end > end)
+		runs[middle].end = tail.end;
+	else if (last + 1 < usageRuns.size() && usageRuns[last + 1].usage == usage)
+		runs[middle].end = usageRuns[++last].end;
+
+	// Overwrite in place where possible so the common case does not shift the array.
+	uint32_t replaced = last - first + 1;
+	uint32_t common = std::min(replaced, runCount);
+	std::copy(runs, runs + common, usageRuns.begin() + first);
+	if (replaced > runCount)
+		usageRuns.erase(usageRuns.begin() + first + common, usageRuns.begin() + first + replaced);
+	else if (runCount > replaced)
+		usageRuns.insert(usageRuns.begin() + first + common, runs + common, runs + runCount);
+}
+
+bool Image::checkUsageRuns(uint32_t begin, uint32_t end, Usage usage)
+{
+	// Neighbouring runs never share a usage, so nothing changes only if the range sits within one run of this usage.
+	uint32_t first = findUsageRun(begin);
+	bool changed = usageRuns[first].end < end || usageRuns[first].usage != usage;
 
+	// Only a couple of usages can make a transition inefficient or kill a store,
+	// don't bother looking at every run otherwise.
+	if (!isInefficientTransition(Usage::RenderPassStored, usage) && !isInefficientTransition(Usage::Cleared, usage) &&
+	    !isDeadStore(Usage::RenderPassStored, usage))
+		return changed;
+
+	for (uint32_t i = first; i < usageRuns.size() && usageRuns[i].begin < end; i++)
+	{
+		auto &run = usageRuns[i];
+		if (isInefficientTransition(run.usage, usage))
+			logInefficientTransition(std::max(run.begin, begin), std::min(run.end, end), run.usage, usage);
+		if (isDeadStore(run.usage, usage))
+			recordDeadStore(std::max(run.begin, begin), std::min(run.end, end), deadStoreReason(usage));
+	}
+	return changed;
+}
+
+bool Image::isDeadStore(Usage oldUsage, Usage usage) const
+{
+	// Presentation reads swapchain images behind our back.
+	if (oldUsage != Usage::RenderPassStored || swapchainImage)
+		return false;
+
+	switch (usage)
+	{
+	case Usage::Undefined:
+	case Usage::RenderPassCleared:
+	case Usage::Cleared:
+	case Usage::ResourceOverwrite:
+	case Usage::RenderPassStored:
+	case Usage::RenderPassDiscarded:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+VkDeviceSize Image::getSubresourceBytes(uint32_t begin, uint32_t end) const
+{
+	uint32_t layers = createInfo.arrayLayers;
+	VkDeviceSize bytes = 0;
+	for (uint32_t level = begin / layers; level * layers < end; level++)
+	{
+		uint32_t first = std::max(begin, level * layers);
+		uint32_t last = std::min(end, (level + 1) * layers);
+		VkExtent3D extent = { std::max(createInfo.extent.width >> level, 1u),
+			                  std::max(createInfo.extent.height >> level, 1u),
+			                  std::max(createInfo.extent.depth >> level, 1u) };
+		bytes += BandwidthTracker::imageRegionBytes(*this, extent, last - first);
+	}
+	return bytes;
+}
+
+void Image::recordDeadStore(uint32_t begin, uint32_t end, DeadStoreReasonFlags reason)
+{
+	baseDevice->getBandwidthTracker().addDeadStore(image, getSubresourceBytes(begin, end), reason);
+}
+
+void Image::updateTransientCandidate(Usage usage)
+{
+	// Only these come from render pass load/store ops which keep the contents on tile.
+	bool onTileOnly =
+	    usage == Usage::Undefined || usage == Usage::RenderPassCleared || usage == Usage::RenderPassDiscarded;
+
+	if (!onTileOnly)
+	{
+		leavesTile = true;
+		if (transientCandidate)
+			baseDevice->getTransientMemoryTracker().disqualifyCandidate(transientCandidateHeap, memoryRequirements.size,
+			                                                            transientCandidateTime);
+		transientCandidate = false;
+	}
+	// Load ops come before the store op of the same render pass, so only a discarding store op adds a candidate.
+	// Otherwise every stored attachment would briefly count towards the peak.
+	else if (usage == Usage::RenderPassDiscarded && !transientCandidate && memory && !lazilyAllocated)
+	{
+		auto &memoryType =
+		    baseDevice->getMemoryProperties().memoryTypes[memory->getAllocateInfo().memoryTypeIndex];
+		transientCandidate = true;
+		transientCandidateHeap = memoryType.heapIndex;
+		transientCandidateTime =
+		    baseDevice->getTransientMemoryTracker().addCandidate(transientCandidateHeap, memoryRequirements.size);
+	}
+}
+
+void Image::signalDestroy()
+{
+	baseDevice->getMemoryAliasingAdvisor().removeImage(this, aliasingInterval);
+
+	if (transientCandidate)
+		baseDevice->getTransientMemoryTracker().removeCandidate(transientCandidateHeap, memoryRequirements.size,
+		                                                        transientCandidateTime);
+	transientCandidate = false;
+
+	if (usageRuns.empty())
+	{
+		if (isDeadStore(uniformUsage, Usage::Undefined))
+			recordDeadStore(0, createInfo.arrayLayers * createInfo.mipLevels, DEAD_STORE_DESTROYED_BIT);
+		return;
+	}
+
+	for (auto &run : usageRuns)
+		if (isDeadStore(run.usage, Usage::Undefined))
+			recordDeadStore(run.begin, run.end, DEAD_STORE_DESTROYED_BIT);
+}
+
+bool Image::coversMipLevel(const VkImageSubresourceLayers &subresource, const VkOffset3D &offset,
+                           const VkExtent3D &extent) const
+{
+	// A region which leaves an aspect untouched, e.g. a depth-only copy into a depth/stencil image,
+	// does not replace the data of that aspect.
+	VkImageAspectFlags aspects = VK_IMAGE_ASPECT_COLOR_BIT;
+	if (formatIsDepthStencil(createInfo.format))
+		aspects = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+	else if (formatIsDepthOnly(createInfo.format))
+		aspects = VK_IMAGE_ASPECT_DEPTH_BIT;
+	else if (formatIsStencilOnly(createInfo.format))
+		aspects = VK_IMAGE_ASPECT_STENCIL_BIT;
+
+	if ((subresource.aspectMask & aspects) != aspects)
+		return false;
+
+	uint32_t mipLevel = subresource.mipLevel;
+	return offset.x == 0 && offset.y == 0 && offset.z == 0 &&
+	       extent.width >= std::max(createInfo.extent.width >> mipLevel, 1u) &&
+	       extent.height >= std::max(createInfo.extent.height >> mipLevel, 1u) &&
+	       extent.depth >= std::max(createInfo.extent.depth >> mipLevel, 1u);
+}
+
+bool Image::isInefficientTransition(Usage oldUsage, Usage usage) const
+{
 	// Swapchain images are implicitly read so clear after store is expected.
-	if (usage == Usage::RenderPassCleared && oldUsage == Usage::RenderPassStored && !swapchainImage)
+	if (usage == Usage::RenderPassCleared)
+		return (oldUsage == Usage::RenderPassStored && !swapchainImage) || oldUsage == Usage::Cleared;
+	else if (usage == Usage::RenderPassReadToTile)
+		return oldUsage == Usage::Cleared;
+	else
+		return false;
+}
+
+void Image::logInefficientTransition(uint32_t begin, uint32_t end, Usage oldUsage, Usage usage)
+{
+	// Name the whole run rather than warning about each subresource in it.
+	char subresources[128];
+	uint32_t layers = createInfo.arrayLayers;
+	if (end - begin == 1)
+	{
+		snprintf(subresources, sizeof(subresources), "Subresource (arrayLayer: %u, mipLevel: %u)", begin % layers,
+		         begin / layers);
+	}
+	else
+	{
+		snprintf(subresources, sizeof(subresources),
+		         "%u subresources (arrayLayer: %u, mipLevel: %u) to (arrayLayer: %u, mipLevel: %u)", end - begin,
+		         begin % layers, begin / layers, (end - 1) % layers, (end - 1) / layers);
+	}
+
+	if (usage == Usage::RenderPassCleared && oldUsage == Usage::RenderPassStored)
 	{
 		log(VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT, MESSAGE_CODE_REDUNDANT_RENDERPASS_STORE,
-		    "Subresource (arrayLayer: %u, mipLevel: %u) of image was cleared as part of LOAD_OP_CLEAR, but last time "
+		    "%s of image was cleared as part of LOAD_OP_CLEAR, but last time "
 		    "image was used, it was written to with STORE_OP_STORE. "
 		    "Storing to the image is probably redundant in this case, and wastes bandwidth on tile-based "
 		    "architectures.",
-		    arrayLayer, mipLevel);
+		    subresources);
 	}
 	else if (usage == Usage::RenderPassCleared && oldUsage == Usage::Cleared)
 	{
 		log(VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT, MESSAGE_CODE_REDUNDANT_IMAGE_CLEAR,
-		    "Subresource (arrayLayer: %u, mipLevel: %u) of image was cleared as part of LOAD_OP_CLEAR, but last time "
+		    "%s of image was cleared as part of LOAD_OP_CLEAR, but last time "
 		    "image was used, it was written to with vkCmdClear*Image(). "
 		    "Clearing the image with vkCmdClear*Image() is probably redundant in this case, and wastes bandwidth on "
 		    "tile-based architectures.",
-		    arrayLayer, mipLevel);
+		    subresources);
 	}
 	else if (usage == Usage::RenderPassReadToTile && oldUsage == Usage::Cleared)
 	{
 		log(VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT, MESSAGE_CODE_INEFFICIENT_CLEAR,
-		    "Subresource (arrayLayer: %u, mipLevel: %u) of image was loaded to tile as part of LOAD_OP_LOAD, but last "
+		    "%s of image was loaded to tile as part of LOAD_OP_LOAD, but last "
 		    "time image was used, it was written to with vkCmdClear*Image(). "
 		    "Clearing the image with vkCmdClear*Image() is probably redundant in this case, and wastes bandwidth on "
 		    "tile-based architectures. "
 		    "Use LOAD_OP_CLEAR instead to clear the image for free.",
-		    arrayLayer, mipLevel);
+		    subresources);
 	}
-
-	arrayLayers[arrayLayer].mipLevels[mipLevel].lastUsage = usage;
 }
 
 VkResult Image::initSwapchain(VkImage image_, const VkImageCreateInfo &createInfo)
@@ -196,6 +502,10 @@ VkResult Image::bindMemory(DeviceMemory *memory_, VkDeviceSize offset)
 	memory = memory_;
 	memoryOffset = offset;
 
+	auto memoryType = memory->getAllocateInfo().memoryTypeIndex;
+	lazilyAllocated = (baseDevice->getMemoryProperties().memoryTypes[memoryType].propertyFlags &
+	                   VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0;
+
 	checkLazyAndTransient();
 	checkAllocationSize();
 
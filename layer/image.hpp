@@ -19,7 +19,9 @@
  */
 
 #pragma once
+#include "bandwidth_tracker.hpp"
 #include "base_object.hpp"
+#include "memory_aliasing_advisor.hpp"
 #include "dispatch_helper.hpp"
 #include "perfdoc.hpp"
 #include <vector>
@@ -53,6 +55,16 @@ public:
 		return createInfo;
 	}
 
+	VkImage getImage() const
+	{
+		return image;
+	}
+
+	const AliasingInterval &getAliasingInterval() const
+	{
+		return aliasingInterval;
+	}
+
 	bool isSwapchainImage() const
 	{
 		return swapchainImage;
@@ -66,6 +78,8 @@ public:
 		Cleared,
 		ResourceRead,
 		ResourceWrite,
+		// A transfer write which replaces every texel of the subresource.
+		ResourceOverwrite,
 		RenderPassStored,
 		RenderPassDiscarded
 	};
@@ -74,8 +88,17 @@ public:
 	void signalUsage(const VkImageSubresourceRange &range, Usage usage);
 	void signalUsage(const VkImageSubresourceLayers &range, Usage usage);
 
+	/// Called when the image is destroyed, any stored data which was never read is wasted.
+	/// Also withdraws the image from the transient memory and aliasing candidates.
+	void signalDestroy();
+
 	Usage getLastUsage(uint32_t arrayLayer, uint32_t mipLevel) const;
 
+	/// Returns true if a transfer region starting at offset with the given extent writes all of a mip level,
+	/// in every aspect of the image.
+	bool coversMipLevel(const VkImageSubresourceLayers &subresource, const VkOffset3D &offset,
+	                    const VkExtent3D &extent) const;
+
 private:
 	VkImage image = VK_NULL_HANDLE;
 	DeviceMemory *memory = nullptr;
@@ -83,20 +106,46 @@ private:
 	VkImageCreateInfo createInfo;
 	VkMemoryRequirements memoryRequirements;
 	bool swapchainImage = false;
+	bool lazilyAllocated = false;
+	AliasingInterval aliasingInterval;
 
 	void checkLazyAndTransient();
 	void checkAllocationSize();
 
-	struct MipLevel
+	// Subresources are ordered by mip level, then array layer, so a range of layers in one mip level is contiguous.
+	// The last usage is tracked as sorted, non-overlapping runs [begin, end) which cover every subresource,
+	// adjacent runs always have different usages.
+	// While every subresource shares the same usage, usageRuns is empty and uniformUsage holds the state.
+	struct UsageRun
 	{
-		Usage lastUsage = Usage::Undefined;
+		uint32_t begin;
+		uint32_t end;
+		Usage usage;
 	};
 
-	struct Layer
-	{
-		std::vector<MipLevel> mipLevels;
-	};
+	Usage uniformUsage = Usage::Undefined;
+	std::vector<UsageRun> usageRuns;
+
+	uint32_t findUsageRun(uint32_t index) const;
+	void setUsageRun(uint32_t begin, uint32_t end, Usage usage);
+	// Logs transitions out of the runs in the range, returns true if any of them has a different usage.
+	bool checkUsageRuns(uint32_t begin, uint32_t end, Usage usage);
+	bool isInefficientTransition(Usage oldUsage, Usage usage) const;
+	void logInefficientTransition(uint32_t begin, uint32_t end, Usage oldUsage, Usage usage);
+
+	// A subresource whose last usage is RenderPassStored holds data nobody has read yet.
+	// Once it is replaced or discarded without being read, the store was dead.
+	bool isDeadStore(Usage oldUsage, Usage usage) const;
+
+	// Set once any usage needs the contents in memory. Until then, the image is counted by the
+	// device's TransientMemoryTracker as soon as it is used as an attachment.
+	bool leavesTile = false;
+	bool transientCandidate = false;
+	uint32_t transientCandidateHeap = 0;
+	uint64_t transientCandidateTime = 0;
+	void updateTransientCandidate(Usage usage);
 
-	std::vector<Layer> arrayLayers;
+	void recordDeadStore(uint32_t begin, uint32_t end, DeadStoreReasonFlags reason);
+	VkDeviceSize getSubresourceBytes(uint32_t begin, uint32_t end) const;
 };
 }
@@ -20,6 +20,8 @@
 
 #include "image_view.hpp"
 #include "device.hpp"
+#include "framebuffer.hpp"
+#include <algorithm>
 
 namespace MPD
 {
@@ -31,8 +33,38 @@ VkResult ImageView::init(VkImageView imageView_, const VkImageViewCreateInfo &cr
 	return VK_SUCCESS;
 }
 
-void ImageView::signalUsage(Image::Usage usage)
+ImageView::~ImageView()
 {
+	for (auto *framebuffer : framebuffers)
+		framebuffer->invalidateImageView(this);
+}
+
+void ImageView::addFramebuffer(Framebuffer *framebuffer)
+{
+	if (std::find(std::begin(framebuffers), std::end(framebuffers), framebuffer) == std::end(framebuffers))
+		framebuffers.push_back(framebuffer);
+}
+
+void ImageView::removeFramebuffer(Framebuffer *framebuffer)
+{
+	auto itr = std::find(std::begin(framebuffers), std::end(framebuffers), framebuffer);
+	if (itr != std::end(framebuffers))
+	{
+		*itr = framebuffers.back();
+		framebuffers.pop_back();
+	}
+}
+
+bool ImageView::signalUsage(Image::Usage usage)
+{
+	if (signaledEpoch == baseDevice->getUsageEpoch() && signaledUsage == usage)
+		return false;
+
 	image->signalUsage(createInfo.subresourceRange, usage);
+
+	// Read the epoch back, a state change of the image itself should not invalidate this signal.
+	signaledEpoch = baseDevice->getUsageEpoch();
+	signaledUsage = usage;
+	return true;
 }
 }
\ No newline at end of file
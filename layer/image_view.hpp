@@ -25,6 +25,8 @@
 
 namespace MPD
 {
+class Framebuffer;
+
 class ImageView : public BaseObject
 {
 public:
@@ -36,6 +38,8 @@ public:
 	{
 	}
 
+	~ImageView();
+
 	VkResult init(VkImageView imageView, const VkImageViewCreateInfo &createInfo);
 
 	const VkImageViewCreateInfo &getCreateInfo() const
@@ -43,11 +47,25 @@ public:
 		return createInfo;
 	}
 
-	void signalUsage(Image::Usage usage);
+	Image *getImage() const
+	{
+		return image;
+	}
+
+	/// Returns false if the view was already signaled with the same usage this epoch, which would not change anything.
+	bool signalUsage(Image::Usage usage);
+
+	/// Framebuffers which cache a pointer to this view, invalidated when the view is destroyed.
+	void addFramebuffer(Framebuffer *framebuffer);
+	void removeFramebuffer(Framebuffer *framebuffer);
 
 private:
 	VkImageView imageView = VK_NULL_HANDLE;
 	VkImageViewCreateInfo createInfo;
 	Image *image = nullptr;
+	std::vector<Framebuffer *> framebuffers;
+
+	uint64_t signaledEpoch = 0;
+	Image::Usage signaledUsage = Image::Usage::Undefined;
 };
 }
@@ -128,11 +128,13 @@ bool Instance::init(VkInstance instance_, VkLayerInstanceDispatchTable *pTable_,
 	auto configPath = getSystemProperty("debug.mali.perfdoc.config");
 	const char *path = configPath.empty() ? nullptr : configPath.c_str();
 	auto logFilename = getSystemProperty("debug.mali.perfdoc.log");
+	auto captureFilename = getSystemProperty("debug.mali.perfdoc.capture");
 #else
 	const char *path = getenv("MALI_PERFDOC_CONFIG");
 	if (!path)
 		path = "mali-perfdoc.cfg";
 	const char *logFilename = getenv("MALI_PERFDOC_LOG");
+	const char *captureFilename = getenv("MALI_PERFDOC_CAPTURE");
 #endif
 
 	const char *dumpPath = getenv("MALI_PERFDOC_CONFIG_DUMP");
@@ -152,9 +154,13 @@ bool Instance::init(VkInstance instance_, VkLayerInstanceDispatchTable *pTable_,
 #ifdef ANDROID
 	if (cfg.loggingFilename.empty())
 		cfg.loggingFilename = logFilename;
+	if (cfg.captureFilename.empty())
+		cfg.captureFilename = captureFilename;
 #else
 	if (cfg.loggingFilename.empty() && logFilename)
 		cfg.loggingFilename = logFilename;
+	if (cfg.captureFilename.empty() && captureFilename)
+		cfg.captureFilename = captureFilename;
 #endif
 
 	// Setup custom logging callbacks.
@@ -0,0 +1,184 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "memory_aliasing_advisor.hpp"
+#include "device.hpp"
+#include "image.hpp"
+#include "message_codes.hpp"
+#include <algorithm>
+#include <stdio.h>
+#include <string>
+
+using namespace std;
+
+namespace MPD
+{
+MemoryAliasingAdvisor::MemoryAliasingAdvisor(Device &device)
+    : device(device)
+{
+}
+
+void MemoryAliasingAdvisor::useImage(Image *image, AliasingInterval &interval, bool discardsContents)
+{
+	if (interval.frame != frame)
+	{
+		interval.usedInPreviousFrame = interval.frame + 1 == frame;
+		interval.frame = frame;
+		interval.firstUse = clock;
+		interval.readsPreviousContents = !discardsContents;
+		images.push_back(image);
+	}
+	interval.lastUse = clock;
+}
+
+void MemoryAliasingAdvisor::removeImage(Image *image, const AliasingInterval &interval)
+{
+	if (interval.frame != frame)
+		return;
+
+	auto itr = find(begin(images), end(images), image);
+	if (itr != end(images))
+	{
+		*itr = images.back();
+		images.pop_back();
+	}
+}
+
+void MemoryAliasingAdvisor::endFrame()
+{
+	planAliasing();
+	images.clear();
+	frame++;
+	clock = 0;
+}
+
+void MemoryAliasingAdvisor::planAliasing()
+{
+	candidates.clear();
+	blocks.clear();
+
+	for (auto *image : images)
+	{
+		auto &interval = image->getAliasingInterval();
+		if (interval.readsPreviousContents || !interval.usedInPreviousFrame)
+			continue;
+
+		auto &requirements = image->getMemoryRequirements();
+		candidates.push_back(
+		    { image, interval.firstUse, interval.lastUse, requirements.size, requirements.memoryTypeBits, 0 });
+	}
+
+	if (candidates.size() < 2)
+		return;
+
+	sort(begin(candidates), end(candidates),
+	     [](const Candidate &a, const Candidate &b) { return a.firstUse < b.firstUse; });
+
+	VkDeviceSize totalBytes = 0;
+	for (auto &candidate : candidates)
+	{
+		totalBytes += candidate.size;
+
+		// Best fit: the smallest free block the image fits in, otherwise the largest free block, which has to grow.
+		uint32_t best = ~0u;
+		for (uint32_t i = 0; i < blocks.size(); i++)
+		{
+			auto &block = blocks[i];
+			if (block.lastUse >= candidate.firstUse || (block.memoryTypeBits & candidate.memoryTypeBits) == 0)
+				continue;
+
+			if (best == ~0u)
+			{
+				best = i;
+				continue;
+			}
+
+			bool fits = block.size >= candidate.size;
+			bool bestFits = blocks[best].size >= candidate.size;
+			if ((fits && !bestFits) || (fits && block.size < blocks[best].size) ||
+			    (!fits && !bestFits && block.size > blocks[best].size))
+				best = i;
+		}
+
+		if (best == ~0u)
+		{
+			candidate.block = uint32_t(blocks.size());
+			blocks.push_back({ candidate.size, candidate.memoryTypeBits, candidate.lastUse, 1 });
+		}
+		else
+		{
+			auto &block = blocks[best];
+			candidate.block = best;
+			block.size = max(block.size, candidate.size);
+			block.memoryTypeBits &= candidate.memoryTypeBits;
+			block.lastUse = candidate.lastUse;
+			block.imageCount++;
+		}
+	}
+
+	VkDeviceSize blockBytes = 0;
+	for (auto &block : blocks)
+		blockBytes += block.size;
+
+	VkDeviceSize savedBytes = totalBytes - blockBytes;
+	if (savedBytes > reportedSavings)
+	{
+		reportedSavings = savedBytes;
+		report(totalBytes, savedBytes);
+	}
+}
+
+static double toMiB(double bytes)
+{
+	return bytes / (1024.0 * 1024.0);
+}
+
+void MemoryAliasingAdvisor::report(VkDeviceSize totalBytes, VkDeviceSize savedBytes)
+{
+	char line[256];
+	snprintf(line, sizeof(line),
+	         "%u image(s) using %.2f MiB are only used during part of a frame and never read what the previous frame "
+	         "left in them. Aliasing them in %u memory block(s) would save %.2f MiB. Images which could share memory:",
+	         unsigned(candidates.size()), toMiB(double(totalBytes)), unsigned(blocks.size()), toMiB(double(savedBytes)));
+	string message = line;
+
+	for (uint32_t i = 0; i < blocks.size(); i++)
+	{
+		if (blocks[i].imageCount < 2)
+			continue;
+
+		snprintf(line, sizeof(line), "\n  %.2f MiB block:", toMiB(double(blocks[i].size)));
+		message += line;
+
+		for (auto &candidate : candidates)
+		{
+			if (candidate.block != i)
+				continue;
+
+			snprintf(line, sizeof(line), " VkImage 0x%llx", static_cast<unsigned long long>(
+			                                                      (uint64_t)candidate.image->getImage()));
+			message += line;
+		}
+	}
+
+	device.log(VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT, MESSAGE_CODE_MEMORY_ALIASING_CANDIDATES, "%s",
+	           message.c_str());
+}
+}
@@ -0,0 +1,98 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#include "perfdoc.hpp"
+#include <vector>
+
+namespace MPD
+{
+class Device;
+class Image;
+
+/// When an image was first and last used in the current frame, kept by the image itself.
+struct AliasingInterval
+{
+	uint64_t frame = ~0ull;
+	uint32_t firstUse = 0;
+	uint32_t lastUse = 0;
+	// If the first use of the frame reads what the previous frame left behind, the image cannot share memory.
+	bool readsPreviousContents = false;
+	// Resources which are only touched once, e.g. uploaded and sampled in a loading frame, are not aliased.
+	bool usedInPreviousFrame = false;
+};
+
+/// Finds images which are only alive for part of each frame and could share memory with each other.
+/// Image usage is timestamped with a clock which ticks at each render pass boundary as work is submitted.
+/// At the end of every frame, the images' lifetimes are packed into as few memory blocks as possible,
+/// greedily assigning each interval to a free block of a compatible memory type.
+/// Like the other image usage tracking, usage is only seen the first time a recording is submitted.
+/// Command buffers which are recorded once and submitted every frame do not contribute after the first frame.
+class MemoryAliasingAdvisor
+{
+public:
+	explicit MemoryAliasingAdvisor(Device &device);
+
+	void tick()
+	{
+		clock++;
+	}
+
+	/// An image with memory bound to it was used. discardsContents is true if the usage does not read old contents.
+	void useImage(Image *image, AliasingInterval &interval, bool discardsContents);
+
+	/// The image is being destroyed, forget about it for the rest of the frame.
+	void removeImage(Image *image, const AliasingInterval &interval);
+
+	/// Called on present, plans aliasing for the frame and reports if it would save more than reported before.
+	void endFrame();
+
+private:
+	Device &device;
+	uint64_t frame = 1;
+	uint32_t clock = 0;
+	std::vector<Image *> images;
+
+	struct Candidate
+	{
+		Image *image;
+		uint32_t firstUse;
+		uint32_t lastUse;
+		VkDeviceSize size;
+		uint32_t memoryTypeBits;
+		uint32_t block;
+	};
+
+	struct Block
+	{
+		VkDeviceSize size;
+		uint32_t memoryTypeBits;
+		uint32_t lastUse;
+		uint32_t imageCount;
+	};
+
+	std::vector<Candidate> candidates;
+	std::vector<Block> blocks;
+	VkDeviceSize reportedSavings = 0;
+
+	void planAliasing();
+	void report(VkDeviceSize totalBytes, VkDeviceSize savedBytes);
+};
+}
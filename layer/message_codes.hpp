@@ -61,6 +61,21 @@ enum MessageCodes
 	MESSAGE_CODE_REDUNDANT_IMAGE_CLEAR = 35,
 	MESSAGE_CODE_INEFFICIENT_CLEAR = 36,
 	MESSAGE_CODE_LAZY_TRANSIENT_IMAGE_NOT_SUPPORTED = 37,
+	MESSAGE_CODE_BANDWIDTH_REPORT = 38,
+	MESSAGE_CODE_TILE_BUFFER_BUDGET_EXCEEDED = 39,
+	MESSAGE_CODE_RENDER_PASS_MERGE_CANDIDATE = 40,
+	MESSAGE_CODE_DEAD_ATTACHMENT_STORE = 41,
+	MESSAGE_CODE_TRANSIENT_MEMORY_SAVINGS = 42,
+	MESSAGE_CODE_MEMORY_ALIASING_CANDIDATES = 43,
+	MESSAGE_CODE_DESCRIPTOR_POOL_OVER_PROVISIONED = 44,
+	MESSAGE_CODE_REDUNDANT_STATE_BIND = 45,
+	MESSAGE_CODE_DRAW_ORDER_STATE_CHANGES = 46,
+	MESSAGE_CODE_PIPELINE_LAYOUT_UNUSED_BINDING = 47,
+	MESSAGE_CODE_PIPELINE_LAYOUT_OVERSIZED_PUSH_CONSTANTS = 48,
+	MESSAGE_CODE_PIPELINE_LAYOUT_MERGEABLE_SETS = 49,
+	MESSAGE_CODE_HIDDEN_SURFACE_REMOVAL_DISABLED = 50,
+	MESSAGE_CODE_SHADER_COST_REPORT = 51,
+	MESSAGE_CODE_FULL_PRECISION_FRAGMENT_SHADER = 52,
 
 	MESSAGE_CODE_COUNT
 };
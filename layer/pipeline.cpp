@@ -238,6 +238,8 @@ VkResult Pipeline::initCompute(VkPipeline pipeline_, const VkComputePipelineCrea
 
 	checkWorkGroupSize(createInfo);
 	checkPushConstantsForStage(createInfo.stage);
+	if (layout)
+		layout->addPipelineUsage(1, &createInfo.stage);
 	return VK_SUCCESS;
 }
 
@@ -327,10 +329,132 @@ VkResult Pipeline::initGraphics(VkPipeline pipeline_, const VkGraphicsPipelineCr
 		this->createInfo.graphics.pColorBlendState = &colorBlendState;
 	}
 
+	// Without depth writes, later draws are not tested against earlier ones. Draws which do not write color are
+	// usually depth pre-passes or stencil setup which other draws rely on, so they are left in place too.
+	auto compareOp = depthStencilState.depthCompareOp;
+	orderIndependent = depthStencilState.depthTestEnable && depthStencilState.depthWriteEnable &&
+	                   !depthStencilState.stencilTestEnable && compareOp != VK_COMPARE_OP_EQUAL &&
+	                   compareOp != VK_COMPARE_OP_NOT_EQUAL && compareOp != VK_COMPARE_OP_ALWAYS &&
+	                   compareOp != VK_COMPARE_OP_NEVER;
+	for (auto &attachment : colorBlendAttachmentState)
+		if (attachment.blendEnable || attachment.colorWriteMask == 0)
+			orderIndependent = false;
+
 	checkInstancedVertexBuffer(createInfo);
 	checkMultisampledBlending(createInfo);
 	for (uint32_t i = 0; i < createInfo.stageCount; i++)
-		checkPushConstantsForStage(createInfo.pStages[i]);
+	{
+		auto &stage = createInfo.pStages[i];
+		checkPushConstantsForStage(stage);
+		if (stage.stage == VK_SHADER_STAGE_FRAGMENT_BIT)
+			baseDevice->get<ShaderModule>(stage.module)->checkFragmentPrecision(stage.pName);
+	}
+	if (layout)
+		layout->addPipelineUsage(createInfo.stageCount, createInfo.pStages);
+	checkHiddenSurfaceRemoval(createInfo);
+	estimateShaderCosts(createInfo);
 	return VK_SUCCESS;
 }
+
+static string describeFragmentEffects(uint32_t effects)
+{
+	static const char *const names[] = { "writing FragDepth", "discard", "storage buffer or image writes",
+		                                 "atomics", "alpha to coverage" };
+
+	string description;
+	for (uint32_t bit = 0; bit < sizeof(names) / sizeof(names[0]); bit++)
+	{
+		if (effects & (1u << bit))
+		{
+			if (!description.empty())
+				description += ", ";
+			description += names[bit];
+		}
+	}
+	return description;
+}
+
+void Pipeline::checkHiddenSurfaceRemoval(const VkGraphicsPipelineCreateInfo &createInfo)
+{
+	uint32_t effects = 0;
+	if (createInfo.pMultisampleState && createInfo.pMultisampleState->alphaToCoverageEnable)
+		effects |= FRAGMENT_ALPHA_TO_COVERAGE;
+
+	bool earlyFragmentTests = false;
+	for (uint32_t i = 0; i < createInfo.stageCount; i++)
+	{
+		auto &stage = createInfo.pStages[i];
+		if (stage.stage != VK_SHADER_STAGE_FRAGMENT_BIT)
+			continue;
+
+		auto &fragment = baseDevice->get<ShaderModule>(stage.module)->getFragmentEffects(stage.pName);
+		if (!fragment.valid)
+			return;
+
+		effects |= fragment.effects;
+		earlyFragmentTests = fragment.earlyFragmentTests;
+	}
+
+	// Early depth/stencil testing only matters if the pipeline tests depth or stencil at all.
+	// Discarding fragments only delays the depth/stencil update if the pipeline writes depth or stencil.
+	auto *depthStencil = createInfo.pDepthStencilState;
+	if (depthStencil && (depthStencil->depthTestEnable || depthStencil->stencilTestEnable))
+	{
+		earlyZSKillers = effects & FRAGMENT_WRITES_DEPTH;
+		if (!earlyFragmentTests)
+			earlyZSKillers |= effects & (FRAGMENT_WRITES_STORAGE | FRAGMENT_USES_ATOMICS);
+		if (depthStencil->depthWriteEnable || depthStencil->stencilTestEnable)
+			earlyZSKillers |= effects & (FRAGMENT_DISCARDS | FRAGMENT_ALPHA_TO_COVERAGE);
+	}
+
+	// Blended fragments can never be killed by later ones, so the shader costs nothing extra there.
+	bool blending = false;
+	for (auto &attachment : colorBlendAttachmentState)
+		if (attachment.blendEnable)
+			blending = true;
+	if (!blending)
+		forwardPixelKillKillers = effects;
+}
+
+void Pipeline::estimateShaderCosts(const VkGraphicsPipelineCreateInfo &createInfo)
+{
+	for (uint32_t i = 0; i < createInfo.stageCount; i++)
+	{
+		auto &stage = createInfo.pStages[i];
+		ShaderCost cost;
+		if (!baseDevice->get<ShaderModule>(stage.module)->getShaderCost(stage.pName, stage.stage, cost))
+			continue;
+
+		shaders.push_back({ ShaderCostTracker::hashShader(stage.module, stage.stage, stage.pName), stage.module,
+		                    stage.stage, stage.pName, cost });
+	}
+}
+
+void Pipeline::addSubmittedDraws(uint32_t count)
+{
+	submittedDraws += count;
+
+	auto &tracker = baseDevice->getShaderCostTracker();
+	for (auto &shader : shaders)
+		tracker.addDraws(shader, count);
+	if (!earlyZSKillers && !forwardPixelKillKillers)
+		return;
+
+	// Report once the pipeline is used a lot, then again each time its use doubles.
+	uint64_t threshold = max<uint64_t>(baseDevice->getConfig().hiddenSurfaceRemovalDrawThreshold, 2 * reportedDraws);
+	if (submittedDraws < threshold)
+		return;
+	reportedDraws = submittedDraws;
+
+	string message;
+	if (earlyZSKillers)
+		message += " Early depth/stencil testing is disabled by " + describeFragmentEffects(earlyZSKillers) + ".";
+	if (forwardPixelKillKillers)
+		message += " Forward Pixel Kill is disabled by " + describeFragmentEffects(forwardPixelKillKillers) + ".";
+
+	log(VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT, MESSAGE_CODE_HIDDEN_SURFACE_REMOVAL_DISABLED,
+	    "%llu submitted draws used a pipeline which defeats hidden surface removal, so their fragments are shaded "
+	    "even where later geometry hides them.%s",
+	    static_cast<unsigned long long>(submittedDraws), message.c_str());
+}
 }
@@ -21,6 +21,7 @@
 #pragma once
 #include "base_object.hpp"
 #include "pipeline_layout.hpp"
+#include "shader_cost_tracker.hpp"
 
 #include <vector>
 
@@ -68,9 +69,29 @@ public:
 		return layout;
 	}
 
+	/// True if draws with this pipeline give the same result in any order:
+	/// they test and write depth and write color, without blending or stencil.
+	bool isOrderIndependent() const
+	{
+		return orderIndependent;
+	}
+
+	/// Fragment work which keeps Mali's hidden surface removal from culling occluded fragments.
+	enum FragmentEffectBits
+	{
+		FRAGMENT_WRITES_DEPTH = 1 << 0,
+		FRAGMENT_DISCARDS = 1 << 1,
+		FRAGMENT_WRITES_STORAGE = 1 << 2,
+		FRAGMENT_USES_ATOMICS = 1 << 3,
+		FRAGMENT_ALPHA_TO_COVERAGE = 1 << 4
+	};
+
+	/// Called as command buffers drawing with this pipeline are submitted.
+	void addSubmittedDraws(uint32_t count);
+
 private:
 	VkPipeline pipeline = VK_NULL_HANDLE;
-	const PipelineLayout *layout = nullptr;
+	PipelineLayout *layout = nullptr;
 	union {
 		VkGraphicsPipelineCreateInfo graphics;
 		VkComputePipelineCreateInfo compute;
@@ -80,6 +101,18 @@ private:
 	VkPipelineColorBlendStateCreateInfo colorBlendState;
 	VkPipelineInputAssemblyStateCreateInfo inputAssemblyState;
 	std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachmentState;
+	bool orderIndependent = false;
+
+	// FragmentEffectBits which disable early depth/stencil testing and Forward Pixel Kill for this pipeline.
+	uint32_t earlyZSKillers = 0;
+	uint32_t forwardPixelKillKillers = 0;
+	uint64_t submittedDraws = 0;
+	uint64_t reportedDraws = 0;
+	void checkHiddenSurfaceRemoval(const VkGraphicsPipelineCreateInfo &createInfo);
+
+	// Static cost of each graphics stage, accounted for every submitted draw.
+	std::vector<ShaderCostTracker::Shader> shaders;
+	void estimateShaderCosts(const VkGraphicsPipelineCreateInfo &createInfo);
 
 	void checkInstancedVertexBuffer(const VkGraphicsPipelineCreateInfo &createInfo);
 	void checkMultisampledBlending(const VkGraphicsPipelineCreateInfo &createInfo);
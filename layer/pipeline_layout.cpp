@@ -20,6 +20,11 @@
 
 #include "pipeline_layout.hpp"
 #include "device.hpp"
+#include "message_codes.hpp"
+#include "shader_module.hpp"
+#include <algorithm>
+
+using namespace std;
 
 namespace MPD
 {
@@ -31,8 +36,138 @@ VkResult PipelineLayout::init(const VkPipelineLayoutCreateInfo *pCreateInfo)
 		auto *setLayout = baseDevice->get<DescriptorSetLayout>(pCreateInfo->pSetLayouts[i]);
 		MPD_ASSERT(setLayout);
 		descriptorSetLayouts.push_back(setLayout);
+
+		SetUsage usage;
+		if (setLayout)
+		{
+			usage.bindingTable = setLayout->getBindingTable();
+			usage.usedBindings.resize(usage.bindingTable->bindings.size());
+		}
+		setUsage.push_back(move(usage));
 	}
 
+	pushConstantRanges.assign(pCreateInfo->pPushConstantRanges,
+	                          pCreateInfo->pPushConstantRanges + pCreateInfo->pushConstantRangeCount);
+	pushConstantUsage.resize(pushConstantRanges.size());
+
 	return VK_SUCCESS;
 }
+
+void PipelineLayout::addPipelineUsage(uint32_t stageCount, const VkPipelineShaderStageCreateInfo *pStages)
+{
+	// Collected per pipeline first, so a stage which cannot be analyzed leaves the layout untouched.
+	vector<pair<uint32_t, uint32_t>> usedBindings;
+	vector<pair<VkShaderStageFlagBits, uint32_t>> pushConstantEnds;
+
+	for (uint32_t i = 0; i < stageCount; i++)
+	{
+		auto &stage = pStages[i];
+		auto &usage = baseDevice->get<ShaderModule>(stage.module)->getResourceUsage(stage.pName);
+		if (!usage.valid)
+			return;
+
+		usedBindings.insert(end(usedBindings), begin(usage.bindings), end(usage.bindings));
+		pushConstantEnds.push_back({ stage.stage, usage.pushConstantEnd });
+	}
+
+	for (auto &binding : usedBindings)
+	{
+		if (binding.first < setUsage.size() && binding.second < setUsage[binding.first].usedBindings.size())
+			setUsage[binding.first].usedBindings[binding.second] = true;
+	}
+
+	for (uint32_t i = 0; i < pushConstantRanges.size(); i++)
+	{
+		for (auto &stageEnd : pushConstantEnds)
+		{
+			if (pushConstantRanges[i].stageFlags & stageEnd.first)
+			{
+				pushConstantUsage[i].end = max(pushConstantUsage[i].end, stageEnd.second);
+				pushConstantUsage[i].covered = true;
+			}
+		}
+	}
+
+	pipelineCount++;
+}
+
+void PipelineLayout::reportUsage()
+{
+	// Nothing is known about layouts which no pipeline was created with.
+	if (pipelineCount == 0)
+		return;
+
+	// Unused bindings still take descriptor memory in every set allocated with the layout,
+	// and still have to be written before the set can be bound.
+	uint32_t usedSetCount = 0;
+	uint32_t totalUsedBindings = 0;
+	for (uint32_t set = 0; set < setUsage.size(); set++)
+	{
+		if (!setUsage[set].bindingTable)
+			continue;
+
+		auto &bindings = setUsage[set].bindingTable->bindings;
+		auto &usedBindings = setUsage[set].usedBindings;
+		uint32_t unusedBindings = 0;
+		uint32_t usedBindingCount = 0;
+		uint32_t wastedBytes = 0;
+		for (uint32_t binding = 0; binding < bindings.size(); binding++)
+		{
+			if (bindings[binding].arraySize == 0)
+				continue;
+
+			if (usedBindings[binding])
+			{
+				usedBindingCount++;
+				continue;
+			}
+
+			unusedBindings++;
+			wastedBytes += bindings[binding].arraySize *
+			               DescriptorSetLayout::estimatedDescriptorBytes(bindings[binding].descriptorType);
+		}
+
+		if (unusedBindings)
+		{
+			log(VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT, MESSAGE_CODE_PIPELINE_LAYOUT_UNUSED_BINDING,
+			    "Descriptor set layout %u of the pipeline layout has %u binding(s) which none of the %u pipeline(s) "
+			    "created with it statically uses, wasting an estimated %u bytes of descriptor memory per descriptor "
+			    "set. Consider removing them from the layout.",
+			    set, unusedBindings, pipelineCount, wastedBytes);
+		}
+
+		if (usedBindingCount)
+		{
+			usedSetCount++;
+			totalUsedBindings += usedBindingCount;
+		}
+	}
+
+	// Push constants are uploaded for every draw, bytes beyond what any stage reads are pure overhead.
+	for (uint32_t i = 0; i < pushConstantRanges.size(); i++)
+	{
+		auto &range = pushConstantRanges[i];
+		auto &usage = pushConstantUsage[i];
+		uint32_t rangeEnd = range.offset + range.size;
+		if (usage.covered && usage.end < rangeEnd)
+		{
+			uint32_t unread = rangeEnd - max(usage.end, range.offset);
+			log(VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT, MESSAGE_CODE_PIPELINE_LAYOUT_OVERSIZED_PUSH_CONSTANTS,
+			    "Push constant range (offset %u, size %u) is larger than any shader stage of the %u pipeline(s) "
+			    "created with the layout reads. %u bytes per vkCmdPushConstants are never read, consider "
+			    "shrinking the range.",
+			    range.offset, range.size, pipelineCount, unread);
+		}
+	}
+
+	// Binding a descriptor set has a fixed cost, a few bindings spread over several sets are cheaper in one.
+	if (usedSetCount > 1 && totalUsedBindings <= baseDevice->getConfig().pipelineLayoutMergeableSetBindings)
+	{
+		log(VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT, MESSAGE_CODE_PIPELINE_LAYOUT_MERGEABLE_SETS,
+		    "The pipelines created with the layout use only %u descriptor bindings spread over %u descriptor sets. "
+		    "If these are updated at the same frequency, merging them into a single set would save %u "
+		    "vkCmdBindDescriptorSets and descriptor table switches per draw.",
+		    totalUsedBindings, usedSetCount, usedSetCount - 1);
+	}
+}
 }
\ No newline at end of file
@@ -22,6 +22,7 @@
 #include "base_object.hpp"
 #include "descriptor_set_layout.hpp"
 
+#include <memory>
 #include <vector>
 
 namespace MPD
@@ -44,7 +45,38 @@ public:
 		return descriptorSetLayouts;
 	}
 
+	const std::vector<VkPushConstantRange> &getPushConstantRanges() const
+	{
+		return pushConstantRanges;
+	}
+
+	/// Accumulates the descriptor bindings and push constant bytes the stages of a pipeline created with this
+	/// layout statically use. Pipelines with a stage which cannot be analyzed are left out.
+	void addPipelineUsage(uint32_t stageCount, const VkPipelineShaderStageCreateInfo *pStages);
+
+	/// Reports bindings and push constant bytes which no pipeline created with this layout uses,
+	/// and sets which could be merged. Called before the layout, or the device it belongs to, is destroyed.
+	void reportUsage();
+
 private:
 	std::vector<DescriptorSetLayout *> descriptorSetLayouts;
+	std::vector<VkPushConstantRange> pushConstantRanges;
+
+	// The binding tables are kept alive, the set layouts may be destroyed before this layout.
+	struct SetUsage
+	{
+		std::shared_ptr<const DescriptorSetLayout::BindingTable> bindingTable;
+		std::vector<bool> usedBindings;
+	};
+	std::vector<SetUsage> setUsage;
+
+	// Furthest byte read by any stage in each push constant range, if any pipeline has a stage in its stageFlags.
+	struct PushConstantRangeUsage
+	{
+		uint32_t end;
+		bool covered;
+	};
+	std::vector<PushConstantRangeUsage> pushConstantUsage;
+	uint32_t pipelineCount = 0;
 };
 }
@@ -21,6 +21,7 @@
 #include "render_pass.hpp"
 #include "device.hpp"
 #include "format.hpp"
+#include "framebuffer.hpp"
 #include "message_codes.hpp"
 #include <algorithm>
 #include <iterator>
@@ -61,49 +62,132 @@ void RenderPass::checkMultisampling()
 	}
 }
 
-bool RenderPass::renderPassUsesAttachmentAsImageOnly(uint32_t attachment) const
+void RenderPass::computeAttachmentStates()
 {
-	if (renderPassUsesAttachmentOnTile(attachment))
-		return false;
+	attachmentStates.clear();
+	attachmentStates.resize(createInfo.attachmentCount);
+
+	auto markUsage = [this](const VkAttachmentReference &ref, AttachmentUsageFlags usage) {
+		if (ref.attachment != VK_ATTACHMENT_UNUSED)
+			attachmentStates[ref.attachment].usage |= usage;
+	};
 
 	for (uint32_t subpass = 0; subpass < createInfo.subpassCount; subpass++)
 	{
 		auto &subpassInfo = createInfo.pSubpasses[subpass];
 
+		for (uint32_t i = 0; i < subpassInfo.colorAttachmentCount; i++)
+			markUsage(subpassInfo.pColorAttachments[i], ATTACHMENT_USAGE_COLOR_BIT);
+
+		if (subpassInfo.pResolveAttachments)
+			for (uint32_t i = 0; i < subpassInfo.colorAttachmentCount; i++)
+				markUsage(subpassInfo.pResolveAttachments[i], ATTACHMENT_USAGE_RESOLVE_BIT);
+
+		if (subpassInfo.pDepthStencilAttachment)
+			markUsage(*subpassInfo.pDepthStencilAttachment, ATTACHMENT_USAGE_DEPTH_STENCIL_BIT);
+
 		for (uint32_t i = 0; i < subpassInfo.inputAttachmentCount; i++)
-			if (subpassInfo.pInputAttachments[i].attachment == attachment)
-				return true;
+			markUsage(subpassInfo.pInputAttachments[i], ATTACHMENT_USAGE_INPUT_BIT);
 	}
 
-	return false;
+	// Resolve what the load and store ops mean for the image.
+	// Don't care is treated as undefined.
+	for (uint32_t att = 0; att < createInfo.attachmentCount; att++)
+	{
+		auto &attachment = createInfo.pAttachments[att];
+		auto &state = attachmentStates[att];
+		bool hasDepthOrColor = !formatIsStencilOnly(attachment.format);
+		bool hasStencil = formatIsDepthStencil(attachment.format) || formatIsStencilOnly(attachment.format);
+
+		if (hasDepthOrColor && attachment.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD)
+			state.loadUsage = Image::Usage::RenderPassReadToTile;
+		if (hasStencil && attachment.stencilLoadOp == VK_ATTACHMENT_LOAD_OP_LOAD)
+			state.loadUsage = Image::Usage::RenderPassReadToTile;
+		if (hasDepthOrColor && attachment.loadOp == VK_ATTACHMENT_LOAD_OP_CLEAR)
+			state.loadUsage = Image::Usage::RenderPassCleared;
+		if (hasStencil && attachment.stencilLoadOp == VK_ATTACHMENT_LOAD_OP_CLEAR)
+			state.loadUsage = Image::Usage::RenderPassCleared;
+
+		// If the attachment is only used as an input attachment, it is basically a fancy way of reading as a texture.
+		// LOAD_OP_LOAD doesn't actually read-back to tile.
+		if (renderPassUsesAttachmentAsImageOnly(att))
+			state.loadUsage = Image::Usage::ResourceRead;
+
+		if (hasDepthOrColor && attachment.storeOp == VK_ATTACHMENT_STORE_OP_STORE)
+			state.storeUsage = Image::Usage::RenderPassStored;
+		if (hasStencil && attachment.stencilStoreOp == VK_ATTACHMENT_STORE_OP_STORE)
+			state.storeUsage = Image::Usage::RenderPassStored;
+	}
 }
 
-bool RenderPass::renderPassUsesAttachmentOnTile(uint32_t attachment) const
+void RenderPass::checkTileBufferBudget()
 {
+	uint32_t budget = baseDevice->getTileBufferBudget();
+
+	subpassTileUsage.clear();
+	subpassTileUsage.resize(createInfo.subpassCount);
+
 	for (uint32_t subpass = 0; subpass < createInfo.subpassCount; subpass++)
 	{
 		auto &subpassInfo = createInfo.pSubpasses[subpass];
+		auto &usage = subpassTileUsage[subpass];
 
-		// If an attachment is ever used as a color attachment,
-		// resolve attachment or depth stencil attachment,
-		// it needs to exist on tile at some point.
-
+		// Depth/stencil has dedicated storage and resolves happen on writeback, so only color counts against the budget.
 		for (uint32_t i = 0; i < subpassInfo.colorAttachmentCount; i++)
-			if (subpassInfo.pColorAttachments[i].attachment == attachment)
-				return true;
-
-		if (subpassInfo.pResolveAttachments)
 		{
-			for (uint32_t i = 0; i < subpassInfo.colorAttachmentCount; i++)
-				if (subpassInfo.pResolveAttachments[i].attachment == attachment)
-					return true;
+			uint32_t att = subpassInfo.pColorAttachments[i].attachment;
+			if (att == VK_ATTACHMENT_UNUSED)
+				continue;
+
+			auto &attachment = createInfo.pAttachments[att];
+			usage.colorBitsPerPixel += formatBitsPerPixel(attachment.format) * uint32_t(attachment.samples);
 		}
 
-		if (subpassInfo.pDepthStencilAttachment && subpassInfo.pDepthStencilAttachment->attachment == attachment)
-			return true;
+		// Tiles are halved until the color storage fits, alternating between height and width.
+		while (usage.colorBitsPerPixel > budget * usage.tileSizeDivisor)
+			usage.tileSizeDivisor *= 2;
+
+		if (usage.tileSizeDivisor > 1)
+		{
+			uint32_t tileWidth = 16, tileHeight = 16;
+			for (uint32_t divisor = usage.tileSizeDivisor; divisor > 1; divisor /= 2)
+			{
+				if (tileHeight >= tileWidth)
+					tileHeight = max(tileHeight / 2, 1u);
+				else
+					tileWidth = max(tileWidth / 2, 1u);
+			}
+
+			log(VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT, MESSAGE_CODE_TILE_BUFFER_BUDGET_EXCEEDED,
+			    "Subpass %u stores %u color bits per pixel (all color attachments times samples), but the tile buffer "
+			    "only fits %u bits per pixel at full tile size. "
+			    "The tile size is expected to shrink from 16x16 to %ux%u, reducing throughput. "
+			    "Consider using fewer or narrower color attachments, or fewer samples.",
+			    subpass, usage.colorBitsPerPixel, budget, tileWidth, tileHeight);
+		}
 	}
+}
 
-	return false;
+RenderPass::~RenderPass()
+{
+	for (auto *framebuffer : framebuffers)
+		framebuffer->invalidateRenderPass(this);
+}
+
+void RenderPass::addFramebuffer(Framebuffer *framebuffer)
+{
+	if (find(begin(framebuffers), end(framebuffers), framebuffer) == end(framebuffers))
+		framebuffers.push_back(framebuffer);
+}
+
+void RenderPass::removeFramebuffer(Framebuffer *framebuffer)
+{
+	auto itr = find(begin(framebuffers), end(framebuffers), framebuffer);
+	if (itr != end(framebuffers))
+	{
+		*itr = framebuffers.back();
+		framebuffers.pop_back();
+	}
 }
 
 VkResult RenderPass::init(VkRenderPass renderPass_, const VkRenderPassCreateInfo &createInfo_)
@@ -175,7 +259,9 @@ VkResult RenderPass::init(VkRenderPass renderPass_, const VkRenderPassCreateInfo
 	if (createInfo.subpassCount)
 		createInfo.pSubpasses = subpassDescriptions.data();
 
+	computeAttachmentStates();
 	checkMultisampling();
+	checkTileBufferBudget();
 
 	return VK_SUCCESS;
 }
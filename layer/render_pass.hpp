@@ -20,10 +20,13 @@
 
 #pragma once
 #include "base_object.hpp"
+#include "image.hpp"
 #include <vector>
 
 namespace MPD
 {
+class Framebuffer;
+
 class RenderPass : public BaseObject
 {
 public:
@@ -35,6 +38,8 @@ public:
 	{
 	}
 
+	~RenderPass();
+
 	VkResult init(VkRenderPass renderPass, const VkRenderPassCreateInfo &createInfo);
 
 	const VkRenderPassCreateInfo &getCreateInfo() const
@@ -42,14 +47,78 @@ public:
 		return createInfo;
 	}
 
-	bool renderPassUsesAttachmentOnTile(uint32_t attachment) const;
-	bool renderPassUsesAttachmentAsImageOnly(uint32_t attachment) const;
+	/// How an attachment is referenced by the subpasses of the render pass.
+	enum AttachmentUsageBits
+	{
+		ATTACHMENT_USAGE_COLOR_BIT = 1 << 0,
+		ATTACHMENT_USAGE_RESOLVE_BIT = 1 << 1,
+		ATTACHMENT_USAGE_DEPTH_STENCIL_BIT = 1 << 2,
+		ATTACHMENT_USAGE_INPUT_BIT = 1 << 3,
+
+		// Any of these means the attachment needs to exist on tile at some point.
+		ATTACHMENT_USAGE_ON_TILE_MASK =
+		    ATTACHMENT_USAGE_COLOR_BIT | ATTACHMENT_USAGE_RESOLVE_BIT | ATTACHMENT_USAGE_DEPTH_STENCIL_BIT
+	};
+	using AttachmentUsageFlags = uint32_t;
+
+	/// Per-attachment state which only depends on the create info, computed once in init().
+	struct AttachmentState
+	{
+		AttachmentUsageFlags usage = 0;
+		// What the image sees when the render pass begins and ends, if the attachment is used at all.
+		Image::Usage loadUsage = Image::Usage::Undefined;
+		Image::Usage storeUsage = Image::Usage::RenderPassDiscarded;
+	};
+
+	const AttachmentState &getAttachmentState(uint32_t attachment) const
+	{
+		return attachmentStates[attachment];
+	}
+
+	bool renderPassUsesAttachmentOnTile(uint32_t attachment) const
+	{
+		return (attachmentStates[attachment].usage & ATTACHMENT_USAGE_ON_TILE_MASK) != 0;
+	}
+
+	bool renderPassUsesAttachmentAsImageOnly(uint32_t attachment) const
+	{
+		return attachmentStates[attachment].usage == ATTACHMENT_USAGE_INPUT_BIT;
+	}
+
+	/// How much tile buffer storage a subpass needs, computed once in init().
+	struct SubpassTileUsage
+	{
+		// Sum of color attachment bits per pixel times sample count.
+		uint32_t colorBitsPerPixel = 0;
+		// The factor by which the GPU has to shrink its tiles to fit the color storage, 1 if it fits.
+		uint32_t tileSizeDivisor = 1;
+	};
+
+	const SubpassTileUsage &getSubpassTileUsage(uint32_t subpass) const
+	{
+		return subpassTileUsage[subpass];
+	}
+
+	/// Framebuffers which cache a pointer to this render pass, invalidated when the render pass is destroyed.
+	void addFramebuffer(Framebuffer *framebuffer);
+	void removeFramebuffer(Framebuffer *framebuffer);
+
+	/// Returns true if sorting the draws of an instance would save more state switches than previously reported,
+	/// so the same render pass recorded every frame is not reported over and over.
+	bool updateDrawOrderSavings(uint32_t savings)
+	{
+		if (savings <= maxReportedDrawOrderSavings)
+			return false;
+		maxReportedDrawOrderSavings = savings;
+		return true;
+	}
 
 private:
 	VkRenderPass renderPass = VK_NULL_HANDLE;
 	VkRenderPassCreateInfo createInfo;
 	std::vector<VkSubpassDependency> subpassDependencies;
 	std::vector<VkAttachmentDescription> attachments;
+	std::vector<Framebuffer *> framebuffers;
 
 	struct SubpassAttachments
 	{
@@ -61,7 +130,12 @@ private:
 	};
 	std::vector<SubpassAttachments> subpasses;
 	std::vector<VkSubpassDescription> subpassDescriptions;
+	std::vector<AttachmentState> attachmentStates;
+	std::vector<SubpassTileUsage> subpassTileUsage;
+	uint32_t maxReportedDrawOrderSavings = 0;
 
 	void checkMultisampling();
+	void computeAttachmentStates();
+	void checkTileBufferBudget();
 };
 }
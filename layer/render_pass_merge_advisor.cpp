@@ -0,0 +1,159 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "render_pass_merge_advisor.hpp"
+#include "format.hpp"
+#include "framebuffer.hpp"
+#include "image.hpp"
+#include "message_codes.hpp"
+#include "render_pass.hpp"
+#include <algorithm>
+#include <stdio.h>
+#include <string>
+
+using namespace std;
+
+namespace MPD
+{
+void RenderPassMergeAdvisor::beginRenderPass(VkRenderPass handle, RenderPass *renderPass,
+                                             const Framebuffer *framebuffer, const VkRect2D &renderArea)
+{
+	instances.push_back({ handle, renderPass, framebuffer, renderArea });
+	insideRenderPass = true;
+
+	swap(previousStored, currentStored);
+	currentStored.clear();
+
+	auto &createInfo = renderPass->getCreateInfo();
+	VkDeviceSize pixels = VkDeviceSize(renderArea.extent.width) * renderArea.extent.height *
+	                      max(framebuffer->getCreateInfo().layers, 1u);
+
+	for (uint32_t att = 0; att < createInfo.attachmentCount; att++)
+	{
+		auto *image = framebuffer->getAttachment(att).image;
+		if (!image || renderPass->getAttachmentState(att).storeUsage != Image::Usage::RenderPassStored)
+			continue;
+
+		auto &attachment = createInfo.pAttachments[att];
+		VkDeviceSize bytes =
+		    pixels * static_cast<uint32_t>(attachment.samples) * formatBitsPerPixel(attachment.format) / 8;
+		currentStored.push_back({ image, bytes });
+	}
+}
+
+void RenderPassMergeAdvisor::endRenderPass()
+{
+	insideRenderPass = false;
+}
+
+bool RenderPassMergeAdvisor::isSameResolution(const Instance &a, const Instance &b) const
+{
+	auto &fbA = a.framebuffer->getCreateInfo();
+	auto &fbB = b.framebuffer->getCreateInfo();
+	return fbA.width == fbB.width && fbA.height == fbB.height && fbA.layers == fbB.layers &&
+	       a.renderArea.offset.x == b.renderArea.offset.x && a.renderArea.offset.y == b.renderArea.offset.y &&
+	       a.renderArea.extent.width == b.renderArea.extent.width &&
+	       a.renderArea.extent.height == b.renderArea.extent.height;
+}
+
+void RenderPassMergeAdvisor::sampleImage(const Image *image)
+{
+	if (!insideRenderPass || instances.size() < 2)
+		return;
+
+	uint32_t current = uint32_t(instances.size() - 1);
+
+	// The same image may well be sampled through many descriptors.
+	for (auto itr = links.rbegin(); itr != links.rend() && itr->instance == current; ++itr)
+		if (itr->image == image)
+			return;
+
+	auto stored = find_if(begin(previousStored), end(previousStored),
+	                      [image](const StoredAttachment &attachment) { return attachment.image == image; });
+	if (stored == end(previousStored))
+		return;
+
+	if (!isSameResolution(instances[current - 1], instances[current]))
+		return;
+
+	links.push_back({ current, image, stored->bytes });
+}
+
+static double toMiB(double bytes)
+{
+	return bytes / (1024.0 * 1024.0);
+}
+
+void RenderPassMergeAdvisor::reportChain(uint32_t firstInstance, uint32_t lastInstance, size_t firstLink,
+                                         size_t lastLink)
+{
+	// FNV-1a over the render pass handles, so the same chain seen every frame is only reported once.
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (uint32_t i = firstInstance; i <= lastInstance; i++)
+		hash = (hash ^ (uint64_t)instances[i].handle) * 0x100000001b3ull;
+
+	if (!reportedChains.insert(hash).second)
+		return;
+
+	VkDeviceSize savedBytes = 0;
+	for (size_t i = firstLink; i < lastLink; i++)
+		savedBytes += links[i].bytes;
+
+	string chain;
+	char handle[32];
+	for (uint32_t i = firstInstance; i <= lastInstance; i++)
+	{
+		snprintf(handle, sizeof(handle), "%s0x%llx", i == firstInstance ? "" : " -> ",
+		         static_cast<unsigned long long>((uint64_t)instances[i].handle));
+		chain += handle;
+	}
+
+	instances[firstInstance].renderPass->log(
+	    VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT, MESSAGE_CODE_RENDER_PASS_MERGE_CANDIDATE,
+	    "The render passes %s run back to back in the same submission, and each one samples attachments stored by the "
+	    "previous one at the same resolution (%u in total). "
+	    "If the sampling only reads the pixel being shaded, these can be merged into one render pass with a subpass "
+	    "each, reading the data as input attachments. This keeps it on tile and saves up to %.2f MiB of reads, plus "
+	    "%.2f MiB of writes if the stored data is not needed afterwards, per submission.",
+	    chain.c_str(), unsigned(lastLink - firstLink), toMiB(double(savedBytes)), toMiB(double(savedBytes)));
+}
+
+void RenderPassMergeAdvisor::endSubmit()
+{
+	// Links are ordered by instance, a chain is a run of instances where each one links back to the previous one.
+	size_t i = 0;
+	while (i < links.size())
+	{
+		uint32_t last = links[i].instance;
+		size_t end = i;
+		while (end < links.size() && links[end].instance <= last + 1)
+			last = links[end++].instance;
+
+		reportChain(links[i].instance - 1, last, i, end);
+		i = end;
+	}
+
+	instances.clear();
+	previousStored.clear();
+	currentStored.clear();
+	links.clear();
+	insideRenderPass = false;
+}
+}
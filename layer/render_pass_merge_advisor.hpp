@@ -0,0 +1,86 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#include "perfdoc.hpp"
+#include <unordered_set>
+#include <vector>
+
+namespace MPD
+{
+class Device;
+class Image;
+class RenderPass;
+class Framebuffer;
+
+/// Follows the render pass instances of a submission in execution order and finds chains of consecutive
+/// render passes where each one samples attachments stored by the previous one at the same resolution.
+/// Such chains could be merged into subpasses of a single render pass, reading the data as input attachments,
+/// which keeps it on tile instead of going through external memory.
+/// Fed from deferred functions as command buffers are submitted.
+class RenderPassMergeAdvisor
+{
+public:
+	void beginRenderPass(VkRenderPass handle, RenderPass *renderPass, const Framebuffer *framebuffer,
+	                     const VkRect2D &renderArea);
+	void endRenderPass();
+
+	/// An image was sampled through a descriptor set by the current render pass, if any.
+	void sampleImage(const Image *image);
+
+	/// Reports any mergeable chains found in the submission, and starts a new one.
+	void endSubmit();
+
+private:
+	struct Instance
+	{
+		VkRenderPass handle;
+		RenderPass *renderPass;
+		const Framebuffer *framebuffer;
+		VkRect2D renderArea;
+	};
+
+	struct StoredAttachment
+	{
+		const Image *image;
+		VkDeviceSize bytes;
+	};
+
+	// A render pass instance sampling an attachment stored by the instance just before it.
+	struct Link
+	{
+		uint32_t instance;
+		const Image *image;
+		VkDeviceSize bytes;
+	};
+
+	std::vector<Instance> instances;
+	std::vector<StoredAttachment> previousStored;
+	std::vector<StoredAttachment> currentStored;
+	std::vector<Link> links;
+	bool insideRenderPass = false;
+
+	// Chains are reported once, identified by a hash of their render pass handles.
+	std::unordered_set<uint64_t> reportedChains;
+
+	bool isSameResolution(const Instance &a, const Instance &b) const;
+	void reportChain(uint32_t firstInstance, uint32_t lastInstance, size_t firstLink, size_t lastLink);
+};
+}
@@ -0,0 +1,168 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "shader_cost_tracker.hpp"
+#include "device.hpp"
+#include "message_codes.hpp"
+#include <algorithm>
+#include <stdio.h>
+#include <vector>
+
+using namespace std;
+
+namespace MPD
+{
+ShaderCostTracker::ShaderCostTracker(Device &device)
+    : device(device)
+{
+}
+
+uint64_t ShaderCostTracker::hashShader(VkShaderModule module, VkShaderStageFlagBits stage, const char *entryPoint)
+{
+	// FNV-1a
+	uint64_t hash = 0xcbf29ce484222325ull;
+	hash = (hash ^ (uint64_t)module) * 0x100000001b3ull;
+	hash = (hash ^ uint64_t(stage)) * 0x100000001b3ull;
+	for (const char *c = entryPoint; *c; c++)
+		hash = (hash ^ uint64_t(uint8_t(*c))) * 0x100000001b3ull;
+	return hash;
+}
+
+void ShaderCostTracker::addDraws(const Shader &shader, uint32_t draws)
+{
+	auto it = shaders.find(shader.key);
+	if (it == end(shaders))
+		it = shaders.insert(make_pair(shader.key, ShaderTotals{ shader, 0 })).first;
+	it->second.draws += draws;
+}
+
+void ShaderCostTracker::endFrame()
+{
+	frameCount++;
+
+	uint64_t interval = device.getConfig().shaderCostReportFrameInterval;
+	if (interval != 0 && frameCount >= interval)
+		report(frameCount);
+}
+
+void ShaderCostTracker::flush()
+{
+	if (!shaders.empty())
+		report(max<uint64_t>(frameCount, 1));
+}
+
+static const char *stageName(VkShaderStageFlagBits stage)
+{
+	switch (stage)
+	{
+	case VK_SHADER_STAGE_VERTEX_BIT:
+		return "vertex";
+	case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT:
+		return "tessellation control";
+	case VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT:
+		return "tessellation evaluation";
+	case VK_SHADER_STAGE_GEOMETRY_BIT:
+		return "geometry";
+	case VK_SHADER_STAGE_FRAGMENT_BIT:
+		return "fragment";
+	default:
+		return "compute";
+	}
+}
+
+void ShaderCostTracker::report(uint64_t frames)
+{
+	// A draw runs the vertex shader once per vertex and the fragment shader once per fragment, so draws only weigh
+	// shaders against each other within a stage. Each stage is ranked on its own.
+	vector<const ShaderTotals *> ranked;
+	ranked.reserve(shaders.size());
+	for (auto &shader : shaders)
+		ranked.push_back(&shader.second);
+
+	auto frameCost = [](const ShaderTotals *totals) {
+		return totals->shader.cost.getCycles() * double(totals->draws);
+	};
+
+	// Fragment shaders first, they usually dominate.
+	sort(begin(ranked), end(ranked), [&](const ShaderTotals *a, const ShaderTotals *b) {
+		bool aFragment = a->shader.stage == VK_SHADER_STAGE_FRAGMENT_BIT;
+		bool bFragment = b->shader.stage == VK_SHADER_STAGE_FRAGMENT_BIT;
+		if (aFragment != bFragment)
+			return aFragment;
+		if (a->shader.stage != b->shader.stage)
+			return a->shader.stage < b->shader.stage;
+		return frameCost(a) > frameCost(b);
+	});
+
+	double perFrame = 1.0 / double(frames);
+	char line[256];
+
+	snprintf(line, sizeof(line),
+	         "Estimated shader cost over frames %llu to %llu, ranked per stage by static cycles per invocation times "
+	         "draws per frame. Every reachable instruction counts once, loops and branches are not modelled.",
+	         static_cast<unsigned long long>(firstFrame), static_cast<unsigned long long>(firstFrame + frames - 1));
+	string message = line;
+
+	auto stageBegin = begin(ranked);
+	while (stageBegin != end(ranked))
+	{
+		auto stage = (*stageBegin)->shader.stage;
+		auto stageEnd = find_if(stageBegin, end(ranked),
+		                        [stage](const ShaderTotals *totals) { return totals->shader.stage != stage; });
+
+		double total = 0.0;
+		for (auto itr = stageBegin; itr != stageEnd; ++itr)
+			total += frameCost(*itr);
+
+		snprintf(line, sizeof(line), "\n Top %s shaders:", stageName(stage));
+		message += line;
+
+		size_t count = min<size_t>(stageEnd - stageBegin, device.getConfig().shaderCostReportTopShaders);
+		for (size_t i = 0; i < count; i++)
+		{
+			auto &totals = *stageBegin[i];
+			auto &cost = totals.shader.cost;
+			double share = total > 0.0 ? 100.0 * frameCost(&totals) / total : 0.0;
+
+			snprintf(line, sizeof(line),
+			         "\n  #%u %s shader \"%.32s\" in VkShaderModule 0x%llx: %.1f draws per frame, %.1f cycles, "
+			         "%s bound (%.1f%% of the stage).",
+			         unsigned(i + 1), stageName(totals.shader.stage), totals.shader.entryPoint.c_str(),
+			         static_cast<unsigned long long>((uint64_t)totals.shader.module), totals.draws * perFrame,
+			         cost.getCycles(), ShaderCost::getPipeName(cost.getBoundPipe()), share);
+			message += line;
+
+			snprintf(line, sizeof(line),
+			         " Arithmetic %.1f, load/store %.1f, varying %.1f and texture %.1f cycles, %u branches.",
+			         cost.cycles[ShaderCost::PIPE_ARITHMETIC], cost.cycles[ShaderCost::PIPE_LOAD_STORE],
+			         cost.cycles[ShaderCost::PIPE_VARYING], cost.cycles[ShaderCost::PIPE_TEXTURE], cost.branches);
+			message += line;
+		}
+
+		stageBegin = stageEnd;
+	}
+
+	device.log(VK_DEBUG_REPORT_INFORMATION_BIT_EXT, MESSAGE_CODE_SHADER_COST_REPORT, "%s", message.c_str());
+
+	shaders.clear();
+	firstFrame += frames;
+	frameCount = 0;
+}
+}
@@ -0,0 +1,74 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#include "perfdoc.hpp"
+#include "spirv_analysis.hpp"
+#include <string>
+#include <unordered_map>
+
+namespace MPD
+{
+class Device;
+
+/// Combines the static cost of each shader with how many draws use it,
+/// and periodically reports the shaders of each stage which are likely to cost the most per frame.
+/// Draws are only accounted for once the command buffer is submitted.
+class ShaderCostTracker
+{
+public:
+	explicit ShaderCostTracker(Device &device);
+
+	struct Shader
+	{
+		// Identifies the module, stage and entry point.
+		uint64_t key;
+		VkShaderModule module;
+		VkShaderStageFlagBits stage;
+		std::string entryPoint;
+		ShaderCost cost;
+	};
+
+	static uint64_t hashShader(VkShaderModule module, VkShaderStageFlagBits stage, const char *entryPoint);
+
+	void addDraws(const Shader &shader, uint32_t draws);
+
+	/// Called on present, reports every shaderCostReportFrameInterval frames if enabled.
+	void endFrame();
+
+	/// Reports everything accumulated since the last report, called when the device is destroyed.
+	void flush();
+
+private:
+	Device &device;
+
+	struct ShaderTotals
+	{
+		Shader shader;
+		uint64_t draws;
+	};
+
+	std::unordered_map<uint64_t, ShaderTotals> shaders;
+	uint64_t firstFrame = 0;
+	uint64_t frameCount = 0;
+
+	void report(uint64_t frames);
+};
+}
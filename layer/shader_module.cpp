@@ -19,7 +19,13 @@
  */
 
 #include "shader_module.hpp"
+#include "device.hpp"
+#include "message_codes.hpp"
+#include "pipeline.hpp"
+#include "spirv_cross.hpp"
+#include <algorithm>
 
+using namespace spirv_cross;
 using namespace std;
 
 namespace MPD
@@ -33,4 +39,144 @@ VkResult ShaderModule::init(VkShaderModule shaderModule_, const VkShaderModuleCr
 	// We don't yet know the entry point nor the pipeline stage, so we cannot do any analysis yet, defer till pipeline creation.
 	return VK_SUCCESS;
 }
+
+void ShaderModule::checkFragmentPrecision(const char *entryPoint)
+{
+	for (auto &entry : fragmentPrecision)
+		if (entry.entryPoint == entryPoint)
+			return;
+
+	SpirvModule module;
+	if (!module.init(spirv, entryPoint, VK_SHADER_STAGE_FRAGMENT_BIT))
+		return;
+
+	auto stats = analyzeFloatPrecision(module);
+	fragmentPrecision.push_back({ entryPoint, stats });
+
+	// Only whole-shader fp32 use is reported, a shader which already uses mediump somewhere made a choice.
+	if (stats.fp32Ops < stats.floatOps || stats.fp32Ops < baseDevice->getConfig().fullPrecisionFragmentOpThreshold)
+		return;
+
+	log(VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT, MESSAGE_CODE_FULL_PRECISION_FRAGMENT_SHADER,
+	    "Fragment shader entry point \"%s\" does all of its %u floating-point operations in 32-bit precision, "
+	    "and %u of its %u float varyings are 32-bit. Mali GPUs run 16-bit arithmetic at twice the rate and "
+	    "16-bit values need half the registers and varying bandwidth. Consider mediump (RelaxedPrecision) or "
+	    "16-bit types wherever the precision allows.",
+	    entryPoint, stats.fp32Ops, stats.fp32Varyings, stats.varyings);
+}
+
+const ShaderModule::ResourceUsage &ShaderModule::getResourceUsage(const char *entryPoint)
+{
+	for (auto &entry : resourceUsage)
+		if (entry.entryPoint == entryPoint)
+			return entry.usage;
+
+	ResourceUsage usage = {};
+	try
+	{
+		Compiler comp(spirv);
+		comp.set_entry_point(entryPoint);
+
+		auto activeVariables = comp.get_active_interface_variables();
+		auto resources = comp.get_shader_resources(activeVariables);
+
+		auto addBindings = [&](const vector<Resource> &list) {
+			for (auto &resource : list)
+			{
+				usage.bindings.push_back({ comp.get_decoration(resource.id, spv::DecorationDescriptorSet),
+				                           comp.get_decoration(resource.id, spv::DecorationBinding) });
+			}
+		};
+
+		addBindings(resources.uniform_buffers);
+		addBindings(resources.storage_buffers);
+		addBindings(resources.sampled_images);
+		addBindings(resources.separate_images);
+		addBindings(resources.separate_samplers);
+		addBindings(resources.storage_images);
+		addBindings(resources.subpass_inputs);
+		addBindings(resources.atomic_counters);
+
+		for (auto &block : resources.push_constant_buffers)
+			for (auto &range : comp.get_active_buffer_ranges(block.id))
+				usage.pushConstantEnd = max(usage.pushConstantEnd, uint32_t(range.offset + range.range));
+		usage.valid = true;
+	}
+	catch (const CompilerError &error)
+	{
+		log(VK_DEBUG_REPORT_WARNING_BIT_EXT, 0,
+		    "SPIRV-Cross failed to analyze shader: %s. No pipeline layout checks will be performed for it.",
+		    error.what());
+	}
+
+	resourceUsage.push_back({ entryPoint, move(usage) });
+	return resourceUsage.back().usage;
+}
+
+const ShaderModule::FragmentEffects &ShaderModule::getFragmentEffects(const char *entryPoint)
+{
+	for (auto &entry : fragmentEffects)
+		if (entry.entryPoint == entryPoint)
+			return entry.effects;
+
+	FragmentEffects fragment = {};
+	SpirvModule module;
+	if (module.init(spirv, entryPoint, VK_SHADER_STAGE_FRAGMENT_BIT))
+	{
+		fragment.valid = true;
+
+		// Vulkan requires DepthReplacing whenever the shader writes FragDepth.
+		if (module.hasExecutionMode(spv::ExecutionModeDepthReplacing))
+			fragment.effects |= Pipeline::FRAGMENT_WRITES_DEPTH;
+		fragment.earlyFragmentTests = module.hasExecutionMode(spv::ExecutionModeEarlyFragmentTests);
+
+		// Not in every spirv.hpp yet.
+		static const uint32_t OpTerminateInvocation = 4416;
+		static const uint32_t OpDemoteToHelperInvocationEXT = 5380;
+
+		module.forEachReachableInstruction([&](const SpirvModule::Instruction &instruction) {
+			uint32_t op = instruction.op;
+			if (op == spv::OpKill || op == OpTerminateInvocation || op == OpDemoteToHelperInvocationEXT)
+				fragment.effects |= Pipeline::FRAGMENT_DISCARDS;
+			else if (op == spv::OpImageWrite)
+				fragment.effects |= Pipeline::FRAGMENT_WRITES_STORAGE;
+			else if (op >= spv::OpAtomicLoad && op <= spv::OpAtomicXor)
+				fragment.effects |= Pipeline::FRAGMENT_USES_ATOMICS;
+			else if ((op == spv::OpStore || op == spv::OpCopyMemory) && instruction.count >= 1)
+			{
+				// Uniform buffers are read-only, so stores through Uniform pointers go to BufferBlock storage buffers.
+				auto storage = module.getStorageClass(instruction.ops[0]);
+				if (storage == spv::StorageClassUniform || storage == spv::StorageClassStorageBuffer)
+					fragment.effects |= Pipeline::FRAGMENT_WRITES_STORAGE;
+			}
+		});
+	}
+
+	fragmentEffects.push_back({ entryPoint, fragment });
+	return fragmentEffects.back().effects;
+}
+
+bool ShaderModule::getShaderCost(const char *entryPoint, VkShaderStageFlagBits stage, ShaderCost &cost)
+{
+	for (auto &entry : shaderCosts)
+	{
+		if (entry.stage == stage && entry.entryPoint == entryPoint)
+		{
+			cost = entry.cost;
+			return entry.valid;
+		}
+	}
+
+	EntryPointCost entry = { entryPoint, stage, false, ShaderCost() };
+	SpirvModule module;
+	if (module.init(spirv, entryPoint, stage))
+	{
+		entry.cost = estimateShaderCost(module, stage);
+		entry.valid = true;
+	}
+
+	shaderCosts.push_back(entry);
+	cost = entry.cost;
+	return entry.valid;
+}
 }
@@ -22,6 +22,9 @@
 #include "base_object.hpp"
 #include "dispatch_helper.hpp"
 #include "perfdoc.hpp"
+#include "spirv_analysis.hpp"
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace MPD
@@ -49,8 +52,74 @@ public:
 		return shaderModule;
 	}
 
+	/// Reports fragment entry points which do all of their floating-point math in 32-bit precision.
+	/// Each entry point is analyzed and reported once, pipelines reusing it only look up the cached result.
+	void checkFragmentPrecision(const char *entryPoint);
+
+	/// Descriptor bindings and push constant bytes an entry point statically uses.
+	struct ResourceUsage
+	{
+		// False if SPIRV-Cross could not analyze the entry point.
+		bool valid;
+		// Set and binding numbers.
+		std::vector<std::pair<uint32_t, uint32_t>> bindings;
+		// One past the furthest push constant byte read.
+		uint32_t pushConstantEnd;
+	};
+
+	/// Reflected once per entry point, pipelines reusing it only look up the cached result.
+	/// The reference is invalidated by the next call for another entry point.
+	const ResourceUsage &getResourceUsage(const char *entryPoint);
+
+	/// Fragment work of an entry point which keeps hidden surface removal from culling its fragments.
+	struct FragmentEffects
+	{
+		// False if the entry point could not be parsed.
+		bool valid;
+		// Pipeline::FragmentEffectBits, except FRAGMENT_ALPHA_TO_COVERAGE which is pipeline state.
+		uint32_t effects;
+		bool earlyFragmentTests;
+	};
+
+	/// Analyzed once per fragment entry point, the reference is invalidated by the next call for another one.
+	const FragmentEffects &getFragmentEffects(const char *entryPoint);
+
+	/// Static cost of an entry point in a stage, estimated once and then looked up.
+	/// Returns false if the entry point could not be parsed.
+	bool getShaderCost(const char *entryPoint, VkShaderStageFlagBits stage, ShaderCost &cost);
+
 private:
 	VkShaderModule shaderModule;
 	std::vector<uint32_t> spirv;
+
+	struct EntryPointPrecision
+	{
+		std::string entryPoint;
+		FloatPrecisionStats stats;
+	};
+	std::vector<EntryPointPrecision> fragmentPrecision;
+
+	struct EntryPointResources
+	{
+		std::string entryPoint;
+		ResourceUsage usage;
+	};
+	std::vector<EntryPointResources> resourceUsage;
+
+	struct EntryPointEffects
+	{
+		std::string entryPoint;
+		FragmentEffects effects;
+	};
+	std::vector<EntryPointEffects> fragmentEffects;
+
+	struct EntryPointCost
+	{
+		std::string entryPoint;
+		VkShaderStageFlagBits stage;
+		bool valid;
+		ShaderCost cost;
+	};
+	std::vector<EntryPointCost> shaderCosts;
 };
 }
@@ -0,0 +1,403 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "spirv_analysis.hpp"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+using namespace std;
+
+namespace MPD
+{
+
+static spv::ExecutionModel executionModelForStage(VkShaderStageFlagBits stage)
+{
+	switch (stage)
+	{
+	case VK_SHADER_STAGE_VERTEX_BIT:
+		return spv::ExecutionModelVertex;
+	case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT:
+		return spv::ExecutionModelTessellationControl;
+	case VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT:
+		return spv::ExecutionModelTessellationEvaluation;
+	case VK_SHADER_STAGE_GEOMETRY_BIT:
+		return spv::ExecutionModelGeometry;
+	case VK_SHADER_STAGE_FRAGMENT_BIT:
+		return spv::ExecutionModelFragment;
+	default:
+		return spv::ExecutionModelGLCompute;
+	}
+}
+
+bool SpirvModule::init(const vector<uint32_t> &spirv, const char *entryPoint, VkShaderStageFlagBits stage)
+{
+	static const uint32_t headerWords = 5;
+	if (spirv.size() < headerWords || spirv[0] != spv::MagicNumber)
+		return false;
+
+	code = spirv.data();
+	const uint32_t size = uint32_t(spirv.size());
+	const spv::ExecutionModel model = executionModelForStage(stage);
+
+	unordered_map<uint32_t, WordRange> functions;
+	uint32_t currentFunction = 0;
+
+	uint32_t offset = headerWords;
+	while (offset < size)
+	{
+		uint32_t wordCount = code[offset] >> 16;
+		if (wordCount == 0 || offset + wordCount > size)
+			return false;
+
+		auto op = static_cast<spv::Op>(code[offset] & 0xffff);
+		const uint32_t *ops = &code[offset + 1];
+		uint32_t count = wordCount - 1;
+
+		switch (op)
+		{
+		case spv::OpEntryPoint:
+			// The name is a nul-terminated literal string packed into the words before the interface ids.
+			if (count >= 3 && spv::ExecutionModel(ops[0]) == model &&
+			    strncmp(reinterpret_cast<const char *>(&ops[2]), entryPoint, (count - 2) * sizeof(uint32_t)) == 0)
+			{
+				entryPointId = ops[1];
+				uint32_t nameWords = uint32_t(strlen(entryPoint) / sizeof(uint32_t)) + 1;
+				if (2 + nameWords < count)
+					interfaceIds.assign(&ops[2 + nameWords], &ops[count]);
+			}
+			break;
+
+		case spv::OpExecutionMode:
+			if (count >= 2 && entryPointId && ops[0] == entryPointId)
+				executionModes.push_back(spv::ExecutionMode(ops[1]));
+			break;
+
+		case spv::OpDecorate:
+			if (count >= 2 && spv::Decoration(ops[1]) == spv::DecorationRelaxedPrecision)
+				relaxedPrecisionIds.insert(ops[0]);
+			else if (count >= 2 && spv::Decoration(ops[1]) == spv::DecorationBuiltIn)
+				builtInIds.insert(ops[0]);
+			break;
+
+		case spv::OpTypeFloat:
+			if (count >= 2)
+				floatWidths[ops[0]] = ops[1];
+			break;
+
+		case spv::OpTypeVector:
+		case spv::OpTypeMatrix:
+			// Matrices count the components of all their columns.
+			if (count >= 3)
+			{
+				componentCounts[ops[0]] = getComponentCount(ops[1]) * ops[2];
+				if (uint32_t width = getFloatWidth(ops[1]))
+					floatWidths[ops[0]] = width;
+			}
+			break;
+
+		case spv::OpTypePointer:
+			if (count >= 3)
+			{
+				pointerTypes[ops[0]] = spv::StorageClass(ops[1]);
+				pointeeTypes[ops[0]] = ops[2];
+			}
+			break;
+
+		case spv::OpVariable:
+		case spv::OpFunctionParameter:
+		case spv::OpAccessChain:
+		case spv::OpInBoundsAccessChain:
+		case spv::OpPtrAccessChain:
+		case spv::OpCopyObject:
+			if (count >= 2)
+				pointerValueTypes[ops[1]] = ops[0];
+			break;
+
+		case spv::OpFunction:
+			if (count >= 2)
+			{
+				currentFunction = ops[1];
+				functions[currentFunction] = { offset, offset };
+			}
+			break;
+
+		case spv::OpFunctionEnd:
+			if (currentFunction)
+				functions[currentFunction].end = offset + wordCount;
+			currentFunction = 0;
+			break;
+
+		default:
+			break;
+		}
+
+		offset += wordCount;
+	}
+
+	if (!entryPointId || !functions.count(entryPointId))
+		return false;
+
+	// Follow OpFunctionCall from the entry point, each function is visited once.
+	vector<uint32_t> pending = { entryPointId };
+	vector<uint32_t> visited = { entryPointId };
+	while (!pending.empty())
+	{
+		auto function = functions[pending.back()];
+		pending.pop_back();
+		reachableFunctions.push_back(function);
+
+		for (uint32_t word = function.begin; word < function.end; word += code[word] >> 16)
+		{
+			if (static_cast<spv::Op>(code[word] & 0xffff) != spv::OpFunctionCall || (code[word] >> 16) < 4)
+				continue;
+
+			uint32_t callee = code[word + 3];
+			if (functions.count(callee) && find(begin(visited), end(visited), callee) == end(visited))
+			{
+				visited.push_back(callee);
+				pending.push_back(callee);
+			}
+		}
+	}
+
+	return true;
+}
+
+bool SpirvModule::hasExecutionMode(spv::ExecutionMode mode) const
+{
+	return find(begin(executionModes), end(executionModes), mode) != end(executionModes);
+}
+
+spv::StorageClass SpirvModule::getStorageClass(uint32_t pointerId) const
+{
+	auto value = pointerValueTypes.find(pointerId);
+	if (value == end(pointerValueTypes))
+		return spv::StorageClassMax;
+
+	auto type = pointerTypes.find(value->second);
+	return type != end(pointerTypes) ? type->second : spv::StorageClassMax;
+}
+
+uint32_t SpirvModule::getComponentCount(uint32_t typeId) const
+{
+	auto type = componentCounts.find(typeId);
+	return type != end(componentCounts) ? type->second : 1;
+}
+
+uint32_t SpirvModule::getFloatWidth(uint32_t typeId) const
+{
+	auto type = floatWidths.find(typeId);
+	return type != end(floatWidths) ? type->second : 0;
+}
+
+uint32_t SpirvModule::getPointeeType(uint32_t pointerId) const
+{
+	auto value = pointerValueTypes.find(pointerId);
+	if (value == end(pointerValueTypes))
+		return 0;
+
+	auto type = pointeeTypes.find(value->second);
+	return type != end(pointeeTypes) ? type->second : 0;
+}
+
+bool SpirvModule::isRelaxedPrecision(uint32_t id) const
+{
+	return relaxedPrecisionIds.count(id) != 0;
+}
+
+bool SpirvModule::isBuiltIn(uint32_t id) const
+{
+	return builtInIds.count(id) != 0;
+}
+
+ShaderCost::Pipe ShaderCost::getBoundPipe() const
+{
+	return Pipe(max_element(begin(cycles), end(cycles)) - begin(cycles));
+}
+
+const char *ShaderCost::getPipeName(Pipe pipe)
+{
+	switch (pipe)
+	{
+	case PIPE_ARITHMETIC:
+		return "arithmetic";
+	case PIPE_LOAD_STORE:
+		return "load/store";
+	case PIPE_VARYING:
+		return "varying";
+	default:
+		return "texture";
+	}
+}
+
+// GLSL.std.450 instructions from Sin to MatrixInverse run on the special function unit.
+static bool isTranscendental(uint32_t extInstruction)
+{
+	return extInstruction >= 13 && extInstruction <= 34;
+}
+
+// Conversions, arithmetic, relational, bit and derivative instructions.
+static bool isArithmetic(uint32_t op)
+{
+	return (op >= spv::OpConvertFToU && op <= spv::OpBitcast) || (op >= spv::OpSNegate && op <= spv::OpFwidthCoarse);
+}
+
+// Instructions which start with a result type and a result id, and whose operands matter for the cost.
+static bool producesValue(uint32_t op)
+{
+	return isArithmetic(op) || op == spv::OpLoad || op == spv::OpExtInst || op == spv::OpFunctionParameter ||
+	       op == spv::OpFunctionCall || op == spv::OpPhi || op == spv::OpCopyObject ||
+	       (op >= spv::OpVectorExtractDynamic && op <= spv::OpCompositeInsert);
+}
+
+ShaderCost estimateShaderCost(const SpirvModule &module, VkShaderStageFlagBits stage)
+{
+	// Relative issue costs for a Bifrost style core: arithmetic is scalar per thread, so each component costs
+	// a cycle and special functions cost four. The load/store pipe takes a cycle per access, the varying unit
+	// interpolates four 32-bit components per cycle and the texture unit filters one bilinear sample per cycle.
+	static const float transcendentalCycles = 4.0f;
+	static const float componentsPerVaryingCycle = 4.0f;
+
+	ShaderCost cost;
+	auto addCycles = [&](ShaderCost::Pipe pipe, float cycles) {
+		cost.instructions[pipe]++;
+		cost.cycles[pipe] += cycles;
+	};
+
+	// Result types of the values seen so far, for instructions whose cost depends on their operands.
+	unordered_map<uint32_t, uint32_t> valueTypes;
+	auto operandComponents = [&](uint32_t id) -> uint32_t {
+		auto value = valueTypes.find(id);
+		return value != end(valueTypes) ? module.getComponentCount(value->second) : 4;
+	};
+
+	module.forEachReachableInstruction([&](const SpirvModule::Instruction &instruction) {
+		uint32_t op = instruction.op;
+		const uint32_t *ops = instruction.ops;
+		if (producesValue(op) && instruction.count >= 2)
+			valueTypes[ops[1]] = ops[0];
+
+		if ((op == spv::OpLoad && instruction.count >= 3) ||
+		    ((op == spv::OpStore || op == spv::OpCopyMemory) && instruction.count >= 2))
+		{
+			uint32_t pointer = op == spv::OpLoad ? ops[2] : ops[0];
+			switch (module.getStorageClass(pointer))
+			{
+			case spv::StorageClassInput:
+				// Fragment inputs are interpolated, vertex inputs are attribute fetches.
+				if (stage == VK_SHADER_STAGE_FRAGMENT_BIT)
+					addCycles(ShaderCost::PIPE_VARYING, module.getComponentCount(ops[0]) / componentsPerVaryingCycle);
+				else
+					addCycles(ShaderCost::PIPE_LOAD_STORE, 1.0f);
+				break;
+
+			case spv::StorageClassOutput:
+				// Vertex outputs are written to memory, fragment outputs go to the tile buffer.
+				if (stage != VK_SHADER_STAGE_FRAGMENT_BIT)
+					addCycles(ShaderCost::PIPE_LOAD_STORE, 1.0f);
+				break;
+
+			case spv::StorageClassUniform:
+			case spv::StorageClassStorageBuffer:
+			case spv::StorageClassWorkgroup:
+				addCycles(ShaderCost::PIPE_LOAD_STORE, 1.0f);
+				break;
+
+			default:
+				// Function and private variables live in registers, push constants in uniform registers.
+				break;
+			}
+		}
+		else if (op == spv::OpImageRead || op == spv::OpImageWrite ||
+		         (op >= spv::OpAtomicLoad && op <= spv::OpAtomicXor))
+			addCycles(ShaderCost::PIPE_LOAD_STORE, 1.0f);
+		else if ((op >= spv::OpImageSampleImplicitLod && op <= spv::OpImageDrefGather) ||
+		         (op >= spv::OpImageSparseSampleImplicitLod && op <= spv::OpImageSparseDrefGather))
+			addCycles(ShaderCost::PIPE_TEXTURE, 1.0f);
+		else if (op == spv::OpExtInst && instruction.count >= 4)
+		{
+			float components = float(module.getComponentCount(ops[0]));
+			if (isTranscendental(ops[3]))
+				components *= transcendentalCycles;
+			addCycles(ShaderCost::PIPE_ARITHMETIC, components);
+		}
+		else if (op == spv::OpDot && instruction.count >= 3)
+			addCycles(ShaderCost::PIPE_ARITHMETIC, float(operandComponents(ops[2])));
+		else if (op == spv::OpMatrixTimesVector && instruction.count >= 4)
+		{
+			// One multiply-add per component of the matrix.
+			addCycles(ShaderCost::PIPE_ARITHMETIC, float(operandComponents(ops[2])));
+		}
+		else if (op == spv::OpVectorTimesMatrix && instruction.count >= 4)
+			addCycles(ShaderCost::PIPE_ARITHMETIC, float(operandComponents(ops[3])));
+		else if (op == spv::OpMatrixTimesMatrix && instruction.count >= 4)
+		{
+			// R x K times K x C is R * K * C multiply-adds, the square root of the product of all three sizes.
+			float product = float(operandComponents(ops[2])) * float(operandComponents(ops[3])) *
+			                float(module.getComponentCount(ops[0]));
+			addCycles(ShaderCost::PIPE_ARITHMETIC, sqrt(product));
+		}
+		else if (op == spv::OpFDiv || op == spv::OpFMod || op == spv::OpFRem)
+			addCycles(ShaderCost::PIPE_ARITHMETIC, module.getComponentCount(ops[0]) * transcendentalCycles);
+		else if (isArithmetic(op))
+			addCycles(ShaderCost::PIPE_ARITHMETIC, float(module.getComponentCount(ops[0])));
+		else if (op == spv::OpBranchConditional || op == spv::OpSwitch)
+			cost.branches++;
+	});
+
+	return cost;
+}
+
+FloatPrecisionStats analyzeFloatPrecision(const SpirvModule &module)
+{
+	FloatPrecisionStats stats;
+
+	// 16-bit types and RelaxedPrecision (mediump) results can both run at half precision.
+	module.forEachReachableInstruction([&](const SpirvModule::Instruction &instruction) {
+		if ((!isArithmetic(instruction.op) && instruction.op != spv::OpExtInst) || instruction.count < 2)
+			return;
+
+		uint32_t width = module.getFloatWidth(instruction.ops[0]);
+		if (!width)
+			return;
+
+		stats.floatOps++;
+		if (width > 16 && !module.isRelaxedPrecision(instruction.ops[1]))
+			stats.fp32Ops++;
+	});
+
+	for (auto id : module.getInterface())
+	{
+		if (module.getStorageClass(id) != spv::StorageClassInput || module.isBuiltIn(id))
+			continue;
+
+		uint32_t width = module.getFloatWidth(module.getPointeeType(id));
+		if (!width)
+			continue;
+
+		stats.varyings++;
+		if (width > 16 && !module.isRelaxedPrecision(id))
+			stats.fp32Varyings++;
+	}
+
+	return stats;
+}
+}
@@ -0,0 +1,149 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#include "perfdoc.hpp"
+#include "spirv.hpp"
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace MPD
+{
+
+/// Minimal walker over the raw SPIR-V of a shader module, for the checks SPIRV-Cross reflection does not cover,
+/// such as which instructions an entry point can actually execute.
+class SpirvModule
+{
+public:
+	struct Instruction
+	{
+		spv::Op op;
+		// Operands following the opcode word.
+		const uint32_t *ops;
+		uint32_t count;
+	};
+
+	/// Returns false if the module is malformed or has no matching entry point.
+	/// The code must outlive this object.
+	bool init(const std::vector<uint32_t> &code, const char *entryPoint, VkShaderStageFlagBits stage);
+
+	bool hasExecutionMode(spv::ExecutionMode mode) const;
+
+	/// Storage class of a pointer, following access chains back to their variable.
+	/// Returns spv::StorageClassMax for ids which are not known pointers.
+	spv::StorageClass getStorageClass(uint32_t pointerId) const;
+
+	/// Scalar components of a numerical type, 1 for scalars and types which are not vectors or matrices.
+	uint32_t getComponentCount(uint32_t typeId) const;
+
+	/// Width of the scalar floats in a float, vector or matrix type, 0 for other types.
+	uint32_t getFloatWidth(uint32_t typeId) const;
+
+	/// Type a pointer points to, 0 if unknown.
+	uint32_t getPointeeType(uint32_t pointerId) const;
+
+	bool isRelaxedPrecision(uint32_t id) const;
+	bool isBuiltIn(uint32_t id) const;
+
+	/// Input and output variables declared by the entry point.
+	const std::vector<uint32_t> &getInterface() const
+	{
+		return interfaceIds;
+	}
+
+	/// Calls func with each instruction of the functions reachable from the entry point.
+	template <typename Func>
+	void forEachReachableInstruction(const Func &func) const
+	{
+		for (auto &function : reachableFunctions)
+		{
+			uint32_t offset = function.begin;
+			while (offset < function.end)
+			{
+				uint32_t wordCount = code[offset] >> 16;
+				func(Instruction{ static_cast<spv::Op>(code[offset] & 0xffff), &code[offset + 1], wordCount - 1 });
+				offset += wordCount;
+			}
+		}
+	}
+
+private:
+	struct WordRange
+	{
+		uint32_t begin;
+		uint32_t end;
+	};
+
+	const uint32_t *code = nullptr;
+	uint32_t entryPointId = 0;
+	std::vector<uint32_t> interfaceIds;
+	std::vector<spv::ExecutionMode> executionModes;
+	std::vector<WordRange> reachableFunctions;
+	std::unordered_map<uint32_t, spv::StorageClass> pointerTypes;
+	std::unordered_map<uint32_t, uint32_t> pointerValueTypes;
+	std::unordered_map<uint32_t, uint32_t> pointeeTypes;
+	std::unordered_map<uint32_t, uint32_t> componentCounts;
+	std::unordered_map<uint32_t, uint32_t> floatWidths;
+	std::unordered_set<uint32_t> relaxedPrecisionIds;
+	std::unordered_set<uint32_t> builtInIds;
+};
+
+/// Static, first-order cost of one shader invocation on the pipes of a Mali shader core.
+/// Every reachable instruction is counted once: loops are not unrolled and both sides of a branch are taken.
+struct ShaderCost
+{
+	enum Pipe
+	{
+		PIPE_ARITHMETIC,
+		PIPE_LOAD_STORE,
+		PIPE_VARYING,
+		PIPE_TEXTURE,
+		PIPE_COUNT
+	};
+
+	uint32_t instructions[PIPE_COUNT] = {};
+	float cycles[PIPE_COUNT] = {};
+	uint32_t branches = 0;
+
+	/// The pipes run in parallel, so the busiest one bounds the shader.
+	Pipe getBoundPipe() const;
+
+	float getCycles() const
+	{
+		return cycles[getBoundPipe()];
+	}
+
+	static const char *getPipeName(Pipe pipe);
+};
+
+ShaderCost estimateShaderCost(const SpirvModule &module, VkShaderStageFlagBits stage);
+
+/// Floating-point arithmetic and float varyings of an entry point, and how many of them need full 32-bit precision.
+struct FloatPrecisionStats
+{
+	uint32_t floatOps = 0;
+	uint32_t fp32Ops = 0;
+	uint32_t varyings = 0;
+	uint32_t fp32Varyings = 0;
+};
+
+FloatPrecisionStats analyzeFloatPrecision(const SpirvModule &module);
+}
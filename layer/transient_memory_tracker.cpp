@@ -0,0 +1,175 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "transient_memory_tracker.hpp"
+#include "device.hpp"
+#include "message_codes.hpp"
+#include <algorithm>
+#include <stdio.h>
+#include <string>
+
+using namespace std;
+
+namespace MPD
+{
+TransientMemoryTracker::TransientMemoryTracker(Device &device)
+    : device(device)
+{
+}
+
+uint64_t TransientMemoryTracker::addCandidate(uint32_t heapIndex, VkDeviceSize size)
+{
+	MPD_ASSERT(heapIndex < VK_MAX_MEMORY_HEAPS);
+	auto &heap = heaps[heapIndex];
+	heap.currentBytes += size;
+	heap.currentImages++;
+	heap.events.push_back({ ++time, size, true });
+	heap.liveCandidates.insert(time);
+	return time;
+}
+
+void TransientMemoryTracker::removeCandidate(uint32_t heapIndex, VkDeviceSize size, uint64_t addedTime)
+{
+	MPD_ASSERT(heapIndex < VK_MAX_MEMORY_HEAPS);
+	auto &heap = heaps[heapIndex];
+	MPD_ASSERT(heap.currentBytes >= size && heap.currentImages > 0);
+	heap.currentBytes -= size;
+	heap.currentImages--;
+	heap.events.push_back({ ++time, size, false });
+	heap.liveCandidates.erase(heap.liveCandidates.find(addedTime));
+	settle(heap);
+}
+
+void TransientMemoryTracker::disqualifyCandidate(uint32_t heapIndex, VkDeviceSize size, uint64_t addedTime)
+{
+	MPD_ASSERT(heapIndex < VK_MAX_MEMORY_HEAPS);
+	auto &heap = heaps[heapIndex];
+	MPD_ASSERT(heap.currentBytes >= size && heap.currentImages > 0);
+	heap.currentBytes -= size;
+	heap.currentImages--;
+
+	// The add event of a live candidate is never settled, so it is still in the history.
+	auto itr = lower_bound(begin(heap.events), end(heap.events), addedTime,
+	                       [](const Event &event, uint64_t t) { return event.time < t; });
+	MPD_ASSERT(itr != end(heap.events) && itr->time == addedTime && itr->added);
+	heap.events.erase(itr);
+	heap.liveCandidates.erase(heap.liveCandidates.find(addedTime));
+	settle(heap);
+}
+
+void TransientMemoryTracker::settle(HeapTotals &heap)
+{
+	uint64_t oldestLive = heap.liveCandidates.empty() ? ~0ull : *heap.liveCandidates.begin();
+	while (!heap.events.empty() && heap.events.front().time < oldestLive)
+	{
+		auto &event = heap.events.front();
+		if (event.added)
+			heap.settledBytes += event.size;
+		else
+			heap.settledBytes -= event.size;
+		heap.settledPeak = max(heap.settledPeak, heap.settledBytes);
+		heap.events.pop_front();
+	}
+}
+
+VkDeviceSize TransientMemoryTracker::getPeakBytes(const HeapTotals &heap)
+{
+	VkDeviceSize bytes = heap.settledBytes;
+	VkDeviceSize peak = heap.settledPeak;
+	for (auto &event : heap.events)
+	{
+		if (event.added)
+			bytes += event.size;
+		else
+			bytes -= event.size;
+		peak = max(peak, bytes);
+	}
+	return peak;
+}
+
+void TransientMemoryTracker::endFrame()
+{
+	uint64_t interval = device.getConfig().transientMemoryReportFrameInterval;
+	if (interval != 0 && ++frameCount >= interval)
+	{
+		frameCount = 0;
+		report();
+	}
+}
+
+void TransientMemoryTracker::flush()
+{
+	report();
+}
+
+static double toMiB(double bytes)
+{
+	return bytes / (1024.0 * 1024.0);
+}
+
+void TransientMemoryTracker::report()
+{
+	auto &memoryProperties = device.getMemoryProperties();
+
+	VkDeviceSize current = 0;
+	VkDeviceSize peak = 0;
+	uint32_t images = 0;
+	bool supportsLazy = false;
+
+	for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+	{
+		current += heaps[i].currentBytes;
+		peak += getPeakBytes(heaps[i]);
+		images += heaps[i].currentImages;
+	}
+
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+		if (memoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+			supportsLazy = true;
+
+	if (peak == 0 || (peak == lastReportedPeak && current == lastReportedCurrent))
+		return;
+	lastReportedPeak = peak;
+	lastReportedCurrent = current;
+
+	char line[256];
+	snprintf(line, sizeof(line),
+	         "%u live image(s) using %.2f MiB (peak %.2f MiB) have only been used as attachments whose contents never "
+	         "leave the tile. Creating them with VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT and binding "
+	         "LAZILY_ALLOCATED memory would save that much physical memory%s. Per heap:",
+	         images, toMiB(double(current)), toMiB(double(peak)),
+	         supportsLazy ? "" : " on devices which support lazily allocated memory");
+	string message = line;
+
+	for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+	{
+		VkDeviceSize heapPeak = getPeakBytes(heaps[i]);
+		if (heapPeak == 0)
+			continue;
+
+		snprintf(line, sizeof(line), "\n  Heap %u: %.2f MiB in %u image(s), peak %.2f MiB.", i,
+		         toMiB(double(heaps[i].currentBytes)), heaps[i].currentImages, toMiB(double(heapPeak)));
+		message += line;
+	}
+
+	device.log(VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT, MESSAGE_CODE_TRANSIENT_MEMORY_SAVINGS, "%s",
+	           message.c_str());
+}
+}
@@ -0,0 +1,90 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#include "perfdoc.hpp"
+#include <deque>
+#include <set>
+
+namespace MPD
+{
+class Device;
+
+/// Sums up the memory of images which, judging by how they have been used so far, never need their contents to
+/// leave the tile, and could be transient attachments backed by lazily allocated memory instead.
+/// Images add and remove themselves as candidates, totals are kept per memory heap.
+/// An image which turns out to need its contents after all is disqualified, and is left out of the peak too.
+class TransientMemoryTracker
+{
+public:
+	explicit TransientMemoryTracker(Device &device);
+
+	/// Returns the time the candidate was added, which identifies it when it is removed or disqualified.
+	uint64_t addCandidate(uint32_t heapIndex, VkDeviceSize size);
+
+	/// The candidate was destroyed without leaving the tile, so it counted towards the peak while it was alive.
+	void removeCandidate(uint32_t heapIndex, VkDeviceSize size, uint64_t addedTime);
+
+	/// The candidate's contents left the tile, it is taken out of the current total and the history of the peak.
+	void disqualifyCandidate(uint32_t heapIndex, VkDeviceSize size, uint64_t addedTime);
+
+	/// Called on present, reports every transientMemoryReportFrameInterval frames if enabled.
+	void endFrame();
+
+	/// Reports the final numbers, called when the device is destroyed.
+	void flush();
+
+private:
+	Device &device;
+
+	struct Event
+	{
+		uint64_t time;
+		VkDeviceSize size;
+		bool added;
+	};
+
+	struct HeapTotals
+	{
+		VkDeviceSize currentBytes = 0;
+		uint32_t currentImages = 0;
+
+		// Live candidates can still be disqualified, which erases their add event. Events older than the oldest live
+		// candidate can no longer change, so they are folded into settledBytes and settledPeak.
+		std::deque<Event> events;
+		std::multiset<uint64_t> liveCandidates;
+		VkDeviceSize settledBytes = 0;
+		VkDeviceSize settledPeak = 0;
+	};
+
+	HeapTotals heaps[VK_MAX_MEMORY_HEAPS];
+	uint64_t time = 0;
+	uint64_t frameCount = 0;
+
+	static void settle(HeapTotals &heap);
+	static VkDeviceSize getPeakBytes(const HeapTotals &heap);
+
+	// Only report again once the numbers have changed.
+	VkDeviceSize lastReportedPeak = 0;
+	VkDeviceSize lastReportedCurrent = 0;
+
+	void report();
+};
+}
@@ -0,0 +1,110 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "vulkan_test.hpp"
+#include "perfdoc.hpp"
+#include "util.hpp"
+#include <memory>
+
+using namespace MPD;
+using namespace std;
+
+class Bandwidth : public VulkanTestHelper
+{
+	bool runTest()
+	{
+		if (!testRenderPass(VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE,
+		                    "0.00 MiB read and 4.00 MiB written per frame"))
+			return false;
+		if (!testRenderPass(VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_DONT_CARE,
+		                    "4.00 MiB read and 0.00 MiB written per frame"))
+			return false;
+
+		// A command buffer submitted twice costs its bandwidth twice.
+		if (!testRenderPass(VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE,
+		                    "0.00 MiB read and 8.00 MiB written per frame", 2))
+			return false;
+
+		return true;
+	}
+
+	bool testRenderPass(VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp, const char *expected,
+	                    unsigned submits = 1)
+	{
+		resetCounts();
+
+		{
+			// One pass over a 1024x1024 RGBA8 attachment, 4 MiB each way.
+			auto tex = make_shared<Texture>(device);
+			tex->initRenderTarget2D(1024, 1024, VK_FORMAT_R8G8B8A8_UNORM);
+
+			auto fb = make_shared<Framebuffer>(device);
+			fb->initOnlyColor(tex, loadOp, storeOp);
+
+			auto cmd = make_shared<CommandBuffer>(device);
+			cmd->initPrimary();
+
+			VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+			if (submits == 1)
+				beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			MPD_ASSERT_RESULT(vkBeginCommandBuffer(cmd->commandBuffer, &beginInfo));
+
+			VkClearValue clearValue = {};
+			VkRenderPassBeginInfo rbi = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+			rbi.renderPass = fb->renderPass;
+			rbi.framebuffer = fb->framebuffer;
+			rbi.renderArea.extent.width = 1024;
+			rbi.renderArea.extent.height = 1024;
+			rbi.clearValueCount = 1;
+			rbi.pClearValues = &clearValue;
+			vkCmdBeginRenderPass(cmd->commandBuffer, &rbi, VK_SUBPASS_CONTENTS_INLINE);
+			vkCmdEndRenderPass(cmd->commandBuffer);
+			MPD_ASSERT_RESULT(vkEndCommandBuffer(cmd->commandBuffer));
+
+			VkSubmitInfo submit = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+			submit.commandBufferCount = 1;
+			submit.pCommandBuffers = &cmd->commandBuffer;
+			for (unsigned i = 0; i < submits; i++)
+			{
+				MPD_ASSERT_RESULT(vkQueueSubmit(queue, 1, &submit, VK_NULL_HANDLE));
+				vkQueueWaitIdle(queue);
+			}
+		}
+
+		// Nothing is presented, so the work is reported as a single frame when the device goes away.
+		if (getCount(MESSAGE_CODE_BANDWIDTH_REPORT) != 0)
+			return false;
+
+		destroyDevice();
+		createDevice();
+
+		if (getCount(MESSAGE_CODE_BANDWIDTH_REPORT) != 1)
+			return false;
+		if (getLastMessage(MESSAGE_CODE_BANDWIDTH_REPORT).find(expected) == string::npos)
+			return false;
+
+		return true;
+	}
+};
+
+VulkanTestHelper *MPD::createTest()
+{
+	return new Bandwidth;
+}
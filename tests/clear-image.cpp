@@ -42,9 +42,146 @@ class ClearImage : public VulkanTestHelper
 		if (!testRedundantStore(true, 0))
 			return false;
 
+		if (!testOverlappingRanges())
+			return false;
+
 		return true;
 	}
 
+	// Clears overlapping mip and layer ranges of one image with vkCmdClearColorImage,
+	// then clears single mip levels with LOAD_OP_CLEAR. Each redundant clear must be reported once per run
+	// of subresources, naming exactly the subresources which were cleared twice.
+	bool testOverlappingRanges()
+	{
+		resetCounts();
+		const VkFormat FMT = VK_FORMAT_R8G8B8A8_UNORM;
+		const uint32_t WIDTH = 64, HEIGHT = 64, LEVELS = 4, LAYERS = 4;
+
+		VkImageCreateInfo info = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+		info.imageType = VK_IMAGE_TYPE_2D;
+		info.format = FMT;
+		info.extent.width = WIDTH;
+		info.extent.height = HEIGHT;
+		info.extent.depth = 1;
+		info.mipLevels = LEVELS;
+		info.arrayLayers = LAYERS;
+		info.samples = VK_SAMPLE_COUNT_1_BIT;
+		info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		info.tiling = VK_IMAGE_TILING_OPTIMAL;
+		info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkImage image;
+		MPD_ASSERT_RESULT(vkCreateImage(device, &info, nullptr, &image));
+
+		VkMemoryRequirements memReqs;
+		vkGetImageMemoryRequirements(device, image, &memReqs);
+		VkMemoryAllocateInfo alloc = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+		alloc.allocationSize = memReqs.size;
+		alloc.memoryTypeIndex = ctz(memReqs.memoryTypeBits);
+		VkDeviceMemory memory;
+		MPD_ASSERT_RESULT(vkAllocateMemory(device, &alloc, nullptr, &memory));
+		vkBindImageMemory(device, image, memory, 0);
+
+		// Only used for its render pass, which is compatible with every mip level view below.
+		auto tex = make_shared<Texture>(device);
+		tex->initRenderTarget2D(WIDTH, HEIGHT, FMT);
+		auto fb = make_shared<Framebuffer>(device);
+		fb->initOnlyColor(tex, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE);
+
+		VkImageView views[LEVELS];
+		VkFramebuffer framebuffers[LEVELS];
+		for (uint32_t level = 0; level < LEVELS; level++)
+		{
+			VkImageViewCreateInfo viewInfo = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+			viewInfo.image = image;
+			viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+			viewInfo.format = FMT;
+			viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, LAYERS };
+			MPD_ASSERT_RESULT(vkCreateImageView(device, &viewInfo, nullptr, &views[level]));
+
+			VkFramebufferCreateInfo fbInfo = { VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
+			fbInfo.renderPass = fb->renderPass;
+			fbInfo.attachmentCount = 1;
+			fbInfo.pAttachments = &views[level];
+			fbInfo.width = WIDTH >> level;
+			fbInfo.height = HEIGHT >> level;
+			fbInfo.layers = LAYERS;
+			MPD_ASSERT_RESULT(vkCreateFramebuffer(device, &fbInfo, nullptr, &framebuffers[level]));
+		}
+
+		const auto submit = [&](const function<void(VkCommandBuffer cmd)> &work) {
+			auto cmdb = make_shared<CommandBuffer>(device);
+			cmdb->initPrimary();
+			VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, nullptr,
+				                                   VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, nullptr };
+			MPD_ASSERT_RESULT(vkBeginCommandBuffer(cmdb->commandBuffer, &beginInfo));
+			work(cmdb->commandBuffer);
+			MPD_ASSERT_RESULT(vkEndCommandBuffer(cmdb->commandBuffer));
+
+			VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &cmdb->commandBuffer;
+			vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+			vkQueueWaitIdle(queue);
+		};
+
+		const auto clearImage = [&](uint32_t baseLevel, uint32_t levelCount, uint32_t baseLayer, uint32_t layerCount) {
+			submit([&](VkCommandBuffer cmd) {
+				VkClearColorValue value = {};
+				VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, baseLevel, levelCount, baseLayer,
+					                              layerCount };
+				vkCmdClearColorImage(cmd, image, VK_IMAGE_LAYOUT_GENERAL, &value, 1, &range);
+			});
+		};
+
+		// Returns true if the clear was reported exactly once and named the expected subresources.
+		const auto clearLevel = [&](uint32_t level, const char *expected) -> bool {
+			unsigned count = getCount(MESSAGE_CODE_REDUNDANT_IMAGE_CLEAR);
+			submit([&](VkCommandBuffer cmd) {
+				VkClearValue clearValue = {};
+				VkRenderPassBeginInfo rbi = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+				rbi.renderPass = fb->renderPass;
+				rbi.framebuffer = framebuffers[level];
+				rbi.renderArea.extent.width = WIDTH >> level;
+				rbi.renderArea.extent.height = HEIGHT >> level;
+				rbi.clearValueCount = 1;
+				rbi.pClearValues = &clearValue;
+				vkCmdBeginRenderPass(cmd, &rbi, VK_SUBPASS_CONTENTS_INLINE);
+				vkCmdEndRenderPass(cmd);
+			});
+
+			return getCount(MESSAGE_CODE_REDUNDANT_IMAGE_CLEAR) == count + 1 &&
+			       getLastMessage(MESSAGE_CODE_REDUNDANT_IMAGE_CLEAR).find(expected) != string::npos;
+		};
+
+		// Levels 1-2 of layers 1-2, then levels 0-1 of every layer. The second range covers part of the first.
+		clearImage(1, 2, 1, 2);
+		clearImage(0, 2, 0, LAYERS);
+
+		bool success = clearLevel(1, "4 subresources (arrayLayer: 0, mipLevel: 1) to (arrayLayer: 3, mipLevel: 1)") &&
+		               clearLevel(2, "2 subresources (arrayLayer: 1, mipLevel: 2) to (arrayLayer: 2, mipLevel: 2)");
+
+		// Clearing levels 1-3 leaves every subresource cleared, so the image is uniform again.
+		if (success)
+		{
+			clearImage(1, LEVELS - 1, 0, LAYERS);
+			success = clearLevel(0, "4 subresources (arrayLayer: 0, mipLevel: 0) to (arrayLayer: 3, mipLevel: 0)") &&
+			          clearLevel(3, "4 subresources (arrayLayer: 0, mipLevel: 3) to (arrayLayer: 3, mipLevel: 3)");
+		}
+
+		if (getCount(MESSAGE_CODE_INEFFICIENT_CLEAR) != 0 || getCount(MESSAGE_CODE_REDUNDANT_RENDERPASS_STORE) != 0)
+			success = false;
+
+		for (uint32_t level = 0; level < LEVELS; level++)
+		{
+			vkDestroyFramebuffer(device, framebuffers[level], nullptr);
+			vkDestroyImageView(device, views[level], nullptr);
+		}
+		vkDestroyImage(device, image, nullptr);
+		vkFreeMemory(device, memory, nullptr);
+		return success;
+	}
+
 	bool testRedundantStore(bool positiveTest, unsigned testVariant)
 	{
 		resetCounts();
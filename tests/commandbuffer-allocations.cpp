@@ -0,0 +1,171 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "perfdoc.hpp"
+#include "util/util.hpp"
+#include "vulkan_test.hpp"
+#include <atomic>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace MPD;
+using namespace std;
+
+// Counts every operator new in the process, which includes the layer as it shares the C++ runtime with the test.
+static atomic<uint64_t> allocationCount;
+
+void *operator new(size_t size)
+{
+	allocationCount++;
+	void *ptr = malloc(size ? size : 1);
+	if (!ptr)
+		throw bad_alloc();
+	return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+	free(ptr);
+}
+
+// Records, submits and resets the same command buffer over and over.
+// Once warmed up, the layer must not add any allocations on top of what the driver does by itself.
+class CommandBufferAllocationTest : public VulkanTestHelper
+{
+public:
+	static const unsigned warmupCycles = 8;
+	static const unsigned measuredCycles = 32;
+	static const unsigned drawsPerCycle = 16;
+
+	explicit CommandBufferAllocationTest(bool enablePerfDocLayer = true)
+	    : VulkanTestHelper(enablePerfDocLayer)
+	{
+	}
+
+	bool runTest()
+	{
+		uint64_t withLayer = measure();
+
+		uint64_t withoutLayer;
+		{
+			CommandBufferAllocationTest baseline(false);
+			withoutLayer = baseline.measure();
+		}
+
+		printf("Allocations over %u record/submit/reset cycles: %llu with layer, %llu without layer.\n",
+		       measuredCycles, static_cast<unsigned long long>(withLayer),
+		       static_cast<unsigned long long>(withoutLayer));
+		return withLayer <= withoutLayer;
+	}
+
+	uint64_t measure()
+	{
+		const uint32_t width = 64, height = 64;
+
+		auto tex = make_shared<Texture>(device);
+		tex->initRenderTarget2D(width, height, VK_FORMAT_R8G8B8A8_UNORM);
+
+		auto fb = make_shared<Framebuffer>(device);
+		fb->initOnlyColor(tex);
+
+		static const uint32_t vertCode[] =
+#include "quad_no_attribs.vert.inc"
+		    ;
+
+		static const uint32_t fragCode[] =
+#include "quad.frag.inc"
+		    ;
+
+		VkGraphicsPipelineCreateInfo info = {};
+		info.renderPass = fb->renderPass;
+		auto pipeline = make_shared<Pipeline>(device);
+		pipeline->initGraphics(vertCode, sizeof(vertCode), fragCode, sizeof(fragCode), &info);
+
+		// Few enough indices to stay below the index buffer scanning threshold.
+		static const uint16_t indices[] = { 0, 1, 2, 3, 4, 5 };
+		auto indexBuffer = make_shared<Buffer>(device);
+		indexBuffer->init(sizeof(indices), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, memoryProperties, HOST_ACCESS_WRITE,
+		                  const_cast<uint16_t *>(indices));
+
+		VkCommandPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO, nullptr,
+			                                 VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, queueFamilyIndex };
+		VkCommandPool pool;
+		MPD_ASSERT_RESULT(vkCreateCommandPool(device, &poolInfo, nullptr, &pool));
+
+		VkCommandBufferAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO, nullptr, pool,
+			                                      VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1 };
+		VkCommandBuffer cmd;
+		MPD_ASSERT_RESULT(vkAllocateCommandBuffers(device, &allocInfo, &cmd));
+
+		VkClearValue clearValue = {};
+		VkRenderPassBeginInfo rpInfo = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+		rpInfo.renderPass = fb->renderPass;
+		rpInfo.framebuffer = fb->framebuffer;
+		rpInfo.renderArea.extent.width = width;
+		rpInfo.renderArea.extent.height = height;
+		rpInfo.clearValueCount = 1;
+		rpInfo.pClearValues = &clearValue;
+
+		VkViewport vp = { 0.0f, 0.0f, float(width), float(height), 0.0f, 1.0f };
+
+		auto cycle = [&]() {
+			VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, nullptr,
+				                                   VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, nullptr };
+			MPD_ASSERT_RESULT(vkBeginCommandBuffer(cmd, &beginInfo));
+			vkCmdSetViewport(cmd, 0, 1, &vp);
+			vkCmdBeginRenderPass(cmd, &rpInfo, VK_SUBPASS_CONTENTS_INLINE);
+			vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipeline);
+			vkCmdBindIndexBuffer(cmd, indexBuffer->buffer, 0, VK_INDEX_TYPE_UINT16);
+			for (unsigned i = 0; i < drawsPerCycle; i++)
+			{
+				if (i & 1)
+					vkCmdDrawIndexed(cmd, 6, 1, 0, 0, 0);
+				else
+					vkCmdDraw(cmd, 3, 1, 0, 0);
+			}
+			vkCmdEndRenderPass(cmd);
+			MPD_ASSERT_RESULT(vkEndCommandBuffer(cmd));
+
+			VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+			submitInfo.commandBufferCount = 1;
+			submitInfo.pCommandBuffers = &cmd;
+			MPD_ASSERT_RESULT(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
+			MPD_ASSERT_RESULT(vkQueueWaitIdle(queue));
+			MPD_ASSERT_RESULT(vkResetCommandBuffer(cmd, 0));
+		};
+
+		for (unsigned i = 0; i < warmupCycles; i++)
+			cycle();
+
+		uint64_t before = allocationCount;
+		for (unsigned i = 0; i < measuredCycles; i++)
+			cycle();
+		uint64_t allocations = allocationCount - before;
+
+		vkDestroyCommandPool(device, pool, nullptr);
+		return allocations;
+	}
+};
+
+VulkanTestHelper *MPD::createTest()
+{
+	return new CommandBufferAllocationTest;
+}
@@ -42,6 +42,239 @@ class CommandBufferTest : public VulkanTestHelper
 		if (!testIndexScanning())
 			return false;
 
+		if (!testRedundantBinds())
+			return false;
+
+		if (!testDrawOrder(DRAW_ORDER_OPAQUE))
+			return false;
+
+		if (!testDrawOrder(DRAW_ORDER_BLENDED))
+			return false;
+
+		if (!testDrawOrder(DRAW_ORDER_NO_DEPTH_WRITE))
+			return false;
+
+		if (!testDrawOrder(DRAW_ORDER_NO_COLOR_WRITE))
+			return false;
+
+		if (!testDrawOrder(DRAW_ORDER_BLENDED_BETWEEN))
+			return false;
+
+		return true;
+	}
+
+	enum DrawOrderVariant
+	{
+		DRAW_ORDER_OPAQUE,
+		DRAW_ORDER_BLENDED,
+		DRAW_ORDER_NO_DEPTH_WRITE,
+		DRAW_ORDER_NO_COLOR_WRITE,
+		// Opaque draws with a blended draw after every pair, which keeps them from being grouped.
+		DRAW_ORDER_BLENDED_BETWEEN
+	};
+
+	// Alternating between two depth tested pipelines can be sorted away,
+	// unless the draws are blended or do not write both depth and color.
+	bool testDrawOrder(DrawOrderVariant variant)
+	{
+		bool blended = variant == DRAW_ORDER_BLENDED;
+		resetCounts();
+		const VkFormat FMT = VK_FORMAT_R8G8B8A8_UNORM;
+		const VkFormat DEPTH_FMT = VK_FORMAT_D32_SFLOAT;
+		const uint32_t WIDTH = 64, HEIGHT = 64;
+
+		auto tex = make_shared<Texture>(device);
+		tex->initRenderTarget2D(WIDTH, HEIGHT, FMT);
+
+		auto texDepth = make_shared<Texture>(device);
+		texDepth->initDepthStencil(WIDTH, HEIGHT, DEPTH_FMT);
+
+		auto fb = make_shared<Framebuffer>(device);
+		fb->initDepthColor(texDepth, tex);
+
+		static const uint32_t vertCode[] =
+#include "quad_no_attribs.vert.inc"
+		    ;
+
+		static const uint32_t fragCode[] =
+#include "quad.frag.inc"
+		    ;
+
+		VkPipelineColorBlendAttachmentState blendAttachment = {};
+		blendAttachment.colorWriteMask = variant == DRAW_ORDER_NO_COLOR_WRITE ? 0 : 0xF;
+		blendAttachment.blendEnable = blended ? VK_TRUE : VK_FALSE;
+		blendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+		blendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+		blendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+		blendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		blendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+		blendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+		VkPipelineColorBlendStateCreateInfo cbState = {};
+		cbState.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		cbState.attachmentCount = 1;
+		cbState.pAttachments = &blendAttachment;
+
+		VkPipelineDepthStencilStateCreateInfo dsState = {};
+		dsState.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+		dsState.depthTestEnable = VK_TRUE;
+		dsState.depthWriteEnable = variant == DRAW_ORDER_NO_DEPTH_WRITE ? VK_FALSE : VK_TRUE;
+		dsState.depthCompareOp = VK_COMPARE_OP_LESS;
+
+		VkGraphicsPipelineCreateInfo info = {};
+		info.renderPass = fb->renderPass;
+		info.pDepthStencilState = &dsState;
+		info.pColorBlendState = &cbState;
+
+		auto pipelineA = make_shared<Pipeline>(device);
+		pipelineA->initGraphics(vertCode, sizeof(vertCode), fragCode, sizeof(fragCode), &info);
+		auto pipelineB = make_shared<Pipeline>(device);
+		pipelineB->initGraphics(vertCode, sizeof(vertCode), fragCode, sizeof(fragCode), &info);
+
+		auto blendedAttachment = blendAttachment;
+		blendedAttachment.blendEnable = VK_TRUE;
+		auto blendedState = cbState;
+		blendedState.pAttachments = &blendedAttachment;
+		info.pColorBlendState = &blendedState;
+		auto pipelineBlended = make_shared<Pipeline>(device);
+		pipelineBlended->initGraphics(vertCode, sizeof(vertCode), fragCode, sizeof(fragCode), &info);
+
+		auto cmdb = make_shared<CommandBuffer>(device);
+		cmdb->initPrimary();
+
+		VkCommandBufferBeginInfo cbBeginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
+			                                     VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, NULL };
+		MPD_ASSERT_RESULT(vkBeginCommandBuffer(cmdb->commandBuffer, &cbBeginInfo));
+
+		VkClearValue clearValues[2] = {};
+		clearValues[1].depthStencil.depth = 1.0f;
+		VkRenderPassBeginInfo rbi = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+		rbi.renderPass = fb->renderPass;
+		rbi.framebuffer = fb->framebuffer;
+		rbi.renderArea.extent.width = WIDTH;
+		rbi.renderArea.extent.height = HEIGHT;
+		rbi.clearValueCount = 2;
+		rbi.pClearValues = clearValues;
+
+		VkViewport vp = { 0.0f, 0.0f, float(WIDTH), float(HEIGHT), 0.0f, 1.0f };
+		vkCmdSetViewport(cmdb->commandBuffer, 0, 1, &vp);
+		vkCmdBeginRenderPass(cmdb->commandBuffer, &rbi, VK_SUBPASS_CONTENTS_INLINE);
+
+		// Every draw switches pipelines, sorted there would be two switches in total.
+		for (unsigned i = 0; i < cfg.drawOrderSwitchSavingsThreshold + 2; i++)
+		{
+			auto &pipeline = (i & 1) ? pipelineA : pipelineB;
+			vkCmdBindPipeline(cmdb->commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipeline);
+			vkCmdDraw(cmdb->commandBuffer, 3, 1, 0, 0);
+
+			if (variant == DRAW_ORDER_BLENDED_BETWEEN && (i & 1))
+			{
+				vkCmdBindPipeline(cmdb->commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineBlended->pipeline);
+				vkCmdDraw(cmdb->commandBuffer, 3, 1, 0, 0);
+			}
+		}
+
+		vkCmdEndRenderPass(cmdb->commandBuffer);
+		MPD_ASSERT_RESULT(vkEndCommandBuffer(cmdb->commandBuffer));
+
+		VkSubmitInfo submit = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+		submit.commandBufferCount = 1;
+		submit.pCommandBuffers = &cmdb->commandBuffer;
+		MPD_ASSERT_RESULT(vkQueueSubmit(queue, 1, &submit, VK_NULL_HANDLE));
+		MPD_ASSERT_RESULT(vkQueueWaitIdle(queue));
+
+		if (getCount(MESSAGE_CODE_DRAW_ORDER_STATE_CHANGES) != (variant == DRAW_ORDER_OPAQUE ? 1u : 0u))
+			return false;
+
+		return true;
+	}
+
+	bool testRedundantBinds()
+	{
+		const uint32_t WIDTH = 64, HEIGHT = 64;
+
+		auto tex = make_shared<Texture>(device);
+		tex->initRenderTarget2D(WIDTH, HEIGHT, VK_FORMAT_R8G8B8A8_UNORM);
+
+		auto fb = make_shared<Framebuffer>(device);
+		fb->initOnlyColor(tex);
+
+		static const uint32_t vertCode[] =
+#include "quad_no_attribs.vert.inc"
+		    ;
+
+		static const uint32_t fragCode[] =
+#include "quad.frag.inc"
+		    ;
+
+		VkGraphicsPipelineCreateInfo info = {};
+		info.renderPass = fb->renderPass;
+		auto pipelineA = make_shared<Pipeline>(device);
+		pipelineA->initGraphics(vertCode, sizeof(vertCode), fragCode, sizeof(fragCode), &info);
+		auto pipelineB = make_shared<Pipeline>(device);
+		pipelineB->initGraphics(vertCode, sizeof(vertCode), fragCode, sizeof(fragCode), &info);
+
+		auto idxBuff = make_shared<Buffer>(device);
+		idxBuff->init(sizeof(uint16_t) * 3, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, memoryProperties);
+
+		const auto submitDraws = [&](bool redundant) {
+			auto cmdb = make_shared<CommandBuffer>(device);
+			cmdb->initPrimary();
+
+			VkCommandBufferBeginInfo cbBeginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
+				                                     VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, NULL };
+			MPD_ASSERT_RESULT(vkBeginCommandBuffer(cmdb->commandBuffer, &cbBeginInfo));
+
+			VkClearValue clearValue = {};
+			VkRenderPassBeginInfo rbi = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+			rbi.renderPass = fb->renderPass;
+			rbi.framebuffer = fb->framebuffer;
+			rbi.renderArea.extent.width = WIDTH;
+			rbi.renderArea.extent.height = HEIGHT;
+			rbi.clearValueCount = 1;
+			rbi.pClearValues = &clearValue;
+
+			VkViewport vp = { 0.0f, 0.0f, float(WIDTH), float(HEIGHT), 0.0f, 1.0f };
+			vkCmdSetViewport(cmdb->commandBuffer, 0, 1, &vp);
+			vkCmdBeginRenderPass(cmdb->commandBuffer, &rbi, VK_SUBPASS_CONTENTS_INLINE);
+
+			// Either rebind the same state before every draw, or alternate between different state.
+			for (unsigned i = 0; i < cfg.redundantBindThreshold; i++)
+			{
+				auto &pipeline = (redundant || (i & 1)) ? pipelineA : pipelineB;
+				vkCmdBindPipeline(cmdb->commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipeline);
+				vkCmdBindIndexBuffer(cmdb->commandBuffer, idxBuff->buffer, redundant ? 0 : (i & 1) * 2,
+				                     VK_INDEX_TYPE_UINT16);
+				vkCmdDrawIndexed(cmdb->commandBuffer, 1, 1, 0, 0, 0);
+			}
+
+			vkCmdEndRenderPass(cmdb->commandBuffer);
+			MPD_ASSERT_RESULT(vkEndCommandBuffer(cmdb->commandBuffer));
+
+			// Nothing is reported before the command buffer is submitted.
+			if (getCount(MESSAGE_CODE_REDUNDANT_STATE_BIND) != 0)
+				return false;
+
+			VkSubmitInfo submit = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+			submit.commandBufferCount = 1;
+			submit.pCommandBuffers = &cmdb->commandBuffer;
+			MPD_ASSERT_RESULT(vkQueueSubmit(queue, 1, &submit, VK_NULL_HANDLE));
+			MPD_ASSERT_RESULT(vkQueueWaitIdle(queue));
+			return true;
+		};
+
+		resetCounts();
+		if (!submitDraws(false))
+			return false;
+		if (getCount(MESSAGE_CODE_REDUNDANT_STATE_BIND) != 0)
+			return false;
+
+		resetCounts();
+		if (!submitDraws(true))
+			return false;
+		if (getCount(MESSAGE_CODE_REDUNDANT_STATE_BIND) != 1)
+			return false;
+
 		return true;
 	}
 
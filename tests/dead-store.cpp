@@ -0,0 +1,302 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "vulkan_test.hpp"
+#include "perfdoc.hpp"
+#include "util.hpp"
+#include <memory>
+
+using namespace MPD;
+using namespace std;
+
+class DeadStore : public VulkanTestHelper
+{
+	enum Variant
+	{
+		VARIANT_DONT_CARE_LOAD,
+		VARIANT_FULL_COPY,
+		VARIANT_PARTIAL_COPY,
+		VARIANT_DESTROY,
+		VARIANT_SAMPLE_BETWEEN_STORES
+	};
+
+	bool runTest()
+	{
+		if (!testDeadStore(VARIANT_DONT_CARE_LOAD, "discarded by DONT_CARE"))
+			return false;
+		if (!testDeadStore(VARIANT_FULL_COPY, "overwritten by a transfer"))
+			return false;
+		if (!testDeadStore(VARIANT_PARTIAL_COPY, nullptr))
+			return false;
+		if (!testDeadStore(VARIANT_DESTROY, "destroyed"))
+			return false;
+		if (!testDeadStore(VARIANT_SAMPLE_BETWEEN_STORES, nullptr))
+			return false;
+		if (!testDepthStencilCopy(VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT, true))
+			return false;
+		if (!testDepthStencilCopy(VK_IMAGE_ASPECT_DEPTH_BIT, false))
+			return false;
+
+		return true;
+	}
+
+	static void renderPass(VkCommandBuffer cmd, const Framebuffer &fb)
+	{
+		VkClearValue clearValue = {};
+		VkRenderPassBeginInfo rbi = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+		rbi.renderPass = fb.renderPass;
+		rbi.framebuffer = fb.framebuffer;
+		rbi.renderArea.extent.width = WIDTH;
+		rbi.renderArea.extent.height = HEIGHT;
+		rbi.clearValueCount = 1;
+		rbi.pClearValues = &clearValue;
+		vkCmdBeginRenderPass(cmd, &rbi, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdEndRenderPass(cmd);
+	}
+
+	static void copyImage(VkCommandBuffer cmd, const Texture &src, const Texture &dst, uint32_t width, uint32_t height)
+	{
+		VkImageCopy region = {};
+		region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.srcSubresource.layerCount = 1;
+		region.dstSubresource = region.srcSubresource;
+		region.extent.width = width;
+		region.extent.height = height;
+		region.extent.depth = 1;
+		vkCmdCopyImage(cmd, src.image, VK_IMAGE_LAYOUT_GENERAL, dst.image, VK_IMAGE_LAYOUT_GENERAL, 1, &region);
+	}
+
+	// The first render pass stores an image, the variant decides what happens to it next.
+	// Dead stores are reported when the device is destroyed, with the reason the stored data was lost.
+	// expectedReason is nullptr if no dead store should be reported.
+	bool testDeadStore(Variant variant, const char *expectedReason)
+	{
+		resetCounts();
+
+		{
+			static const uint32_t vertCode[] =
+#include "quad_no_attribs.vert.inc"
+			    ;
+
+			static const uint32_t fragCode[] =
+#include "quad_sampler.frag.inc"
+			    ;
+
+			auto stored = make_shared<Texture>(device);
+			stored->initRenderTarget2D(WIDTH, HEIGHT, VK_FORMAT_R8G8B8A8_UNORM);
+			auto other = make_shared<Texture>(device);
+			other->initRenderTarget2D(WIDTH, HEIGHT, VK_FORMAT_R8G8B8A8_UNORM);
+
+			auto fbStore = make_shared<Framebuffer>(device);
+			fbStore->initOnlyColor(stored, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
+			auto fbDiscard = make_shared<Framebuffer>(device);
+			fbDiscard->initOnlyColor(stored, VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE);
+			auto fbSample = make_shared<Framebuffer>(device);
+			fbSample->initOnlyColor(other, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE);
+
+			VkGraphicsPipelineCreateInfo pi = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+			pi.renderPass = fbSample->renderPass;
+			auto pipeline = make_shared<Pipeline>(device);
+			pipeline->initGraphics(vertCode, sizeof(vertCode), fragCode, sizeof(fragCode), &pi);
+
+			auto descriptors = make_shared<SampledImageDescriptorSet>(device);
+			descriptors->init(pipeline->descriptorSetLayout, stored->view);
+
+			auto cmd = make_shared<CommandBuffer>(device);
+			cmd->initPrimary();
+			auto vkcmd = cmd->commandBuffer;
+
+			VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			MPD_ASSERT_RESULT(vkBeginCommandBuffer(vkcmd, &beginInfo));
+
+			const auto samplePass = [&]() {
+				VkClearValue clearValue = {};
+				VkRenderPassBeginInfo rbi = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+				rbi.renderPass = fbSample->renderPass;
+				rbi.framebuffer = fbSample->framebuffer;
+				rbi.renderArea.extent.width = WIDTH;
+				rbi.renderArea.extent.height = HEIGHT;
+				rbi.clearValueCount = 1;
+				rbi.pClearValues = &clearValue;
+				vkCmdBeginRenderPass(vkcmd, &rbi, VK_SUBPASS_CONTENTS_INLINE);
+				vkCmdBindPipeline(vkcmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipeline);
+				vkCmdBindDescriptorSets(vkcmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipelineLayout, 0, 1,
+				                        &descriptors->set, 0, nullptr);
+
+				VkViewport viewport = { 0.0f, 0.0f, float(WIDTH), float(HEIGHT), 0.0f, 1.0f };
+				VkRect2D scissor = { { 0, 0 }, { WIDTH, HEIGHT } };
+				vkCmdSetViewport(vkcmd, 0, 1, &viewport);
+				vkCmdSetScissor(vkcmd, 0, 1, &scissor);
+				vkCmdDraw(vkcmd, 3, 1, 0, 0);
+				vkCmdEndRenderPass(vkcmd);
+			};
+
+			renderPass(vkcmd, *fbStore);
+
+			switch (variant)
+			{
+			case VARIANT_DONT_CARE_LOAD:
+				renderPass(vkcmd, *fbDiscard);
+				break;
+
+			case VARIANT_FULL_COPY:
+				copyImage(vkcmd, *other, *stored, WIDTH, HEIGHT);
+				break;
+
+			case VARIANT_PARTIAL_COPY:
+				// Part of the stored data survives, so the store was not dead.
+				copyImage(vkcmd, *other, *stored, WIDTH / 2, HEIGHT / 2);
+				break;
+
+			case VARIANT_DESTROY:
+				break;
+
+			case VARIANT_SAMPLE_BETWEEN_STORES:
+				// Both stores are read before anything else happens to the image.
+				samplePass();
+				renderPass(vkcmd, *fbStore);
+				samplePass();
+				break;
+			}
+
+			MPD_ASSERT_RESULT(vkEndCommandBuffer(vkcmd));
+
+			VkSubmitInfo submit = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+			submit.commandBufferCount = 1;
+			submit.pCommandBuffers = &vkcmd;
+			MPD_ASSERT_RESULT(vkQueueSubmit(queue, 1, &submit, VK_NULL_HANDLE));
+			vkQueueWaitIdle(queue);
+		}
+
+		destroyDevice();
+		createDevice();
+
+		if (!expectedReason)
+			return getCount(MESSAGE_CODE_DEAD_ATTACHMENT_STORE) == 0;
+
+		if (getCount(MESSAGE_CODE_DEAD_ATTACHMENT_STORE) != 1)
+			return false;
+
+		// Only the variant's own reason may be given, in particular the image is not destroyed with the data live.
+		auto &message = getLastMessage(MESSAGE_CODE_DEAD_ATTACHMENT_STORE);
+		static const char *reasons[] = { "discarded by DONT_CARE", "cleared", "overwritten by a transfer",
+			                             "stored again", "destroyed" };
+		for (auto *reason : reasons)
+		{
+			bool expected = strcmp(reason, expectedReason) == 0;
+			if (expected != (message.find(reason) != string::npos))
+				return false;
+		}
+
+		return true;
+	}
+
+	// A depth/stencil attachment is stored, then copied over with the given aspects.
+	// Only a copy which writes both depth and stencil overwrites all of the stored data.
+	bool testDepthStencilCopy(VkImageAspectFlags aspects, bool expectOverwrite)
+	{
+		static const VkFormat candidates[] = { VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D32_SFLOAT_S8_UINT };
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		for (auto candidate : candidates)
+		{
+			VkFormatProperties props;
+			vkGetPhysicalDeviceFormatProperties(gpu, candidate, &props);
+			if (props.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+			{
+				format = candidate;
+				break;
+			}
+		}
+
+		// No depth/stencil format to test with.
+		if (format == VK_FORMAT_UNDEFINED)
+			return true;
+
+		resetCounts();
+
+		{
+			auto stored = make_shared<Texture>(device);
+			stored->initDepthStencil(WIDTH, HEIGHT, format);
+			auto other = make_shared<Texture>(device);
+			other->initDepthStencil(WIDTH, HEIGHT, format);
+			auto color = make_shared<Texture>(device);
+			color->initRenderTarget2D(WIDTH, HEIGHT, VK_FORMAT_R8G8B8A8_UNORM);
+
+			auto fb = make_shared<Framebuffer>(device);
+			fb->initDepthColor(stored, color, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE,
+			                   VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE);
+
+			auto cmd = make_shared<CommandBuffer>(device);
+			cmd->initPrimary();
+			auto vkcmd = cmd->commandBuffer;
+
+			VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			MPD_ASSERT_RESULT(vkBeginCommandBuffer(vkcmd, &beginInfo));
+
+			VkClearValue clearValues[2] = {};
+			VkRenderPassBeginInfo rbi = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+			rbi.renderPass = fb->renderPass;
+			rbi.framebuffer = fb->framebuffer;
+			rbi.renderArea.extent.width = WIDTH;
+			rbi.renderArea.extent.height = HEIGHT;
+			rbi.clearValueCount = 2;
+			rbi.pClearValues = clearValues;
+			vkCmdBeginRenderPass(vkcmd, &rbi, VK_SUBPASS_CONTENTS_INLINE);
+			vkCmdEndRenderPass(vkcmd);
+
+			VkImageCopy region = {};
+			region.srcSubresource.aspectMask = aspects;
+			region.srcSubresource.layerCount = 1;
+			region.dstSubresource = region.srcSubresource;
+			region.extent.width = WIDTH;
+			region.extent.height = HEIGHT;
+			region.extent.depth = 1;
+			vkCmdCopyImage(vkcmd, other->image, VK_IMAGE_LAYOUT_GENERAL, stored->image, VK_IMAGE_LAYOUT_GENERAL, 1,
+			               &region);
+
+			MPD_ASSERT_RESULT(vkEndCommandBuffer(vkcmd));
+
+			VkSubmitInfo submit = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+			submit.commandBufferCount = 1;
+			submit.pCommandBuffers = &vkcmd;
+			MPD_ASSERT_RESULT(vkQueueSubmit(queue, 1, &submit, VK_NULL_HANDLE));
+			vkQueueWaitIdle(queue);
+		}
+
+		destroyDevice();
+		createDevice();
+
+		if (!expectOverwrite)
+			return getCount(MESSAGE_CODE_DEAD_ATTACHMENT_STORE) == 0;
+
+		return getCount(MESSAGE_CODE_DEAD_ATTACHMENT_STORE) == 1 &&
+		       getLastMessage(MESSAGE_CODE_DEAD_ATTACHMENT_STORE).find("overwritten by a transfer") != string::npos;
+	}
+
+	static const uint32_t WIDTH = 64;
+	static const uint32_t HEIGHT = 64;
+};
+
+VulkanTestHelper *MPD::createTest()
+{
+	return new DeadStore;
+}
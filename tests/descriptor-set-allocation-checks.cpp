@@ -77,6 +77,90 @@ class DescriptorSetAllocationsTest : public VulkanTestHelper
 		if (!testNegative())
 			return false;
 
+		if (!testOverProvisionedReset())
+			return false;
+
+		if (!testOverProvisionedDestroy())
+			return false;
+
+		if (!testOverProvisionedSets())
+			return false;
+
+		return true;
+	}
+
+	VkDescriptorPool createPool(uint32_t maxSets, uint32_t samplerCount)
+	{
+		VkDescriptorPoolSize poolSizes[] = { { VK_DESCRIPTOR_TYPE_SAMPLER, samplerCount } };
+
+		VkDescriptorPoolCreateInfo inf = {};
+		inf.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		inf.maxSets = maxSets;
+		inf.poolSizeCount = sizeof(poolSizes) / sizeof(poolSizes[0]);
+		inf.pPoolSizes = &poolSizes[0];
+
+		VkDescriptorPool overProvisionedPool;
+		MPD_ASSERT_RESULT(vkCreateDescriptorPool(device, &inf, nullptr, &overProvisionedPool));
+		return overProvisionedPool;
+	}
+
+	void allocateSet(VkDescriptorPool fromPool)
+	{
+		VkDescriptorSet set = VK_NULL_HANDLE;
+
+		VkDescriptorSetAllocateInfo inf = {};
+		inf.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		inf.descriptorPool = fromPool;
+		inf.descriptorSetCount = 1;
+		inf.pSetLayouts = &descriptorSetLayout;
+		MPD_ASSERT_RESULT(vkAllocateDescriptorSets(device, &inf, &set));
+	}
+
+	bool testOverProvisionedReset()
+	{
+		resetCounts();
+		VkDescriptorPool bigPool = createPool(1000, 1000);
+
+		allocateSet(bigPool);
+		MPD_ASSERT_RESULT(vkResetDescriptorPool(device, bigPool, 0));
+		if (getCount(MESSAGE_CODE_DESCRIPTOR_POOL_OVER_PROVISIONED) != 1)
+			return false;
+
+		// The same usage again must not repeat the report, not on reset nor on destroy.
+		allocateSet(bigPool);
+		MPD_ASSERT_RESULT(vkResetDescriptorPool(device, bigPool, 0));
+		vkDestroyDescriptorPool(device, bigPool, nullptr);
+		if (getCount(MESSAGE_CODE_DESCRIPTOR_POOL_OVER_PROVISIONED) != 1)
+			return false;
+
+		return true;
+	}
+
+	bool testOverProvisionedDestroy()
+	{
+		resetCounts();
+		VkDescriptorPool bigPool = createPool(1000, 1000);
+
+		allocateSet(bigPool);
+		vkDestroyDescriptorPool(device, bigPool, nullptr);
+		if (getCount(MESSAGE_CODE_DESCRIPTOR_POOL_OVER_PROVISIONED) != 1)
+			return false;
+
+		return true;
+	}
+
+	bool testOverProvisionedSets()
+	{
+		resetCounts();
+
+		// Only the sets are over-provisioned, there is just enough room for the one sampler.
+		VkDescriptorPool bigPool = createPool(1000, 1);
+
+		allocateSet(bigPool);
+		vkDestroyDescriptorPool(device, bigPool, nullptr);
+		if (getCount(MESSAGE_CODE_DESCRIPTOR_POOL_OVER_PROVISIONED) != 1)
+			return false;
+
 		return true;
 	}
 
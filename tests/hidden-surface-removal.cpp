@@ -0,0 +1,166 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "vulkan_test.hpp"
+#include "perfdoc.hpp"
+#include "util.hpp"
+#include <memory>
+#include <vector>
+
+using namespace MPD;
+using namespace std;
+
+class HiddenSurfaceRemovalTest : public VulkanTestHelper
+{
+	bool runTest()
+	{
+		if (!testDiscard(false, false))
+			return false;
+		if (!testDiscard(true, false))
+			return false;
+
+		VkPhysicalDeviceFeatures features;
+		vkGetPhysicalDeviceFeatures(gpu, &features);
+		if (features.multiDrawIndirect && !testDiscard(false, true))
+			return false;
+
+		return true;
+	}
+
+	// A discarding shader disables early depth testing and Forward Pixel Kill for opaque draws which write depth.
+	// Blended draws without depth writes lose neither. Indirect draws count every draw of their drawCount.
+	bool testDiscard(bool blended, bool indirect)
+	{
+		resetCounts();
+		const VkFormat FMT = VK_FORMAT_R8G8B8A8_UNORM;
+		const VkFormat DEPTH_FMT = VK_FORMAT_D32_SFLOAT;
+		const uint32_t WIDTH = 64, HEIGHT = 64;
+
+		auto tex = make_shared<Texture>(device);
+		tex->initRenderTarget2D(WIDTH, HEIGHT, FMT);
+
+		auto texDepth = make_shared<Texture>(device);
+		texDepth->initDepthStencil(WIDTH, HEIGHT, DEPTH_FMT);
+
+		auto fb = make_shared<Framebuffer>(device);
+		fb->initDepthColor(texDepth, tex);
+
+		static const uint32_t vertCode[] =
+#include "quad_no_attribs.vert.inc"
+		    ;
+
+		static const uint32_t fragCode[] =
+#include "quad_discard.frag.inc"
+		    ;
+
+		VkPipelineColorBlendAttachmentState blendAttachment = {};
+		blendAttachment.colorWriteMask = 0xF;
+		blendAttachment.blendEnable = blended ? VK_TRUE : VK_FALSE;
+		blendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+		blendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+		blendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+		blendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		blendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+		blendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+		VkPipelineColorBlendStateCreateInfo cbState = {};
+		cbState.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		cbState.attachmentCount = 1;
+		cbState.pAttachments = &blendAttachment;
+
+		VkPipelineDepthStencilStateCreateInfo dsState = {};
+		dsState.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+		dsState.depthTestEnable = VK_TRUE;
+		dsState.depthWriteEnable = blended ? VK_FALSE : VK_TRUE;
+		dsState.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+		VkGraphicsPipelineCreateInfo info = {};
+		info.renderPass = fb->renderPass;
+		info.pDepthStencilState = &dsState;
+		info.pColorBlendState = &cbState;
+
+		auto pipeline = make_shared<Pipeline>(device);
+		pipeline->initGraphics(vertCode, sizeof(vertCode), fragCode, sizeof(fragCode), &info);
+
+		const auto submitDraws = [&](uint32_t draws) {
+			auto cmdb = make_shared<CommandBuffer>(device);
+			cmdb->initPrimary();
+
+			VkCommandBufferBeginInfo cbBeginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, NULL,
+				                                     VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, NULL };
+			MPD_ASSERT_RESULT(vkBeginCommandBuffer(cmdb->commandBuffer, &cbBeginInfo));
+
+			VkClearValue clearValues[2] = {};
+			clearValues[1].depthStencil.depth = 1.0f;
+			VkRenderPassBeginInfo rbi = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+			rbi.renderPass = fb->renderPass;
+			rbi.framebuffer = fb->framebuffer;
+			rbi.renderArea.extent.width = WIDTH;
+			rbi.renderArea.extent.height = HEIGHT;
+			rbi.clearValueCount = 2;
+			rbi.pClearValues = clearValues;
+
+			VkViewport vp = { 0.0f, 0.0f, float(WIDTH), float(HEIGHT), 0.0f, 1.0f };
+			vkCmdSetViewport(cmdb->commandBuffer, 0, 1, &vp);
+			vkCmdBeginRenderPass(cmdb->commandBuffer, &rbi, VK_SUBPASS_CONTENTS_INLINE);
+			vkCmdBindPipeline(cmdb->commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipeline);
+
+			auto indirectBuffer = make_shared<Buffer>(device);
+			if (indirect)
+			{
+				vector<VkDrawIndirectCommand> commands(draws, { 3, 1, 0, 0 });
+				indirectBuffer->init(commands.size() * sizeof(VkDrawIndirectCommand),
+				                     VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, memoryProperties, HOST_ACCESS_WRITE,
+				                     commands.data());
+				vkCmdDrawIndirect(cmdb->commandBuffer, indirectBuffer->buffer, 0, draws,
+				                  sizeof(VkDrawIndirectCommand));
+			}
+			else
+			{
+				for (uint32_t i = 0; i < draws; i++)
+					vkCmdDraw(cmdb->commandBuffer, 3, 1, 0, 0);
+			}
+			vkCmdEndRenderPass(cmdb->commandBuffer);
+			MPD_ASSERT_RESULT(vkEndCommandBuffer(cmdb->commandBuffer));
+
+			VkSubmitInfo submit = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+			submit.commandBufferCount = 1;
+			submit.pCommandBuffers = &cmdb->commandBuffer;
+			MPD_ASSERT_RESULT(vkQueueSubmit(queue, 1, &submit, VK_NULL_HANDLE));
+			MPD_ASSERT_RESULT(vkQueueWaitIdle(queue));
+		};
+
+		// Nothing is reported until enough draws were submitted for the pipeline to matter.
+		submitDraws(cfg.hiddenSurfaceRemovalDrawThreshold - 1);
+		if (getCount(MESSAGE_CODE_HIDDEN_SURFACE_REMOVAL_DISABLED) != 0)
+			return false;
+
+		submitDraws(1);
+		if (getCount(MESSAGE_CODE_HIDDEN_SURFACE_REMOVAL_DISABLED) != (blended ? 0u : 1u))
+			return false;
+
+		return true;
+	}
+};
+
+VulkanTestHelper *MPD::createTest()
+{
+	return new HiddenSurfaceRemovalTest;
+}
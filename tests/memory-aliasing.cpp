@@ -0,0 +1,125 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "vulkan_test.hpp"
+#include "perfdoc.hpp"
+#include "util.hpp"
+#include <memory>
+
+using namespace MPD;
+using namespace std;
+
+class MemoryAliasing : public VulkanTestHelper
+{
+	enum Variant
+	{
+		// Two render targets are used one after the other, they can share memory.
+		VARIANT_DISJOINT,
+		// The first render target is used again after the second one.
+		VARIANT_OVERLAPPING,
+		// The first render target loads what it held at the end of the previous frame.
+		VARIANT_READS_PREVIOUS_FRAME
+	};
+
+	bool runTest()
+	{
+		VULKAN_SYMBOL_WRAPPER_LOAD_DEVICE_EXTENSION_SYMBOL(device, vkQueuePresentKHR);
+		if (!vkQueuePresentKHR)
+			return false;
+
+		if (!testAliasing(VARIANT_DISJOINT))
+			return false;
+		if (!testAliasing(VARIANT_OVERLAPPING))
+			return false;
+		if (!testAliasing(VARIANT_READS_PREVIOUS_FRAME))
+			return false;
+
+		return true;
+	}
+
+	static void renderPass(VkCommandBuffer cmd, const Framebuffer &fb)
+	{
+		VkClearValue clearValue = {};
+		VkRenderPassBeginInfo rbi = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+		rbi.renderPass = fb.renderPass;
+		rbi.framebuffer = fb.framebuffer;
+		rbi.renderArea.extent.width = 256;
+		rbi.renderArea.extent.height = 256;
+		rbi.clearValueCount = 1;
+		rbi.pClearValues = &clearValue;
+		vkCmdBeginRenderPass(cmd, &rbi, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdEndRenderPass(cmd);
+	}
+
+	bool testAliasing(Variant variant)
+	{
+		resetCounts();
+
+		auto first = make_shared<Texture>(device);
+		first->initRenderTarget2D(256, 256, VK_FORMAT_R8G8B8A8_UNORM);
+		auto second = make_shared<Texture>(device);
+		second->initRenderTarget2D(256, 256, VK_FORMAT_R8G8B8A8_UNORM);
+
+		auto fbFirst = make_shared<Framebuffer>(device);
+		fbFirst->initOnlyColor(first, variant == VARIANT_READS_PREVIOUS_FRAME ? VK_ATTACHMENT_LOAD_OP_LOAD :
+		                                                                       VK_ATTACHMENT_LOAD_OP_CLEAR,
+		                       VK_ATTACHMENT_STORE_OP_STORE);
+		auto fbFirstAgain = make_shared<Framebuffer>(device);
+		fbFirstAgain->initOnlyColor(first, VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_STORE);
+		auto fbSecond = make_shared<Framebuffer>(device);
+		fbSecond->initOnlyColor(second, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
+
+		auto cmd = make_shared<CommandBuffer>(device);
+		cmd->initPrimary();
+
+		// Images only used in a single frame are not considered, it takes two frames to see the pattern.
+		// Image usage is only seen on the first submit of a recording, so the frame is recorded again every time.
+		for (unsigned frame = 0; frame < 2; frame++)
+		{
+			VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			MPD_ASSERT_RESULT(vkBeginCommandBuffer(cmd->commandBuffer, &beginInfo));
+			renderPass(cmd->commandBuffer, *fbFirst);
+			renderPass(cmd->commandBuffer, *fbSecond);
+			if (variant == VARIANT_OVERLAPPING)
+				renderPass(cmd->commandBuffer, *fbFirstAgain);
+			MPD_ASSERT_RESULT(vkEndCommandBuffer(cmd->commandBuffer));
+
+			VkSubmitInfo submit = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+			submit.commandBufferCount = 1;
+			submit.pCommandBuffers = &cmd->commandBuffer;
+			MPD_ASSERT_RESULT(vkQueueSubmit(queue, 1, &submit, VK_NULL_HANDLE));
+			vkQueueWaitIdle(queue);
+
+			VkPresentInfoKHR present = { VK_STRUCTURE_TYPE_PRESENT_INFO_KHR };
+			vkQueuePresentKHR(queue, &present);
+		}
+
+		if (variant == VARIANT_DISJOINT)
+			return getCount(MESSAGE_CODE_MEMORY_ALIASING_CANDIDATES) == 1;
+		else
+			return getCount(MESSAGE_CODE_MEMORY_ALIASING_CANDIDATES) == 0;
+	}
+};
+
+VulkanTestHelper *MPD::createTest()
+{
+	return new MemoryAliasing;
+}
@@ -35,6 +35,50 @@ class Multisampling : public VulkanTestHelper
 			return false;
 		if (!testMultisampledBlending())
 			return false;
+		if (!testTileBufferBudget())
+			return false;
+		return true;
+	}
+
+	bool testTileBufferBudget(VkFormat format, VkSampleCountFlagBits samples)
+	{
+		resetCounts();
+
+		VkAttachmentDescription attachment = {};
+		attachment.format = format;
+		attachment.samples = samples;
+		attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+		const VkAttachmentReference colorRef = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+		VkSubpassDescription subpass = {};
+		subpass.colorAttachmentCount = 1;
+		subpass.pColorAttachments = &colorRef;
+
+		VkRenderPassCreateInfo info = { VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+		info.attachmentCount = 1;
+		info.pAttachments = &attachment;
+		info.subpassCount = 1;
+		info.pSubpasses = &subpass;
+
+		VkRenderPass renderPass;
+		MPD_ASSERT_RESULT(vkCreateRenderPass(device, &info, nullptr, &renderPass));
+		vkDestroyRenderPass(device, renderPass, nullptr);
+
+		return getCount(MESSAGE_CODE_TILE_BUFFER_BUDGET_EXCEEDED) == 1;
+	}
+
+	bool testTileBufferBudget()
+	{
+		// 128 bits per pixel fits the default budget, 256 does not.
+		if (testTileBufferBudget(VK_FORMAT_R8G8B8A8_UNORM, VK_SAMPLE_COUNT_4_BIT))
+			return false;
+		if (!testTileBufferBudget(VK_FORMAT_R16G16B16A16_SFLOAT, VK_SAMPLE_COUNT_4_BIT))
+			return false;
 		return true;
 	}
 
@@ -0,0 +1,222 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "vulkan_test.hpp"
+#include "perfdoc.hpp"
+#include "util.hpp"
+#include <memory>
+#include <vector>
+
+using namespace MPD;
+using namespace std;
+
+static const uint32_t baseCode[] =
+#include "pipeline_layout.comp.inc"
+    ;
+
+static const uint32_t readUboCode[] =
+#include "pipeline_layout.ubo.comp.inc"
+    ;
+
+static const uint32_t secondSetCode[] =
+#include "pipeline_layout.set1.comp.inc"
+    ;
+
+// Run with pipeline-layout.cfg, which sets pipelineLayoutMergeableSetBindings to 4.
+class PipelineLayoutTest : public VulkanTestHelper
+{
+	bool runTest()
+	{
+		if (!testUnusedBinding(false))
+			return false;
+		if (!testUnusedBinding(true))
+			return false;
+
+		if (!testOversizedPushConstants(64))
+			return false;
+		if (!testOversizedPushConstants(16))
+			return false;
+
+		if (!testMergeableSets(true))
+			return false;
+		if (!testMergeableSets(false))
+			return false;
+
+		if (!testLayoutAliveAtDeviceDestruction())
+			return false;
+
+		return true;
+	}
+
+	VkDescriptorSetLayout createSetLayout(const vector<VkDescriptorType> &types)
+	{
+		vector<VkDescriptorSetLayoutBinding> bindings(types.size());
+		for (uint32_t i = 0; i < types.size(); i++)
+		{
+			bindings[i].binding = i;
+			bindings[i].descriptorType = types[i];
+			bindings[i].descriptorCount = 1;
+			bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		}
+
+		VkDescriptorSetLayoutCreateInfo info = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+		info.bindingCount = uint32_t(bindings.size());
+		info.pBindings = bindings.data();
+
+		VkDescriptorSetLayout setLayout;
+		MPD_ASSERT_RESULT(vkCreateDescriptorSetLayout(device, &info, nullptr, &setLayout));
+		return setLayout;
+	}
+
+	VkPipelineLayout createLayout(const vector<VkDescriptorSetLayout> &setLayouts, uint32_t pushConstantSize)
+	{
+		VkPushConstantRange range = { VK_SHADER_STAGE_COMPUTE_BIT, 0, pushConstantSize };
+
+		VkPipelineLayoutCreateInfo info = { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+		info.setLayoutCount = uint32_t(setLayouts.size());
+		info.pSetLayouts = setLayouts.data();
+		info.pushConstantRangeCount = 1;
+		info.pPushConstantRanges = &range;
+
+		VkPipelineLayout layout;
+		MPD_ASSERT_RESULT(vkCreatePipelineLayout(device, &info, nullptr, &layout));
+		return layout;
+	}
+
+	// The pipeline is destroyed right away, the layout keeps what its shader used.
+	void createPipeline(VkPipelineLayout layout, const uint32_t *code, size_t size)
+	{
+		Shader shader(device);
+		shader.init(code, size);
+
+		VkComputePipelineCreateInfo info = { VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+		info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		info.stage.module = shader.module;
+		info.stage.pName = "main";
+		info.layout = layout;
+
+		VkPipeline pipeline;
+		MPD_ASSERT_RESULT(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &info, nullptr, &pipeline));
+		vkDestroyPipeline(device, pipeline, nullptr);
+	}
+
+	// The uniform buffer binding is only unused if no pipeline created with the layout reads it.
+	bool testUnusedBinding(bool otherPipelineReadsIt)
+	{
+		resetCounts();
+
+		auto setLayout = createSetLayout({ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER });
+		auto layout = createLayout({ setLayout }, 16);
+
+		createPipeline(layout, baseCode, sizeof(baseCode));
+		if (otherPipelineReadsIt)
+			createPipeline(layout, readUboCode, sizeof(readUboCode));
+
+		// Nothing is reported before the layout is destroyed.
+		if (getCount(MESSAGE_CODE_PIPELINE_LAYOUT_UNUSED_BINDING) != 0)
+			return false;
+
+		vkDestroyPipelineLayout(device, layout, nullptr);
+		vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+
+		if (getCount(MESSAGE_CODE_PIPELINE_LAYOUT_UNUSED_BINDING) != (otherPipelineReadsIt ? 0u : 1u))
+			return false;
+		if (getCount(MESSAGE_CODE_PIPELINE_LAYOUT_OVERSIZED_PUSH_CONSTANTS) != 0)
+			return false;
+
+		return true;
+	}
+
+	// The shader reads 16 bytes of push constants.
+	bool testOversizedPushConstants(uint32_t pushConstantSize)
+	{
+		resetCounts();
+
+		auto setLayout = createSetLayout({ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER });
+		auto layout = createLayout({ setLayout }, pushConstantSize);
+
+		createPipeline(layout, baseCode, sizeof(baseCode));
+		createPipeline(layout, baseCode, sizeof(baseCode));
+
+		vkDestroyPipelineLayout(device, layout, nullptr);
+		vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+
+		if (getCount(MESSAGE_CODE_PIPELINE_LAYOUT_OVERSIZED_PUSH_CONSTANTS) != (pushConstantSize > 16 ? 1u : 0u))
+			return false;
+		if (getCount(MESSAGE_CODE_PIPELINE_LAYOUT_UNUSED_BINDING) != 0)
+			return false;
+
+		return true;
+	}
+
+	// Layouts which are still alive are reported when the device is destroyed.
+	bool testLayoutAliveAtDeviceDestruction()
+	{
+		resetCounts();
+
+		auto setLayout = createSetLayout({ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER });
+		auto layout = createLayout({ setLayout }, 16);
+		createPipeline(layout, baseCode, sizeof(baseCode));
+
+		destroyDevice();
+		createDevice();
+
+		return getCount(MESSAGE_CODE_PIPELINE_LAYOUT_UNUSED_BINDING) == 1;
+	}
+
+	// Two bindings in two sets could share one set, two bindings in one set are fine.
+	bool testMergeableSets(bool split)
+	{
+		resetCounts();
+
+		vector<VkDescriptorSetLayout> setLayouts;
+		if (split)
+		{
+			setLayouts.push_back(createSetLayout({ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER }));
+			setLayouts.push_back(createSetLayout({ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER }));
+		}
+		else
+			setLayouts.push_back(
+			    createSetLayout({ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER }));
+		auto layout = createLayout(setLayouts, 16);
+
+		if (split)
+			createPipeline(layout, secondSetCode, sizeof(secondSetCode));
+		else
+			createPipeline(layout, readUboCode, sizeof(readUboCode));
+
+		vkDestroyPipelineLayout(device, layout, nullptr);
+		for (auto setLayout : setLayouts)
+			vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+
+		if (getCount(MESSAGE_CODE_PIPELINE_LAYOUT_MERGEABLE_SETS) != (split ? 1u : 0u))
+			return false;
+		if (getCount(MESSAGE_CODE_PIPELINE_LAYOUT_UNUSED_BINDING) != 0)
+			return false;
+
+		return true;
+	}
+};
+
+VulkanTestHelper *MPD::createTest()
+{
+	return new PipelineLayoutTest;
+}
@@ -0,0 +1,90 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "vulkan_test.hpp"
+#include "perfdoc.hpp"
+#include "util.hpp"
+#include <memory>
+
+using namespace MPD;
+using namespace std;
+
+class PrecisionTest : public VulkanTestHelper
+{
+	bool runTest()
+	{
+		if (!testFragmentPrecision(true))
+			return false;
+		if (!testFragmentPrecision(false))
+			return false;
+
+		return true;
+	}
+
+	bool testFragmentPrecision(bool highp)
+	{
+		resetCounts();
+
+		static const uint32_t vertCode[] =
+#include "quad_no_attribs.vert.inc"
+		    ;
+
+		static const uint32_t highpCode[] =
+#include "precision.highp.frag.inc"
+		    ;
+
+		static const uint32_t mediumpCode[] =
+#include "precision.mediump.frag.inc"
+		    ;
+
+		auto tex = make_shared<Texture>(device);
+		tex->initRenderTarget2D(64, 64, VK_FORMAT_R8G8B8A8_UNORM);
+
+		auto fb = make_shared<Framebuffer>(device);
+		fb->initOnlyColor(tex);
+
+		VkGraphicsPipelineCreateInfo info = {};
+		info.renderPass = fb->renderPass;
+
+		auto pipeline = make_shared<Pipeline>(device);
+		if (highp)
+			pipeline->initGraphics(vertCode, sizeof(vertCode), highpCode, sizeof(highpCode), &info);
+		else
+			pipeline->initGraphics(vertCode, sizeof(vertCode), mediumpCode, sizeof(mediumpCode), &info);
+
+		if (getCount(MESSAGE_CODE_FULL_PRECISION_FRAGMENT_SHADER) != (highp ? 1u : 0u))
+			return false;
+
+		// The analysis is cached per module and entry point, another pipeline with the same shader stays quiet.
+		info.layout = pipeline->pipelineLayout;
+		auto samePipeline = make_shared<Pipeline>(device);
+		samePipeline->initGraphics(pipeline->shaders[0], pipeline->shaders[1], &info);
+
+		if (getCount(MESSAGE_CODE_FULL_PRECISION_FRAGMENT_SHADER) != (highp ? 1u : 0u))
+			return false;
+
+		return true;
+	}
+};
+
+VulkanTestHelper *MPD::createTest()
+{
+	return new PrecisionTest;
+}
@@ -0,0 +1,275 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "perfdoc.hpp"
+#include "util/util.hpp"
+#include "vulkan_test.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+using namespace MPD;
+using namespace std;
+
+// End-to-end scaling benchmark.
+// A fixed amount of command buffers is recorded concurrently on 1..N threads, each thread owning its own
+// command pool, while a dedicated thread submits command buffers as soon as they are recorded.
+// The same workload is run with the layer enabled and disabled so the overhead and the speedup curve
+// can be compared directly.
+class RecordingScalabilityBenchmark : public VulkanTestHelper
+{
+public:
+	static const unsigned commandBufferCount = 64;
+	static const unsigned renderPassesPerCommandBuffer = 8;
+	static const unsigned drawsPerRenderPass = 512;
+	static const unsigned drawsPerPipelineBind = 16;
+	static const unsigned iterations = 3;
+
+	explicit RecordingScalabilityBenchmark(bool enablePerfDocLayer)
+	    : VulkanTestHelper(enablePerfDocLayer)
+	{
+	}
+
+	static unsigned getMaxThreadCount()
+	{
+		return max(1u, min(8u, thread::hardware_concurrency()));
+	}
+
+	// Returns the best observed recording + submission time in seconds for each thread count in 1..maxThreads.
+	vector<double> measure(unsigned maxThreads)
+	{
+		setupResources();
+
+		vector<double> results;
+		for (unsigned threads = 1; threads <= maxThreads; threads++)
+		{
+			double best = 0.0;
+			for (unsigned i = 0; i < iterations; i++)
+			{
+				double t = runIteration(threads);
+				if (i == 0 || t < best)
+					best = t;
+			}
+			results.push_back(best);
+		}
+
+		return results;
+	}
+
+	bool runTest()
+	{
+		const unsigned maxThreads = getMaxThreadCount();
+		const double drawCount =
+		    double(commandBufferCount) * double(renderPassesPerCommandBuffer) * double(drawsPerRenderPass);
+
+		auto withLayer = measure(maxThreads);
+
+		vector<double> withoutLayer;
+		{
+			RecordingScalabilityBenchmark baseline(false);
+			withoutLayer = baseline.measure(maxThreads);
+		}
+
+		printf("Recording %u command buffers, %u render passes each, %u draws per render pass.\n", commandBufferCount,
+		       renderPassesPerCommandBuffer, drawsPerRenderPass);
+		printf("%8s %16s %10s %16s %10s %10s\n", "threads", "layer draws/s", "speedup", "no-layer draws/s", "speedup",
+		       "overhead");
+
+		for (unsigned i = 0; i < maxThreads; i++)
+		{
+			double layerThroughput = drawCount / withLayer[i];
+			double baseThroughput = drawCount / withoutLayer[i];
+			printf("%8u %16.0f %9.2fx %16.0f %9.2fx %9.2fx\n", i + 1, layerThroughput, withLayer[0] / withLayer[i],
+			       baseThroughput, withoutLayer[0] / withoutLayer[i], withLayer[i] / withoutLayer[i]);
+		}
+
+		return true;
+	}
+
+private:
+	shared_ptr<Framebuffer> fb;
+	shared_ptr<Pipeline> pipelines[2];
+	shared_ptr<Buffer> indexBuffer;
+	uint32_t width = 64, height = 64;
+
+	void setupResources()
+	{
+		if (fb)
+			return;
+
+		auto tex = make_shared<Texture>(device);
+		tex->initRenderTarget2D(width, height, VK_FORMAT_R8G8B8A8_UNORM);
+
+		fb = make_shared<Framebuffer>(device);
+		fb->initOnlyColor(tex);
+
+		static const uint32_t vertCode[] =
+#include "quad_no_attribs.vert.inc"
+		    ;
+
+		static const uint32_t fragCode[] =
+#include "quad.frag.inc"
+		    ;
+
+		VkGraphicsPipelineCreateInfo info = {};
+		info.renderPass = fb->renderPass;
+
+		for (auto &pipeline : pipelines)
+		{
+			pipeline = make_shared<Pipeline>(device);
+			pipeline->initGraphics(vertCode, sizeof(vertCode), fragCode, sizeof(fragCode), &info);
+		}
+
+		static const uint16_t indices[] = { 0, 1, 2, 3, 4, 5 };
+		indexBuffer = make_shared<Buffer>(device);
+		indexBuffer->init(sizeof(indices), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, memoryProperties, HOST_ACCESS_WRITE,
+		                  const_cast<uint16_t *>(indices));
+	}
+
+	void record(VkCommandBuffer cmd)
+	{
+		VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, nullptr,
+			                                   VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, nullptr };
+		MPD_ASSERT_RESULT(vkBeginCommandBuffer(cmd, &beginInfo));
+
+		VkClearValue clearValue = {};
+		VkRenderPassBeginInfo rpInfo = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+		rpInfo.renderPass = fb->renderPass;
+		rpInfo.framebuffer = fb->framebuffer;
+		rpInfo.renderArea.extent.width = width;
+		rpInfo.renderArea.extent.height = height;
+		rpInfo.clearValueCount = 1;
+		rpInfo.pClearValues = &clearValue;
+
+		VkViewport vp = { 0.0f, 0.0f, float(width), float(height), 0.0f, 1.0f };
+		vkCmdSetViewport(cmd, 0, 1, &vp);
+
+		for (unsigned pass = 0; pass < renderPassesPerCommandBuffer; pass++)
+		{
+			vkCmdBeginRenderPass(cmd, &rpInfo, VK_SUBPASS_CONTENTS_INLINE);
+			vkCmdBindIndexBuffer(cmd, indexBuffer->buffer, 0, VK_INDEX_TYPE_UINT16);
+
+			for (unsigned draw = 0; draw < drawsPerRenderPass; draw++)
+			{
+				if ((draw % drawsPerPipelineBind) == 0)
+				{
+					unsigned index = (draw / drawsPerPipelineBind) & 1;
+					vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines[index]->pipeline);
+				}
+
+				if (draw & 1)
+					vkCmdDrawIndexed(cmd, 6, 1, 0, 0, 0);
+				else
+					vkCmdDraw(cmd, 3, 1, 0, 0);
+			}
+
+			vkCmdEndRenderPass(cmd);
+		}
+
+		MPD_ASSERT_RESULT(vkEndCommandBuffer(cmd));
+	}
+
+	double runIteration(unsigned threadCount)
+	{
+		vector<VkCommandPool> pools(threadCount);
+		vector<vector<VkCommandBuffer>> commandBuffers(threadCount);
+
+		for (unsigned i = 0; i < threadCount; i++)
+		{
+			VkCommandPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO, nullptr,
+				                                 VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, 0 };
+			MPD_ASSERT_RESULT(vkCreateCommandPool(device, &poolInfo, nullptr, &pools[i]));
+
+			// Distribute the fixed workload evenly, first threads take the remainder.
+			unsigned count = commandBufferCount / threadCount + (i < (commandBufferCount % threadCount) ? 1 : 0);
+			commandBuffers[i].resize(count);
+			if (count)
+			{
+				VkCommandBufferAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO, nullptr,
+					                                      pools[i], VK_COMMAND_BUFFER_LEVEL_PRIMARY, count };
+				MPD_ASSERT_RESULT(vkAllocateCommandBuffers(device, &allocInfo, commandBuffers[i].data()));
+			}
+		}
+
+		mutex lock;
+		condition_variable cond;
+		deque<VkCommandBuffer> pending;
+		unsigned submitted = 0;
+
+		auto start = chrono::steady_clock::now();
+
+		// Only the submission thread touches the queue.
+		thread submitter([&]() {
+			while (submitted < commandBufferCount)
+			{
+				vector<VkCommandBuffer> batch;
+				{
+					unique_lock<mutex> holder{ lock };
+					cond.wait(holder, [&]() { return !pending.empty(); });
+					batch.assign(pending.begin(), pending.end());
+					pending.clear();
+				}
+
+				VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+				submitInfo.commandBufferCount = uint32_t(batch.size());
+				submitInfo.pCommandBuffers = batch.data();
+				MPD_ASSERT_RESULT(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
+				submitted += unsigned(batch.size());
+			}
+		});
+
+		vector<thread> workers;
+		for (unsigned i = 0; i < threadCount; i++)
+		{
+			workers.emplace_back([&, i]() {
+				for (auto cmd : commandBuffers[i])
+				{
+					record(cmd);
+
+					lock_guard<mutex> holder{ lock };
+					pending.push_back(cmd);
+					cond.notify_one();
+				}
+			});
+		}
+
+		for (auto &worker : workers)
+			worker.join();
+		submitter.join();
+
+		auto end = chrono::steady_clock::now();
+
+		MPD_ASSERT_RESULT(vkQueueWaitIdle(queue));
+		for (auto pool : pools)
+			vkDestroyCommandPool(device, pool, nullptr);
+
+		return chrono::duration<double>(end - start).count();
+	}
+};
+
+VulkanTestHelper *MPD::createTest()
+{
+	return new RecordingScalabilityBenchmark(true);
+}
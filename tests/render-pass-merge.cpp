@@ -0,0 +1,147 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "vulkan_test.hpp"
+#include "perfdoc.hpp"
+#include "util.hpp"
+#include <memory>
+
+using namespace MPD;
+using namespace std;
+
+class RenderPassMerge : public VulkanTestHelper
+{
+	bool runTest()
+	{
+		if (!testMerge(true, true))
+			return false;
+		if (!testMerge(false, true))
+			return false;
+		if (!testMerge(true, false))
+			return false;
+
+		return true;
+	}
+
+	static void beginRenderPass(VkCommandBuffer cmd, const Framebuffer &fb, uint32_t width, uint32_t height)
+	{
+		VkClearValue clearValue = {};
+		VkRenderPassBeginInfo rbi = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+		rbi.renderPass = fb.renderPass;
+		rbi.framebuffer = fb.framebuffer;
+		rbi.renderArea.extent.width = width;
+		rbi.renderArea.extent.height = height;
+		rbi.clearValueCount = 1;
+		rbi.pClearValues = &clearValue;
+		vkCmdBeginRenderPass(cmd, &rbi, VK_SUBPASS_CONTENTS_INLINE);
+	}
+
+	void submit(const CommandBuffer &cmd)
+	{
+		VkSubmitInfo submit = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+		submit.commandBufferCount = 1;
+		submit.pCommandBuffers = &cmd.commandBuffer;
+		MPD_ASSERT_RESULT(vkQueueSubmit(queue, 1, &submit, VK_NULL_HANDLE));
+		vkQueueWaitIdle(queue);
+	}
+
+	// A render pass stores an attachment which the next render pass samples.
+	// This can only be merged if both run at the same resolution, and the advisor only looks within a submission.
+	bool testMerge(bool sameResolution, bool sameSubmit)
+	{
+		resetCounts();
+
+		static const uint32_t vertCode[] =
+#include "quad_no_attribs.vert.inc"
+		    ;
+
+		static const uint32_t fragCode[] =
+#include "quad_sampler.frag.inc"
+		    ;
+
+		const VkFormat FMT = VK_FORMAT_R8G8B8A8_UNORM;
+		const uint32_t WIDTH = 64, HEIGHT = 64;
+		const uint32_t secondWidth = sameResolution ? WIDTH : WIDTH / 2;
+		const uint32_t secondHeight = sameResolution ? HEIGHT : HEIGHT / 2;
+
+		auto stored = make_shared<Texture>(device);
+		stored->initRenderTarget2D(WIDTH, HEIGHT, FMT);
+		auto target = make_shared<Texture>(device);
+		target->initRenderTarget2D(secondWidth, secondHeight, FMT);
+
+		auto fbStored = make_shared<Framebuffer>(device);
+		fbStored->initOnlyColor(stored, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
+		auto fbTarget = make_shared<Framebuffer>(device);
+		fbTarget->initOnlyColor(target, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
+
+		VkGraphicsPipelineCreateInfo pi = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+		pi.renderPass = fbTarget->renderPass;
+		auto pipeline = make_shared<Pipeline>(device);
+		pipeline->initGraphics(vertCode, sizeof(vertCode), fragCode, sizeof(fragCode), &pi);
+
+		auto descriptors = make_shared<SampledImageDescriptorSet>(device);
+		descriptors->init(pipeline->descriptorSetLayout, stored->view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		auto first = make_shared<CommandBuffer>(device);
+		first->initPrimary();
+		auto second = sameSubmit ? first : make_shared<CommandBuffer>(device);
+		if (!sameSubmit)
+			second->initPrimary();
+
+		MPD_ASSERT_RESULT(vkBeginCommandBuffer(first->commandBuffer, &beginInfo));
+		beginRenderPass(first->commandBuffer, *fbStored, WIDTH, HEIGHT);
+		vkCmdEndRenderPass(first->commandBuffer);
+
+		if (!sameSubmit)
+		{
+			MPD_ASSERT_RESULT(vkEndCommandBuffer(first->commandBuffer));
+			submit(*first);
+			MPD_ASSERT_RESULT(vkBeginCommandBuffer(second->commandBuffer, &beginInfo));
+		}
+
+		auto vkcmd = second->commandBuffer;
+		beginRenderPass(vkcmd, *fbTarget, secondWidth, secondHeight);
+		vkCmdBindPipeline(vkcmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipeline);
+		vkCmdBindDescriptorSets(vkcmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipelineLayout, 0, 1,
+		                        &descriptors->set, 0, nullptr);
+
+		VkViewport viewport = { 0.0f, 0.0f, float(secondWidth), float(secondHeight), 0.0f, 1.0f };
+		VkRect2D scissor = { { 0, 0 }, { secondWidth, secondHeight } };
+		vkCmdSetViewport(vkcmd, 0, 1, &viewport);
+		vkCmdSetScissor(vkcmd, 0, 1, &scissor);
+		vkCmdDraw(vkcmd, 3, 1, 0, 0);
+		vkCmdEndRenderPass(vkcmd);
+		MPD_ASSERT_RESULT(vkEndCommandBuffer(vkcmd));
+		submit(*second);
+
+		if (sameResolution && sameSubmit)
+			return getCount(MESSAGE_CODE_RENDER_PASS_MERGE_CANDIDATE) == 1;
+		else
+			return getCount(MESSAGE_CODE_RENDER_PASS_MERGE_CANDIDATE) == 0;
+	}
+};
+
+VulkanTestHelper *MPD::createTest()
+{
+	return new RenderPassMerge;
+}
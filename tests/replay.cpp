@@ -0,0 +1,1649 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "capture_format.hpp"
+#include "perfdoc.hpp"
+#include "vulkan_test.hpp"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace MPD;
+using namespace std;
+
+// Replays a capture written by the layer (see captureFilename in the config) against the PerfDoc layer.
+// This makes it possible to reproduce diagnostics and to A/B layer changes on real application workloads
+// without having the application around.
+//
+// The capture file is given in MALI_PERFDOC_REPLAY_FILE.
+// Set MALI_PERFDOC_REPLAY_NO_LAYER to replay without the layer to get a baseline time.
+
+// Read-only memory mapping of the whole capture file.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile &) = delete;
+	void operator=(const MappedFile &) = delete;
+
+	~MappedFile()
+	{
+#ifdef _WIN32
+		if (data)
+			UnmapViewOfFile(data);
+		if (mapping)
+			CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+#else
+		if (data)
+			munmap(const_cast<uint8_t *>(data), size);
+		if (fd >= 0)
+			close(fd);
+#endif
+	}
+
+	bool open(const char *path)
+	{
+#ifdef _WIN32
+		file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+			return false;
+		size = size_t(fileSize.QuadPart);
+
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mapping)
+			return false;
+
+		data = static_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+		fd = ::open(path, O_RDONLY);
+		if (fd < 0)
+			return false;
+
+		struct stat s;
+		if (fstat(fd, &s) < 0 || s.st_size == 0)
+			return false;
+		size = size_t(s.st_size);
+
+		void *ptr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (ptr == MAP_FAILED)
+			return false;
+		data = static_cast<const uint8_t *>(ptr);
+#endif
+		return data != nullptr;
+	}
+
+	const uint8_t *getData() const
+	{
+		return data;
+	}
+
+	size_t getSize() const
+	{
+		return size;
+	}
+
+private:
+	const uint8_t *data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#else
+	int fd = -1;
+#endif
+};
+
+// Decodes the payload of a single record, mirroring the helpers in CaptureWriter.
+// Data in the mapping is not necessarily aligned, so everything is copied out with memcpy.
+class RecordReader
+{
+public:
+	RecordReader(const uint8_t *data, size_t size)
+	    : data(data)
+	    , size(size)
+	{
+	}
+
+	bool isValid() const
+	{
+		return !overflow;
+	}
+
+	void readRaw(void *dst, size_t count)
+	{
+		if (overflow || count > size - offset)
+		{
+			overflow = true;
+			memset(dst, 0, count);
+			return;
+		}
+
+		memcpy(dst, data + offset, count);
+		offset += count;
+	}
+
+	template <typename T>
+	T read()
+	{
+		T value;
+		readRaw(&value, sizeof(T));
+		return value;
+	}
+
+	uint64_t readHandle()
+	{
+		return read<uint64_t>();
+	}
+
+	template <typename T>
+	vector<T> readArray()
+	{
+		return readArray<T>(read<uint32_t>());
+	}
+
+	template <typename T>
+	vector<T> readArray(uint32_t count)
+	{
+		if (overflow || count > (size - offset) / sizeof(T))
+		{
+			overflow = true;
+			return {};
+		}
+
+		vector<T> values(count);
+		if (count)
+			readRaw(values.data(), count * sizeof(T));
+		return values;
+	}
+
+	vector<uint64_t> readHandleArray()
+	{
+		return readArray<uint64_t>();
+	}
+
+	vector<uint8_t> readBlob()
+	{
+		return readArray<uint8_t>();
+	}
+
+private:
+	const uint8_t *data;
+	size_t size;
+	size_t offset = 0;
+	bool overflow = false;
+};
+
+// Maps handles from the capture to the objects created during replay.
+template <typename T>
+class HandleMap
+{
+public:
+	void set(uint64_t captured, T handle)
+	{
+		if (captured)
+			handles[captured] = handle;
+	}
+
+	T get(uint64_t captured) const
+	{
+		auto itr = handles.find(captured);
+		return itr != end(handles) ? itr->second : T(VK_NULL_HANDLE);
+	}
+
+	T remove(uint64_t captured)
+	{
+		auto itr = handles.find(captured);
+		if (itr == end(handles))
+			return T(VK_NULL_HANDLE);
+
+		T handle = itr->second;
+		handles.erase(itr);
+		return handle;
+	}
+
+	unordered_map<uint64_t, T> handles;
+};
+
+class CaptureReplay : public VulkanTestHelper
+{
+public:
+	CaptureReplay(const char *path, bool enablePerfDocLayer)
+	    : VulkanTestHelper(enablePerfDocLayer)
+	    , path(path)
+	{
+	}
+
+	bool runTest()
+	{
+		MappedFile file;
+		if (!file.open(path))
+		{
+			fprintf(stderr, "Failed to map capture file %s.\n", path);
+			return false;
+		}
+
+		const uint8_t *data = file.getData();
+		size_t size = file.getSize();
+
+		CaptureFileHeader header;
+		if (size < sizeof(header))
+		{
+			fprintf(stderr, "Capture file is truncated.\n");
+			return false;
+		}
+
+		memcpy(&header, data, sizeof(header));
+		if (header.magic != CAPTURE_MAGIC || header.version != CAPTURE_VERSION)
+		{
+			fprintf(stderr, "Capture file has wrong magic or version.\n");
+			return false;
+		}
+
+		size_t offset = sizeof(header);
+		unsigned recordCount = 0;
+		auto start = chrono::steady_clock::now();
+
+		while (offset + sizeof(CaptureRecordHeader) <= size)
+		{
+			CaptureRecordHeader record;
+			memcpy(&record, data + offset, sizeof(record));
+			offset += sizeof(record);
+
+			if (record.size > size - offset)
+			{
+				fprintf(stderr, "Capture file is truncated in record %u.\n", recordCount);
+				break;
+			}
+
+			RecordReader reader(data + offset, record.size);
+			if (!replayRecord(CaptureOp(record.op), reader) || !reader.isValid())
+			{
+				fprintf(stderr, "Failed to replay record %u (op %u).\n", recordCount, record.op);
+				return false;
+			}
+
+			offset += record.size;
+			recordCount++;
+		}
+
+		MPD_ASSERT_RESULT(vkDeviceWaitIdle(device));
+		auto end = chrono::steady_clock::now();
+
+		cleanup();
+
+		printf("Replayed %u records (%u submissions) in %.3f ms.\n", recordCount, submitCount,
+		       chrono::duration<double, milli>(end - start).count());
+		if (memoryFallbackCount)
+			printf("%u resources needed dedicated memory to satisfy replay device requirements.\n", memoryFallbackCount);
+		if (skippedCount)
+			printf("%u records referenced objects which are not part of the capture and were skipped.\n",
+			       skippedCount);
+
+		for (unsigned code = 0; code < MESSAGE_CODE_COUNT; code++)
+			if (warningCount[code])
+				printf("Message code %2u: %u\n", code, warningCount[code]);
+
+		return true;
+	}
+
+private:
+	const char *path;
+
+	struct Memory
+	{
+		VkDeviceSize size;
+		VkMemoryPropertyFlags flags;
+		VkDeviceMemory memory;
+		VkDeviceSize allocatedSize;
+		uint32_t memoryTypeIndex;
+		void *mapped;
+	};
+
+	struct BufferBinding
+	{
+		VkDeviceMemory memory;
+		VkDeviceSize offset;
+		void *mapped;
+	};
+
+	HandleMap<VkQueue> queues;
+	unordered_map<uint64_t, Memory> memories;
+	HandleMap<VkBuffer> buffers;
+	HandleMap<VkImage> images;
+	HandleMap<VkImageView> imageViews;
+	HandleMap<VkSampler> samplers;
+	HandleMap<VkShaderModule> shaderModules;
+	HandleMap<VkRenderPass> renderPasses;
+	HandleMap<VkFramebuffer> framebuffers;
+	HandleMap<VkDescriptorSetLayout> setLayouts;
+	HandleMap<VkPipelineLayout> pipelineLayouts;
+	HandleMap<VkPipeline> pipelines;
+	HandleMap<VkDescriptorPool> descriptorPools;
+	HandleMap<VkDescriptorSet> descriptorSets;
+	HandleMap<VkCommandPool> commandPools;
+	HandleMap<VkCommandBuffer> commandBuffers;
+
+	// Memory which the replay allocated on its own, freed together with the resource.
+	unordered_map<uint64_t, VkDeviceMemory> dedicatedBufferMemory;
+	unordered_map<uint64_t, VkDeviceMemory> dedicatedImageMemory;
+	unordered_map<uint64_t, BufferBinding> bufferBindings;
+
+	unsigned submitCount = 0;
+	unsigned memoryFallbackCount = 0;
+	unsigned skippedCount = 0;
+
+	uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags flags) const
+	{
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+			if ((typeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & flags) == flags)
+				return i;
+
+		// Fall back to anything which is compatible with the resource.
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+			if (typeBits & (1u << i))
+				return i;
+
+		return ~0u;
+	}
+
+	static VkImageLayout patchLayout(VkImageLayout layout)
+	{
+		// There is no swapchain during replay.
+		return layout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR ? VK_IMAGE_LAYOUT_GENERAL : layout;
+	}
+
+	// Memory type indices are not portable, so the real allocation is deferred until the first resource is bound
+	// and we know its requirements. If a later resource cannot live in the same allocation on this device,
+	// it gets a dedicated allocation instead.
+	bool bindMemory(const VkMemoryRequirements &reqs, uint64_t capturedMemory, VkDeviceSize offset,
+	                VkDeviceMemory &memory, VkDeviceSize &boundOffset, VkDeviceMemory &dedicated)
+	{
+		dedicated = VK_NULL_HANDLE;
+
+		auto itr = memories.find(capturedMemory);
+		if (itr == end(memories))
+			return false;
+
+		auto &mem = itr->second;
+		if (mem.memory == VK_NULL_HANDLE)
+		{
+			VkMemoryAllocateInfo info = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+			info.allocationSize = max(mem.size, offset + reqs.size);
+			info.memoryTypeIndex = findMemoryType(reqs.memoryTypeBits, mem.flags);
+			if (info.memoryTypeIndex == ~0u || vkAllocateMemory(device, &info, nullptr, &mem.memory) != VK_SUCCESS)
+				return false;
+
+			mem.allocatedSize = info.allocationSize;
+			mem.memoryTypeIndex = info.memoryTypeIndex;
+		}
+
+		bool compatible = (reqs.memoryTypeBits & (1u << mem.memoryTypeIndex)) != 0 &&
+		                  (offset % reqs.alignment) == 0 && offset + reqs.size <= mem.allocatedSize;
+
+		if (compatible)
+		{
+			memory = mem.memory;
+			boundOffset = offset;
+			return true;
+		}
+
+		VkMemoryAllocateInfo info = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+		info.allocationSize = reqs.size;
+		info.memoryTypeIndex = findMemoryType(reqs.memoryTypeBits, mem.flags);
+		if (info.memoryTypeIndex == ~0u || vkAllocateMemory(device, &info, nullptr, &dedicated) != VK_SUCCESS)
+			return false;
+
+		memoryFallbackCount++;
+		memory = dedicated;
+		boundOffset = 0;
+		return true;
+	}
+
+	void *mapMemory(VkDeviceMemory memory)
+	{
+		for (auto &mem : memories)
+		{
+			if (mem.second.memory == memory)
+			{
+				auto &flags = memoryProperties.memoryTypes[mem.second.memoryTypeIndex].propertyFlags;
+				if (!mem.second.mapped && (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+					vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &mem.second.mapped);
+				return mem.second.mapped;
+			}
+		}
+
+		return nullptr;
+	}
+
+	struct ShaderStage
+	{
+		VkPipelineShaderStageCreateInfo info;
+		string name;
+		vector<VkSpecializationMapEntry> mapEntries;
+		vector<uint8_t> specData;
+		VkSpecializationInfo spec;
+	};
+
+	void readShaderStage(RecordReader &reader, ShaderStage &stage)
+	{
+		stage.info = { VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO };
+		stage.info.flags = reader.read<VkPipelineShaderStageCreateFlags>();
+		stage.info.stage = reader.read<VkShaderStageFlagBits>();
+		stage.info.module = shaderModules.get(reader.readHandle());
+
+		auto name = reader.readBlob();
+		stage.name = name.empty() ? string("main") : string(reinterpret_cast<const char *>(name.data()));
+		stage.mapEntries = reader.readArray<VkSpecializationMapEntry>();
+		stage.specData = reader.readBlob();
+	}
+
+	void finalizeShaderStage(ShaderStage &stage)
+	{
+		stage.info.pName = stage.name.c_str();
+		if (!stage.mapEntries.empty() || !stage.specData.empty())
+		{
+			stage.spec.mapEntryCount = uint32_t(stage.mapEntries.size());
+			stage.spec.pMapEntries = stage.mapEntries.data();
+			stage.spec.dataSize = stage.specData.size();
+			stage.spec.pData = stage.specData.data();
+			stage.info.pSpecializationInfo = &stage.spec;
+		}
+	}
+
+	bool createGraphicsPipeline(RecordReader &reader)
+	{
+		uint64_t captured = reader.readHandle();
+
+		VkGraphicsPipelineCreateInfo info = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+		info.flags = reader.read<VkPipelineCreateFlags>();
+
+		vector<ShaderStage> stages(reader.read<uint32_t>());
+		for (auto &stage : stages)
+			readShaderStage(reader, stage);
+
+		vector<VkPipelineShaderStageCreateInfo> stageInfos;
+		for (auto &stage : stages)
+		{
+			finalizeShaderStage(stage);
+			stageInfos.push_back(stage.info);
+		}
+		info.stageCount = uint32_t(stageInfos.size());
+		info.pStages = stageInfos.data();
+
+		VkPipelineVertexInputStateCreateInfo vertexInput = {
+			VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO
+		};
+		vector<VkVertexInputBindingDescription> vertexBindings;
+		vector<VkVertexInputAttributeDescription> vertexAttributes;
+		if (reader.read<uint32_t>())
+		{
+			vertexBindings = reader.readArray<VkVertexInputBindingDescription>();
+			vertexAttributes = reader.readArray<VkVertexInputAttributeDescription>();
+			vertexInput.vertexBindingDescriptionCount = uint32_t(vertexBindings.size());
+			vertexInput.pVertexBindingDescriptions = vertexBindings.data();
+			vertexInput.vertexAttributeDescriptionCount = uint32_t(vertexAttributes.size());
+			vertexInput.pVertexAttributeDescriptions = vertexAttributes.data();
+			info.pVertexInputState = &vertexInput;
+		}
+
+		VkPipelineInputAssemblyStateCreateInfo inputAssembly;
+		if (reader.read<uint32_t>())
+		{
+			inputAssembly = reader.read<VkPipelineInputAssemblyStateCreateInfo>();
+			info.pInputAssemblyState = &inputAssembly;
+		}
+
+		VkPipelineTessellationStateCreateInfo tessellation;
+		if (reader.read<uint32_t>())
+		{
+			tessellation = reader.read<VkPipelineTessellationStateCreateInfo>();
+			info.pTessellationState = &tessellation;
+		}
+
+		VkPipelineViewportStateCreateInfo viewport = { VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO };
+		vector<VkViewport> viewports;
+		vector<VkRect2D> scissors;
+		if (reader.read<uint32_t>())
+		{
+			viewport.viewportCount = reader.read<uint32_t>();
+			viewport.scissorCount = reader.read<uint32_t>();
+			viewports = reader.readArray<VkViewport>();
+			scissors = reader.readArray<VkRect2D>();
+			viewport.pViewports = viewports.empty() ? nullptr : viewports.data();
+			viewport.pScissors = scissors.empty() ? nullptr : scissors.data();
+			info.pViewportState = &viewport;
+		}
+
+		VkPipelineRasterizationStateCreateInfo rasterization;
+		if (reader.read<uint32_t>())
+		{
+			rasterization = reader.read<VkPipelineRasterizationStateCreateInfo>();
+			info.pRasterizationState = &rasterization;
+		}
+
+		VkPipelineMultisampleStateCreateInfo multisample;
+		vector<VkSampleMask> sampleMask;
+		if (reader.read<uint32_t>())
+		{
+			multisample = reader.read<VkPipelineMultisampleStateCreateInfo>();
+			sampleMask = reader.readArray<VkSampleMask>();
+			multisample.pSampleMask = sampleMask.empty() ? nullptr : sampleMask.data();
+			info.pMultisampleState = &multisample;
+		}
+
+		VkPipelineDepthStencilStateCreateInfo depthStencil;
+		if (reader.read<uint32_t>())
+		{
+			depthStencil = reader.read<VkPipelineDepthStencilStateCreateInfo>();
+			info.pDepthStencilState = &depthStencil;
+		}
+
+		VkPipelineColorBlendStateCreateInfo colorBlend;
+		vector<VkPipelineColorBlendAttachmentState> blendAttachments;
+		if (reader.read<uint32_t>())
+		{
+			colorBlend = reader.read<VkPipelineColorBlendStateCreateInfo>();
+			blendAttachments = reader.readArray<VkPipelineColorBlendAttachmentState>();
+			colorBlend.attachmentCount = uint32_t(blendAttachments.size());
+			colorBlend.pAttachments = blendAttachments.data();
+			info.pColorBlendState = &colorBlend;
+		}
+
+		VkPipelineDynamicStateCreateInfo dynamic = { VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
+		auto dynamicStates = reader.readArray<VkDynamicState>();
+		if (!dynamicStates.empty())
+		{
+			dynamic.dynamicStateCount = uint32_t(dynamicStates.size());
+			dynamic.pDynamicStates = dynamicStates.data();
+			info.pDynamicState = &dynamic;
+		}
+
+		info.layout = pipelineLayouts.get(reader.readHandle());
+		info.renderPass = renderPasses.get(reader.readHandle());
+		info.subpass = reader.read<uint32_t>();
+
+		if (!reader.isValid())
+			return false;
+
+		VkPipeline pipeline;
+		if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &info, nullptr, &pipeline) != VK_SUCCESS)
+			return false;
+		pipelines.set(captured, pipeline);
+		return true;
+	}
+
+	bool createRenderPass(RecordReader &reader)
+	{
+		struct Subpass
+		{
+			VkSubpassDescription desc;
+			vector<VkAttachmentReference> inputs, colors, resolves, depthStencil;
+			vector<uint32_t> preserves;
+		};
+
+		uint64_t captured = reader.readHandle();
+		VkRenderPassCreateInfo info = { VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+		info.flags = reader.read<VkRenderPassCreateFlags>();
+
+		auto attachments = reader.readArray<VkAttachmentDescription>();
+		for (auto &att : attachments)
+		{
+			att.initialLayout = patchLayout(att.initialLayout);
+			att.finalLayout = patchLayout(att.finalLayout);
+		}
+
+		vector<Subpass> subpasses(reader.read<uint32_t>());
+		vector<VkSubpassDescription> descs;
+		for (auto &subpass : subpasses)
+		{
+			subpass.desc = {};
+			subpass.desc.flags = reader.read<VkSubpassDescriptionFlags>();
+			subpass.desc.pipelineBindPoint = reader.read<VkPipelineBindPoint>();
+			subpass.inputs = reader.readArray<VkAttachmentReference>();
+			subpass.colors = reader.readArray<VkAttachmentReference>();
+			subpass.resolves = reader.readArray<VkAttachmentReference>();
+			subpass.depthStencil = reader.readArray<VkAttachmentReference>();
+			subpass.preserves = reader.readArray<uint32_t>();
+
+			subpass.desc.inputAttachmentCount = uint32_t(subpass.inputs.size());
+			subpass.desc.pInputAttachments = subpass.inputs.data();
+			subpass.desc.colorAttachmentCount = uint32_t(subpass.colors.size());
+			subpass.desc.pColorAttachments = subpass.colors.data();
+			subpass.desc.pResolveAttachments = subpass.resolves.empty() ? nullptr : subpass.resolves.data();
+			subpass.desc.pDepthStencilAttachment =
+			    subpass.depthStencil.empty() ? nullptr : subpass.depthStencil.data();
+			subpass.desc.preserveAttachmentCount = uint32_t(subpass.preserves.size());
+			subpass.desc.pPreserveAttachments = subpass.preserves.data();
+			descs.push_back(subpass.desc);
+		}
+
+		auto dependencies = reader.readArray<VkSubpassDependency>();
+		if (!reader.isValid())
+			return false;
+
+		info.attachmentCount = uint32_t(attachments.size());
+		info.pAttachments = attachments.data();
+		info.subpassCount = uint32_t(descs.size());
+		info.pSubpasses = descs.data();
+		info.dependencyCount = uint32_t(dependencies.size());
+		info.pDependencies = dependencies.data();
+
+		VkRenderPass renderPass;
+		if (vkCreateRenderPass(device, &info, nullptr, &renderPass) != VK_SUCCESS)
+			return false;
+		renderPasses.set(captured, renderPass);
+		return true;
+	}
+
+	bool updateDescriptorSets(RecordReader &reader)
+	{
+		struct Write
+		{
+			VkWriteDescriptorSet write;
+			vector<VkDescriptorImageInfo> images;
+			vector<VkDescriptorBufferInfo> buffers;
+		};
+
+		vector<Write> writes(reader.read<uint32_t>());
+		vector<VkWriteDescriptorSet> writeInfos;
+		for (auto &w : writes)
+		{
+			w.write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+			w.write.dstSet = descriptorSets.get(reader.readHandle());
+			w.write.dstBinding = reader.read<uint32_t>();
+			w.write.dstArrayElement = reader.read<uint32_t>();
+			w.write.descriptorType = reader.read<VkDescriptorType>();
+
+			switch (w.write.descriptorType)
+			{
+			case VK_DESCRIPTOR_TYPE_SAMPLER:
+			case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+			case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+			case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+			case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+				w.images = reader.readArray<VkDescriptorImageInfo>();
+				for (auto &image : w.images)
+				{
+					image.sampler = samplers.get(uint64_t(image.sampler));
+					image.imageView = imageViews.get(uint64_t(image.imageView));
+					image.imageLayout = patchLayout(image.imageLayout);
+				}
+				w.write.descriptorCount = uint32_t(w.images.size());
+				w.write.pImageInfo = w.images.data();
+				writeInfos.push_back(w.write);
+				break;
+
+			case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+			case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+			case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+			case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+				w.buffers = reader.readArray<VkDescriptorBufferInfo>();
+				for (auto &buffer : w.buffers)
+					buffer.buffer = buffers.get(uint64_t(buffer.buffer));
+				w.write.descriptorCount = uint32_t(w.buffers.size());
+				w.write.pBufferInfo = w.buffers.data();
+				writeInfos.push_back(w.write);
+				break;
+
+			default:
+				// Texel buffer views are not captured.
+				reader.read<uint32_t>();
+				skippedCount++;
+				break;
+			}
+		}
+
+		auto copies = reader.readArray<VkCopyDescriptorSet>();
+		for (auto &copy : copies)
+		{
+			copy.srcSet = descriptorSets.get(uint64_t(copy.srcSet));
+			copy.dstSet = descriptorSets.get(uint64_t(copy.dstSet));
+		}
+
+		if (!reader.isValid())
+			return false;
+
+		vkUpdateDescriptorSets(device, uint32_t(writeInfos.size()), writeInfos.data(), uint32_t(copies.size()),
+		                       copies.data());
+		return true;
+	}
+
+	bool cmdPipelineBarrier(RecordReader &reader)
+	{
+		VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+		auto srcStages = reader.read<VkPipelineStageFlags>();
+		auto dstStages = reader.read<VkPipelineStageFlags>();
+		auto dependencyFlags = reader.read<VkDependencyFlags>();
+
+		auto memoryBarriers = reader.readArray<VkMemoryBarrier>();
+		auto bufferBarriers = reader.readArray<VkBufferMemoryBarrier>();
+		for (auto &barrier : bufferBarriers)
+			barrier.buffer = buffers.get(uint64_t(barrier.buffer));
+
+		auto imageBarriers = reader.readArray<VkImageMemoryBarrier>();
+		for (auto &barrier : imageBarriers)
+		{
+			barrier.image = images.get(uint64_t(barrier.image));
+			barrier.oldLayout = patchLayout(barrier.oldLayout);
+			barrier.newLayout = patchLayout(barrier.newLayout);
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		}
+
+		if (!reader.isValid())
+			return false;
+
+		vkCmdPipelineBarrier(cmd, srcStages, dstStages, dependencyFlags, uint32_t(memoryBarriers.size()),
+		                     memoryBarriers.data(), uint32_t(bufferBarriers.size()), bufferBarriers.data(),
+		                     uint32_t(imageBarriers.size()), imageBarriers.data());
+		return true;
+	}
+
+	bool replayRecord(CaptureOp op, RecordReader &reader)
+	{
+		switch (op)
+		{
+		case CAPTURE_OP_GET_DEVICE_QUEUE:
+		{
+			// Everything is replayed on a single queue.
+			reader.read<uint32_t>();
+			reader.read<uint32_t>();
+			queues.set(reader.readHandle(), queue);
+			break;
+		}
+
+		case CAPTURE_OP_ALLOCATE_MEMORY:
+		{
+			uint64_t captured = reader.readHandle();
+			Memory mem = {};
+			mem.size = reader.read<VkDeviceSize>();
+			mem.flags = reader.read<VkMemoryPropertyFlags>();
+			memories[captured] = mem;
+			break;
+		}
+
+		case CAPTURE_OP_FREE_MEMORY:
+		{
+			auto itr = memories.find(reader.readHandle());
+			if (itr != end(memories))
+			{
+				if (itr->second.memory != VK_NULL_HANDLE)
+					vkFreeMemory(device, itr->second.memory, nullptr);
+				memories.erase(itr);
+			}
+			break;
+		}
+
+		case CAPTURE_OP_CREATE_BUFFER:
+		{
+			uint64_t captured = reader.readHandle();
+			auto info = reader.read<VkBufferCreateInfo>();
+			VkBuffer buffer;
+			if (!reader.isValid() || vkCreateBuffer(device, &info, nullptr, &buffer) != VK_SUCCESS)
+				return false;
+			buffers.set(captured, buffer);
+			break;
+		}
+
+		case CAPTURE_OP_DESTROY_BUFFER:
+		{
+			uint64_t captured = reader.readHandle();
+			vkDestroyBuffer(device, buffers.remove(captured), nullptr);
+			bufferBindings.erase(captured);
+
+			auto itr = dedicatedBufferMemory.find(captured);
+			if (itr != end(dedicatedBufferMemory))
+			{
+				vkFreeMemory(device, itr->second, nullptr);
+				dedicatedBufferMemory.erase(itr);
+			}
+			break;
+		}
+
+		case CAPTURE_OP_BIND_BUFFER_MEMORY:
+		{
+			uint64_t captured = reader.readHandle();
+			uint64_t capturedMemory = reader.readHandle();
+			auto offset = reader.read<VkDeviceSize>();
+
+			VkBuffer buffer = buffers.get(captured);
+			VkMemoryRequirements reqs;
+			vkGetBufferMemoryRequirements(device, buffer, &reqs);
+
+			BufferBinding binding = {};
+			VkDeviceMemory dedicated;
+			if (!bindMemory(reqs, capturedMemory, offset, binding.memory, binding.offset, dedicated))
+				return false;
+
+			if (dedicated != VK_NULL_HANDLE)
+				dedicatedBufferMemory[captured] = dedicated;
+			bufferBindings[captured] = binding;
+			vkBindBufferMemory(device, buffer, binding.memory, binding.offset);
+			break;
+		}
+
+		case CAPTURE_OP_CREATE_IMAGE:
+		{
+			uint64_t captured = reader.readHandle();
+			auto info = reader.read<VkImageCreateInfo>();
+			info.initialLayout = patchLayout(info.initialLayout);
+			VkImage image;
+			if (!reader.isValid() || vkCreateImage(device, &info, nullptr, &image) != VK_SUCCESS)
+				return false;
+			images.set(captured, image);
+			break;
+		}
+
+		case CAPTURE_OP_CREATE_SWAPCHAIN_IMAGE:
+		{
+			// Swapchain images become regular images backed by dedicated memory.
+			uint64_t captured = reader.readHandle();
+			auto info = reader.read<VkImageCreateInfo>();
+			VkImage image;
+			if (!reader.isValid() || vkCreateImage(device, &info, nullptr, &image) != VK_SUCCESS)
+				return false;
+
+			VkMemoryRequirements reqs;
+			vkGetImageMemoryRequirements(device, image, &reqs);
+
+			VkMemoryAllocateInfo alloc = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+			alloc.allocationSize = reqs.size;
+			alloc.memoryTypeIndex = findMemoryType(reqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			VkDeviceMemory memory;
+			if (vkAllocateMemory(device, &alloc, nullptr, &memory) != VK_SUCCESS)
+				return false;
+
+			vkBindImageMemory(device, image, memory, 0);
+			images.set(captured, image);
+			dedicatedImageMemory[captured] = memory;
+			break;
+		}
+
+		case CAPTURE_OP_DESTROY_IMAGE:
+		{
+			uint64_t captured = reader.readHandle();
+			vkDestroyImage(device, images.remove(captured), nullptr);
+
+			auto itr = dedicatedImageMemory.find(captured);
+			if (itr != end(dedicatedImageMemory))
+			{
+				vkFreeMemory(device, itr->second, nullptr);
+				dedicatedImageMemory.erase(itr);
+			}
+			break;
+		}
+
+		case CAPTURE_OP_BIND_IMAGE_MEMORY:
+		{
+			uint64_t captured = reader.readHandle();
+			uint64_t capturedMemory = reader.readHandle();
+			auto offset = reader.read<VkDeviceSize>();
+
+			VkImage image = images.get(captured);
+			VkMemoryRequirements reqs;
+			vkGetImageMemoryRequirements(device, image, &reqs);
+
+			VkDeviceMemory memory, dedicated;
+			VkDeviceSize boundOffset;
+			if (!bindMemory(reqs, capturedMemory, offset, memory, boundOffset, dedicated))
+				return false;
+
+			if (dedicated != VK_NULL_HANDLE)
+				dedicatedImageMemory[captured] = dedicated;
+			vkBindImageMemory(device, image, memory, boundOffset);
+			break;
+		}
+
+		case CAPTURE_OP_CREATE_IMAGE_VIEW:
+		{
+			uint64_t captured = reader.readHandle();
+			auto info = reader.read<VkImageViewCreateInfo>();
+			info.image = images.get(uint64_t(info.image));
+			VkImageView view;
+			if (!reader.isValid() || vkCreateImageView(device, &info, nullptr, &view) != VK_SUCCESS)
+				return false;
+			imageViews.set(captured, view);
+			break;
+		}
+
+		case CAPTURE_OP_DESTROY_IMAGE_VIEW:
+			vkDestroyImageView(device, imageViews.remove(reader.readHandle()), nullptr);
+			break;
+
+		case CAPTURE_OP_CREATE_SAMPLER:
+		{
+			uint64_t captured = reader.readHandle();
+			auto info = reader.read<VkSamplerCreateInfo>();
+			VkSampler sampler;
+			if (!reader.isValid() || vkCreateSampler(device, &info, nullptr, &sampler) != VK_SUCCESS)
+				return false;
+			samplers.set(captured, sampler);
+			break;
+		}
+
+		case CAPTURE_OP_DESTROY_SAMPLER:
+			vkDestroySampler(device, samplers.remove(reader.readHandle()), nullptr);
+			break;
+
+		case CAPTURE_OP_CREATE_SHADER_MODULE:
+		{
+			uint64_t captured = reader.readHandle();
+			VkShaderModuleCreateInfo info = { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+			info.flags = reader.read<VkShaderModuleCreateFlags>();
+
+			// SPIR-V must be 32-bit aligned, so it cannot be passed straight from the mapping.
+			uint32_t codeSize = reader.read<uint32_t>();
+			auto code = reader.readArray<uint32_t>(codeSize / sizeof(uint32_t));
+			info.codeSize = code.size() * sizeof(uint32_t);
+			info.pCode = code.data();
+
+			VkShaderModule module;
+			if (!reader.isValid() || vkCreateShaderModule(device, &info, nullptr, &module) != VK_SUCCESS)
+				return false;
+			shaderModules.set(captured, module);
+			break;
+		}
+
+		case CAPTURE_OP_DESTROY_SHADER_MODULE:
+			vkDestroyShaderModule(device, shaderModules.remove(reader.readHandle()), nullptr);
+			break;
+
+		case CAPTURE_OP_CREATE_RENDER_PASS:
+			return createRenderPass(reader);
+
+		case CAPTURE_OP_DESTROY_RENDER_PASS:
+			vkDestroyRenderPass(device, renderPasses.remove(reader.readHandle()), nullptr);
+			break;
+
+		case CAPTURE_OP_CREATE_FRAMEBUFFER:
+		{
+			uint64_t captured = reader.readHandle();
+			VkFramebufferCreateInfo info = { VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
+			info.flags = reader.read<VkFramebufferCreateFlags>();
+			info.renderPass = renderPasses.get(reader.readHandle());
+
+			vector<VkImageView> views;
+			for (auto view : reader.readHandleArray())
+				views.push_back(imageViews.get(view));
+			info.attachmentCount = uint32_t(views.size());
+			info.pAttachments = views.data();
+			info.width = reader.read<uint32_t>();
+			info.height = reader.read<uint32_t>();
+			info.layers = reader.read<uint32_t>();
+
+			VkFramebuffer framebuffer;
+			if (!reader.isValid() || vkCreateFramebuffer(device, &info, nullptr, &framebuffer) != VK_SUCCESS)
+				return false;
+			framebuffers.set(captured, framebuffer);
+			break;
+		}
+
+		case CAPTURE_OP_DESTROY_FRAMEBUFFER:
+			vkDestroyFramebuffer(device, framebuffers.remove(reader.readHandle()), nullptr);
+			break;
+
+		case CAPTURE_OP_CREATE_DESCRIPTOR_SET_LAYOUT:
+		{
+			uint64_t captured = reader.readHandle();
+			VkDescriptorSetLayoutCreateInfo info = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+			info.flags = reader.read<VkDescriptorSetLayoutCreateFlags>();
+
+			vector<VkDescriptorSetLayoutBinding> bindings(reader.read<uint32_t>());
+			vector<vector<VkSampler>> immutableSamplers(bindings.size());
+			for (size_t i = 0; i < bindings.size(); i++)
+			{
+				auto &binding = bindings[i];
+				binding.binding = reader.read<uint32_t>();
+				binding.descriptorType = reader.read<VkDescriptorType>();
+				binding.descriptorCount = reader.read<uint32_t>();
+				binding.stageFlags = reader.read<VkShaderStageFlags>();
+
+				for (auto sampler : reader.readHandleArray())
+					immutableSamplers[i].push_back(samplers.get(sampler));
+				binding.pImmutableSamplers = immutableSamplers[i].empty() ? nullptr : immutableSamplers[i].data();
+			}
+			info.bindingCount = uint32_t(bindings.size());
+			info.pBindings = bindings.data();
+
+			VkDescriptorSetLayout layout;
+			if (!reader.isValid() || vkCreateDescriptorSetLayout(device, &info, nullptr, &layout) != VK_SUCCESS)
+				return false;
+			setLayouts.set(captured, layout);
+			break;
+		}
+
+		case CAPTURE_OP_DESTROY_DESCRIPTOR_SET_LAYOUT:
+			vkDestroyDescriptorSetLayout(device, setLayouts.remove(reader.readHandle()), nullptr);
+			break;
+
+		case CAPTURE_OP_CREATE_PIPELINE_LAYOUT:
+		{
+			uint64_t captured = reader.readHandle();
+			VkPipelineLayoutCreateInfo info = { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+			info.flags = reader.read<VkPipelineLayoutCreateFlags>();
+
+			vector<VkDescriptorSetLayout> layouts;
+			for (auto layout : reader.readHandleArray())
+				layouts.push_back(setLayouts.get(layout));
+			auto ranges = reader.readArray<VkPushConstantRange>();
+
+			info.setLayoutCount = uint32_t(layouts.size());
+			info.pSetLayouts = layouts.data();
+			info.pushConstantRangeCount = uint32_t(ranges.size());
+			info.pPushConstantRanges = ranges.data();
+
+			VkPipelineLayout layout;
+			if (!reader.isValid() || vkCreatePipelineLayout(device, &info, nullptr, &layout) != VK_SUCCESS)
+				return false;
+			pipelineLayouts.set(captured, layout);
+			break;
+		}
+
+		case CAPTURE_OP_DESTROY_PIPELINE_LAYOUT:
+			vkDestroyPipelineLayout(device, pipelineLayouts.remove(reader.readHandle()), nullptr);
+			break;
+
+		case CAPTURE_OP_CREATE_GRAPHICS_PIPELINE:
+			return createGraphicsPipeline(reader);
+
+		case CAPTURE_OP_CREATE_COMPUTE_PIPELINE:
+		{
+			uint64_t captured = reader.readHandle();
+			VkComputePipelineCreateInfo info = { VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+			info.flags = reader.read<VkPipelineCreateFlags>();
+
+			ShaderStage stage;
+			readShaderStage(reader, stage);
+			finalizeShaderStage(stage);
+			info.stage = stage.info;
+			info.layout = pipelineLayouts.get(reader.readHandle());
+
+			VkPipeline pipeline;
+			if (!reader.isValid() ||
+			    vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &info, nullptr, &pipeline) != VK_SUCCESS)
+				return false;
+			pipelines.set(captured, pipeline);
+			break;
+		}
+
+		case CAPTURE_OP_DESTROY_PIPELINE:
+			vkDestroyPipeline(device, pipelines.remove(reader.readHandle()), nullptr);
+			break;
+
+		case CAPTURE_OP_CREATE_DESCRIPTOR_POOL:
+		{
+			uint64_t captured = reader.readHandle();
+			VkDescriptorPoolCreateInfo info = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+			info.flags = reader.read<VkDescriptorPoolCreateFlags>();
+			info.maxSets = reader.read<uint32_t>();
+			auto sizes = reader.readArray<VkDescriptorPoolSize>();
+			info.poolSizeCount = uint32_t(sizes.size());
+			info.pPoolSizes = sizes.data();
+
+			VkDescriptorPool pool;
+			if (!reader.isValid() || vkCreateDescriptorPool(device, &info, nullptr, &pool) != VK_SUCCESS)
+				return false;
+			descriptorPools.set(captured, pool);
+			break;
+		}
+
+		case CAPTURE_OP_DESTROY_DESCRIPTOR_POOL:
+			vkDestroyDescriptorPool(device, descriptorPools.remove(reader.readHandle()), nullptr);
+			break;
+
+		case CAPTURE_OP_RESET_DESCRIPTOR_POOL:
+			vkResetDescriptorPool(device, descriptorPools.get(reader.readHandle()), 0);
+			break;
+
+		case CAPTURE_OP_ALLOCATE_DESCRIPTOR_SETS:
+		{
+			VkDescriptorSetAllocateInfo info = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+			info.descriptorPool = descriptorPools.get(reader.readHandle());
+
+			vector<VkDescriptorSetLayout> layouts;
+			for (auto layout : reader.readHandleArray())
+				layouts.push_back(setLayouts.get(layout));
+			auto captured = reader.readHandleArray();
+			if (!reader.isValid() || captured.size() != layouts.size())
+				return false;
+
+			vector<VkDescriptorSet> sets(layouts.size());
+			info.descriptorSetCount = uint32_t(layouts.size());
+			info.pSetLayouts = layouts.data();
+			if (vkAllocateDescriptorSets(device, &info, sets.data()) != VK_SUCCESS)
+				return false;
+
+			for (size_t i = 0; i < sets.size(); i++)
+				descriptorSets.set(captured[i], sets[i]);
+			break;
+		}
+
+		case CAPTURE_OP_FREE_DESCRIPTOR_SETS:
+		{
+			VkDescriptorPool pool = descriptorPools.get(reader.readHandle());
+			vector<VkDescriptorSet> sets;
+			for (auto set : reader.readHandleArray())
+				sets.push_back(descriptorSets.remove(set));
+			vkFreeDescriptorSets(device, pool, uint32_t(sets.size()), sets.data());
+			break;
+		}
+
+		case CAPTURE_OP_UPDATE_DESCRIPTOR_SETS:
+			return updateDescriptorSets(reader);
+
+		case CAPTURE_OP_CREATE_COMMAND_POOL:
+		{
+			uint64_t captured = reader.readHandle();
+			VkCommandPoolCreateInfo info = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+			info.flags = reader.read<VkCommandPoolCreateFlags>();
+			reader.read<uint32_t>();
+			info.queueFamilyIndex = queueFamilyIndex;
+
+			VkCommandPool pool;
+			if (!reader.isValid() || vkCreateCommandPool(device, &info, nullptr, &pool) != VK_SUCCESS)
+				return false;
+			commandPools.set(captured, pool);
+			break;
+		}
+
+		case CAPTURE_OP_DESTROY_COMMAND_POOL:
+			vkDestroyCommandPool(device, commandPools.remove(reader.readHandle()), nullptr);
+			break;
+
+		case CAPTURE_OP_ALLOCATE_COMMAND_BUFFERS:
+		{
+			VkCommandBufferAllocateInfo info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+			info.commandPool = commandPools.get(reader.readHandle());
+			info.level = reader.read<VkCommandBufferLevel>();
+			auto captured = reader.readHandleArray();
+			if (!reader.isValid() || captured.empty())
+				return reader.isValid();
+
+			vector<VkCommandBuffer> cmds(captured.size());
+			info.commandBufferCount = uint32_t(cmds.size());
+			if (vkAllocateCommandBuffers(device, &info, cmds.data()) != VK_SUCCESS)
+				return false;
+
+			for (size_t i = 0; i < cmds.size(); i++)
+				commandBuffers.set(captured[i], cmds[i]);
+			break;
+		}
+
+		case CAPTURE_OP_FREE_COMMAND_BUFFERS:
+		{
+			VkCommandPool pool = commandPools.get(reader.readHandle());
+			vector<VkCommandBuffer> cmds;
+			for (auto cmd : reader.readHandleArray())
+				cmds.push_back(commandBuffers.remove(cmd));
+			vkFreeCommandBuffers(device, pool, uint32_t(cmds.size()), cmds.data());
+			break;
+		}
+
+		case CAPTURE_OP_RESET_COMMAND_POOL:
+			vkResetCommandPool(device, commandPools.get(reader.readHandle()), 0);
+			break;
+
+		case CAPTURE_OP_RESET_COMMAND_BUFFER:
+			vkResetCommandBuffer(commandBuffers.get(reader.readHandle()), 0);
+			break;
+
+		case CAPTURE_OP_BEGIN_COMMAND_BUFFER:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			VkCommandBufferBeginInfo info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+			info.flags = reader.read<VkCommandBufferUsageFlags>();
+
+			VkCommandBufferInheritanceInfo inheritance;
+			if (reader.read<uint32_t>())
+			{
+				inheritance = reader.read<VkCommandBufferInheritanceInfo>();
+				inheritance.renderPass = renderPasses.get(uint64_t(inheritance.renderPass));
+				inheritance.framebuffer = framebuffers.get(uint64_t(inheritance.framebuffer));
+				info.pInheritanceInfo = &inheritance;
+			}
+
+			if (!reader.isValid() || vkBeginCommandBuffer(cmd, &info) != VK_SUCCESS)
+				return false;
+			break;
+		}
+
+		case CAPTURE_OP_END_COMMAND_BUFFER:
+			if (vkEndCommandBuffer(commandBuffers.get(reader.readHandle())) != VK_SUCCESS)
+				return false;
+			break;
+
+		case CAPTURE_OP_CMD_BEGIN_RENDER_PASS:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			VkRenderPassBeginInfo info = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+			info.renderPass = renderPasses.get(reader.readHandle());
+			info.framebuffer = framebuffers.get(reader.readHandle());
+			info.renderArea = reader.read<VkRect2D>();
+			auto clearValues = reader.readArray<VkClearValue>();
+			info.clearValueCount = uint32_t(clearValues.size());
+			info.pClearValues = clearValues.data();
+			auto contents = reader.read<VkSubpassContents>();
+			vkCmdBeginRenderPass(cmd, &info, contents);
+			break;
+		}
+
+		case CAPTURE_OP_CMD_NEXT_SUBPASS:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			vkCmdNextSubpass(cmd, reader.read<VkSubpassContents>());
+			break;
+		}
+
+		case CAPTURE_OP_CMD_END_RENDER_PASS:
+			vkCmdEndRenderPass(commandBuffers.get(reader.readHandle()));
+			break;
+
+		case CAPTURE_OP_CMD_EXECUTE_COMMANDS:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			vector<VkCommandBuffer> secondaries;
+			for (auto secondary : reader.readHandleArray())
+				secondaries.push_back(commandBuffers.get(secondary));
+			if (!secondaries.empty())
+				vkCmdExecuteCommands(cmd, uint32_t(secondaries.size()), secondaries.data());
+			break;
+		}
+
+		case CAPTURE_OP_CMD_BIND_PIPELINE:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			auto bindPoint = reader.read<VkPipelineBindPoint>();
+			vkCmdBindPipeline(cmd, bindPoint, pipelines.get(reader.readHandle()));
+			break;
+		}
+
+		case CAPTURE_OP_CMD_BIND_DESCRIPTOR_SETS:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			auto bindPoint = reader.read<VkPipelineBindPoint>();
+			VkPipelineLayout layout = pipelineLayouts.get(reader.readHandle());
+			auto firstSet = reader.read<uint32_t>();
+
+			vector<VkDescriptorSet> sets;
+			for (auto set : reader.readHandleArray())
+				sets.push_back(descriptorSets.get(set));
+			auto dynamicOffsets = reader.readArray<uint32_t>();
+
+			vkCmdBindDescriptorSets(cmd, bindPoint, layout, firstSet, uint32_t(sets.size()), sets.data(),
+			                        uint32_t(dynamicOffsets.size()), dynamicOffsets.data());
+			break;
+		}
+
+		case CAPTURE_OP_CMD_BIND_INDEX_BUFFER:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			VkBuffer buffer = buffers.get(reader.readHandle());
+			auto offset = reader.read<VkDeviceSize>();
+			vkCmdBindIndexBuffer(cmd, buffer, offset, reader.read<VkIndexType>());
+			break;
+		}
+
+		case CAPTURE_OP_CMD_BIND_VERTEX_BUFFERS:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			auto firstBinding = reader.read<uint32_t>();
+			vector<VkBuffer> vbos;
+			for (auto buffer : reader.readHandleArray())
+				vbos.push_back(buffers.get(buffer));
+			auto offsets = reader.readArray<VkDeviceSize>();
+			if (!reader.isValid() || offsets.size() != vbos.size())
+				return false;
+			vkCmdBindVertexBuffers(cmd, firstBinding, uint32_t(vbos.size()), vbos.data(), offsets.data());
+			break;
+		}
+
+		case CAPTURE_OP_CMD_SET_VIEWPORT:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			auto first = reader.read<uint32_t>();
+			auto viewports = reader.readArray<VkViewport>();
+			vkCmdSetViewport(cmd, first, uint32_t(viewports.size()), viewports.data());
+			break;
+		}
+
+		case CAPTURE_OP_CMD_SET_SCISSOR:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			auto first = reader.read<uint32_t>();
+			auto scissors = reader.readArray<VkRect2D>();
+			vkCmdSetScissor(cmd, first, uint32_t(scissors.size()), scissors.data());
+			break;
+		}
+
+		case CAPTURE_OP_CMD_PUSH_CONSTANTS:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			VkPipelineLayout layout = pipelineLayouts.get(reader.readHandle());
+			auto stages = reader.read<VkShaderStageFlags>();
+			auto offset = reader.read<uint32_t>();
+			auto values = reader.readBlob();
+			if (!values.empty())
+				vkCmdPushConstants(cmd, layout, stages, offset, uint32_t(values.size()), values.data());
+			break;
+		}
+
+		case CAPTURE_OP_INDEX_DATA:
+		{
+			// Restore the index buffer contents the layer saw, so index buffer analysis gives the same results.
+			uint64_t captured = reader.readHandle();
+			auto offset = reader.read<VkDeviceSize>();
+			auto indices = reader.readBlob();
+
+			auto itr = bufferBindings.find(captured);
+			if (itr == end(bufferBindings))
+			{
+				skippedCount++;
+				break;
+			}
+
+			auto &binding = itr->second;
+			if (!binding.mapped)
+				binding.mapped = mapMemory(binding.memory);
+
+			if (binding.mapped)
+				memcpy(static_cast<uint8_t *>(binding.mapped) + binding.offset + offset, indices.data(),
+				       indices.size());
+			else
+				skippedCount++;
+			break;
+		}
+
+		case CAPTURE_OP_CMD_DRAW:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			auto vertexCount = reader.read<uint32_t>();
+			auto instanceCount = reader.read<uint32_t>();
+			auto firstVertex = reader.read<uint32_t>();
+			auto firstInstance = reader.read<uint32_t>();
+			vkCmdDraw(cmd, vertexCount, instanceCount, firstVertex, firstInstance);
+			break;
+		}
+
+		case CAPTURE_OP_CMD_DRAW_INDEXED:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			auto indexCount = reader.read<uint32_t>();
+			auto instanceCount = reader.read<uint32_t>();
+			auto firstIndex = reader.read<uint32_t>();
+			auto vertexOffset = reader.read<int32_t>();
+			auto firstInstance = reader.read<uint32_t>();
+			vkCmdDrawIndexed(cmd, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+			break;
+		}
+
+		case CAPTURE_OP_CMD_DRAW_INDIRECT:
+		case CAPTURE_OP_CMD_DRAW_INDEXED_INDIRECT:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			VkBuffer buffer = buffers.get(reader.readHandle());
+			auto offset = reader.read<VkDeviceSize>();
+			auto drawCount = reader.read<uint32_t>();
+			auto stride = reader.read<uint32_t>();
+			if (op == CAPTURE_OP_CMD_DRAW_INDIRECT)
+				vkCmdDrawIndirect(cmd, buffer, offset, drawCount, stride);
+			else
+				vkCmdDrawIndexedIndirect(cmd, buffer, offset, drawCount, stride);
+			break;
+		}
+
+		case CAPTURE_OP_CMD_DISPATCH:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			auto x = reader.read<uint32_t>();
+			auto y = reader.read<uint32_t>();
+			auto z = reader.read<uint32_t>();
+			vkCmdDispatch(cmd, x, y, z);
+			break;
+		}
+
+		case CAPTURE_OP_CMD_DISPATCH_INDIRECT:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			VkBuffer buffer = buffers.get(reader.readHandle());
+			vkCmdDispatchIndirect(cmd, buffer, reader.read<VkDeviceSize>());
+			break;
+		}
+
+		case CAPTURE_OP_CMD_PIPELINE_BARRIER:
+			return cmdPipelineBarrier(reader);
+
+		case CAPTURE_OP_CMD_CLEAR_COLOR_IMAGE:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			VkImage image = images.get(reader.readHandle());
+			auto layout = patchLayout(reader.read<VkImageLayout>());
+			auto color = reader.read<VkClearColorValue>();
+			auto ranges = reader.readArray<VkImageSubresourceRange>();
+			vkCmdClearColorImage(cmd, image, layout, &color, uint32_t(ranges.size()), ranges.data());
+			break;
+		}
+
+		case CAPTURE_OP_CMD_CLEAR_DEPTH_STENCIL_IMAGE:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			VkImage image = images.get(reader.readHandle());
+			auto layout = patchLayout(reader.read<VkImageLayout>());
+			auto value = reader.read<VkClearDepthStencilValue>();
+			auto ranges = reader.readArray<VkImageSubresourceRange>();
+			vkCmdClearDepthStencilImage(cmd, image, layout, &value, uint32_t(ranges.size()), ranges.data());
+			break;
+		}
+
+		case CAPTURE_OP_CMD_CLEAR_ATTACHMENTS:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			auto attachments = reader.readArray<VkClearAttachment>();
+			auto rects = reader.readArray<VkClearRect>();
+			vkCmdClearAttachments(cmd, uint32_t(attachments.size()), attachments.data(), uint32_t(rects.size()),
+			                      rects.data());
+			break;
+		}
+
+		case CAPTURE_OP_CMD_COPY_BUFFER:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			VkBuffer src = buffers.get(reader.readHandle());
+			VkBuffer dst = buffers.get(reader.readHandle());
+			auto regions = reader.readArray<VkBufferCopy>();
+			vkCmdCopyBuffer(cmd, src, dst, uint32_t(regions.size()), regions.data());
+			break;
+		}
+
+		case CAPTURE_OP_CMD_COPY_IMAGE:
+		case CAPTURE_OP_CMD_RESOLVE_IMAGE:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			VkImage src = images.get(reader.readHandle());
+			auto srcLayout = patchLayout(reader.read<VkImageLayout>());
+			VkImage dst = images.get(reader.readHandle());
+			auto dstLayout = patchLayout(reader.read<VkImageLayout>());
+
+			if (op == CAPTURE_OP_CMD_COPY_IMAGE)
+			{
+				auto regions = reader.readArray<VkImageCopy>();
+				vkCmdCopyImage(cmd, src, srcLayout, dst, dstLayout, uint32_t(regions.size()), regions.data());
+			}
+			else
+			{
+				auto regions = reader.readArray<VkImageResolve>();
+				vkCmdResolveImage(cmd, src, srcLayout, dst, dstLayout, uint32_t(regions.size()), regions.data());
+			}
+			break;
+		}
+
+		case CAPTURE_OP_CMD_COPY_BUFFER_TO_IMAGE:
+		case CAPTURE_OP_CMD_COPY_IMAGE_TO_BUFFER:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			VkBuffer buffer = buffers.get(reader.readHandle());
+			VkImage image = images.get(reader.readHandle());
+			auto layout = patchLayout(reader.read<VkImageLayout>());
+			auto regions = reader.readArray<VkBufferImageCopy>();
+
+			if (op == CAPTURE_OP_CMD_COPY_BUFFER_TO_IMAGE)
+				vkCmdCopyBufferToImage(cmd, buffer, image, layout, uint32_t(regions.size()), regions.data());
+			else
+				vkCmdCopyImageToBuffer(cmd, image, layout, buffer, uint32_t(regions.size()), regions.data());
+			break;
+		}
+
+		case CAPTURE_OP_CMD_BLIT_IMAGE:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			VkImage src = images.get(reader.readHandle());
+			auto srcLayout = patchLayout(reader.read<VkImageLayout>());
+			VkImage dst = images.get(reader.readHandle());
+			auto dstLayout = patchLayout(reader.read<VkImageLayout>());
+			auto regions = reader.readArray<VkImageBlit>();
+			auto filter = reader.read<VkFilter>();
+			vkCmdBlitImage(cmd, src, srcLayout, dst, dstLayout, uint32_t(regions.size()), regions.data(), filter);
+			break;
+		}
+
+		case CAPTURE_OP_CMD_FILL_BUFFER:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			VkBuffer buffer = buffers.get(reader.readHandle());
+			auto offset = reader.read<VkDeviceSize>();
+			auto size = reader.read<VkDeviceSize>();
+			vkCmdFillBuffer(cmd, buffer, offset, size, reader.read<uint32_t>());
+			break;
+		}
+
+		case CAPTURE_OP_CMD_UPDATE_BUFFER:
+		{
+			VkCommandBuffer cmd = commandBuffers.get(reader.readHandle());
+			VkBuffer buffer = buffers.get(reader.readHandle());
+			auto offset = reader.read<VkDeviceSize>();
+			auto data = reader.readBlob();
+			if (!data.empty())
+				vkCmdUpdateBuffer(cmd, buffer, offset, data.size(), data.data());
+			break;
+		}
+
+		case CAPTURE_OP_QUEUE_SUBMIT:
+		{
+			// Semaphores and fences are not captured, so every submission is waited on.
+			reader.readHandle();
+			vector<vector<VkCommandBuffer>> batches(reader.read<uint32_t>());
+			vector<VkSubmitInfo> submits;
+			for (auto &batch : batches)
+			{
+				for (auto cmd : reader.readHandleArray())
+					batch.push_back(commandBuffers.get(cmd));
+
+				VkSubmitInfo submit = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+				submit.commandBufferCount = uint32_t(batch.size());
+				submit.pCommandBuffers = batch.data();
+				submits.push_back(submit);
+			}
+
+			if (!reader.isValid() ||
+			    vkQueueSubmit(queue, uint32_t(submits.size()), submits.data(), VK_NULL_HANDLE) != VK_SUCCESS)
+				return false;
+			MPD_ASSERT_RESULT(vkQueueWaitIdle(queue));
+			submitCount++;
+			break;
+		}
+
+		default:
+			fprintf(stderr, "Unknown capture op %u.\n", unsigned(op));
+			return false;
+		}
+
+		return true;
+	}
+
+	// Captures are often cut short, destroy whatever the application did not get to.
+	void cleanup()
+	{
+		for (auto &pool : commandPools.handles)
+			vkDestroyCommandPool(device, pool.second, nullptr);
+		for (auto &pool : descriptorPools.handles)
+			vkDestroyDescriptorPool(device, pool.second, nullptr);
+		for (auto &pipeline : pipelines.handles)
+			vkDestroyPipeline(device, pipeline.second, nullptr);
+		for (auto &layout : pipelineLayouts.handles)
+			vkDestroyPipelineLayout(device, layout.second, nullptr);
+		for (auto &layout : setLayouts.handles)
+			vkDestroyDescriptorSetLayout(device, layout.second, nullptr);
+		for (auto &framebuffer : framebuffers.handles)
+			vkDestroyFramebuffer(device, framebuffer.second, nullptr);
+		for (auto &renderPass : renderPasses.handles)
+			vkDestroyRenderPass(device, renderPass.second, nullptr);
+		for (auto &module : shaderModules.handles)
+			vkDestroyShaderModule(device, module.second, nullptr);
+		for (auto &sampler : samplers.handles)
+			vkDestroySampler(device, sampler.second, nullptr);
+		for (auto &view : imageViews.handles)
+			vkDestroyImageView(device, view.second, nullptr);
+		for (auto &image : images.handles)
+			vkDestroyImage(device, image.second, nullptr);
+		for (auto &buffer : buffers.handles)
+			vkDestroyBuffer(device, buffer.second, nullptr);
+
+		for (auto &memory : dedicatedImageMemory)
+			vkFreeMemory(device, memory.second, nullptr);
+		for (auto &memory : dedicatedBufferMemory)
+			vkFreeMemory(device, memory.second, nullptr);
+		for (auto &memory : memories)
+			if (memory.second.memory != VK_NULL_HANDLE)
+				vkFreeMemory(device, memory.second.memory, nullptr);
+	}
+};
+
+VulkanTestHelper *MPD::createTest()
+{
+	const char *path = getenv("MALI_PERFDOC_REPLAY_FILE");
+	if (!path)
+	{
+		fprintf(stderr, "Set MALI_PERFDOC_REPLAY_FILE to the capture which should be replayed.\n");
+		return nullptr;
+	}
+
+	return new CaptureReplay(path, getenv("MALI_PERFDOC_REPLAY_NO_LAYER") == nullptr);
+}
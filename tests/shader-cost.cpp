@@ -0,0 +1,131 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "vulkan_test.hpp"
+#include "perfdoc.hpp"
+#include "util.hpp"
+#include <memory>
+#include <string>
+
+using namespace MPD;
+using namespace std;
+
+class ShaderCostTest : public VulkanTestHelper
+{
+	bool runTest()
+	{
+		resetCounts();
+
+		{
+			static const uint32_t vertCode[] =
+#include "quad_no_attribs.vert.inc"
+			    ;
+
+			static const uint32_t fragCode[] =
+#include "quad_texture_heavy.frag.inc"
+			    ;
+
+			const VkFormat FMT = VK_FORMAT_R8G8B8A8_UNORM;
+			const uint32_t WIDTH = 64, HEIGHT = 64;
+
+			auto tex = make_shared<Texture>(device);
+			tex->initRenderTarget2D(WIDTH, HEIGHT, FMT);
+			auto sampled = make_shared<Texture>(device);
+			sampled->initRenderTarget2D(WIDTH, HEIGHT, FMT);
+
+			auto fb = make_shared<Framebuffer>(device);
+			fb->initOnlyColor(tex, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
+
+			VkGraphicsPipelineCreateInfo pi = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+			pi.renderPass = fb->renderPass;
+			auto pipeline = make_shared<Pipeline>(device);
+			pipeline->initGraphics(vertCode, sizeof(vertCode), fragCode, sizeof(fragCode), &pi);
+
+			auto descriptors = make_shared<SampledImageDescriptorSet>(device);
+			descriptors->init(pipeline->descriptorSetLayout, sampled->view);
+
+			auto cmd = make_shared<CommandBuffer>(device);
+			cmd->initPrimary();
+			auto vkcmd = cmd->commandBuffer;
+
+			VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			MPD_ASSERT_RESULT(vkBeginCommandBuffer(vkcmd, &beginInfo));
+
+			VkClearValue clearValue = {};
+			VkRenderPassBeginInfo rbi = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+			rbi.renderPass = fb->renderPass;
+			rbi.framebuffer = fb->framebuffer;
+			rbi.renderArea.extent.width = WIDTH;
+			rbi.renderArea.extent.height = HEIGHT;
+			rbi.clearValueCount = 1;
+			rbi.pClearValues = &clearValue;
+
+			VkViewport vp = { 0.0f, 0.0f, float(WIDTH), float(HEIGHT), 0.0f, 1.0f };
+			vkCmdSetViewport(vkcmd, 0, 1, &vp);
+			vkCmdBeginRenderPass(vkcmd, &rbi, VK_SUBPASS_CONTENTS_INLINE);
+			vkCmdBindPipeline(vkcmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipeline);
+			vkCmdBindDescriptorSets(vkcmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipelineLayout, 0, 1,
+			                        &descriptors->set, 0, nullptr);
+			for (unsigned i = 0; i < 10; i++)
+				vkCmdDraw(vkcmd, 3, 1, 0, 0);
+			vkCmdEndRenderPass(vkcmd);
+			MPD_ASSERT_RESULT(vkEndCommandBuffer(vkcmd));
+
+			VkSubmitInfo submit = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+			submit.commandBufferCount = 1;
+			submit.pCommandBuffers = &vkcmd;
+			MPD_ASSERT_RESULT(vkQueueSubmit(queue, 1, &submit, VK_NULL_HANDLE));
+			vkQueueWaitIdle(queue);
+		}
+
+		// Nothing is presented, so the shaders are reported when the device goes away.
+		if (getCount(MESSAGE_CODE_SHADER_COST_REPORT) != 0)
+			return false;
+
+		destroyDevice();
+
+		if (getCount(MESSAGE_CODE_SHADER_COST_REPORT) != 1)
+			return false;
+
+		// Each stage is ranked on its own. The chain of dependent texture reads makes the texture unit the bound.
+		string report = getLastMessage(MESSAGE_CODE_SHADER_COST_REPORT);
+		if (report.find("Top vertex shaders:") == string::npos)
+			return false;
+
+		auto fragment = report.find("Top fragment shaders:");
+		if (fragment == string::npos)
+			return false;
+		auto first = report.find("#1 ", fragment);
+		if (first == string::npos)
+			return false;
+
+		string top = report.substr(first, report.find('\n', first) - first);
+		if (top.find("fragment shader") == string::npos || top.find("texture bound") == string::npos)
+			return false;
+
+		return true;
+	}
+};
+
+VulkanTestHelper *MPD::createTest()
+{
+	return new ShaderCostTest;
+}
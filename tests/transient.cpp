@@ -42,9 +42,130 @@ class Transient : public VulkanTestHelper
 		if (!testTransientMismatch(true, true))
 			return false;
 
+		if (!testTransientMemorySavings(false))
+			return false;
+		if (!testTransientMemorySavings(true))
+			return false;
+		if (!testTransientMemoryPeak())
+			return false;
+
 		return true;
 	}
 
+	// An image which is only ever cleared and discarded on tile could have been transient.
+	// The savings are reported when the device is destroyed.
+	bool testTransientMemorySavings(bool positiveTest)
+	{
+		// Start from a fresh device, so earlier tests do not count towards the totals.
+		destroyDevice();
+		createDevice();
+		resetCounts();
+
+		{
+			auto renderTarget = make_shared<Texture>(device);
+			renderTarget->initRenderTarget2D(1024, 1024, VK_FORMAT_R8G8B8A8_UNORM);
+
+			auto fb = make_shared<Framebuffer>(device);
+			fb->initOnlyColor(renderTarget, VK_ATTACHMENT_LOAD_OP_CLEAR,
+			                  positiveTest ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE);
+
+			auto cmd = make_shared<CommandBuffer>(device);
+			cmd->initPrimary();
+
+			VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			MPD_ASSERT_RESULT(vkBeginCommandBuffer(cmd->commandBuffer, &beginInfo));
+
+			VkClearValue clearValue = {};
+			VkRenderPassBeginInfo rbi = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+			rbi.renderPass = fb->renderPass;
+			rbi.framebuffer = fb->framebuffer;
+			rbi.renderArea.extent.width = 1024;
+			rbi.renderArea.extent.height = 1024;
+			rbi.clearValueCount = 1;
+			rbi.pClearValues = &clearValue;
+			vkCmdBeginRenderPass(cmd->commandBuffer, &rbi, VK_SUBPASS_CONTENTS_INLINE);
+			vkCmdEndRenderPass(cmd->commandBuffer);
+			MPD_ASSERT_RESULT(vkEndCommandBuffer(cmd->commandBuffer));
+
+			VkSubmitInfo submit = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+			submit.commandBufferCount = 1;
+			submit.pCommandBuffers = &cmd->commandBuffer;
+			MPD_ASSERT_RESULT(vkQueueSubmit(queue, 1, &submit, VK_NULL_HANDLE));
+			vkQueueWaitIdle(queue);
+		}
+
+		destroyDevice();
+		createDevice();
+
+		if (positiveTest)
+			return getCount(MESSAGE_CODE_TRANSIENT_MEMORY_SAVINGS) == 1;
+		else
+			return getCount(MESSAGE_CODE_TRANSIENT_MEMORY_SAVINGS) == 0;
+	}
+
+	// Two images are discarded on tile, then one of them is stored.
+	// The stored image was never a real saving, so it must not count towards the peak either.
+	bool testTransientMemoryPeak()
+	{
+		destroyDevice();
+		createDevice();
+		resetCounts();
+
+		char expectedPeak[64];
+		{
+			auto kept = make_shared<Texture>(device);
+			kept->initRenderTarget2D(1024, 1024, VK_FORMAT_R8G8B8A8_UNORM);
+			auto disqualified = make_shared<Texture>(device);
+			disqualified->initRenderTarget2D(1024, 1024, VK_FORMAT_R8G8B8A8_UNORM);
+
+			VkMemoryRequirements memReqs;
+			vkGetImageMemoryRequirements(device, kept->image, &memReqs);
+			snprintf(expectedPeak, sizeof(expectedPeak), "(peak %.2f MiB)", memReqs.size / (1024.0 * 1024.0));
+
+			auto fbKept = make_shared<Framebuffer>(device);
+			fbKept->initOnlyColor(kept, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE);
+			auto fbDiscard = make_shared<Framebuffer>(device);
+			fbDiscard->initOnlyColor(disqualified, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE);
+			auto fbStore = make_shared<Framebuffer>(device);
+			fbStore->initOnlyColor(disqualified, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
+
+			auto cmd = make_shared<CommandBuffer>(device);
+			cmd->initPrimary();
+
+			VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			MPD_ASSERT_RESULT(vkBeginCommandBuffer(cmd->commandBuffer, &beginInfo));
+
+			for (auto *fb : { fbKept.get(), fbDiscard.get(), fbStore.get() })
+			{
+				VkClearValue clearValue = {};
+				VkRenderPassBeginInfo rbi = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+				rbi.renderPass = fb->renderPass;
+				rbi.framebuffer = fb->framebuffer;
+				rbi.renderArea.extent.width = 1024;
+				rbi.renderArea.extent.height = 1024;
+				rbi.clearValueCount = 1;
+				rbi.pClearValues = &clearValue;
+				vkCmdBeginRenderPass(cmd->commandBuffer, &rbi, VK_SUBPASS_CONTENTS_INLINE);
+				vkCmdEndRenderPass(cmd->commandBuffer);
+			}
+			MPD_ASSERT_RESULT(vkEndCommandBuffer(cmd->commandBuffer));
+
+			VkSubmitInfo submit = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+			submit.commandBufferCount = 1;
+			submit.pCommandBuffers = &cmd->commandBuffer;
+			MPD_ASSERT_RESULT(vkQueueSubmit(queue, 1, &submit, VK_NULL_HANDLE));
+			vkQueueWaitIdle(queue);
+		}
+
+		destroyDevice();
+		createDevice();
+
+		return getCount(MESSAGE_CODE_TRANSIENT_MEMORY_SAVINGS) == 1 &&
+		       getLastMessage(MESSAGE_CODE_TRANSIENT_MEMORY_SAVINGS).find(expectedPeak) != string::npos;
+	}
+
 	bool testTransientMismatch(bool transientImage, bool transientRenderPass)
 	{
 		resetCounts();
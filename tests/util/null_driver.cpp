@@ -0,0 +1,819 @@
+/* Copyright (c) 2017, ARM Limited and Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "null_driver.hpp"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string.h>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vk_layer.h>
+
+// The layer is linked statically into the analyzer, so these resolve to its exported entry points.
+// This file must not include libvulkan-stub.h, which redirects the vk* prototypes to the dynamic loader.
+
+using namespace std;
+
+namespace MPD
+{
+namespace
+{
+// The first word of a dispatchable object is its dispatch key, just like with the real loader.
+// Physical devices share the key of their instance, queues and command buffers the key of their device.
+struct NullDispatchable
+{
+	void *key;
+};
+
+struct NullInstance
+{
+	NullDispatchable dispatch;
+	NullDispatchable gpu;
+};
+
+struct NullDevice
+{
+	NullDispatchable dispatch;
+	NullDispatchable queue;
+};
+
+struct NullMemory
+{
+	VkDeviceSize size;
+	vector<uint8_t> data;
+};
+
+struct NullDriverState
+{
+	mutex lock;
+	atomic<uint64_t> nextHandle = { 1 };
+	unordered_map<uint64_t, VkMemoryRequirements> requirements;
+	unordered_map<uint64_t, NullMemory> memory;
+	unordered_map<uint64_t, vector<NullDispatchable *>> commandPools;
+};
+
+static NullDriverState &getState()
+{
+	static NullDriverState state;
+	return state;
+}
+
+template <typename T>
+static T allocHandle()
+{
+	return (T)getState().nextHandle.fetch_add(1);
+}
+
+// Memory types exposed by the null driver, mirroring what a Mali device typically reports.
+enum NullMemoryType
+{
+	NULL_MEMORY_TYPE_COHERENT = 0,
+	NULL_MEMORY_TYPE_CACHED = 1,
+	NULL_MEMORY_TYPE_LAZY = 2,
+	NULL_MEMORY_TYPE_COUNT
+};
+
+static const VkDeviceSize NULL_MEMORY_ALIGNMENT = 256;
+
+static VkDeviceSize alignSize(VkDeviceSize size)
+{
+	return (size + NULL_MEMORY_ALIGNMENT - 1) & ~(NULL_MEMORY_ALIGNMENT - 1);
+}
+
+// Entry points which carry no state are implemented generically from their PFN type,
+// so the signature (and calling convention) matches the API exactly.
+template <typename Func>
+struct NullEntry;
+
+template <typename Ret, typename... Args>
+struct NullEntry<Ret(VKAPI_PTR *)(Args...)>
+{
+	static VKAPI_ATTR Ret VKAPI_CALL call(Args...)
+	{
+		return Ret();
+	}
+};
+
+template <typename Info, typename T>
+static VKAPI_ATTR VkResult VKAPI_CALL CreateObject(VkDevice, const Info *, const VkAllocationCallbacks *, T *pObject)
+{
+	*pObject = allocHandle<T>();
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL GetInstanceProcAddr(VkInstance instance, const char *pName);
+static VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL GetDeviceProcAddr(VkDevice device, const char *pName);
+
+static VKAPI_ATTR VkResult VKAPI_CALL CreateInstance(const VkInstanceCreateInfo *, const VkAllocationCallbacks *,
+                                                     VkInstance *pInstance)
+{
+	auto *instance = new NullInstance;
+	instance->dispatch.key = instance;
+	instance->gpu.key = instance;
+	*pInstance = reinterpret_cast<VkInstance>(instance);
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL DestroyInstance(VkInstance instance, const VkAllocationCallbacks *)
+{
+	delete reinterpret_cast<NullInstance *>(instance);
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL EnumeratePhysicalDevices(VkInstance instance, uint32_t *pPhysicalDeviceCount,
+                                                               VkPhysicalDevice *pPhysicalDevices)
+{
+	if (!pPhysicalDevices)
+	{
+		*pPhysicalDeviceCount = 1;
+		return VK_SUCCESS;
+	}
+
+	if (*pPhysicalDeviceCount < 1)
+		return VK_INCOMPLETE;
+
+	*pPhysicalDeviceCount = 1;
+	pPhysicalDevices[0] = reinterpret_cast<VkPhysicalDevice>(&reinterpret_cast<NullInstance *>(instance)->gpu);
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL GetPhysicalDeviceFeatures(VkPhysicalDevice, VkPhysicalDeviceFeatures *pFeatures)
+{
+	memset(pFeatures, 0, sizeof(*pFeatures));
+}
+
+static VKAPI_ATTR void VKAPI_CALL GetPhysicalDeviceFormatProperties(VkPhysicalDevice, VkFormat,
+                                                                    VkFormatProperties *pFormatProperties)
+{
+	// Claim everything, the analyzer replays what the original device accepted.
+	pFormatProperties->linearTilingFeatures = ~0u;
+	pFormatProperties->optimalTilingFeatures = ~0u;
+	pFormatProperties->bufferFeatures = ~0u;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL GetPhysicalDeviceImageFormatProperties(
+    VkPhysicalDevice, VkFormat, VkImageType, VkImageTiling, VkImageUsageFlags, VkImageCreateFlags,
+    VkImageFormatProperties *pImageFormatProperties)
+{
+	pImageFormatProperties->maxExtent = { 8192, 8192, 2048 };
+	pImageFormatProperties->maxMipLevels = 14;
+	pImageFormatProperties->maxArrayLayers = 2048;
+	pImageFormatProperties->sampleCounts = VK_SAMPLE_COUNT_1_BIT | VK_SAMPLE_COUNT_4_BIT;
+	pImageFormatProperties->maxResourceSize = VkDeviceSize(1) << 32;
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL GetPhysicalDeviceProperties(VkPhysicalDevice, VkPhysicalDeviceProperties *pProperties)
+{
+	memset(pProperties, 0, sizeof(*pProperties));
+	pProperties->apiVersion = VK_MAKE_VERSION(1, 0, VK_HEADER_VERSION);
+	pProperties->vendorID = 0x13b5;
+	pProperties->deviceType = VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU;
+	strcpy(pProperties->deviceName, "PerfDoc offline analyzer");
+
+	auto &limits = pProperties->limits;
+	limits.maxImageDimension1D = 8192;
+	limits.maxImageDimension2D = 8192;
+	limits.maxImageDimension3D = 2048;
+	limits.maxImageDimensionCube = 8192;
+	limits.maxImageArrayLayers = 2048;
+	limits.maxUniformBufferRange = 65536;
+	limits.maxStorageBufferRange = 1u << 27;
+	limits.maxPushConstantsSize = 128;
+	limits.maxMemoryAllocationCount = 4096;
+	limits.maxSamplerAllocationCount = 4000;
+	limits.bufferImageGranularity = 1;
+	limits.maxBoundDescriptorSets = 4;
+	limits.maxPerStageResources = 44;
+	limits.maxVertexInputAttributes = 16;
+	limits.maxVertexInputBindings = 16;
+	limits.maxFragmentOutputAttachments = 4;
+	limits.maxColorAttachments = 4;
+	limits.maxComputeWorkGroupCount[0] = 65535;
+	limits.maxComputeWorkGroupCount[1] = 65535;
+	limits.maxComputeWorkGroupCount[2] = 65535;
+	limits.maxComputeWorkGroupInvocations = 256;
+	limits.maxComputeWorkGroupSize[0] = 256;
+	limits.maxComputeWorkGroupSize[1] = 256;
+	limits.maxComputeWorkGroupSize[2] = 64;
+	limits.maxViewports = 1;
+	limits.maxViewportDimensions[0] = 8192;
+	limits.maxViewportDimensions[1] = 8192;
+	limits.maxFramebufferWidth = 8192;
+	limits.maxFramebufferHeight = 8192;
+	limits.maxFramebufferLayers = 256;
+	limits.framebufferColorSampleCounts = VK_SAMPLE_COUNT_1_BIT | VK_SAMPLE_COUNT_4_BIT;
+	limits.framebufferDepthSampleCounts = VK_SAMPLE_COUNT_1_BIT | VK_SAMPLE_COUNT_4_BIT;
+	limits.framebufferStencilSampleCounts = VK_SAMPLE_COUNT_1_BIT | VK_SAMPLE_COUNT_4_BIT;
+	limits.minMemoryMapAlignment = 64;
+	limits.minTexelBufferOffsetAlignment = 16;
+	limits.minUniformBufferOffsetAlignment = 16;
+	limits.minStorageBufferOffsetAlignment = 16;
+	limits.optimalBufferCopyOffsetAlignment = 64;
+	limits.optimalBufferCopyRowPitchAlignment = 64;
+	limits.nonCoherentAtomSize = 64;
+}
+
+static VKAPI_ATTR void VKAPI_CALL GetPhysicalDeviceQueueFamilyProperties(
+    VkPhysicalDevice, uint32_t *pQueueFamilyPropertyCount, VkQueueFamilyProperties *pQueueFamilyProperties)
+{
+	if (!pQueueFamilyProperties)
+	{
+		*pQueueFamilyPropertyCount = 1;
+		return;
+	}
+
+	if (*pQueueFamilyPropertyCount < 1)
+		return;
+
+	*pQueueFamilyPropertyCount = 1;
+	pQueueFamilyProperties[0] = {};
+	pQueueFamilyProperties[0].queueFlags = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
+	pQueueFamilyProperties[0].queueCount = 1;
+	pQueueFamilyProperties[0].timestampValidBits = 64;
+	pQueueFamilyProperties[0].minImageTransferGranularity = { 1, 1, 1 };
+}
+
+static VKAPI_ATTR void VKAPI_CALL GetPhysicalDeviceMemoryProperties(VkPhysicalDevice,
+                                                                    VkPhysicalDeviceMemoryProperties *pMemoryProperties)
+{
+	memset(pMemoryProperties, 0, sizeof(*pMemoryProperties));
+
+	pMemoryProperties->memoryHeapCount = 1;
+	pMemoryProperties->memoryHeaps[0].size = VkDeviceSize(2) << 30;
+	pMemoryProperties->memoryHeaps[0].flags = VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+
+	const VkMemoryPropertyFlags hostVisible =
+	    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+	pMemoryProperties->memoryTypeCount = NULL_MEMORY_TYPE_COUNT;
+	pMemoryProperties->memoryTypes[NULL_MEMORY_TYPE_COHERENT].propertyFlags = hostVisible;
+	pMemoryProperties->memoryTypes[NULL_MEMORY_TYPE_CACHED].propertyFlags =
+	    hostVisible | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+	pMemoryProperties->memoryTypes[NULL_MEMORY_TYPE_LAZY].propertyFlags =
+	    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL CreateDevice(VkPhysicalDevice, const VkDeviceCreateInfo *,
+                                                   const VkAllocationCallbacks *, VkDevice *pDevice)
+{
+	auto *device = new NullDevice;
+	device->dispatch.key = device;
+	device->queue.key = device;
+	*pDevice = reinterpret_cast<VkDevice>(device);
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL DestroyDevice(VkDevice device, const VkAllocationCallbacks *)
+{
+	auto &state = getState();
+	lock_guard<mutex> holder{ state.lock };
+
+	// Command buffers of pools which were never destroyed.
+	auto *nullDevice = reinterpret_cast<NullDevice *>(device);
+	for (auto &pool : state.commandPools)
+	{
+		auto &cmds = pool.second;
+		auto itr = remove_if(begin(cmds), end(cmds), [nullDevice](NullDispatchable *cmd) {
+			if (cmd->key != nullDevice)
+				return false;
+			delete cmd;
+			return true;
+		});
+		cmds.erase(itr, end(cmds));
+	}
+
+	delete nullDevice;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL EnumerateDeviceExtensionProperties(VkPhysicalDevice, const char *,
+                                                                         uint32_t *pPropertyCount,
+                                                                         VkExtensionProperties *)
+{
+	*pPropertyCount = 0;
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL GetDeviceQueue(VkDevice device, uint32_t, uint32_t, VkQueue *pQueue)
+{
+	*pQueue = reinterpret_cast<VkQueue>(&reinterpret_cast<NullDevice *>(device)->queue);
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL AllocateMemory(VkDevice, const VkMemoryAllocateInfo *pAllocateInfo,
+                                                     const VkAllocationCallbacks *, VkDeviceMemory *pMemory)
+{
+	auto &state = getState();
+	lock_guard<mutex> holder{ state.lock };
+
+	*pMemory = allocHandle<VkDeviceMemory>();
+	state.memory[(uint64_t)*pMemory].size = pAllocateInfo->allocationSize;
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL FreeMemory(VkDevice, VkDeviceMemory memory, const VkAllocationCallbacks *)
+{
+	auto &state = getState();
+	lock_guard<mutex> holder{ state.lock };
+	state.memory.erase((uint64_t)memory);
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL MapMemory(VkDevice, VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize,
+                                                VkMemoryMapFlags, void **ppData)
+{
+	auto &state = getState();
+	lock_guard<mutex> holder{ state.lock };
+
+	auto itr = state.memory.find((uint64_t)memory);
+	if (itr == end(state.memory))
+		return VK_ERROR_MEMORY_MAP_FAILED;
+
+	// Host storage only exists for memory which is actually mapped.
+	auto &mem = itr->second;
+	if (mem.data.empty())
+		mem.data.resize(size_t(mem.size));
+
+	*ppData = mem.data.data() + offset;
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL CreateBuffer(VkDevice, const VkBufferCreateInfo *pCreateInfo,
+                                                   const VkAllocationCallbacks *, VkBuffer *pBuffer)
+{
+	auto &state = getState();
+	lock_guard<mutex> holder{ state.lock };
+
+	*pBuffer = allocHandle<VkBuffer>();
+
+	VkMemoryRequirements reqs;
+	reqs.size = alignSize(pCreateInfo->size);
+	reqs.alignment = NULL_MEMORY_ALIGNMENT;
+	reqs.memoryTypeBits = (1u << NULL_MEMORY_TYPE_COHERENT) | (1u << NULL_MEMORY_TYPE_CACHED);
+	state.requirements[(uint64_t)*pBuffer] = reqs;
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL CreateImage(VkDevice, const VkImageCreateInfo *pCreateInfo,
+                                                  const VkAllocationCallbacks *, VkImage *pImage)
+{
+	auto &state = getState();
+	lock_guard<mutex> holder{ state.lock };
+
+	*pImage = allocHandle<VkImage>();
+
+	// Sizes are only estimated, assuming 32 bits per texel.
+	VkDeviceSize size = VkDeviceSize(pCreateInfo->extent.width) * pCreateInfo->extent.height *
+	                    pCreateInfo->extent.depth * pCreateInfo->arrayLayers * pCreateInfo->samples * 4;
+	if (pCreateInfo->mipLevels > 1)
+		size += size / 3;
+
+	VkMemoryRequirements reqs;
+	reqs.size = alignSize(size);
+	reqs.alignment = NULL_MEMORY_ALIGNMENT;
+	reqs.memoryTypeBits = (1u << NULL_MEMORY_TYPE_COHERENT) | (1u << NULL_MEMORY_TYPE_CACHED);
+	if (pCreateInfo->usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT)
+		reqs.memoryTypeBits |= 1u << NULL_MEMORY_TYPE_LAZY;
+	state.requirements[(uint64_t)*pImage] = reqs;
+	return VK_SUCCESS;
+}
+
+static void getMemoryRequirements(uint64_t object, VkMemoryRequirements *pMemoryRequirements)
+{
+	auto &state = getState();
+	lock_guard<mutex> holder{ state.lock };
+
+	auto itr = state.requirements.find(object);
+	if (itr != end(state.requirements))
+		*pMemoryRequirements = itr->second;
+	else
+		*pMemoryRequirements = {};
+}
+
+static VKAPI_ATTR void VKAPI_CALL GetBufferMemoryRequirements(VkDevice, VkBuffer buffer,
+                                                              VkMemoryRequirements *pMemoryRequirements)
+{
+	getMemoryRequirements((uint64_t)buffer, pMemoryRequirements);
+}
+
+static VKAPI_ATTR void VKAPI_CALL GetImageMemoryRequirements(VkDevice, VkImage image,
+                                                             VkMemoryRequirements *pMemoryRequirements)
+{
+	getMemoryRequirements((uint64_t)image, pMemoryRequirements);
+}
+
+static void forgetMemoryRequirements(uint64_t object)
+{
+	auto &state = getState();
+	lock_guard<mutex> holder{ state.lock };
+	state.requirements.erase(object);
+}
+
+static VKAPI_ATTR void VKAPI_CALL DestroyBuffer(VkDevice, VkBuffer buffer, const VkAllocationCallbacks *)
+{
+	forgetMemoryRequirements((uint64_t)buffer);
+}
+
+static VKAPI_ATTR void VKAPI_CALL DestroyImage(VkDevice, VkImage image, const VkAllocationCallbacks *)
+{
+	forgetMemoryRequirements((uint64_t)image);
+}
+
+static VKAPI_ATTR void VKAPI_CALL GetRenderAreaGranularity(VkDevice, VkRenderPass, VkExtent2D *pGranularity)
+{
+	*pGranularity = { 16, 16 };
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL CreateGraphicsPipelines(VkDevice, VkPipelineCache, uint32_t createInfoCount,
+                                                              const VkGraphicsPipelineCreateInfo *,
+                                                              const VkAllocationCallbacks *, VkPipeline *pPipelines)
+{
+	for (uint32_t i = 0; i < createInfoCount; i++)
+		pPipelines[i] = allocHandle<VkPipeline>();
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL CreateComputePipelines(VkDevice, VkPipelineCache, uint32_t createInfoCount,
+                                                             const VkComputePipelineCreateInfo *,
+                                                             const VkAllocationCallbacks *, VkPipeline *pPipelines)
+{
+	for (uint32_t i = 0; i < createInfoCount; i++)
+		pPipelines[i] = allocHandle<VkPipeline>();
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL AllocateDescriptorSets(VkDevice, const VkDescriptorSetAllocateInfo *pAllocateInfo,
+                                                             VkDescriptorSet *pDescriptorSets)
+{
+	for (uint32_t i = 0; i < pAllocateInfo->descriptorSetCount; i++)
+		pDescriptorSets[i] = allocHandle<VkDescriptorSet>();
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL CreateCommandPool(VkDevice, const VkCommandPoolCreateInfo *,
+                                                        const VkAllocationCallbacks *, VkCommandPool *pCommandPool)
+{
+	auto &state = getState();
+	lock_guard<mutex> holder{ state.lock };
+
+	*pCommandPool = allocHandle<VkCommandPool>();
+	state.commandPools[(uint64_t)*pCommandPool];
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL DestroyCommandPool(VkDevice, VkCommandPool commandPool,
+                                                     const VkAllocationCallbacks *)
+{
+	auto &state = getState();
+	lock_guard<mutex> holder{ state.lock };
+
+	auto itr = state.commandPools.find((uint64_t)commandPool);
+	if (itr == end(state.commandPools))
+		return;
+
+	for (auto *cmd : itr->second)
+		delete cmd;
+	state.commandPools.erase(itr);
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL AllocateCommandBuffers(VkDevice device,
+                                                             const VkCommandBufferAllocateInfo *pAllocateInfo,
+                                                             VkCommandBuffer *pCommandBuffers)
+{
+	auto &state = getState();
+	lock_guard<mutex> holder{ state.lock };
+
+	auto &pool = state.commandPools[(uint64_t)pAllocateInfo->commandPool];
+	for (uint32_t i = 0; i < pAllocateInfo->commandBufferCount; i++)
+	{
+		auto *cmd = new NullDispatchable;
+		cmd->key = reinterpret_cast<NullDevice *>(device);
+		pool.push_back(cmd);
+		pCommandBuffers[i] = reinterpret_cast<VkCommandBuffer>(cmd);
+	}
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL FreeCommandBuffers(VkDevice, VkCommandPool commandPool, uint32_t commandBufferCount,
+                                                     const VkCommandBuffer *pCommandBuffers)
+{
+	auto &state = getState();
+	lock_guard<mutex> holder{ state.lock };
+
+	auto &pool = state.commandPools[(uint64_t)commandPool];
+	for (uint32_t i = 0; i < commandBufferCount; i++)
+	{
+		auto *cmd = reinterpret_cast<NullDispatchable *>(pCommandBuffers[i]);
+		auto itr = find(begin(pool), end(pool), cmd);
+		if (itr != end(pool))
+		{
+			pool.erase(itr);
+			delete cmd;
+		}
+	}
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL CreateDebugReportCallbackEXT(VkInstance, const VkDebugReportCallbackCreateInfoEXT *,
+                                                                   const VkAllocationCallbacks *,
+                                                                   VkDebugReportCallbackEXT *pCallback)
+{
+	*pCallback = allocHandle<VkDebugReportCallbackEXT>();
+	return VK_SUCCESS;
+}
+
+#define NULL_DRIVER_ENTRY(name) \
+	{ "vk" #name, reinterpret_cast<PFN_vkVoidFunction>(name) }
+#define NULL_DRIVER_NOP(name) \
+	{ "vk" #name, reinterpret_cast<PFN_vkVoidFunction>(NullEntry<PFN_vk##name>::call) }
+#define NULL_DRIVER_CREATE(name, info, handle) \
+	{ "vkCreate" #name, reinterpret_cast<PFN_vkVoidFunction>(CreateObject<info, handle>) }
+
+static const struct
+{
+	const char *name;
+	PFN_vkVoidFunction proc;
+} nullDriverCommands[] = {
+	NULL_DRIVER_ENTRY(GetInstanceProcAddr),
+	NULL_DRIVER_ENTRY(GetDeviceProcAddr),
+	NULL_DRIVER_ENTRY(CreateInstance),
+	NULL_DRIVER_ENTRY(DestroyInstance),
+	NULL_DRIVER_ENTRY(EnumeratePhysicalDevices),
+	NULL_DRIVER_ENTRY(GetPhysicalDeviceFeatures),
+	NULL_DRIVER_ENTRY(GetPhysicalDeviceFormatProperties),
+	NULL_DRIVER_ENTRY(GetPhysicalDeviceImageFormatProperties),
+	NULL_DRIVER_ENTRY(GetPhysicalDeviceProperties),
+	NULL_DRIVER_ENTRY(GetPhysicalDeviceQueueFamilyProperties),
+	NULL_DRIVER_ENTRY(GetPhysicalDeviceMemoryProperties),
+	NULL_DRIVER_NOP(GetPhysicalDeviceSparseImageFormatProperties),
+	NULL_DRIVER_ENTRY(CreateDevice),
+	NULL_DRIVER_ENTRY(DestroyDevice),
+	NULL_DRIVER_ENTRY(EnumerateDeviceExtensionProperties),
+	NULL_DRIVER_ENTRY(CreateDebugReportCallbackEXT),
+	NULL_DRIVER_NOP(DestroyDebugReportCallbackEXT),
+	NULL_DRIVER_NOP(DebugReportMessageEXT),
+
+	NULL_DRIVER_ENTRY(GetDeviceQueue),
+	NULL_DRIVER_NOP(QueueSubmit),
+	NULL_DRIVER_NOP(QueueWaitIdle),
+	NULL_DRIVER_NOP(QueueBindSparse),
+	NULL_DRIVER_NOP(DeviceWaitIdle),
+	// There is no surface, presenting only marks the end of a frame for the layer.
+	NULL_DRIVER_NOP(QueuePresentKHR),
+
+	NULL_DRIVER_ENTRY(AllocateMemory),
+	NULL_DRIVER_ENTRY(FreeMemory),
+	NULL_DRIVER_ENTRY(MapMemory),
+	NULL_DRIVER_NOP(UnmapMemory),
+	NULL_DRIVER_NOP(FlushMappedMemoryRanges),
+	NULL_DRIVER_NOP(InvalidateMappedMemoryRanges),
+	NULL_DRIVER_NOP(GetDeviceMemoryCommitment),
+	NULL_DRIVER_NOP(BindBufferMemory),
+	NULL_DRIVER_NOP(BindImageMemory),
+	NULL_DRIVER_ENTRY(GetBufferMemoryRequirements),
+	NULL_DRIVER_ENTRY(GetImageMemoryRequirements),
+	NULL_DRIVER_NOP(GetImageSparseMemoryRequirements),
+
+	NULL_DRIVER_CREATE(Fence, VkFenceCreateInfo, VkFence),
+	NULL_DRIVER_NOP(DestroyFence),
+	NULL_DRIVER_NOP(ResetFences),
+	NULL_DRIVER_NOP(GetFenceStatus),
+	NULL_DRIVER_NOP(WaitForFences),
+	NULL_DRIVER_CREATE(Semaphore, VkSemaphoreCreateInfo, VkSemaphore),
+	NULL_DRIVER_NOP(DestroySemaphore),
+	NULL_DRIVER_CREATE(Event, VkEventCreateInfo, VkEvent),
+	NULL_DRIVER_NOP(DestroyEvent),
+	NULL_DRIVER_NOP(GetEventStatus),
+	NULL_DRIVER_NOP(SetEvent),
+	NULL_DRIVER_NOP(ResetEvent),
+	NULL_DRIVER_CREATE(QueryPool, VkQueryPoolCreateInfo, VkQueryPool),
+	NULL_DRIVER_NOP(DestroyQueryPool),
+	NULL_DRIVER_NOP(GetQueryPoolResults),
+
+	NULL_DRIVER_ENTRY(CreateBuffer),
+	NULL_DRIVER_ENTRY(DestroyBuffer),
+	NULL_DRIVER_CREATE(BufferView, VkBufferViewCreateInfo, VkBufferView),
+	NULL_DRIVER_NOP(DestroyBufferView),
+	NULL_DRIVER_ENTRY(CreateImage),
+	NULL_DRIVER_ENTRY(DestroyImage),
+	NULL_DRIVER_NOP(GetImageSubresourceLayout),
+	NULL_DRIVER_CREATE(ImageView, VkImageViewCreateInfo, VkImageView),
+	NULL_DRIVER_NOP(DestroyImageView),
+	NULL_DRIVER_CREATE(ShaderModule, VkShaderModuleCreateInfo, VkShaderModule),
+	NULL_DRIVER_NOP(DestroyShaderModule),
+	NULL_DRIVER_CREATE(PipelineCache, VkPipelineCacheCreateInfo, VkPipelineCache),
+	NULL_DRIVER_NOP(DestroyPipelineCache),
+	NULL_DRIVER_NOP(GetPipelineCacheData),
+	NULL_DRIVER_NOP(MergePipelineCaches),
+	NULL_DRIVER_ENTRY(CreateGraphicsPipelines),
+	NULL_DRIVER_ENTRY(CreateComputePipelines),
+	NULL_DRIVER_NOP(DestroyPipeline),
+	NULL_DRIVER_CREATE(PipelineLayout, VkPipelineLayoutCreateInfo, VkPipelineLayout),
+	NULL_DRIVER_NOP(DestroyPipelineLayout),
+	NULL_DRIVER_CREATE(Sampler, VkSamplerCreateInfo, VkSampler),
+	NULL_DRIVER_NOP(DestroySampler),
+	NULL_DRIVER_CREATE(DescriptorSetLayout, VkDescriptorSetLayoutCreateInfo, VkDescriptorSetLayout),
+	NULL_DRIVER_NOP(DestroyDescriptorSetLayout),
+	NULL_DRIVER_CREATE(DescriptorPool, VkDescriptorPoolCreateInfo, VkDescriptorPool),
+	NULL_DRIVER_NOP(DestroyDescriptorPool),
+	NULL_DRIVER_NOP(ResetDescriptorPool),
+	NULL_DRIVER_ENTRY(AllocateDescriptorSets),
+	NULL_DRIVER_NOP(FreeDescriptorSets),
+	NULL_DRIVER_NOP(UpdateDescriptorSets),
+	NULL_DRIVER_CREATE(Framebuffer, VkFramebufferCreateInfo, VkFramebuffer),
+	NULL_DRIVER_NOP(DestroyFramebuffer),
+	NULL_DRIVER_CREATE(RenderPass, VkRenderPassCreateInfo, VkRenderPass),
+	NULL_DRIVER_NOP(DestroyRenderPass),
+	NULL_DRIVER_ENTRY(GetRenderAreaGranularity),
+
+	NULL_DRIVER_ENTRY(CreateCommandPool),
+	NULL_DRIVER_ENTRY(DestroyCommandPool),
+	NULL_DRIVER_NOP(ResetCommandPool),
+	NULL_DRIVER_ENTRY(AllocateCommandBuffers),
+	NULL_DRIVER_ENTRY(FreeCommandBuffers),
+	NULL_DRIVER_NOP(BeginCommandBuffer),
+	NULL_DRIVER_NOP(EndCommandBuffer),
+	NULL_DRIVER_NOP(ResetCommandBuffer),
+
+	NULL_DRIVER_NOP(CmdBindPipeline),
+	NULL_DRIVER_NOP(CmdSetViewport),
+	NULL_DRIVER_NOP(CmdSetScissor),
+	NULL_DRIVER_NOP(CmdSetLineWidth),
+	NULL_DRIVER_NOP(CmdSetDepthBias),
+	NULL_DRIVER_NOP(CmdSetBlendConstants),
+	NULL_DRIVER_NOP(CmdSetDepthBounds),
+	NULL_DRIVER_NOP(CmdSetStencilCompareMask),
+	NULL_DRIVER_NOP(CmdSetStencilWriteMask),
+	NULL_DRIVER_NOP(CmdSetStencilReference),
+	NULL_DRIVER_NOP(CmdBindDescriptorSets),
+	NULL_DRIVER_NOP(CmdBindIndexBuffer),
+	NULL_DRIVER_NOP(CmdBindVertexBuffers),
+	NULL_DRIVER_NOP(CmdDraw),
+	NULL_DRIVER_NOP(CmdDrawIndexed),
+	NULL_DRIVER_NOP(CmdDrawIndirect),
+	NULL_DRIVER_NOP(CmdDrawIndexedIndirect),
+	NULL_DRIVER_NOP(CmdDispatch),
+	NULL_DRIVER_NOP(CmdDispatchIndirect),
+	NULL_DRIVER_NOP(CmdCopyBuffer),
+	NULL_DRIVER_NOP(CmdCopyImage),
+	NULL_DRIVER_NOP(CmdBlitImage),
+	NULL_DRIVER_NOP(CmdCopyBufferToImage),
+	NULL_DRIVER_NOP(CmdCopyImageToBuffer),
+	NULL_DRIVER_NOP(CmdUpdateBuffer),
+	NULL_DRIVER_NOP(CmdFillBuffer),
+	NULL_DRIVER_NOP(CmdClearColorImage),
+	NULL_DRIVER_NOP(CmdClearDepthStencilImage),
+	NULL_DRIVER_NOP(CmdClearAttachments),
+	NULL_DRIVER_NOP(CmdResolveImage),
+	NULL_DRIVER_NOP(CmdSetEvent),
+	NULL_DRIVER_NOP(CmdResetEvent),
+	NULL_DRIVER_NOP(CmdWaitEvents),
+	NULL_DRIVER_NOP(CmdPipelineBarrier),
+	NULL_DRIVER_NOP(CmdBeginQuery),
+	NULL_DRIVER_NOP(CmdEndQuery),
+	NULL_DRIVER_NOP(CmdResetQueryPool),
+	NULL_DRIVER_NOP(CmdWriteTimestamp),
+	NULL_DRIVER_NOP(CmdCopyQueryPoolResults),
+	NULL_DRIVER_NOP(CmdPushConstants),
+	NULL_DRIVER_NOP(CmdBeginRenderPass),
+	NULL_DRIVER_NOP(CmdNextSubpass),
+	NULL_DRIVER_NOP(CmdEndRenderPass),
+	NULL_DRIVER_NOP(CmdExecuteCommands),
+};
+
+#undef NULL_DRIVER_ENTRY
+#undef NULL_DRIVER_NOP
+#undef NULL_DRIVER_CREATE
+
+static PFN_vkVoidFunction getNullDriverCommand(const char *pName)
+{
+	for (auto &cmd : nullDriverCommands)
+		if (strcmp(cmd.name, pName) == 0)
+			return cmd.proc;
+	return nullptr;
+}
+
+static VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL GetInstanceProcAddr(VkInstance, const char *pName)
+{
+	return getNullDriverCommand(pName);
+}
+
+static VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL GetDeviceProcAddr(VkDevice, const char *pName)
+{
+	return getNullDriverCommand(pName);
+}
+
+// The loader side. The layer is always enabled, and it is the only layer on the chain.
+static const VkExtensionProperties offlineInstanceExtensions[] = {
+	{ VK_EXT_DEBUG_REPORT_EXTENSION_NAME, VK_EXT_DEBUG_REPORT_SPEC_VERSION },
+};
+
+static VKAPI_ATTR VkResult VKAPI_CALL OfflineEnumerateInstanceExtensionProperties(const char *pLayerName,
+                                                                                  uint32_t *pPropertyCount,
+                                                                                  VkExtensionProperties *pProperties)
+{
+	if (pLayerName)
+		return ::vkEnumerateInstanceExtensionProperties(pLayerName, pPropertyCount, pProperties);
+
+	const uint32_t count = sizeof(offlineInstanceExtensions) / sizeof(offlineInstanceExtensions[0]);
+	if (!pProperties)
+	{
+		*pPropertyCount = count;
+		return VK_SUCCESS;
+	}
+
+	uint32_t toWrite = min(count, *pPropertyCount);
+	memcpy(pProperties, offlineInstanceExtensions, toWrite * sizeof(offlineInstanceExtensions[0]));
+	*pPropertyCount = toWrite;
+	return toWrite < count ? VK_INCOMPLETE : VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL OfflineCreateInstance(const VkInstanceCreateInfo *pCreateInfo,
+                                                            const VkAllocationCallbacks *pAllocator,
+                                                            VkInstance *pInstance)
+{
+	VkLayerInstanceLink link = {};
+	link.pfnNextGetInstanceProcAddr = GetInstanceProcAddr;
+
+	VkLayerInstanceCreateInfo chainInfo = { VK_STRUCTURE_TYPE_LOADER_INSTANCE_CREATE_INFO };
+	chainInfo.pNext = pCreateInfo->pNext;
+	chainInfo.function = VK_LAYER_LINK_INFO;
+	chainInfo.u.pLayerInfo = &link;
+
+	VkInstanceCreateInfo info = *pCreateInfo;
+	info.pNext = &chainInfo;
+
+	auto fpCreateInstance =
+	    reinterpret_cast<PFN_vkCreateInstance>(::vkGetInstanceProcAddr(VK_NULL_HANDLE, "vkCreateInstance"));
+	return fpCreateInstance(&info, pAllocator, pInstance);
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL OfflineCreateDevice(VkPhysicalDevice gpu, const VkDeviceCreateInfo *pCreateInfo,
+                                                          const VkAllocationCallbacks *pAllocator, VkDevice *pDevice)
+{
+	VkLayerDeviceLink link = {};
+	link.pfnNextGetInstanceProcAddr = GetInstanceProcAddr;
+	link.pfnNextGetDeviceProcAddr = GetDeviceProcAddr;
+
+	VkLayerDeviceCreateInfo chainInfo = { VK_STRUCTURE_TYPE_LOADER_DEVICE_CREATE_INFO };
+	chainInfo.pNext = pCreateInfo->pNext;
+	chainInfo.function = VK_LAYER_LINK_INFO;
+	chainInfo.u.pLayerInfo = &link;
+
+	VkDeviceCreateInfo info = *pCreateInfo;
+	info.pNext = &chainInfo;
+
+	auto fpCreateDevice =
+	    reinterpret_cast<PFN_vkCreateDevice>(::vkGetInstanceProcAddr(VK_NULL_HANDLE, "vkCreateDevice"));
+	return fpCreateDevice(gpu, &info, pAllocator, pDevice);
+}
+
+static VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL OfflineGetInstanceProcAddr(VkInstance instance, const char *pName)
+{
+	static const struct
+	{
+		const char *name;
+		PFN_vkVoidFunction proc;
+	} loaderCommands[] = {
+		{ "vkGetInstanceProcAddr", reinterpret_cast<PFN_vkVoidFunction>(OfflineGetInstanceProcAddr) },
+		{ "vkGetDeviceProcAddr", reinterpret_cast<PFN_vkVoidFunction>(::vkGetDeviceProcAddr) },
+		{ "vkCreateInstance", reinterpret_cast<PFN_vkVoidFunction>(OfflineCreateInstance) },
+		{ "vkCreateDevice", reinterpret_cast<PFN_vkVoidFunction>(OfflineCreateDevice) },
+		{ "vkEnumerateInstanceExtensionProperties",
+		  reinterpret_cast<PFN_vkVoidFunction>(OfflineEnumerateInstanceExtensionProperties) },
+		{ "vkEnumerateInstanceLayerProperties",
+		  reinterpret_cast<PFN_vkVoidFunction>(::vkEnumerateInstanceLayerProperties) },
+		{ "vkEnumerateDeviceLayerProperties", reinterpret_cast<PFN_vkVoidFunction>(::vkEnumerateDeviceLayerProperties) },
+		{ "vkEnumerateDeviceExtensionProperties",
+		  reinterpret_cast<PFN_vkVoidFunction>(EnumerateDeviceExtensionProperties) },
+	};
+
+	for (auto &cmd : loaderCommands)
+		if (strcmp(cmd.name, pName) == 0)
+			return cmd.proc;
+
+	if (instance == VK_NULL_HANDLE)
+		return nullptr;
+	return ::vkGetInstanceProcAddr(instance, pName);
+}
+}
+
+PFN_vkGetInstanceProcAddr getOfflineInstanceProcAddr()
+{
+	return OfflineGetInstanceProcAddr;
+}
+}
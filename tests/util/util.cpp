@@ -140,10 +140,29 @@ void Pipeline::initCompute(const uint32_t *code, size_t size)
 void Pipeline::initGraphics(const uint32_t *vertCode, size_t vertSize, const uint32_t *fragCode, size_t fragSize,
                             const VkGraphicsPipelineCreateInfo *createInfo)
 {
-	shaders[0].reset(new Shader(device));
-	shaders[1].reset(new Shader(device));
-	shaders[0]->init(vertCode, vertSize);
-	shaders[1]->init(fragCode, fragSize);
+	auto vert = make_shared<Shader>(device);
+	auto frag = make_shared<Shader>(device);
+	vert->init(vertCode, vertSize);
+	frag->init(fragCode, fragSize);
+
+	VkGraphicsPipelineCreateInfo inf = *createInfo;
+	if (!createInfo->layout)
+	{
+		const uint32_t *code[2] = { vertCode, fragCode };
+		size_t codeSizes[2] = { vertSize, fragSize };
+		initLayouts(code, codeSizes, 2);
+
+		inf.layout = pipelineLayout;
+	}
+
+	initGraphics(vert, frag, &inf);
+}
+
+void Pipeline::initGraphics(const std::shared_ptr<Shader> &vert, const std::shared_ptr<Shader> &frag,
+                            const VkGraphicsPipelineCreateInfo *createInfo)
+{
+	shaders[0] = vert;
+	shaders[1] = frag;
 
 	VkGraphicsPipelineCreateInfo inf = *createInfo;
 	inf.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
@@ -285,18 +304,52 @@ void Pipeline::initGraphics(const uint32_t *vertCode, size_t vertSize, const uin
 		inf.pDynamicState = &dynState;
 	}
 
-	if (!createInfo->layout)
-	{
-		const uint32_t *code[2] = { vertCode, fragCode };
-		size_t codeSizes[2] = { vertSize, fragSize };
-		initLayouts(code, codeSizes, 2);
-
-		inf.layout = pipelineLayout;
-	}
-
 	MPD_ASSERT_RESULT(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &inf, nullptr, &pipeline));
 }
 
+void SampledImageDescriptorSet::init(VkDescriptorSetLayout setLayout, VkImageView view, VkImageLayout imageLayout)
+{
+	VkDescriptorPoolSize poolSize = {};
+	poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSize.descriptorCount = 1;
+	VkDescriptorPoolCreateInfo poolInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+	MPD_ASSERT_RESULT(vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool));
+
+	VkSamplerCreateInfo samplerInfo = { VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	MPD_ASSERT_RESULT(vkCreateSampler(device, &samplerInfo, nullptr, &sampler));
+
+	VkDescriptorSetAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+	allocInfo.descriptorPool = pool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &setLayout;
+	MPD_ASSERT_RESULT(vkAllocateDescriptorSets(device, &allocInfo, &set));
+
+	if (view == VK_NULL_HANDLE)
+		return;
+
+	VkDescriptorImageInfo imageInfo = {};
+	imageInfo.imageView = view;
+	imageInfo.sampler = sampler;
+	imageInfo.imageLayout = imageLayout;
+
+	VkWriteDescriptorSet write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+	write.dstSet = set;
+	write.dstBinding = 0;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write.pImageInfo = &imageInfo;
+	vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+}
+
 void Framebuffer::initOnlyColor(const std::shared_ptr<Texture> &colorAttachment, VkAttachmentLoadOp load,
                                 VkAttachmentStoreOp store, uint32_t subpassDependencies,
                                 const VkSubpassDependency *pDependencies)
@@ -501,7 +554,8 @@ void Texture::initDepthStencil(uint32_t w, uint32_t h, VkFormat fmt, bool transi
 		info.usage = VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT |
 		             VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
 	else
-		info.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		info.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+		             VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 	info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
 	MPD_ASSERT_RESULT(vkCreateImage(device, &info, nullptr, &image));
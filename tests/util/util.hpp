@@ -98,10 +98,39 @@ struct Pipeline : TestObjectBase
 	void initGraphics(const uint32_t *vertCode, size_t vertSize, const uint32_t *fragCode, size_t fragSize,
 	                  const VkGraphicsPipelineCreateInfo *createInfo);
 
+	// Shares the shader modules of another pipeline, createInfo must provide the layout.
+	void initGraphics(const std::shared_ptr<Shader> &vert, const std::shared_ptr<Shader> &frag,
+	                  const VkGraphicsPipelineCreateInfo *createInfo);
+
 private:
 	void initLayouts(const uint32_t **codes, size_t *sizes, unsigned shaderCount);
 };
 
+/// Descriptor set with a single combined image sampler at binding 0, allocated from its own pool.
+struct SampledImageDescriptorSet : TestObjectBase
+{
+	VkDescriptorPool pool = VK_NULL_HANDLE;
+	VkSampler sampler = VK_NULL_HANDLE;
+	VkDescriptorSet set = VK_NULL_HANDLE;
+
+	SampledImageDescriptorSet(VkDevice device)
+	    : TestObjectBase(device)
+	{
+	}
+
+	~SampledImageDescriptorSet()
+	{
+		if (pool)
+			vkDestroyDescriptorPool(device, pool, nullptr);
+		if (sampler)
+			vkDestroySampler(device, sampler, nullptr);
+	}
+
+	// Writes view to the set unless it is VK_NULL_HANDLE, in which case the caller updates the set itself.
+	void init(VkDescriptorSetLayout setLayout, VkImageView view = VK_NULL_HANDLE,
+	          VkImageLayout imageLayout = VK_IMAGE_LAYOUT_GENERAL);
+};
+
 /// Image and image view wrapper.
 struct Texture : TestObjectBase
 {
@@ -19,6 +19,9 @@
  */
 
 #include "vulkan_test.hpp"
+#ifdef PERFDOC_OFFLINE_ANALYZER
+#include "null_driver.hpp"
+#endif
 #include <stdio.h>
 #include <stdexcept>
 #include <vector>
@@ -28,20 +31,30 @@ using namespace std;
 namespace MPD
 {
 static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(VkDebugReportFlagsEXT flags, VkDebugReportObjectTypeEXT, uint64_t, size_t,
-                                                    int32_t messageCode, const char *pLayerPrefix, const char *, void *pUserData)
+                                                    int32_t messageCode, const char *pLayerPrefix, const char *pMessage,
+                                                    void *pUserData)
 {
-	if (flags == VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT && !strcmp(pLayerPrefix, "MaliPerfDoc"))
+	// Periodic reports are logged as information rather than performance warnings.
+	bool counted =
+	    flags == VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT || flags == VK_DEBUG_REPORT_INFORMATION_BIT_EXT;
+	if (counted && !strcmp(pLayerPrefix, "MaliPerfDoc"))
 	{
 		MPD_ASSERT(messageCode >= 0 && messageCode < MESSAGE_CODE_COUNT);
-		static_cast<VulkanTestHelper *>(pUserData)->notifyCallback(static_cast<MessageCodes>(messageCode));
+		static_cast<VulkanTestHelper *>(pUserData)->notifyCallback(static_cast<MessageCodes>(messageCode), pMessage);
 	}
 	return VK_FALSE;
 }
 
-VulkanTestHelper::VulkanTestHelper()
+VulkanTestHelper::VulkanTestHelper(bool enablePerfDocLayer)
+    : perfDocLayerEnabled(enablePerfDocLayer)
 {
+#ifdef PERFDOC_OFFLINE_ANALYZER
+	// The offline analyzer runs the statically linked layer on top of a null driver instead of the system loader.
+	vulkanSymbolWrapperInit(getOfflineInstanceProcAddr());
+#else
 	if (!vulkanSymbolWrapperInitLoader())
 		throw runtime_error("Cannot find Vulkan loader.");
+#endif
 	if (!vulkanSymbolWrapperLoadGlobalSymbols())
 		throw runtime_error("Failed to load global Vulkan symbols.");
 
@@ -106,8 +119,8 @@ VulkanTestHelper::VulkanTestHelper()
 	instanceInfo.enabledExtensionCount = 1;
 	instanceInfo.ppEnabledExtensionNames = &ext;
 	const char *layer = VK_LAYER_ARM_mali_perf_doc;
-	instanceInfo.enabledLayerCount = 1;
-	instanceInfo.ppEnabledLayerNames = &layer;
+	instanceInfo.enabledLayerCount = enablePerfDocLayer ? 1 : 0;
+	instanceInfo.ppEnabledLayerNames = enablePerfDocLayer ? &layer : nullptr;
 
 	if (vkCreateInstance(&instanceInfo, nullptr, &instance) != VK_SUCCESS)
 		throw runtime_error("Failed to create instance.");
@@ -117,7 +130,8 @@ VulkanTestHelper::VulkanTestHelper()
 
 	VULKAN_SYMBOL_WRAPPER_LOAD_INSTANCE_EXTENSION_SYMBOL(instance, vkCreateDebugReportCallbackEXT);
 	VkDebugReportCallbackCreateInfoEXT info = { VK_STRUCTURE_TYPE_DEBUG_REPORT_CALLBACK_CREATE_INFO_EXT };
-	info.flags = VK_DEBUG_REPORT_ERROR_BIT_EXT | VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT | VK_DEBUG_REPORT_WARNING_BIT_EXT;
+	info.flags = VK_DEBUG_REPORT_ERROR_BIT_EXT | VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT |
+	             VK_DEBUG_REPORT_WARNING_BIT_EXT | VK_DEBUG_REPORT_INFORMATION_BIT_EXT;
 	info.pfnCallback = debugCallback;
 	info.pUserData = this;
 	vkCreateDebugReportCallbackEXT(instance, &info, nullptr, &callback);
@@ -133,6 +147,14 @@ VulkanTestHelper::VulkanTestHelper()
 	vkGetPhysicalDeviceProperties(gpu, &gpuProperties);
 	vkGetPhysicalDeviceMemoryProperties(gpu, &memoryProperties);
 
+	createDevice();
+
+	if (!initialize())
+		throw runtime_error("Failed to initialize test.");
+}
+
+void VulkanTestHelper::createDevice(const vector<const char *> &extensions)
+{
 	uint32_t queueCount;
 	vkGetPhysicalDeviceQueueFamilyProperties(gpu, &queueCount, nullptr);
 	vector<VkQueueFamilyProperties> queueProperties(queueCount);
@@ -145,7 +167,7 @@ VulkanTestHelper::VulkanTestHelper()
 	vector<VkLayerProperties> deviceLayers(deviceLayerCount);
 	vkEnumerateDeviceLayerProperties(gpu, &deviceLayerCount, deviceLayers.data());
 
-	hasPerfDocLayer = false;
+	bool hasPerfDocLayer = false;
 	for (auto &layer : deviceLayers)
 	{
 		if (strcmp(layer.layerName, VK_LAYER_ARM_mali_perf_doc) == 0)
@@ -155,7 +177,7 @@ VulkanTestHelper::VulkanTestHelper()
 		}
 	}
 
-	if (!hasPerfDocLayer)
+	if (perfDocLayerEnabled && !hasPerfDocLayer)
 		throw runtime_error("No PerfDoc device layer present.");
 
 	uint32_t queueIndex = VK_QUEUE_FAMILY_IGNORED;
@@ -178,13 +200,20 @@ VulkanTestHelper::VulkanTestHelper()
 	queueInfo.queueCount = 1;
 	queueInfo.pQueuePriorities = &one;
 
+	const char *layer = VK_LAYER_ARM_mali_perf_doc;
+	// Tests of indirect draws need more than one draw per command.
+	VkPhysicalDeviceFeatures supportedFeatures = {};
+	vkGetPhysicalDeviceFeatures(gpu, &supportedFeatures);
 	VkPhysicalDeviceFeatures features = {};
+	features.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
 	VkDeviceCreateInfo deviceInfo = { VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
 	deviceInfo.queueCreateInfoCount = 1;
 	deviceInfo.pQueueCreateInfos = &queueInfo;
-	deviceInfo.enabledLayerCount = 1;
-	deviceInfo.ppEnabledLayerNames = &layer;
+	deviceInfo.enabledLayerCount = perfDocLayerEnabled ? 1 : 0;
+	deviceInfo.ppEnabledLayerNames = perfDocLayerEnabled ? &layer : nullptr;
 	deviceInfo.pEnabledFeatures = &features;
+	deviceInfo.enabledExtensionCount = uint32_t(extensions.size());
+	deviceInfo.ppEnabledExtensionNames = extensions.empty() ? nullptr : extensions.data();
 
 	if (vkCreateDevice(gpu, &deviceInfo, nullptr, &device) != VK_SUCCESS)
 		throw runtime_error("Failed to create device.");
@@ -193,14 +222,25 @@ VulkanTestHelper::VulkanTestHelper()
 		throw runtime_error("Failed to load device symbols.");
 
 	vkGetDeviceQueue(device, queueIndex, 0, &queue);
+	queueFamilyIndex = queueIndex;
+}
 
-	if (!initialize())
-		throw runtime_error("Failed to initialize test.");
+void VulkanTestHelper::destroyDevice()
+{
+	if (device == VK_NULL_HANDLE)
+		return;
+
+	vkDeviceWaitIdle(device);
+	vkDestroyDevice(device, nullptr);
+	device = VK_NULL_HANDLE;
+	queue = VK_NULL_HANDLE;
 }
 
 void VulkanTestHelper::resetCounts()
 {
 	memset(warningCount, 0, sizeof(warningCount));
+	for (auto &message : lastMessage)
+		message.clear();
 }
 
 unsigned VulkanTestHelper::getCount(MessageCodes code) const
@@ -208,9 +248,15 @@ unsigned VulkanTestHelper::getCount(MessageCodes code) const
 	return warningCount[code];
 }
 
-void VulkanTestHelper::notifyCallback(MessageCodes code)
+const string &VulkanTestHelper::getLastMessage(MessageCodes code) const
+{
+	return lastMessage[code];
+}
+
+void VulkanTestHelper::notifyCallback(MessageCodes code, const char *message)
 {
 	warningCount[code]++;
+	lastMessage[code] = message;
 }
 
 VulkanTestHelper::~VulkanTestHelper()
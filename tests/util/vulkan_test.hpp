@@ -23,13 +23,16 @@
 #include "libvulkan-stub.h"
 #include "layer/config.hpp"
 #include "layer/message_codes.hpp"
+#include <string>
+#include <vector>
 
 namespace MPD
 {
 class VulkanTestHelper
 {
 public:
-	VulkanTestHelper();
+	// The PerfDoc layer is enabled by default. Benchmarks may disable it to get a baseline.
+	explicit VulkanTestHelper(bool enablePerfDocLayer = true);
 	virtual ~VulkanTestHelper();
 
 	virtual bool initialize()
@@ -44,22 +47,35 @@ public:
 		return cfg;
 	}
 
-	void notifyCallback(MessageCodes code);
+	void notifyCallback(MessageCodes code, const char *message);
 
 protected:
 	void resetCounts();
 	unsigned getCount(MessageCodes code) const;
 
+	// Text of the most recent message with this code, empty if there was none since the last resetCounts().
+	const std::string &getLastMessage(MessageCodes code) const;
+
+	// Some reports are only made when the device is destroyed. Every object created from the device must be
+	// destroyed before calling this, the debug callback stays alive so the reports are still counted.
+	void destroyDevice();
+	void createDevice(const std::vector<const char *> &extensions = std::vector<const char *>());
+
 	VkInstance instance = VK_NULL_HANDLE;
 	VkDevice device = VK_NULL_HANDLE;
 	VkPhysicalDevice gpu = VK_NULL_HANDLE;
 	VkQueue queue = VK_NULL_HANDLE;
+	uint32_t queueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 	VkPhysicalDeviceMemoryProperties memoryProperties = {};
 	VkPhysicalDeviceProperties gpuProperties = {};
 	VkDebugReportCallbackEXT callback = VK_NULL_HANDLE;
 
 	unsigned warningCount[MESSAGE_CODE_COUNT] = {};
+	std::string lastMessage[MESSAGE_CODE_COUNT];
 	Config cfg;
+
+private:
+	bool perfDocLayerEnabled;
 };
 
 // Implemented by tests.